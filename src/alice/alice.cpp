@@ -273,6 +273,21 @@ int alice(Firebird::UtilSvc* uSvc)
 			}
 		}
 
+		if (table->in_sw_value & sw_cache)
+		{
+			if (--argc <= 0) {
+				ALICE_error(6);	// msg 6: number of page buffers for cache required
+			}
+			ALICE_upper_case(*argv++, string, sizeof(string));
+			if (!(tdgbl->ALICE_data.ua_page_cache = atoi(string)))
+			{
+				ALICE_error(7);	// msg 7: numeric value required
+			}
+			if (tdgbl->ALICE_data.ua_page_cache < 0) {
+				ALICE_error(114);	// msg 114: positive or zero numeric value required
+			}
+		}
+
 		if (table->in_sw_value & sw_parallel_workers)
 		{
 			if (--argc <= 0) {	// TODO: error message!
@@ -52,7 +52,7 @@ inline constexpr SINT64 sw_user				= 0x0000000000200000L;
 inline constexpr SINT64 sw_password			= 0x0000000000400000L;
 inline constexpr SINT64 sw_shut				= 0x0000000000800000L;
 inline constexpr SINT64 sw_online			= 0x0000000001000000L;	// Byte 3, Bit 0
-//inline constexpr SINT64 sw_cache			= 0x0000000002000000L;
+inline constexpr SINT64 sw_cache			= 0x0000000002000000L;
 inline constexpr SINT64 sw_attach			= 0x0000000004000000L;
 inline constexpr SINT64 sw_force			= 0x0000000008000000L;
 inline constexpr SINT64 sw_tran				= 0x0000000010000000L;
@@ -128,7 +128,8 @@ enum alice_switches
 	IN_SW_ALICE_ROLE				=	49,
 	IN_SW_ALICE_REPLICA				=	50,
 	IN_SW_ALICE_PARALLEL_WORKERS	=	51,
-	IN_SW_ALICE_UPGRADE				=	52
+	IN_SW_ALICE_UPGRADE				=	52,
+	IN_SW_ALICE_CACHE				=	53
 };
 
 static inline constexpr const char* ALICE_SW_ASYNC	= "ASYNC";
@@ -162,6 +163,9 @@ static inline constexpr Switches::in_sw_tab_t alice_in_sw_table[] =
 	{IN_SW_ALICE_BUFFERS, isc_spb_prp_page_buffers, "BUFFERS", sw_buffers,
 		0, 0, false, false, 28, 1, NULL},
 	// msg 28: \t-buffers\tset page buffers <n>
+	{IN_SW_ALICE_CACHE, isc_spb_prp_page_cache, "CACHE", sw_cache,
+		0, 0, false, false, 138, 2, NULL},
+	// msg 138: -cache resize page cache of running database <n>
 	{IN_SW_ALICE_COMMIT, isc_spb_rpr_commit_trans, "COMMIT", sw_commit,
 		0, ~(sw_commit | sw_auth_set | sw_nolinger), false, false, 29, 2, NULL},
 	// msg 29: \t-commit\t\tcommit transaction <tr / all>
@@ -249,6 +249,9 @@ static void buildDpb(Firebird::ClumpletWriter& dpb, const SINT64 switches)
 	else if (switches & sw_buffers) {
 		dpb.insertInt(isc_dpb_set_page_buffers, tdgbl->ALICE_data.ua_page_buffers);
 	}
+	else if (switches & sw_cache) {
+		dpb.insertInt(isc_dpb_page_cache, tdgbl->ALICE_data.ua_page_cache);
+	}
 	else if (switches & sw_kill) {
 		dpb.insertTag(isc_dpb_delete_shadow);
 	}
@@ -402,6 +402,7 @@ ClumpletReader::ClumpletType ClumpletReader::getClumpletType(UCHAR tag) const
 			case isc_spb_prp_force_shutdown:
 			case isc_spb_prp_attachments_shutdown:
 			case isc_spb_prp_transactions_shutdown:
+			case isc_spb_prp_page_cache:
 				return IntSpb;
 			case isc_spb_prp_reserve_space:
 			case isc_spb_prp_write_mode:
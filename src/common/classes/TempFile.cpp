@@ -44,6 +44,10 @@
 #include <unistd.h>
 #endif
 
+#ifdef HAVE_LINUX_FALLOC_H
+#include <linux/falloc.h>
+#endif
+
 #include "../common/gdsassert.h"
 #include "../common/os/os_utils.h"
 #include "../common/os/path_utils.h"
@@ -315,6 +319,22 @@ void TempFile::seek(const offset_t offset)
 
 void TempFile::extend(offset_t delta)
 {
+#if defined(HAVE_LINUX_FALLOC_H) && defined(HAVE_FALLOCATE)
+	// Reserve the space without writing it, so running out of the disk space
+	// is still detected here and not by a later write
+	if (fallocate(handle, 0, (off_t) size, (off_t) delta) == 0)
+	{
+		size += delta;
+		return;
+	}
+
+	if (errno != EOPNOTSUPP && errno != ENOSYS)
+		system_error::raise("fallocate");
+
+	// fallocate is not supported by this kernel or file system,
+	// fill the space with zeroes
+#endif
+
 	const char* const buffer = zeros().getBuffer();
 	const FB_SIZE_T bufferSize = zeros().getSize();
 	const offset_t newSize = size + delta;
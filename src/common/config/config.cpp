@@ -137,6 +137,9 @@ const char*	GCPolicyCooperative	= "cooperative";
 const char*	GCPolicyBackground	= "background";
 const char*	GCPolicyCombined	= "combined";
 
+const char*	PageReplacementLRU	= "LRU";
+const char*	PageReplacement2Q	= "2Q";
+
 ConfigValue Config::defaults[MAX_CONFIG_KEY];
 
 /******************************************************************************
@@ -379,6 +382,17 @@ void Config::checkValues()
 		}
 	}
 
+	strVal = values[KEY_PAGE_REPLACEMENT_POLICY].strVal;
+	if (strVal)
+	{
+		NoCaseString policy(strVal);
+		if (policy != PageReplacementLRU && policy != PageReplacement2Q)
+		{
+			// user-provided value is invalid - fail to default
+			values[KEY_PAGE_REPLACEMENT_POLICY] = defaults[KEY_PAGE_REPLACEMENT_POLICY];
+		}
+	}
+
 	strVal = values[KEY_WIRE_CRYPT].strVal;
 	if (strVal)
 	{
@@ -424,6 +438,31 @@ void Config::checkValues()
 
 	checkIntForLoBound(KEY_PARALLEL_WORKERS, 1, true);
 	checkIntForHiBound(KEY_PARALLEL_WORKERS, values[KEY_MAX_PARALLEL_WORKERS].intVal, false);
+
+	checkIntForLoBound(KEY_READ_AHEAD_SIZE, 0, true);
+	checkIntForHiBound(KEY_READ_AHEAD_SIZE, 4 * 1048576, false);
+
+	checkIntForLoBound(KEY_DIRTY_PAGE_TARGET, 0, true);
+	checkIntForHiBound(KEY_DIRTY_PAGE_TARGET, 100, false);
+
+	const SINT64 hugePageSize = values[KEY_HUGE_PAGE_SIZE].intVal;
+	if (hugePageSize != 0 && hugePageSize != 2 * 1048576 && hugePageSize != 1024 * 1048576)
+	{
+		// user-provided value is invalid - fail to default
+		values[KEY_HUGE_PAGE_SIZE] = defaults[KEY_HUGE_PAGE_SIZE];
+	}
+
+	checkIntForLoBound(KEY_CACHE_DUMP_INTERVAL, 0, true);
+
+	checkIntForLoBound(KEY_PAGE_CACHE_NUMA_NODES, 0, true);
+	checkIntForHiBound(KEY_PAGE_CACHE_NUMA_NODES, 64, false);
+
+	checkIntForLoBound(KEY_HASH_JOIN_MEMORY_LIMIT, 1048576, true);
+
+	checkIntForLoBound(KEY_HASH_AGGREGATE_MEMORY_LIMIT, 1048576, true);
+
+	checkIntForLoBound(KEY_INDEX_FILL_FACTOR, 50, true);
+	checkIntForHiBound(KEY_INDEX_FILL_FACTOR, 100, true);
 }
 
 
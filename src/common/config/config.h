@@ -78,6 +78,9 @@ extern const char*	GCPolicyCooperative;
 extern const char*	GCPolicyBackground;
 extern const char*	GCPolicyCombined;
 
+extern const char*	PageReplacementLRU;
+extern const char*	PageReplacement2Q;
+
 inline constexpr int WIRE_CRYPT_DISABLED = 0;
 inline constexpr int WIRE_CRYPT_ENABLED = 1;
 inline constexpr int WIRE_CRYPT_REQUIRED = 2;
@@ -187,6 +190,16 @@ enum ConfigKey
 	KEY_MAX_PARALLEL_WORKERS,
 	KEY_OPTIMIZE_FOR_FIRST_ROWS,
 	KEY_ALLOW_UPDATE_OVERWRITE,
+	KEY_READ_AHEAD_SIZE,
+	KEY_PAGE_REPLACEMENT_POLICY,
+	KEY_DIRTY_PAGE_TARGET,
+	KEY_HUGE_PAGE_SIZE,
+	KEY_CACHE_DUMP_INTERVAL,
+	KEY_PAGE_CACHE_NUMA_NODES,
+	KEY_HASH_JOIN_MEMORY_LIMIT,
+	KEY_HASH_AGGREGATE_MEMORY_LIMIT,
+	KEY_TEMP_COMPRESSION,
+	KEY_INDEX_FILL_FACTOR,
 	MAX_CONFIG_KEY		// keep it last
 };
 
@@ -300,7 +313,17 @@ inline constexpr ConfigEntry entries[MAX_CONFIG_KEY] =
 	{TYPE_INTEGER,	"ParallelWorkers",			true,	1},
 	{TYPE_INTEGER,	"MaxParallelWorkers",		true,	1},
 	{TYPE_BOOLEAN,	"OptimizeForFirstRows",		false,	false},
-	{TYPE_BOOLEAN,	"AllowUpdateOverwrite",		false,	true}
+	{TYPE_BOOLEAN,	"AllowUpdateOverwrite",		false,	true},
+	{TYPE_INTEGER,	"ReadAheadSize",			false,	262144},	// bytes
+	{TYPE_STRING,	"PageReplacementPolicy",	false,	"LRU"},		// page cache replacement policy
+	{TYPE_INTEGER,	"DirtyPageTarget",			false,	20},		// percent of page cache
+	{TYPE_INTEGER,	"HugePageSize",				false,	0},			// bytes
+	{TYPE_INTEGER,	"CacheDumpInterval",		false,	0},			// seconds
+	{TYPE_INTEGER,	"PageCacheNumaNodes",		false,	1},
+	{TYPE_INTEGER,	"HashJoinMemoryLimit",		false,	64 * 1048576},	// bytes
+	{TYPE_INTEGER,	"HashAggregateMemoryLimit",	false,	64 * 1048576},	// bytes
+	{TYPE_BOOLEAN,	"TempCompression",			false,	false},
+	{TYPE_INTEGER,	"IndexFillFactor",			false,	100}		// percent of index page
 };
 
 
@@ -623,6 +646,26 @@ public:
 	CONFIG_GET_PER_DB_BOOL(getOptimizeForFirstRows, KEY_OPTIMIZE_FOR_FIRST_ROWS);
 
 	CONFIG_GET_PER_DB_BOOL(getAllowUpdateOverwrite, KEY_ALLOW_UPDATE_OVERWRITE);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getReadAheadSize, KEY_READ_AHEAD_SIZE, getInt);
+
+	CONFIG_GET_PER_DB_STR(getPageReplacementPolicy, KEY_PAGE_REPLACEMENT_POLICY);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getDirtyPageTarget, KEY_DIRTY_PAGE_TARGET, getInt);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getHugePageSize, KEY_HUGE_PAGE_SIZE, getInt);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getCacheDumpInterval, KEY_CACHE_DUMP_INTERVAL, getInt);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getPageCacheNumaNodes, KEY_PAGE_CACHE_NUMA_NODES, getInt);
+
+	CONFIG_GET_PER_DB_KEY(FB_UINT64, getHashJoinMemoryLimit, KEY_HASH_JOIN_MEMORY_LIMIT, getInt);
+
+	CONFIG_GET_PER_DB_KEY(FB_UINT64, getHashAggregateMemoryLimit, KEY_HASH_AGGREGATE_MEMORY_LIMIT, getInt);
+
+	CONFIG_GET_PER_DB_BOOL(getTempCompression, KEY_TEMP_COMPRESSION);
+
+	CONFIG_GET_PER_DB_KEY(ULONG, getIndexFillFactor, KEY_INDEX_FILL_FACTOR, getInt);
 };
 
 // Implementation of interface to access master configuration file
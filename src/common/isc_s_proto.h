@@ -232,6 +232,12 @@ public:
 	virtual USHORT getVersion() const = 0;
 	virtual const char* getName() const = 0;
 
+	// Ask the system to back the shared memory by huge pages
+	virtual bool useHugePages() const
+	{
+		return false;
+	}
+
 	virtual void initHeader(MemoryHeader* header)
 	{
 		header->init(getType(), getVersion());
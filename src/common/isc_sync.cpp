@@ -1361,6 +1361,9 @@ SharedMemoryBase::SharedMemoryBase(const TEXT* filename, ULONG length, IpcObject
 		system_call_failed::raise("mmap", errno);
 	}
 
+	if (sh_mem_callback && sh_mem_callback->useHugePages())
+		os_utils::adviseHugePages(address, length);
+
 	// this class is needed to cleanup mapping in case of error
 	class AutoUnmap
 	{
@@ -2542,6 +2545,9 @@ bool SharedMemoryBase::remapFile(CheckStatusWrapper* statusVector, ULONG new_len
 		return false;
 	}
 
+	if (sh_mem_callback && sh_mem_callback->useHugePages())
+		os_utils::adviseHugePages(address, new_length);
+
 	munmap(sh_mem_header, sh_mem_length_mapped);
 
 	IPC_TRACE(("ISC_remap_file %p to %p %d\n", sh_mem_header, address, new_length));
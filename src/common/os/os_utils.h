@@ -51,6 +51,7 @@
 #include <dirent.h>
 #include <sys/mman.h>
 #include <sys/resource.h>
+#include <sys/uio.h>
 
 #define DEFAULT_OPEN_MODE (0666)
 #endif
@@ -88,6 +89,21 @@ namespace os_utils
 	void setCloseOnExec(int fd);	// posix only
 	FILE* fopen(const char* pathname, const char* mode);
 
+	// anonymous memory backed by huge pages of given size, NULL if not available
+	void* allocHugePages(size_t size, size_t hugePageSize);
+	void freeHugePages(void* address, size_t size);
+	// advise system to back mapped memory by transparent huge pages
+	void adviseHugePages(void* address, size_t size);
+	// let system reclaim physical memory of whole pages in the range, content is lost
+	void discardMemory(void* address, size_t size);
+
+	// NUMA topology, node numbers are system ones and may be not contiguous
+	unsigned getCpuCount();
+	int getCurrentCpu();						// -1 if not known
+	int getCpuNumaNode(unsigned cpu);			// -1 if not known
+	// ask system to place physical pages of the range on the given node
+	bool bindMemoryToNumaNode(void* address, size_t size, int node);
+
 	// return a binary string that uniquely identifies the file
 #ifdef WIN_NT
 	void getUniqueFileId(HANDLE fd, Firebird::UCharBuffer& id);
@@ -237,6 +253,30 @@ namespace os_utils
 #endif
 	}
 
+#ifdef HAVE_PREADV
+	inline ssize_t preadv(int fd, const iovec* iov, int iovcnt, off_t offset)
+	{
+		// Don't check EINTR because it's done by caller
+#ifdef LSB_BUILD
+		return preadv64(fd, iov, iovcnt, offset);
+#else
+		return ::preadv(fd, iov, iovcnt, offset);
+#endif
+	}
+#endif
+
+#ifdef HAVE_PWRITEV
+	inline ssize_t pwritev(int fd, const iovec* iov, int iovcnt, off_t offset)
+	{
+		// Don't check EINTR because it's done by caller
+#ifdef LSB_BUILD
+		return pwritev64(fd, iov, iovcnt, offset);
+#else
+		return ::pwritev(fd, iov, iovcnt, offset);
+#endif
+	}
+#endif
+
 	inline struct dirent* readdir(DIR* dirp)
 	{
 		struct dirent* rc;
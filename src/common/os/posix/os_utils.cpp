@@ -84,6 +84,11 @@
 #include <utime.h>
 #endif
 
+#ifdef LINUX
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
 #include <stdio.h>
 
 using namespace Firebird;
@@ -393,6 +398,121 @@ FILE* fopen(const char* pathname, const char* mode)
 	return f;
 }
 
+void* allocHugePages(size_t size, size_t hugePageSize)
+{
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+	fb_assert(hugePageSize && !(hugePageSize & (hugePageSize - 1)));
+	fb_assert(size % hugePageSize == 0);
+
+	int shift = 0;
+	while (((size_t) 1 << shift) < hugePageSize)
+		shift++;
+
+	// mapping fails if there are not enough huge pages reserved in the system
+	void* const address = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0);
+
+	if (address != MAP_FAILED)
+		return address;
+#endif
+
+	return NULL;
+}
+
+void freeHugePages(void* address, size_t size)
+{
+	if (address)
+		munmap(address, size);
+}
+
+// advice is not absolutely required, therefore ignore errors here
+void adviseHugePages(void* address, size_t size)
+{
+#ifdef MADV_HUGEPAGE
+	madvise(address, size, MADV_HUGEPAGE);
+#endif
+}
+
+// advice is not absolutely required, therefore ignore errors here
+void discardMemory(void* address, size_t size)
+{
+#ifdef MADV_DONTNEED
+	static const size_t pageSize = sysconf(_SC_PAGESIZE);
+
+	// system pages partially out of the range must be kept intact
+	UCHAR* const start = FB_ALIGN((UCHAR*) address, pageSize);
+	UCHAR* const end = (UCHAR*) (((U_IPTR) address + size) & ~(U_IPTR) (pageSize - 1));
+
+	if (start < end)
+		madvise(start, end - start, MADV_DONTNEED);
+#endif
+}
+
+unsigned getCpuCount()
+{
+	const long count = sysconf(_SC_NPROCESSORS_CONF);
+	return count > 0 ? (unsigned) count : 1;
+}
+
+int getCurrentCpu()
+{
+#ifdef LINUX
+	return sched_getcpu();
+#else
+	return -1;
+#endif
+}
+
+int getCpuNumaNode(unsigned cpu)
+{
+#ifdef LINUX
+	// CPU directory contains link named after the node it belongs to
+
+	char path[64];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", cpu);
+
+	DIR* const dir = opendir(path);
+	if (!dir)
+		return -1;
+
+	int node = -1;
+	while (const dirent* const ent = os_utils::readdir(dir))
+	{
+		if (sscanf(ent->d_name, "node%d", &node) == 1)
+			break;
+		node = -1;
+	}
+
+	closedir(dir);
+	return node;
+#else
+	return -1;
+#endif
+}
+
+// placement is not absolutely required, therefore only report errors here
+bool bindMemoryToNumaNode(void* address, size_t size, int node)
+{
+#if defined(LINUX) && defined(SYS_mbind)
+	const int MPOL_PREFERRED = 1;
+	static const size_t pageSize = sysconf(_SC_PAGESIZE);
+
+	if (node < 0 || node >= (int) (sizeof(unsigned long) * 8))
+		return false;
+
+	UCHAR* const start = FB_ALIGN((UCHAR*) address, pageSize);
+	UCHAR* const end = (UCHAR*) (((U_IPTR) address + size) & ~(U_IPTR) (pageSize - 1));
+
+	if (start >= end)
+		return false;
+
+	const unsigned long mask = 1UL << node;
+	return syscall(SYS_mbind, start, end - start, MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0) == 0;
+#else
+	return false;
+#endif
+}
+
 static void makeUniqueFileId(const struct STAT& statistics, UCharBuffer& id)
 {
 	const size_t len1 = sizeof(statistics.st_dev);
@@ -408,6 +408,61 @@ FILE* fopen(const char* pathname, const char* mode)
 	return ::fopen(pathname, mode);
 }
 
+// large pages require SeLockMemoryPrivilege, not supported
+void* allocHugePages(size_t /*size*/, size_t /*hugePageSize*/)
+{
+	return NULL;
+}
+
+void freeHugePages(void* /*address*/, size_t /*size*/)
+{
+}
+
+void adviseHugePages(void* /*address*/, size_t /*size*/)
+{
+}
+
+void discardMemory(void* address, size_t size)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	const size_t pageSize = info.dwPageSize;
+
+	// system pages partially out of the range must be kept intact
+	UCHAR* const start = FB_ALIGN((UCHAR*) address, pageSize);
+	UCHAR* const end = (UCHAR*) (((U_IPTR) address + size) & ~(U_IPTR) (pageSize - 1));
+
+	if (start < end)
+		VirtualAlloc(start, end - start, MEM_RESET, PAGE_READWRITE);
+}
+
+unsigned getCpuCount()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+}
+
+int getCurrentCpu()
+{
+	return GetCurrentProcessorNumber();
+}
+
+int getCpuNumaNode(unsigned cpu)
+{
+	UCHAR node;
+	if (cpu > MAX_UCHAR || !GetNumaProcessorNode((UCHAR) cpu, &node) || node == MAX_UCHAR)
+		return -1;
+
+	return node;
+}
+
+// memory can be placed on the node only when it's allocated
+bool bindMemoryToNumaNode(void* address, size_t size, int node)
+{
+	return false;
+}
+
 void getUniqueFileId(HANDLE fd, UCharBuffer& id)
 {
 	entryLoader.init();
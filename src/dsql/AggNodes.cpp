@@ -32,6 +32,7 @@
 #include "../jrd/Statement.h"
 #include "../jrd/met.h"
 #include "../jrd/tra.h"
+#include "../jrd/RecordBatch.h"
 #include "../jrd/recsrc/RecordSource.h"
 #include "../jrd/blb_proto.h"
 #include "../jrd/cmp_proto.h"
@@ -500,6 +501,45 @@ void AggNode::aggFinish(thread_db* /*tdbb*/, Request* request) const
 	}
 }
 
+// Exchange two impure values, keeping their descriptors pointed to their own storage.
+static void swapImpureValues(impure_value_ex* value1, impure_value_ex* value2)
+{
+	const bool local1 = value1->vlu_desc.dsc_address == (UCHAR*) &value1->vlu_misc;
+	const bool local2 = value2->vlu_desc.dsc_address == (UCHAR*) &value2->vlu_misc;
+
+	const impure_value_ex temp = *value1;
+	*value1 = *value2;
+	*value2 = temp;
+
+	if (local1)
+		value2->vlu_desc.dsc_address = (UCHAR*) &value2->vlu_misc;
+
+	if (local2)
+		value1->vlu_desc.dsc_address = (UCHAR*) &value1->vlu_misc;
+}
+
+void AggNode::aggSwapState(Request* request, impure_value_ex* state) const
+{
+	fb_assert(getStateCount() == 1);
+	swapImpureValues(request->getImpure<impure_value_ex>(impureOffset), state);
+}
+
+void AggNode::aggCombine(thread_db* /*tdbb*/, Request* /*request*/, const impure_value_ex* /*state*/) const
+{
+	fb_assert(false);
+}
+
+bool AggNode::aggPassBatch(thread_db* tdbb, Request* request, const RecordBatch& batch) const
+{
+	impure_value_ex state;
+
+	if (!aggPartialBatch(tdbb, request, batch, &state))
+		return false;
+
+	aggCombine(tdbb, request, &state);
+	return true;
+}
+
 dsc* AggNode::execute(thread_db* tdbb, Request* request) const
 {
 	impure_value_ex* impure = request->getImpure<impure_value_ex>(impureOffset);
@@ -1671,6 +1711,31 @@ void AvgAggNode::aggInit(thread_db* tdbb, Request* request) const
 	}
 }
 
+void AvgAggNode::aggSwapState(Request* request, impure_value_ex* state) const
+{
+	swapImpureValues(request->getImpure<impure_value_ex>(impureOffset), &state[0]);
+	swapImpureValues(request->getImpure<impure_value_ex>(tempImpure), &state[1]);
+}
+
+void AvgAggNode::aggCombine(thread_db* tdbb, Request* request, const impure_value_ex* state) const
+{
+	if (!state[0].vlux_count)
+		return;
+
+	impure_value_ex* impure = request->getImpure<impure_value_ex>(impureOffset);
+
+	if (impure->vlux_count == 0)
+	{
+		impure_value_ex* impureTemp = request->getImpure<impure_value_ex>(tempImpure);
+		impureTemp->vlu_desc = state[1].vlu_desc;
+	}
+
+	impure->vlux_count += state[0].vlux_count;
+
+	ArithmeticNode::add(tdbb, &state[0].vlu_desc, &impure->vlu_desc, impure, blr_add,
+		dialect1, nodScale, nodFlags);
+}
+
 void AvgAggNode::aggPass(thread_db* tdbb, Request* request, dsc* desc) const
 {
 	impure_value_ex* impure = request->getImpure<impure_value_ex>(impureOffset);
@@ -2409,6 +2474,52 @@ void CountAggNode::aggPass(thread_db* /*tdbb*/, Request* request, dsc* /*desc*/)
 		++impure->vlu_misc.vlu_int64;
 }
 
+void CountAggNode::aggCombine(thread_db* /*tdbb*/, Request* request, const impure_value_ex* state) const
+{
+	impure_value_ex* impure = request->getImpure<impure_value_ex>(impureOffset);
+
+	if (dialect1)
+		impure->vlu_misc.vlu_long += *(SLONG*) state->vlu_desc.dsc_address;
+	else
+		impure->vlu_misc.vlu_int64 += *(SINT64*) state->vlu_desc.dsc_address;
+}
+
+bool CountAggNode::aggPartialBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+	impure_value_ex* state) const
+{
+	if (!isCombinable())
+		return false;
+
+	SINT64 count = batch.getCount();
+
+	if (arg)
+	{
+		BatchColumn column(*tdbb->getDefaultPool());
+
+		if (!arg->executeBatch(tdbb, request, batch, column))
+			return false;
+
+		for (ULONG i = 0; i < column.count; i++)
+		{
+			if (column.nulls[i])
+				count--;
+		}
+	}
+
+	if (dialect1)
+	{
+		state->vlu_misc.vlu_long = (SLONG) count;
+		state->vlu_desc.makeLong(0, &state->vlu_misc.vlu_long);
+	}
+	else
+	{
+		state->vlu_misc.vlu_int64 = count;
+		state->vlu_desc.makeInt64(0, &state->vlu_misc.vlu_int64);
+	}
+
+	return true;
+}
+
 dsc* CountAggNode::aggExecute(thread_db* /*tdbb*/, Request* request) const
 {
 	impure_value_ex* impure = request->getImpure<impure_value_ex>(impureOffset);
@@ -2668,6 +2779,54 @@ void SumAggNode::aggPass(thread_db* tdbb, Request* request, dsc* desc) const
 	ArithmeticNode::add(tdbb, desc, &impure->vlu_desc, impure, blr_add, dialect1, nodScale, nodFlags);
 }
 
+void SumAggNode::aggCombine(thread_db* tdbb, Request* request, const impure_value_ex* state) const
+{
+	if (!state->vlux_count)
+		return;
+
+	impure_value_ex* impure = request->getImpure<impure_value_ex>(impureOffset);
+	impure->vlux_count += state->vlux_count;
+
+	ArithmeticNode::add(tdbb, &state->vlu_desc, &impure->vlu_desc, impure, blr_add,
+		dialect1, nodScale, nodFlags);
+}
+
+// Sum the exact values of the batch into a partial state
+bool SumAggNode::aggPartialBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+	impure_value_ex* state) const
+{
+	if (!isCombinable() || dialect1)
+		return false;
+
+	BatchColumn column(*tdbb->getDefaultPool());
+
+	if (!arg->executeBatch(tdbb, request, batch, column) || column.kind != BatchColumn::KIND_EXACT)
+		return false;
+
+	state->vlu_misc.vlu_int64 = 0;
+	state->vlux_count = 0;
+
+	for (ULONG i = 0; i < column.count; i++)
+	{
+		if (column.nulls[i])
+			continue;
+
+		const SINT64 value = column.values[i].exact;
+		const SINT64 sum = (SINT64) ((FB_UINT64) state->vlu_misc.vlu_int64 + (FB_UINT64) value);
+
+		// Leave the overflow to be reported (or avoided with a wider type) by the row mode
+		if (((state->vlu_misc.vlu_int64 ^ sum) & (value ^ sum)) < 0)
+			return false;
+
+		state->vlu_misc.vlu_int64 = sum;
+		state->vlux_count++;
+	}
+
+	state->vlu_desc.makeInt64(column.scale, &state->vlu_misc.vlu_int64);
+
+	return true;
+}
+
 dsc* SumAggNode::aggExecute(thread_db* /*tdbb*/, Request* request) const
 {
 	impure_value_ex* impure = request->getImpure<impure_value_ex>(impureOffset);
@@ -2758,6 +2917,80 @@ void MaxMinAggNode::aggPass(thread_db* tdbb, Request* request, dsc* desc) const
 		EVL_make_value(tdbb, desc, impure);
 }
 
+void MaxMinAggNode::aggCombine(thread_db* tdbb, Request* request, const impure_value_ex* state) const
+{
+	if (!state->vlux_count)
+		return;
+
+	impure_value_ex* impure = request->getImpure<impure_value_ex>(impureOffset);
+
+	if (!impure->vlux_count)
+		EVL_make_value(tdbb, &state->vlu_desc, impure);
+	else
+	{
+		const int result = MOV_compare(tdbb, &state->vlu_desc, &impure->vlu_desc);
+
+		if ((type == TYPE_MAX && result > 0) || (type == TYPE_MIN && result < 0))
+			EVL_make_value(tdbb, &state->vlu_desc, impure);
+	}
+
+	impure->vlux_count += state->vlux_count;
+}
+
+// Find the extreme value of the batch as a partial state
+bool MaxMinAggNode::aggPartialBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+	impure_value_ex* state) const
+{
+	if (!isCombinable())
+		return false;
+
+	BatchColumn column(*tdbb->getDefaultPool());
+
+	if (!arg->executeBatch(tdbb, request, batch, column) || column.kind == BatchColumn::KIND_BOOLEAN)
+		return false;
+
+	const bool approx = (column.kind == BatchColumn::KIND_APPROX);
+	ULONG found = 0;
+
+	state->vlux_count = 0;
+
+	for (ULONG i = 0; i < column.count; i++)
+	{
+		if (column.nulls[i])
+			continue;
+
+		const BatchColumn::Value& value = column.values[i];
+
+		if (state->vlux_count++)
+		{
+			const BatchColumn::Value& current = column.values[found];
+			const bool greater = approx ? (value.approx > current.approx) : (value.exact > current.exact);
+			const bool less = approx ? (value.approx < current.approx) : (value.exact < current.exact);
+
+			if ((type == TYPE_MAX && greater) || (type == TYPE_MIN && less))
+				found = i;
+		}
+		else
+			found = i;
+	}
+
+	if (!state->vlux_count)
+		return true;
+
+	if (approx)
+	{
+		state->vlu_misc.vlu_double = column.values[found].approx;
+		state->vlu_desc.makeDouble(&state->vlu_misc.vlu_double);
+	}
+	else
+	{
+		state->vlu_misc.vlu_int64 = column.values[found].exact;
+		state->vlu_desc.makeInt64(column.scale, &state->vlu_misc.vlu_int64);
+	}
+
+	return true;
+}
+
 dsc* MaxMinAggNode::aggExecute(thread_db* /*tdbb*/, Request* request) const
 {
 	impure_value_ex* impure = request->getImpure<impure_value_ex>(impureOffset);
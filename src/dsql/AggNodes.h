@@ -144,7 +144,7 @@ public:
 
 	unsigned getCapabilities() const override
 	{
-		return CAP_RESPECTS_WINDOW_FRAME | CAP_WANTS_AGG_CALLS;
+		return CAP_RESPECTS_WINDOW_FRAME | CAP_WANTS_AGG_CALLS | CAP_COMBINABLE;
 	}
 
 	Firebird::string internalPrint(NodePrinter& printer) const override;
@@ -157,6 +157,14 @@ public:
 	void aggPass(thread_db* tdbb, Request* request, dsc* desc) const override;
 	dsc* aggExecute(thread_db* tdbb, Request* request) const override;
 
+	unsigned getStateCount() const override
+	{
+		return 2;
+	}
+
+	void aggSwapState(Request* request, impure_value_ex* state) const override;
+	void aggCombine(thread_db* tdbb, Request* request, const impure_value_ex* state) const override;
+
 protected:
 	AggNode* dsqlCopy(DsqlCompilerScratch* dsqlScratch) /*const*/ override;
 
@@ -279,7 +287,7 @@ public:
 
 	unsigned getCapabilities() const override
 	{
-		return CAP_RESPECTS_WINDOW_FRAME | CAP_WANTS_AGG_CALLS;
+		return CAP_RESPECTS_WINDOW_FRAME | CAP_WANTS_AGG_CALLS | CAP_COMBINABLE;
 	}
 
 	Firebird::string internalPrint(NodePrinter& printer) const override;
@@ -291,6 +299,9 @@ public:
 	void aggInit(thread_db* tdbb, Request* request) const override;
 	void aggPass(thread_db* tdbb, Request* request, dsc* desc) const override;
 	dsc* aggExecute(thread_db* tdbb, Request* request) const override;
+	void aggCombine(thread_db* tdbb, Request* request, const impure_value_ex* state) const override;
+	bool aggPartialBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+		impure_value_ex* state) const override;
 
 protected:
 	AggNode* dsqlCopy(DsqlCompilerScratch* dsqlScratch) /*const*/ override;
@@ -310,7 +321,7 @@ public:
 
 	unsigned getCapabilities() const override
 	{
-		return CAP_RESPECTS_WINDOW_FRAME | CAP_WANTS_AGG_CALLS;
+		return CAP_RESPECTS_WINDOW_FRAME | CAP_WANTS_AGG_CALLS | CAP_COMBINABLE;
 	}
 
 	Firebird::string internalPrint(NodePrinter& printer) const override;
@@ -321,6 +332,9 @@ public:
 	void aggInit(thread_db* tdbb, Request* request) const override;
 	void aggPass(thread_db* tdbb, Request* request, dsc* desc) const override;
 	dsc* aggExecute(thread_db* tdbb, Request* request) const override;
+	void aggCombine(thread_db* tdbb, Request* request, const impure_value_ex* state) const override;
+	bool aggPartialBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+		impure_value_ex* state) const override;
 
 protected:
 	AggNode* dsqlCopy(DsqlCompilerScratch* dsqlScratch) /*const*/ override;
@@ -341,7 +355,7 @@ public:
 
 	unsigned getCapabilities() const override
 	{
-		return CAP_RESPECTS_WINDOW_FRAME | CAP_WANTS_AGG_CALLS;
+		return CAP_RESPECTS_WINDOW_FRAME | CAP_WANTS_AGG_CALLS | CAP_COMBINABLE;
 	}
 
 	Firebird::string internalPrint(NodePrinter& printer) const override;
@@ -352,6 +366,9 @@ public:
 	void aggInit(thread_db* tdbb, Request* request) const override;
 	void aggPass(thread_db* tdbb, Request* request, dsc* desc) const override;
 	dsc* aggExecute(thread_db* tdbb, Request* request) const override;
+	void aggCombine(thread_db* tdbb, Request* request, const impure_value_ex* state) const override;
+	bool aggPartialBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+		impure_value_ex* state) const override;
 
 protected:
 	AggNode* dsqlCopy(DsqlCompilerScratch* dsqlScratch) /*const*/ override;
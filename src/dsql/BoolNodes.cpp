@@ -26,6 +26,7 @@
 #include "../jrd/align.h"
 #include "firebird/impl/blr.h"
 #include "../jrd/tra.h"
+#include "../jrd/RecordBatch.h"
 #include "../jrd/recsrc/RecordSource.h"
 #include "../jrd/recsrc/Cursor.h"
 #include "../jrd/optimizer/Optimizer.h"
@@ -259,6 +260,46 @@ TriState BinaryBoolNode::execute(thread_db* tdbb, Request* request) const
 	return TriState::empty();
 }
 
+bool BinaryBoolNode::executeBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+	BatchColumn& result) const
+{
+	BatchColumn other(*tdbb->getDefaultPool());
+
+	if (!arg1->executeBatch(tdbb, request, batch, result) ||
+		!arg2->executeBatch(tdbb, request, batch, other))
+	{
+		return false;
+	}
+
+	fb_assert(result.kind == BatchColumn::KIND_BOOLEAN && other.kind == BatchColumn::KIND_BOOLEAN);
+
+	// Same truth tables as in executeAnd and executeOr. The operands are evaluated
+	// for all rows, it's fine as the batch evaluation never raises errors.
+
+	const SINT64 dominant = (blrOp == blr_and) ? 0 : 1;
+
+	for (ULONG i = 0; i < result.count; i++)
+	{
+		const bool null1 = result.nulls[i], null2 = other.nulls[i];
+		const SINT64 value1 = result.values[i].exact, value2 = other.values[i].exact;
+
+		if ((!null1 && value1 == dominant) || (!null2 && value2 == dominant))
+		{
+			result.nulls[i] = 0;
+			result.values[i].exact = dominant;
+		}
+		else if (null1 || null2)
+		{
+			result.nulls[i] = 1;
+			result.values[i].exact = 0;
+		}
+		else
+			result.values[i].exact = 1 - dominant;
+	}
+
+	return true;
+}
+
 TriState BinaryBoolNode::executeAnd(thread_db* tdbb, Request* request) const
 {
 	// If either operand is false, then the result is false;
@@ -885,6 +926,125 @@ TriState ComparativeBoolNode::execute(thread_db* tdbb, Request* request) const
 	return TriState(false);
 }
 
+// Compare numeric values of the batch, other data types are left for the row mode
+bool ComparativeBoolNode::executeBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+	BatchColumn& result) const
+{
+	switch (blrOp)
+	{
+		case blr_eql:
+		case blr_equiv:
+		case blr_gtr:
+		case blr_geq:
+		case blr_lss:
+		case blr_leq:
+		case blr_neq:
+			break;
+
+		default:
+			return false;
+	}
+
+	if (nodFlags & FLAG_INVARIANT)
+		return false;
+
+	BatchColumn left(*tdbb->getDefaultPool());
+	BatchColumn right(*tdbb->getDefaultPool());
+
+	if (!arg1->executeBatch(tdbb, request, batch, left) ||
+		!arg2->executeBatch(tdbb, request, batch, right))
+	{
+		return false;
+	}
+
+	// Convert the operands the same way CVT2_compare does
+
+	if (left.kind == BatchColumn::KIND_BOOLEAN || right.kind == BatchColumn::KIND_BOOLEAN)
+	{
+		if (left.kind != right.kind)
+			return false;
+	}
+	else if (left.kind == BatchColumn::KIND_APPROX || right.kind == BatchColumn::KIND_APPROX)
+	{
+		left.makeApprox();
+		right.makeApprox();
+	}
+	else
+	{
+		const SCHAR scale = MIN(left.scale, right.scale);
+
+		if (!left.rescale(scale) || !right.rescale(scale))
+			return false;
+	}
+
+	const bool approx = (left.kind == BatchColumn::KIND_APPROX);
+	const ULONG count = left.count;
+
+	result.reset(BatchColumn::KIND_BOOLEAN, 0, count);
+
+	for (ULONG i = 0; i < count; i++)
+	{
+		const bool null1 = left.nulls[i], null2 = right.nulls[i];
+		SINT64& value = result.values[i].exact;
+
+		if (null1 || null2)
+		{
+			if (blrOp == blr_equiv)
+				value = (null1 && null2) ? 1 : 0;
+			else
+			{
+				result.nulls[i] = 1;
+				value = 0;
+			}
+
+			continue;
+		}
+
+		int comparison;
+
+		if (approx)
+		{
+			const double value1 = left.values[i].approx, value2 = right.values[i].approx;
+			comparison = (value1 == value2) ? 0 : (value1 > value2) ? 1 : -1;
+		}
+		else
+		{
+			const SINT64 value1 = left.values[i].exact, value2 = right.values[i].exact;
+			comparison = (value1 == value2) ? 0 : (value1 > value2) ? 1 : -1;
+		}
+
+		switch (blrOp)
+		{
+			case blr_eql:
+			case blr_equiv:
+				value = (comparison == 0);
+				break;
+
+			case blr_gtr:
+				value = (comparison > 0);
+				break;
+
+			case blr_geq:
+				value = (comparison >= 0);
+				break;
+
+			case blr_lss:
+				value = (comparison < 0);
+				break;
+
+			case blr_leq:
+				value = (comparison <= 0);
+				break;
+
+			case blr_neq:
+				value = (comparison != 0);
+				break;
+		}
+	}
+
+	return true;
+}
+
 // Perform one of the complex string functions CONTAINING, MATCHES, or STARTS WITH.
 TriState ComparativeBoolNode::stringBoolean(thread_db* tdbb, Request* request,
 	dsc* desc1, dsc* desc2, bool computedInvariant) const
@@ -62,6 +62,8 @@ public:
 	bool dsqlMatch(DsqlCompilerScratch* dsqlScratch, const ExprNode* other, bool ignoreMapCast) const override;
 	bool sameAs(const ExprNode* other, bool ignoreStreams) const override;
 	Firebird::TriState execute(thread_db* tdbb, Request* request) const override;
+	bool executeBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+		BatchColumn& result) const override;
 
 private:
 	Firebird::TriState executeAnd(thread_db* tdbb, Request* request) const;
@@ -122,6 +124,8 @@ public:
 	BoolExprNode* pass1(thread_db* tdbb, CompilerScratch* csb) override;
 	void pass2Boolean(thread_db* tdbb, CompilerScratch* csb, std::function<void ()> process) override;
 	Firebird::TriState execute(thread_db* tdbb, Request* request) const override;
+	bool executeBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+		BatchColumn& result) const override;
 
 private:
 	Firebird::TriState stringBoolean(thread_db* tdbb, Request* request, dsc* desc1, dsc* desc2,
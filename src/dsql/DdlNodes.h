@@ -2038,6 +2038,7 @@ public:
 		bid conditionSource;
 		QualifiedName refRelation;
 		Firebird::ObjectsArray<MetaName> refColumns;
+		Firebird::ObjectsArray<MetaName> includes;
 	};
 
 public:
@@ -2078,6 +2079,7 @@ public:
 	bool active = true;
 	NestConst<RelationSourceNode> relation;
 	NestConst<ValueListNode> columns;
+	NestConst<ValueListNode> includes;
 	NestConst<ValueSourceClause> computed;
 	NestConst<BoolSourceClause> partial;
 	bool createIfNotExistsOnly = false;
@@ -2188,6 +2190,41 @@ public:
 };
 
 
+class SetTableStatisticsNode final : public DdlNode
+{
+public:
+	SetTableStatisticsNode(MemoryPool& p, const QualifiedName& aName)
+		: DdlNode(p),
+		  relationName(p, aName),
+		  columns(p)
+	{
+	}
+
+public:
+	Firebird::string internalPrint(NodePrinter& printer) const override;
+	void checkPermission(thread_db* tdbb, jrd_tra* transaction) override;
+	void execute(thread_db* tdbb, DsqlCompilerScratch* dsqlScratch, jrd_tra* transaction) override;
+
+	DdlNode* dsqlPass(DsqlCompilerScratch* dsqlScratch) override
+	{
+		dsqlScratch->qualifyExistingName(relationName, obj_relation);
+		dsqlScratch->ddlSchema = relationName.schema;
+
+		return DdlNode::dsqlPass(dsqlScratch);
+	}
+
+protected:
+	void putErrorPrefix(Firebird::Arg::StatusVector& statusVector) override
+	{
+		statusVector << Firebird::Arg::Gds(isc_dsql_alter_table_failed) << relationName.toQuotedString();
+	}
+
+public:
+	QualifiedName relationName;
+	Firebird::ObjectsArray<MetaName> columns;
+};
+
+
 class DropIndexNode final : public ModifyIndexNode, public DdlNode
 {
 public:
@@ -2918,6 +2955,7 @@ private:
 public:
 	bool create = false;	// Is the node created with a CREATE DATABASE command?
 	SLONG linger = -1;
+	SLONG pageCache = -1;
 	unsigned clauses = 0;
 	Firebird::string differenceFile;
 	QualifiedName setDefaultCharSet;
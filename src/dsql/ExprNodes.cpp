@@ -35,6 +35,7 @@
 #include "../jrd/tra.h"
 #include "../jrd/met.h"
 #include "../jrd/Function.h"
+#include "../jrd/RecordBatch.h"
 #include "../jrd/SysFunction.h"
 #include "../jrd/recsrc/RecordSource.h"
 #include "../jrd/recsrc/Cursor.h"
@@ -2082,6 +2083,130 @@ dsc* ArithmeticNode::execute(thread_db* tdbb, Request* request) const
 	}
 }
 
+// Evaluate add, subtract and multiply for the batch. Operations that could raise
+// an error (overflows) are not evaluated here, the row mode reports them.
+bool ArithmeticNode::executeBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+	BatchColumn& result) const
+{
+	if (dialect1 || (nodFlags & (FLAG_DATE | FLAG_DECFLOAT | FLAG_INT128)))
+		return false;
+
+	if (blrOp != blr_add && blrOp != blr_subtract && blrOp != blr_multiply)
+		return false;
+
+	BatchColumn other(*tdbb->getDefaultPool());
+
+	if (!arg1->executeBatch(tdbb, request, batch, result) ||
+		!arg2->executeBatch(tdbb, request, batch, other) ||
+		result.kind == BatchColumn::KIND_BOOLEAN || other.kind == BatchColumn::KIND_BOOLEAN)
+	{
+		return false;
+	}
+
+	const ULONG count = result.count;
+	fb_assert(other.count == count);
+
+	if (nodFlags & FLAG_DOUBLE)
+	{
+		result.makeApprox();
+		other.makeApprox();
+
+		for (ULONG i = 0; i < count; i++)
+		{
+			if (result.nulls[i] || other.nulls[i])
+			{
+				result.nulls[i] = 1;
+				result.values[i].approx = 0;
+				continue;
+			}
+
+			double& value = result.values[i].approx;
+			const double arg = other.values[i].approx;
+
+			value = (blrOp == blr_add) ? value + arg : (blrOp == blr_subtract) ? value - arg : value * arg;
+
+			if (std::isinf(value))
+				return false;
+		}
+
+		return true;
+	}
+
+	if (result.kind != BatchColumn::KIND_EXACT || other.kind != BatchColumn::KIND_EXACT)
+		return false;
+
+	if (blrOp == blr_multiply)
+	{
+		if (result.scale + other.scale != nodScale)
+			return false;
+
+		for (ULONG i = 0; i < count; i++)
+		{
+			if (result.nulls[i] || other.nulls[i])
+			{
+				result.nulls[i] = 1;
+				result.values[i].exact = 0;
+				continue;
+			}
+
+			SINT64& value = result.values[i].exact;
+			const SINT64 arg = other.values[i].exact;
+
+			const FB_UINT64 u1 = (value < 0) ? -(FB_UINT64) value : (FB_UINT64) value;
+			const FB_UINT64 u2 = (arg < 0) ? -(FB_UINT64) arg : (FB_UINT64) arg;
+
+			if (u1 && u2 > (FB_UINT64) MAX_SINT64 / u1)
+				return false;
+
+			value *= arg;
+		}
+
+		result.scale = nodScale;
+		return true;
+	}
+
+	if (nodScale > result.scale || nodScale > other.scale ||
+		!result.rescale(nodScale) || !other.rescale(nodScale))
+	{
+		return false;
+	}
+
+	for (ULONG i = 0; i < count; i++)
+	{
+		if (result.nulls[i] || other.nulls[i])
+		{
+			result.nulls[i] = 1;
+			result.values[i].exact = 0;
+			continue;
+		}
+
+		SINT64& value = result.values[i].exact;
+		const SINT64 arg = other.values[i].exact;
+
+		// See addDialect3 for the overflow test
+		if (blrOp == blr_subtract)
+		{
+			const SINT64 diff = (SINT64) ((FB_UINT64) value - (FB_UINT64) arg);
+
+			if (((value ^ arg) & (value ^ diff)) < 0)
+				return false;
+
+			value = diff;
+		}
+		else
+		{
+			const SINT64 sum = (SINT64) ((FB_UINT64) value + (FB_UINT64) arg);
+
+			if (((value ^ sum) & (arg ^ sum)) < 0)
+				return false;
+
+			value = sum;
+		}
+	}
+
+	return true;
+}
+
 dsc* ArithmeticNode::add(thread_db* tdbb, const dsc* desc1, const dsc* desc2, impure_value* value,
 	const UCHAR blrOp, bool dialect1, SCHAR nodScale, USHORT nodFlags)
 {
@@ -7065,6 +7190,7 @@ ValueExprNode* FieldNode::pass2(thread_db* tdbb, CompilerScratch* csb)
 
 	// SMB_SET uses ULONG, not USHORT
 	SBM_SET(tdbb->getDefaultPool(), &csb->csb_rpt[fieldStream].csb_fields, fieldId);
+	csb->csb_rpt[fieldStream].csb_data_refs++;
 
 	if (csb->csb_rpt[fieldStream].csb_relation || csb->csb_rpt[fieldStream].csb_procedure)
 		format = CMP_format(tdbb, csb, fieldStream);
@@ -7122,6 +7248,111 @@ dsc* FieldNode::execute(thread_db* tdbb, Request* request) const
 	return &impure->vlu_desc;
 }
 
+// Read the field of the batch rows. Records of different formats are left for the row mode.
+bool FieldNode::executeBatch(thread_db* /*tdbb*/, Request* /*request*/, const RecordBatch& batch,
+	BatchColumn& result) const
+{
+	FB_SIZE_T streamPos;
+
+	if (cursorNumber.has_value() || !batch.findStream(fieldStream, streamPos))
+		return false;
+
+	const ULONG count = batch.getCount();
+	const Format* recordFormat = nullptr;
+
+	for (ULONG i = 0; i < count; i++)
+	{
+		const Record* const record = batch.getRecord(batch.getRow(i), streamPos);
+
+		if (!record)
+			return false;
+
+		if (!recordFormat)
+			recordFormat = record->getFormat();
+		else if (record->getFormat() != recordFormat)
+			return false;
+	}
+
+	if (!recordFormat)
+	{
+		result.reset(BatchColumn::KIND_EXACT, 0, 0);
+		return true;
+	}
+
+	if ((format && recordFormat->fmt_version != format->fmt_version) ||
+		fieldId >= recordFormat->fmt_count)
+	{
+		return false;
+	}
+
+	const dsc& desc = recordFormat->fmt_desc[fieldId];
+
+	if (!desc.dsc_address)
+		return false;
+
+	switch (desc.dsc_dtype)
+	{
+		case dtype_short:
+		case dtype_long:
+		case dtype_int64:
+			result.reset(BatchColumn::KIND_EXACT, desc.dsc_scale, count);
+			break;
+
+		case dtype_double:
+			result.reset(BatchColumn::KIND_APPROX, 0, count);
+			break;
+
+		case dtype_boolean:
+			result.reset(BatchColumn::KIND_BOOLEAN, 0, count);
+			break;
+
+		default:
+			return false;
+	}
+
+	const IPTR offset = (IPTR) desc.dsc_address;
+
+	for (ULONG i = 0; i < count; i++)
+	{
+		const Record* const record = batch.getRecord(batch.getRow(i), streamPos);
+		BatchColumn::Value& value = result.values[i];
+
+		if (record->isNull(fieldId))
+		{
+			result.nulls[i] = 1;
+			value.exact = 0;
+			continue;
+		}
+
+		const UCHAR* const data = record->getData() + offset;
+
+		switch (desc.dsc_dtype)
+		{
+			case dtype_short:
+				value.exact = *(const SSHORT*) data;
+				break;
+
+			case dtype_long:
+				value.exact = *(const SLONG*) data;
+				break;
+
+			case dtype_int64:
+				value.exact = *(const SINT64*) data;
+				break;
+
+			case dtype_double:
+				memcpy(&value.approx, data, sizeof(double));
+				break;
+
+			case dtype_boolean:
+				value.exact = *data ? 1 : 0;
+				break;
+		}
+	}
+
+	return true;
+}
+
 
 //--------------------
 
@@ -8239,6 +8470,12 @@ dsc* LiteralNode::execute(thread_db* /*tdbb*/, Request* /*request*/) const
 	return const_cast<dsc*>(&litDesc);
 }
 
+bool LiteralNode::executeBatch(thread_db* tdbb, Request* /*request*/, const RecordBatch& batch,
+	BatchColumn& result) const
+{
+	return result.assign(tdbb, &litDesc, batch.getCount());
+}
+
 void LiteralNode::fixMinSInt64(MemoryPool& pool)
 {
 	// MIN_SINT64 should be stored as BIGINT, not 128-bit integer
@@ -10132,6 +10369,13 @@ dsc* ParameterNode::execute(thread_db* tdbb, Request* request) const
 	return isNull ? nullptr : retDesc;
 }
 
+// The parameter value is the same for all rows of the batch
+bool ParameterNode::executeBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+	BatchColumn& result) const
+{
+	return result.assign(tdbb, EVL_expr(tdbb, request, this), batch.getCount());
+}
+
 
 //--------------------
 
@@ -10562,6 +10806,13 @@ ValueExprNode* RecordKeyNode::pass2(thread_db* tdbb, CompilerScratch* csb)
 {
 	ValueExprNode::pass2(tdbb, csb);
 
+	// Record version is taken from the fetched record
+	if (blrOp != blr_dbkey)
+	{
+		csb->csb_rpt[recStream].csb_data_refs++;
+		csb->csb_rpt[recStream].csb_record_refs++;
+	}
+
 	dsc desc;
 	getDesc(tdbb, csb, &desc);
 	impureOffset = csb->allocImpure<impure_value>();
@@ -99,6 +99,8 @@ public:
 	bool sameAs(const ExprNode* other, bool ignoreStreams) const override;
 	ValueExprNode* pass2(thread_db* tdbb, CompilerScratch* csb) override;
 	dsc* execute(thread_db* tdbb, Request* request) const override;
+	bool executeBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+		BatchColumn& result) const override;
 
 	static dsc* add(thread_db* tdbb, const dsc* desc1, const dsc* desc2, impure_value* value,
 		const UCHAR blrOp, bool dialect1, SCHAR nodScale, USHORT nodFlags);
@@ -905,6 +907,8 @@ public:
 	ValueExprNode* pass1(thread_db* tdbb, CompilerScratch* csb) override;
 	ValueExprNode* pass2(thread_db* tdbb, CompilerScratch* csb) override;
 	dsc* execute(thread_db* tdbb, Request* request) const override;
+	bool executeBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+		BatchColumn& result) const override;
 
 private:
 	static dsql_fld* resolveContext(DsqlCompilerScratch* dsqlScratch,
@@ -1043,6 +1047,8 @@ public:
 	bool sameAs(const ExprNode* other, bool ignoreStreams) const override;
 	ValueExprNode* pass2(thread_db* tdbb, CompilerScratch* csb) override;
 	dsc* execute(thread_db* tdbb, Request* request) const override;
+	bool executeBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+		BatchColumn& result) const override;
 
 	bool getBoolean() const
 	{
@@ -1738,6 +1744,8 @@ public:
 	ParameterNode* pass1(thread_db* tdbb, CompilerScratch* csb) override;
 	ParameterNode* pass2(thread_db* tdbb, CompilerScratch* csb) override;
 	dsc* execute(thread_db* tdbb, Request* request) const override;
+	bool executeBatch(thread_db* tdbb, Request* request, const RecordBatch& batch,
+		BatchColumn& result) const override;
 
 public:
 	dsql_par* dsqlParameter = nullptr;
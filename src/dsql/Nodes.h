@@ -36,6 +36,7 @@
 namespace Jrd {
 
 class AggregateSort;
+class BatchColumn;
 class CompilerScratch;
 class SubQuery;
 class Cursor;
@@ -45,6 +46,7 @@ class ExprNode;
 class NodeRefsHolder;
 class Optimizer;
 class OptimizerRetrieval;
+class RecordBatch;
 class RecordSource;
 class RseNode;
 class SlidingWindow;
@@ -851,6 +853,17 @@ public:
 
 	BoolExprNode* copy(thread_db* tdbb, NodeCopier& copier) const override = 0;
 	virtual Firebird::TriState execute(thread_db* tdbb, Request* request) const = 0;
+
+	// Evaluate the boolean for the selected rows of the batch at once. False is returned
+	// if it cannot be done this way and every row should be evaluated with execute().
+	virtual bool executeBatch(thread_db* /*tdbb*/, Request* /*request*/,
+		const RecordBatch& /*batch*/, BatchColumn& /*result*/) const
+	{
+		return false;
+	}
+
+public:
+	double estimatedSelectivity = 0;	// estimated using the column statistics, zero if unknown
 };
 
 class ValueExprNode : public ExprNode
@@ -932,6 +945,14 @@ public:
 	ValueExprNode* copy(thread_db* tdbb, NodeCopier& copier) const override = 0;
 	virtual dsc* execute(thread_db* tdbb, Request* request) const = 0;
 
+	// Evaluate the expression for the selected rows of the batch at once. False is returned
+	// if it cannot be done this way and every row should be evaluated with execute().
+	virtual bool executeBatch(thread_db* /*tdbb*/, Request* /*request*/,
+		const RecordBatch& /*batch*/, BatchColumn& /*result*/) const
+	{
+		return false;
+	}
+
 public:
 	SCHAR nodScale = 0;
 
@@ -1006,6 +1027,8 @@ public:
 	static constexpr unsigned CAP_WANTS_AGG_CALLS		= 0x04;
 	// wants winPass call in a window
 	static constexpr unsigned CAP_WANTS_WIN_PASS_CALL	= 0x08;
+	// partial states may be combined, see aggSwapState and aggCombine
+	static constexpr unsigned CAP_COMBINABLE			= 0x10;
 
 protected:
 	struct AggInfo
@@ -1166,6 +1189,35 @@ public:
 	virtual void aggPass(thread_db* tdbb, Request* request, dsc* desc) const = 0;
 	virtual dsc* aggExecute(thread_db* tdbb, Request* request) const = 0;
 
+	// Partial aggregation. The running state of the aggregate is made of getStateCount()
+	// impure values which may be swapped out of the request, so many groups could be
+	// aggregated at once, and partial states of the same group merged later.
+
+	virtual unsigned getStateCount() const
+	{
+		return 1;
+	}
+
+	virtual void aggSwapState(Request* request, impure_value_ex* state) const;
+	virtual void aggCombine(thread_db* tdbb, Request* request, const impure_value_ex* state) const;
+
+	// Accumulate the selected rows of the batch at once. False means that
+	// aggPass() should be called for every row instead.
+	bool aggPassBatch(thread_db* tdbb, Request* request, const RecordBatch& batch) const;
+
+	// Compute the state of the selected rows of the batch, to be merged by aggCombine().
+	// The request is used by the argument only, so the parallel scan workers pass none.
+	virtual bool aggPartialBatch(thread_db* /*tdbb*/, Request* /*request*/, const RecordBatch& /*batch*/,
+		impure_value_ex* /*state*/) const
+	{
+		return false;
+	}
+
+	bool isCombinable() const
+	{
+		return (getCapabilities() & CAP_COMBINABLE) && !distinct && !sort && !indexed;
+	}
+
 	AggNode* dsqlPass(DsqlCompilerScratch* dsqlScratch) override;
 
 protected:
@@ -106,6 +106,7 @@ static RelationSourceNode* pass1Update(thread_db* tdbb, CompilerScratch* csb, jr
 	jrd_rel* view, StreamType viewStream, StreamType viewUpdateStream);
 static void pass1Validations(thread_db* tdbb, CompilerScratch* csb, Array<ValidateInfo>& validations);
 static ForNode* pass2FindForNode(StmtNode* node, StreamType stream);
+static bool pass2InsideLoop(const StmtNode* node);
 static void postTriggerAccess(CompilerScratch* csb, jrd_rel* ownerRelation,
 	ExternalAccess::exa_act operation, jrd_rel* view);
 static void preModifyEraseTriggers(thread_db* tdbb, Triggers& triggers,
@@ -6260,6 +6261,10 @@ StmtNode* ForNode::pass2(thread_db* tdbb, CompilerScratch* csb)
 	doPass2(tdbb, csb, statement.getAddress(), this);
 	csb->csb_current_for_nodes.pop();
 
+	// Unless some loop executes us repeatedly, the cursor is opened once per request execution
+	if (!pass2InsideLoop(this))
+		rse->flags |= RseNode::FLAG_READ_ONCE;
+
 	// Finish up processing of record selection expressions.
 
 	RecordSource* const rsb = CMP_post_rse(tdbb, csb, rse.getObject());
@@ -12759,6 +12764,18 @@ ForNode* pass2FindForNode(StmtNode* node, StreamType stream)
 	return nullptr;
 };
 
+// Check whether the statement may be executed repeatedly by an enclosing loop
+static bool pass2InsideLoop(const StmtNode* node)
+{
+	for (node = node->parentStmt; node; node = node->parentStmt)
+	{
+		if (nodeIs<ForNode>(node) || nodeIs<ForRangeNode>(node) || nodeIs<LoopNode>(node))
+			return true;
+	}
+
+	return false;
+}
+
 // Inherit access to triggers to be fired.
 //
 // When we detect that a trigger could be fired by a request,
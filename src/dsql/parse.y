@@ -708,6 +708,7 @@ using namespace Firebird;
 %token <metaNamePtr> BIN_OR_AGG
 %token <metaNamePtr> BIN_XOR_AGG
 %token <metaNamePtr> BTRIM
+%token <metaNamePtr> CACHE
 %token <metaNamePtr> CALL
 %token <metaNamePtr> CURRENT_SCHEMA
 %token <metaNamePtr> DOWNTO
@@ -1927,10 +1928,16 @@ index_definition($createIndexNode)
 
 %type index_column_expr(<createIndexNode>)
 index_column_expr($createIndexNode)
-	: column_list
-		{ $createIndexNode->columns = $1; }
-	| column_parens
-		{ $createIndexNode->columns = $1; }
+	: column_list index_include_opt
+		{
+			$createIndexNode->columns = $1;
+			$createIndexNode->includes = $2;
+		}
+	| column_parens index_include_opt
+		{
+			$createIndexNode->columns = $1;
+			$createIndexNode->includes = $2;
+		}
 	| computed_by '(' value ')'
 		{
  			$createIndexNode->computed = newNode<ValueSourceClause>();
@@ -1939,6 +1946,14 @@ index_column_expr($createIndexNode)
 		}
 	;
 
+%type <valueListNode> index_include_opt
+index_include_opt
+	: /* nothing */
+		{ $$ = nullptr; }
+	| INCLUDE column_parens
+		{ $$ = $2; }
+	;
+
 %type <boolSourceClause> index_condition_opt
 index_condition_opt
 	: /* nothing */
@@ -5211,6 +5226,8 @@ db_alter_clause($alterDatabaseNode)
 		{ $alterDatabaseNode->linger = $4; }
 	| DROP LINGER
 		{ $alterDatabaseNode->linger = 0; }
+	| SET PAGE CACHE long_integer
+		{ $alterDatabaseNode->pageCache = $4; }
 	| SET DEFAULT sql_security_clause
 		{ $alterDatabaseNode->ssDefiner = $3; }
 	| ENABLE PUBLICATION
@@ -6496,6 +6513,18 @@ table_list
 set_statistics
 	: SET STATISTICS INDEX symbol_index_name
 		{ $$ = newNode<SetStatisticsNode>(*$4); }
+	| SET STATISTICS TABLE symbol_table_name column_name_list_parens_opt
+		{
+			const auto node = newNode<SetTableStatisticsNode>(*$4);
+
+			if ($5)
+			{
+				for (const auto& column : *$5)
+					node->columns.add(column);
+			}
+
+			$$ = node;
+		}
 	;
 
 %type <ddlNode> comment
@@ -10482,6 +10511,7 @@ non_reserved_word
 	| BIN_AND_AGG
 	| BIN_OR_AGG
 	| BIN_XOR_AGG
+	| CACHE
 	| CONSTANT
 	| DOWNTO
 	| ERROR
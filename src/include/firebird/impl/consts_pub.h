@@ -138,6 +138,7 @@
 #define isc_dpb_search_path				 105
 #define isc_dpb_blr_request_search_path	 106
 #define isc_dpb_gbak_restore_has_schema	 107
+#define isc_dpb_page_cache				 108
 
 
 /**************************************************/
@@ -468,6 +469,7 @@
 #define isc_spb_prp_shutdown_mode		44
 #define isc_spb_prp_online_mode			45
 #define isc_spb_prp_replica_mode		46
+#define isc_spb_prp_page_cache			47
 
 /********************************************
  * Parameters for isc_spb_prp_shutdown_mode *
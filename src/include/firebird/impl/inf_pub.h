@@ -195,6 +195,9 @@ enum db_info_types
 	fb_info_counts_scope_att = 161,
 	fb_info_counts_scope_db = 162,
 
+	fb_info_page_cache_huge_page_size = 163,
+	fb_info_page_cache_nodes = 164,
+
 	isc_info_db_last_value   /* Leave this LAST! */
 };
 
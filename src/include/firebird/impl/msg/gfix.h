@@ -135,3 +135,4 @@ FB_IMPL_MSG_SYMBOL(GFIX, 134, gfix_opt_repl, "   -repl(ica)           replica mo
 FB_IMPL_MSG_SYMBOL(GFIX, 135, gfix_repl_mode_req, "replica mode (none / read_only / read_write) required")
 FB_IMPL_MSG_SYMBOL(GFIX, 136, gfix_opt_parallel, "   -par(allel)          parallel workers <n> (-sweep, -icu)")
 FB_IMPL_MSG_SYMBOL(GFIX, 137, gfix_opt_upgrade, "   -up(grade)           upgrade database ODS")
+FB_IMPL_MSG_SYMBOL(GFIX, 138, gfix_opt_page_cache, "   -ca(che)             resize page cache of running database <n>")
@@ -4332,6 +4332,7 @@ const
 	isc_dpb_search_path = byte(105);
 	isc_dpb_blr_request_search_path = byte(106);
 	isc_dpb_gbak_restore_has_schema = byte(107);
+	isc_dpb_page_cache = byte(108);
 	isc_dpb_address = byte(1);
 	isc_dpb_addr_protocol = byte(1);
 	isc_dpb_addr_endpoint = byte(2);
@@ -4522,6 +4523,7 @@ const
 	isc_spb_prp_shutdown_mode = byte(44);
 	isc_spb_prp_online_mode = byte(45);
 	isc_spb_prp_replica_mode = byte(46);
+	isc_spb_prp_page_cache = byte(47);
 	isc_spb_prp_sm_normal = byte(0);
 	isc_spb_prp_sm_multi = byte(1);
 	isc_spb_prp_sm_single = byte(2);
@@ -4804,6 +4806,8 @@ const
 	fb_info_max_inline_blob_size = byte(160);
 	fb_info_counts_scope_att = byte(161);
 	fb_info_counts_scope_db = byte(162);
+	fb_info_page_cache_huge_page_size = byte(163);
+	fb_info_page_cache_nodes = byte(164);
 	fb_info_crypt_encrypted = $01;
 	fb_info_crypt_process = $02;
 	fb_feature_multi_statements = byte(1);
@@ -63,7 +63,7 @@ SSHORT	ISQL_get_char_length(
 	SSHORT fieldLength,
 	SSHORT characterLengthNull, SSHORT characterLength,
 	SSHORT characterSetIdNull, SSHORT characterSetId);
-SLONG	ISQL_get_index_segments(TEXT*, const size_t, const Firebird::QualifiedMetaString&);
+SLONG	ISQL_get_index_segments(TEXT*, const size_t, const Firebird::QualifiedMetaString&, bool = false);
 bool	ISQL_get_null_flag(const Firebird::QualifiedMetaString&, const Firebird::MetaString&);
 void	ISQL_get_version(bool);
 SSHORT	ISQL_init(FILE*, FILE*);
@@ -0,0 +1,149 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		BCBHashTable.cpp
+ *	DESCRIPTION:	Hash table of the page buffers of disk cache manager
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created for the Firebird Open Source RDBMS project.
+ *
+ *  Copyright (c) 2026 the Firebird Project and all contributors signed below.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ *
+ */
+
+#include "firebird.h"
+#include "../jrd/BCBHashTable.h"
+
+#ifdef HASH_USE_CDS_LIST
+#include "../common/classes/init.h"
+#include "../jrd/InitCDSLib.h"
+#endif
+
+using namespace Firebird;
+
+namespace Jrd
+{
+
+static const ULONG MAX_SLOTS = 1u << 31;
+
+
+void BCBHashTable::resize(ULONG count)
+{
+	const ULONG old_count = m_count;
+	chain_type* const old_chains = m_chains;
+
+	// round number of slots up to the power of 2
+	ULONG slots = 1;
+	while (slots < count && slots < MAX_SLOTS)
+		slots <<= 1;
+
+	count = slots;
+
+	chain_type* new_chains = FB_NEW_POOL(m_pool) chain_type[count];
+	m_count = count;
+	m_mask = count - 1;
+	m_chains = new_chains;
+
+#ifndef HASH_USE_CDS_LIST
+	// Initialize all new new_chains
+	for (chain_type* que = new_chains; que < new_chains + count; que++)
+		QUE_INIT(*que);
+#endif
+
+	if (!old_chains)
+		return;
+
+	const chain_type* const old_end = old_chains + old_count;
+
+	// Move any active buffers from old hash table to new
+	for (chain_type* old_tail = old_chains; old_tail < old_end; old_tail++)
+	{
+#ifndef HASH_USE_CDS_LIST
+		while (QUE_NOT_EMPTY(*old_tail))
+		{
+			QUE que_inst = old_tail->que_forward;
+			BufferDesc* bdb = chainBdb(que_inst);
+			QUE_DELETE(*que_inst);
+			QUE mod_que = &new_chains[hash(bdb->bdb_page)];
+			QUE_INSERT(*mod_que, *que_inst);
+		}
+#else
+		while (!old_tail->empty())
+		{
+			auto n = old_tail->begin();
+			old_tail->erase(n->first);				// bdb_page
+
+			chain_type* new_chain = &m_chains[hash(n->first)];
+			new_chain->insert(n->first, n->second);	// bdb_page, bdb
+		}
+#endif
+	}
+
+	delete[] old_chains;
+}
+
+void BCBHashTable::clear()
+{
+	if (!m_chains)
+		return;
+
+#ifdef HASH_USE_CDS_LIST
+	const chain_type* const end = m_chains + m_count;
+	for (chain_type* tail = m_chains; tail < end; tail++)
+		tail->clear();
+#endif
+
+	delete[] m_chains;
+	m_chains = nullptr;
+	m_count = 0;
+	m_mask = 0;
+}
+
+void BCBHashTable::remove(BufferDesc* bdb)
+{
+#ifndef HASH_USE_CDS_LIST
+	QUE_DELETE(bdb->bdb_que);
+#else
+	BdbList& list = m_chains[hash(bdb->bdb_page)];
+
+#ifdef DEV_BUILD
+	auto p = list.get(bdb->bdb_page);
+	fb_assert(!p.empty() && p->first == bdb->bdb_page && p->second == bdb);
+#endif
+
+	list.erase(bdb->bdb_page);
+#endif
+}
+
+
+#ifdef HASH_USE_CDS_LIST
+
+static InitInstance<InitPool> initPool;
+
+
+void* ListNodePool::allocate(std::size_t size)
+{
+	return initPool().alloc(size);
+}
+
+void ListNodePool::deallocate(void* p)
+{
+	// It uses the correct pool stored within memory block itself
+	MemoryPool::globalFree(p);
+}
+
+#endif // HASH_USE_CDS_LIST
+
+} // namespace Jrd
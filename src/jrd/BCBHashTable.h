@@ -0,0 +1,268 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		BCBHashTable.h
+ *	DESCRIPTION:	Hash table of the page buffers of disk cache manager
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created for the Firebird Open Source RDBMS project.
+ *
+ *  Copyright (c) 2026 the Firebird Project and all contributors signed below.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ *
+ */
+
+#ifndef JRD_BCB_HASH_TABLE_H
+#define JRD_BCB_HASH_TABLE_H
+
+#include "../common/classes/alloc.h"
+#include "../jrd/que.h"
+#include "../jrd/cch.h"
+
+#ifndef CDS_UNAVAILABLE
+// Use lock-free lists in hash table implementation
+#define HASH_USE_CDS_LIST
+#endif
+
+#ifdef HASH_USE_CDS_LIST
+#include <cds/container/michael_kvlist_dhp.h>
+#endif
+
+
+namespace Jrd
+{
+
+#ifdef HASH_USE_CDS_LIST
+
+// Allocates list nodes from the memory pool that lives until libcds is finished
+
+class ListNodePool
+{
+protected:
+	static void* allocate(std::size_t size);
+	static void deallocate(void* p);
+};
+
+template <typename T>
+class ListNodeAllocator : private ListNodePool
+{
+public:
+	typedef T value_type;
+
+	ListNodeAllocator() {};
+
+	template <class U>
+	constexpr ListNodeAllocator(const ListNodeAllocator<U>&) noexcept {}
+
+	T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(ListNodePool::allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T* p, std::size_t /* n */)
+	{
+		ListNodePool::deallocate(p);
+	}
+};
+
+struct BdbTraits : public cds::container::michael_list::traits
+{
+	typedef ListNodeAllocator<int> allocator;
+	//typedef std::less<PageNumber> compare;
+};
+
+typedef cds::container::MichaelKVList<cds::gc::DHP, PageNumber, BufferDesc*, BdbTraits> BdbList;
+
+#endif // HASH_USE_CDS_LIST
+
+
+// Maps page number to the page buffer. When libcds is available, lookups
+// and modifications are lock-free, otherwise caller should guard the table
+// by bcb_syncObject.
+
+class BCBHashTable
+{
+#ifdef HASH_USE_CDS_LIST
+	using chain_type = BdbList;
+#else
+	using chain_type = que;
+#endif
+
+public:
+	BCBHashTable(MemoryPool& pool, ULONG count) :
+		m_pool(pool),
+		m_count(0),
+		m_mask(0),
+		m_chains(nullptr)
+	{
+		resize(count);
+	}
+
+	~BCBHashTable()
+	{
+		clear();
+	}
+
+	void resize(ULONG count);
+	void clear();
+
+	BufferDesc* find(const PageNumber& page) const;
+
+	// tries to put bdb into hash slot by page
+	// if succeed, removes bdb from old slot, if necessary, and returns NULL
+	// else, returns BufferDesc that is currently occupies target slot
+	BufferDesc* emplace(BufferDesc* bdb, const PageNumber& page, bool remove);
+
+	void remove(BufferDesc* bdb);
+
+private:
+	// Number of slots is a power of 2, thus slot is found without division.
+	// Consecutive pages go into different slots, while pages of different
+	// page spaces with the same number are spread over the table too.
+	ULONG hash(const PageNumber& pageno) const
+	{
+		return (pageno.getPageNum() + pageno.getPageSpaceID() * 0x9E3779B1u) & m_mask;
+	}
+
+#ifndef HASH_USE_CDS_LIST
+	static BufferDesc* chainBdb(que* que_inst)
+	{
+		return reinterpret_cast<BufferDesc*>((SCHAR*) que_inst - offsetof(BufferDesc, bdb_que));
+	}
+#endif
+
+	MemoryPool& m_pool;
+	ULONG m_count;
+	ULONG m_mask;
+	chain_type* m_chains;
+};
+
+
+inline BufferDesc* BCBHashTable::find(const PageNumber& page) const
+{
+	auto& list = m_chains[hash(page)];
+
+#ifndef HASH_USE_CDS_LIST
+	QUE que_inst = list.que_forward;
+	for (; que_inst != &list; que_inst = que_inst->que_forward)
+	{
+		BufferDesc* bdb = chainBdb(que_inst);
+		if (bdb->bdb_page == page)
+			return bdb;
+	}
+
+#else // HASH_USE_CDS_LIST
+	auto ptr = list.get(page);
+	if (!ptr.empty())
+	{
+		fb_assert(ptr->second != nullptr);
+#ifdef DEV_BUILD
+		// Original libcds have no update(key, value), use this code with it,
+		// see also comment in get_buffer()
+		while (ptr->second == nullptr)
+			cds::backoff::pause();
+#endif
+		if (ptr->second->bdb_page == page)
+			return ptr->second;
+	}
+#endif
+
+	return nullptr;
+}
+
+inline BufferDesc* BCBHashTable::emplace(BufferDesc* bdb, const PageNumber& page, bool remove)
+{
+#ifndef HASH_USE_CDS_LIST
+	// bcb_syncObject should be locked in EX mode
+
+	BufferDesc* bdb2 = find(page);
+	if (!bdb2)
+	{
+		if (remove)
+			QUE_DELETE(bdb->bdb_que);
+
+		que& mod_que = m_chains[hash(page)];
+		QUE_INSERT(mod_que, bdb->bdb_que);
+	}
+	return bdb2;
+#else // HASH_USE_CDS_LIST
+
+	BufferDesc* bdb2 = nullptr;
+	BdbList& list = m_chains[hash(page)];
+
+/*
+	// Original libcds have no update(key, value), use this code with it
+
+	auto ret = list.update(page, [bdb, &bdb2](bool bNew, BdbList::value_type& val)
+		{
+			if (bNew)
+				val.second = bdb;
+			else
+				while (!(bdb2 = val.second))
+					cds::backoff::pause();
+		},
+		true);
+*/
+
+	auto ret = list.update(page, bdb, [&bdb2](bool bNew, BdbList::value_type& val)
+		{
+			// someone might have put a page buffer in the chain concurrently, so
+			// we store it for the further investigation
+			if (!bNew)
+				bdb2 = val.second;
+		},
+		true);
+	fb_assert(ret.first);
+
+	// if we have inserted the page buffer that we found (empty or oldest)
+	if (bdb2 == nullptr)
+	{
+		fb_assert(ret.second);
+#ifdef DEV_BUILD
+		auto p1 = list.get(page);
+		fb_assert(!p1.empty() && p1->first == page && p1->second == bdb);
+#endif
+
+		if (remove)
+		{
+			// remove the page buffer from old hash slot
+			const PageNumber oldPage = bdb->bdb_page;
+			BdbList& oldList = m_chains[hash(oldPage)];
+
+#ifdef DEV_BUILD
+			p1 = oldList.get(oldPage);
+			fb_assert(!p1.empty() && p1->first == oldPage && p1->second == bdb);
+#endif
+
+			const bool ok = oldList.erase(oldPage);
+			fb_assert(ok);
+
+#ifdef DEV_BUILD
+			p1 = oldList.get(oldPage);
+			fb_assert(p1.empty() || p1->second != bdb);
+#endif
+		}
+
+#ifdef DEV_BUILD
+		p1 = list.get(page);
+		fb_assert(!p1.empty() && p1->first == page && p1->second == bdb);
+#endif
+	}
+	return bdb2;
+#endif
+}
+
+} // namespace Jrd
+
+#endif // JRD_BCB_HASH_TABLE_H
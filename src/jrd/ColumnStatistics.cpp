@@ -0,0 +1,614 @@
+/*
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created for the Firebird Open Source RDBMS project.
+ *
+ *  Copyright (c) 2026 the Firebird Project and all contributors signed below.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../jrd/jrd.h"
+#include "../jrd/req.h"
+#include "../jrd/tra.h"
+#include "../jrd/val.h"
+#include "../jrd/dpm_proto.h"
+#include "../jrd/evl_proto.h"
+#include "../jrd/met_proto.h"
+#include "../jrd/mov_proto.h"
+#include "../jrd/vio_proto.h"
+#include "../jrd/ColumnStatistics.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace Firebird;
+using namespace Jrd;
+
+namespace
+{
+	constexpr UCHAR STATISTICS_VERSION = 1;
+
+	constexpr ULONG SAMPLE_ROWS = 10000;		// rows kept in the sample
+	constexpr ULONG SAMPLE_PAGES = 3000;		// data pages read to collect the sample
+	constexpr ULONG MAX_MCV_COUNT = 100;		// most common values to be stored
+	constexpr ULONG MAX_BUCKET_COUNT = 100;		// histogram buckets to be stored
+	constexpr USHORT MAX_VALUE_LENGTH = 1024;	// longer values are not sampled
+
+	// Sampled values of a single column
+
+	struct ColumnSample
+	{
+		explicit ColumnSample(MemoryPool& p)
+			: values(p), nulls(p)
+		{}
+
+		USHORT fieldId = 0;
+		dsc format;
+		UCharBuffer values;
+		UCharBuffer nulls;
+
+		UCHAR* getAddress(ULONG slot)
+		{
+			return values.begin() + slot * format.dsc_length;
+		}
+	};
+
+	// Group of equal values inside the sorted sample
+
+	struct ValueGroup
+	{
+		ULONG position;
+		ULONG count;
+	};
+
+	template <typename T>
+	void writeValue(UCharBuffer& buffer, const T& value)
+	{
+		buffer.add(reinterpret_cast<const UCHAR*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	bool readValue(const UCHAR*& ptr, const UCHAR* end, T& value)
+	{
+		if (end - ptr < (ptrdiff_t) sizeof(T))
+			return false;
+
+		memcpy(&value, ptr, sizeof(T));
+		ptr += sizeof(T);
+		return true;
+	}
+}
+
+
+// Compare the value against the most common ones and estimate its frequency
+
+double ColumnStatistics::getEqualitySelectivity(thread_db* tdbb, const dsc* value) const
+{
+	for (ULONG i = 0; i < mcvCount; i++)
+	{
+		dsc desc = getValue(i);
+
+		if (!MOV_compare(tdbb, &desc, value))
+			return adjust(frequencies[i]);
+	}
+
+	// Not a common value, assume the uniform distribution of the remaining ones
+
+	const double remainingCount = distinctCount - mcvCount;
+
+	if (remainingCount < 1 || !boundCount)
+		return adjust(0);
+
+	return adjust(histogramFraction / remainingCount);
+}
+
+// Estimate the fraction of values between the given bounds
+
+double ColumnStatistics::getRangeSelectivity(thread_db* tdbb, const dsc* lower, bool lowerInclusive,
+	const dsc* upper, bool upperInclusive) const
+{
+	double selectivity = 0;
+
+	for (ULONG i = 0; i < mcvCount; i++)
+	{
+		dsc desc = getValue(i);
+
+		if (lower)
+		{
+			const auto result = MOV_compare(tdbb, &desc, lower);
+
+			if (result < 0 || (!result && !lowerInclusive))
+				continue;
+		}
+
+		if (upper)
+		{
+			const auto result = MOV_compare(tdbb, &desc, upper);
+
+			if (result > 0 || (!result && !upperInclusive))
+				continue;
+		}
+
+		selectivity += frequencies[i];
+	}
+
+	if (boundCount > 1)
+	{
+		const auto lowerFraction = lower ? getFraction(tdbb, lower) : 0;
+		const auto upperFraction = upper ? getFraction(tdbb, upper) : MAXIMUM_FRACTION;
+
+		if (upperFraction > lowerFraction)
+			selectivity += histogramFraction * (upperFraction - lowerFraction);
+	}
+
+	return adjust(selectivity);
+}
+
+// Estimate the selectivity of the equi-join condition between two columns
+
+double ColumnStatistics::getJoinSelectivity(const ColumnStatistics& other) const
+{
+	const auto selectivity = (MAXIMUM_FRACTION - nullFraction) * (MAXIMUM_FRACTION - other.nullFraction) /
+		MAX(distinctCount, other.distinctCount);
+
+	return adjust(selectivity);
+}
+
+// Parse the stored statistics, they're usable only if match the current column format
+
+bool ColumnStatistics::parse(USHORT id, const dsc* desc, const UCHAR* data, ULONG length)
+{
+	const UCHAR* ptr = data;
+	const UCHAR* const end = data + length;
+
+	UCHAR version;
+	if (!readValue(ptr, end, version) || version != STATISTICS_VERSION)
+		return false;
+
+	format.clear();
+
+	if (!readValue(ptr, end, format.dsc_dtype) ||
+		!readValue(ptr, end, format.dsc_scale) ||
+		!readValue(ptr, end, format.dsc_length) ||
+		!readValue(ptr, end, format.dsc_sub_type))
+	{
+		return false;
+	}
+
+	if (format.dsc_dtype != desc->dsc_dtype ||
+		format.dsc_scale != desc->dsc_scale ||
+		format.dsc_length != desc->dsc_length ||
+		format.dsc_sub_type != desc->dsc_sub_type)
+	{
+		return false;
+	}
+
+	if (!readValue(ptr, end, rowCount) ||
+		!readValue(ptr, end, nullFraction) ||
+		!readValue(ptr, end, distinctCount) ||
+		!readValue(ptr, end, mcvCount) ||
+		!readValue(ptr, end, boundCount))
+	{
+		return false;
+	}
+
+	if (distinctCount < 1 || mcvCount > MAX_MCV_COUNT || boundCount > MAX_BUCKET_COUNT + 1)
+		return false;
+
+	histogramFraction = MAXIMUM_FRACTION - nullFraction;
+
+	frequencies.clear();
+
+	for (ULONG i = 0; i < mcvCount; i++)
+	{
+		double frequency;
+		if (!readValue(ptr, end, frequency))
+			return false;
+
+		frequencies.add(frequency);
+		histogramFraction -= frequency;
+	}
+
+	histogramFraction = MAX(histogramFraction, 0.0);
+
+	const ULONG valuesLength = (mcvCount + boundCount) * format.dsc_length;
+
+	if ((ULONG) (end - ptr) != valuesLength)
+		return false;
+
+	values.assign(ptr, valuesLength);
+	fieldId = id;
+
+	return true;
+}
+
+void ColumnStatistics::serialize(UCharBuffer& buffer) const
+{
+	buffer.clear();
+
+	writeValue(buffer, STATISTICS_VERSION);
+	writeValue(buffer, format.dsc_dtype);
+	writeValue(buffer, format.dsc_scale);
+	writeValue(buffer, format.dsc_length);
+	writeValue(buffer, format.dsc_sub_type);
+	writeValue(buffer, rowCount);
+	writeValue(buffer, nullFraction);
+	writeValue(buffer, distinctCount);
+	writeValue(buffer, mcvCount);
+	writeValue(buffer, boundCount);
+
+	for (const auto frequency : frequencies)
+		writeValue(buffer, frequency);
+
+	buffer.add(values.begin(), values.getCount());
+}
+
+// Check whether the column can be analyzed
+
+bool ColumnStatistics::isSupported(const dsc* desc)
+{
+	return desc->dsc_dtype && !DTYPE_IS_BLOB_OR_QUAD(desc->dsc_dtype) &&
+		desc->dsc_dtype != dtype_dbkey && desc->dsc_length <= MAX_VALUE_LENGTH;
+}
+
+// Collect the statistics of the given columns by sampling the table. Data pages
+// are picked randomly, all rows from them are sampled using the reservoir method.
+
+void ColumnStatistics::collect(thread_db* tdbb, jrd_tra* transaction, jrd_rel* relation,
+	const SortedArray<USHORT>& fieldIds, ColumnStatisticsList& result)
+{
+	SET_TDBB(tdbb);
+	const auto dbb = tdbb->getDatabase();
+	auto& pool = *tdbb->getDefaultPool();
+
+	const auto format = relation->currentFormat(tdbb);
+
+	ObjectsArray<ColumnSample> samples;
+
+	for (const auto id : fieldIds)
+	{
+		if (id >= format->fmt_count || !isSupported(&format->fmt_desc[id]))
+			continue;
+
+		auto& sample = samples.add();
+		sample.fieldId = id;
+		sample.format = format->fmt_desc[id];
+		sample.format.dsc_address = nullptr;
+		sample.format.dsc_flags = 0;
+	}
+
+	if (samples.isEmpty())
+		return;
+
+	const ULONG dataPages = DPM_data_pages(tdbb, relation->getPermanent());
+	const double pageFraction = dataPages > SAMPLE_PAGES ? (double) SAMPLE_PAGES / dataPages : 1.0;
+
+	// Fixed seed makes the sample (and thus the plans) reproducible
+	std::mt19937 generator(dataPages);
+	std::uniform_real_distribution<double> pageDistribution(0.0, 1.0);
+
+	record_param rpb;
+	rpb.rpb_relation = relation;
+	rpb.rpb_number.setValue(BOF_NUMBER);
+
+	FB_UINT64 rowsSeen = 0;
+	ULONG sampleRows = 0;
+	SINT64 currentPage = -1;
+	bool pagePicked = true;
+
+	try
+	{
+		while (VIO_next_record(tdbb, &rpb, transaction, &pool, DPM_next_all))
+		{
+			JRD_reschedule(tdbb);
+
+			const SINT64 pageSequence = rpb.rpb_number.getValue() / dbb->dbb_max_records;
+
+			if (pageSequence != currentPage)
+			{
+				currentPage = pageSequence;
+				pagePicked = (pageFraction >= 1.0 || pageDistribution(generator) < pageFraction);
+			}
+
+			if (!pagePicked)
+			{
+				// Skip the rest of the data page
+				rpb.rpb_number.setValue((pageSequence + 1) * dbb->dbb_max_records - 1);
+				continue;
+			}
+
+			FB_UINT64 slot = sampleRows;
+
+			if (sampleRows == SAMPLE_ROWS)
+				slot = std::uniform_int_distribution<FB_UINT64>(0, rowsSeen)(generator);
+			else
+				sampleRows++;
+
+			rowsSeen++;
+
+			if (slot >= SAMPLE_ROWS)
+				continue;
+
+			for (auto& sample : samples)
+			{
+				const auto length = sample.format.dsc_length;
+
+				if (sample.nulls.getCount() < sampleRows)
+				{
+					sample.nulls.grow(sampleRows);
+					sample.values.grow(sampleRows * length);
+				}
+
+				dsc from;
+
+				if (!EVL_field(relation, rpb.rpb_record, sample.fieldId, &from))
+				{
+					sample.nulls[slot] = 1;
+					continue;
+				}
+
+				dsc to = sample.format;
+				to.dsc_address = sample.getAddress(slot);
+				memset(to.dsc_address, 0, length);
+				MOV_move(tdbb, &from, &to);
+				sample.nulls[slot] = 0;
+			}
+		}
+	}
+	catch (const Exception&)
+	{
+		delete rpb.rpb_record;
+		throw;
+	}
+
+	delete rpb.rpb_record;
+
+	if (!sampleRows)
+		return;
+
+	const double rowCount = MAX(rowsSeen / pageFraction, (double) sampleRows);
+
+	for (auto& sample : samples)
+	{
+		result.add().build(tdbb, sample.fieldId, &sample.format, sample.values.begin(),
+			sample.nulls.begin(), sampleRows, rowCount);
+	}
+}
+
+// Build the statistics from the sampled values of the column
+
+void ColumnStatistics::build(thread_db* tdbb, USHORT id, const dsc* desc, const UCHAR* sampleValues,
+	const UCHAR* sampleNulls, ULONG sampleRows, double cardinality)
+{
+	fb_assert(sampleRows);
+
+	fieldId = id;
+	format = *desc;
+	rowCount = cardinality;
+
+	const auto length = format.dsc_length;
+
+	const auto getSampleValue = [&](ULONG slot)
+	{
+		dsc value = format;
+		value.dsc_address = const_cast<UCHAR*>(sampleValues) + slot * length;
+		return value;
+	};
+
+	Array<ULONG> slots;
+	slots.ensureCapacity(sampleRows);
+
+	for (ULONG slot = 0; slot < sampleRows; slot++)
+	{
+		if (!sampleNulls[slot])
+			slots.add(slot);
+	}
+
+	const ULONG nonNullRows = slots.getCount();
+	nullFraction = (double) (sampleRows - nonNullRows) / sampleRows;
+
+	std::sort(slots.begin(), slots.end(), [&](ULONG slot1, ULONG slot2)
+	{
+		dsc value1 = getSampleValue(slot1);
+		dsc value2 = getSampleValue(slot2);
+		return MOV_compare(tdbb, &value1, &value2) < 0;
+	});
+
+	// Find groups of equal values
+
+	Array<ValueGroup> groups;
+	ULONG singletons = 0;
+
+	for (ULONG pos = 0; pos < nonNullRows; )
+	{
+		dsc value1 = getSampleValue(slots[pos]);
+		ULONG next = pos + 1;
+
+		while (next < nonNullRows)
+		{
+			dsc value2 = getSampleValue(slots[next]);
+
+			if (MOV_compare(tdbb, &value1, &value2))
+				break;
+
+			next++;
+		}
+
+		groups.add({pos, next - pos});
+
+		if (next - pos == 1)
+			singletons++;
+
+		pos = next;
+	}
+
+	// Estimate the number of distinct values in the whole table (Duj1 estimator)
+
+	const double sampled = nonNullRows;
+	const double total = MAX(rowCount * (MAXIMUM_FRACTION - nullFraction), sampled);
+
+	distinctCount = groups.getCount();
+
+	if (singletons)
+		distinctCount = sampled * distinctCount / (sampled - singletons + singletons * sampled / total);
+
+	distinctCount = MAX(MIN(distinctCount, total), (double) groups.getCount());
+	distinctCount = MAX(distinctCount, MAXIMUM_FRACTION);
+
+	// Pick the most common values. If all of them seem to be sampled,
+	// they're all stored and no histogram is needed.
+
+	Array<ULONG> mcvGroups;
+
+	if (!singletons && groups.getCount() <= MAX_MCV_COUNT)
+	{
+		for (ULONG i = 0; i < groups.getCount(); i++)
+			mcvGroups.add(i);
+	}
+	else if (groups.hasData())
+	{
+		const double minCount = MAX(sampled / groups.getCount() * 1.25, 2.0);
+
+		for (ULONG i = 0; i < groups.getCount(); i++)
+		{
+			if (groups[i].count >= minCount)
+				mcvGroups.add(i);
+		}
+
+		std::sort(mcvGroups.begin(), mcvGroups.end(), [&](ULONG group1, ULONG group2)
+		{
+			return groups[group1].count > groups[group2].count;
+		});
+
+		if (mcvGroups.getCount() > MAX_MCV_COUNT)
+			mcvGroups.shrink(MAX_MCV_COUNT);
+
+		std::sort(mcvGroups.begin(), mcvGroups.end());
+	}
+
+	// Build the equi-depth histogram over the remaining values
+
+	Array<ULONG> remaining;
+	FB_SIZE_T mcvIndex = 0;
+
+	for (ULONG i = 0; i < groups.getCount(); i++)
+	{
+		if (mcvIndex < mcvGroups.getCount() && mcvGroups[mcvIndex] == i)
+		{
+			mcvIndex++;
+			continue;
+		}
+
+		const auto& group = groups[i];
+
+		for (ULONG pos = group.position; pos < group.position + group.count; pos++)
+			remaining.add(slots[pos]);
+	}
+
+	Array<ULONG> bounds;
+
+	if (remaining.getCount() > 1)
+	{
+		const ULONG bucketCount = MIN(MAX_BUCKET_COUNT, remaining.getCount() - 1);
+
+		for (ULONG i = 0; i <= bucketCount; i++)
+			bounds.add(remaining[(ULONG) ((FB_UINT64) i * (remaining.getCount() - 1) / bucketCount)]);
+	}
+
+	// Store the most common values followed by the histogram bounds
+
+	mcvCount = mcvGroups.getCount();
+	boundCount = bounds.getCount();
+
+	frequencies.clear();
+	values.clear();
+	histogramFraction = MAXIMUM_FRACTION - nullFraction;
+
+	for (const auto group : mcvGroups)
+	{
+		const double frequency = (double) groups[group].count / sampleRows;
+		frequencies.add(frequency);
+		histogramFraction -= frequency;
+
+		values.add(sampleValues + slots[groups[group].position] * length, length);
+	}
+
+	histogramFraction = MAX(histogramFraction, 0.0);
+
+	for (const auto slot : bounds)
+		values.add(sampleValues + slot * length, length);
+}
+
+dsc ColumnStatistics::getValue(ULONG index) const
+{
+	fb_assert(index < mcvCount + boundCount);
+
+	dsc desc = format;
+	desc.dsc_address = const_cast<UCHAR*>(values.begin()) + index * format.dsc_length;
+	return desc;
+}
+
+// Estimate the fraction of the histogram values being less than the given one
+
+double ColumnStatistics::getFraction(thread_db* tdbb, const dsc* value) const
+{
+	fb_assert(boundCount > 1);
+
+	const ULONG bucketCount = boundCount - 1;
+
+	dsc first = getValue(mcvCount);
+	if (MOV_compare(tdbb, value, &first) <= 0)
+		return 0;
+
+	dsc last = getValue(mcvCount + bucketCount);
+	if (MOV_compare(tdbb, value, &last) >= 0)
+		return MAXIMUM_FRACTION;
+
+	// Find the bucket containing the value
+
+	ULONG low = 0, high = bucketCount;
+
+	while (high - low > 1)
+	{
+		const ULONG middle = (low + high) / 2;
+		dsc bound = getValue(mcvCount + middle);
+
+		if (MOV_compare(tdbb, &bound, value) <= 0)
+			low = middle;
+		else
+			high = middle;
+	}
+
+	// Interpolate inside the bucket, if possible
+
+	double part = 0.5;
+
+	if (DTYPE_IS_NUMERIC(format.dsc_dtype) && DTYPE_IS_NUMERIC(value->dsc_dtype))
+	{
+		dsc lowBound = getValue(mcvCount + low);
+		dsc highBound = getValue(mcvCount + high);
+
+		const double lowValue = MOV_get_double(tdbb, &lowBound);
+		const double highValue = MOV_get_double(tdbb, &highBound);
+
+		if (highValue > lowValue)
+		{
+			part = (MOV_get_double(tdbb, value) - lowValue) / (highValue - lowValue);
+			part = MAX(MIN(part, MAXIMUM_FRACTION), 0.0);
+		}
+	}
+
+	return (low + part) / bucketCount;
+}
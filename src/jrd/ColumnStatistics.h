@@ -0,0 +1,126 @@
+/*
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created for the Firebird Open Source RDBMS project.
+ *
+ *  Copyright (c) 2026 the Firebird Project and all contributors signed below.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#ifndef JRD_COLUMN_STATISTICS_H
+#define JRD_COLUMN_STATISTICS_H
+
+#include "../common/classes/alloc.h"
+#include "../common/classes/array.h"
+#include "../common/classes/objects_array.h"
+#include "../common/dsc.h"
+
+namespace Jrd {
+
+class thread_db;
+class jrd_rel;
+class jrd_tra;
+class ColumnStatisticsList;
+
+// Value distribution of a table column, stored in RDB$COLUMN_STATISTICS.
+// It consists of the most common values with their frequencies and
+// the equi-depth histogram built over the remaining values.
+
+class ColumnStatistics
+{
+public:
+	explicit ColumnStatistics(MemoryPool& p)
+		: frequencies(p), values(p)
+	{}
+
+	USHORT getFieldId() const
+	{
+		return fieldId;
+	}
+
+	double getRowCount() const
+	{
+		return rowCount;
+	}
+
+	double getNullSelectivity() const
+	{
+		return adjust(nullFraction);
+	}
+
+	double getAverageSelectivity() const
+	{
+		return adjust((MAXIMUM_FRACTION - nullFraction) / distinctCount);
+	}
+
+	double getEqualitySelectivity(thread_db* tdbb, const dsc* value) const;
+	double getRangeSelectivity(thread_db* tdbb, const dsc* lower, bool lowerInclusive,
+		const dsc* upper, bool upperInclusive) const;
+	double getJoinSelectivity(const ColumnStatistics& other) const;
+
+	bool parse(USHORT id, const dsc* desc, const UCHAR* data, ULONG length);
+	void serialize(Firebird::UCharBuffer& buffer) const;
+
+	static bool isSupported(const dsc* desc);
+	static void collect(thread_db* tdbb, jrd_tra* transaction, jrd_rel* relation,
+		const Firebird::SortedArray<USHORT>& fieldIds, ColumnStatisticsList& result);
+
+private:
+	static constexpr double MAXIMUM_FRACTION = 1.0;
+
+	void build(thread_db* tdbb, USHORT id, const dsc* desc, const UCHAR* sampleValues,
+		const UCHAR* sampleNulls, ULONG sampleRows, double cardinality);
+	dsc getValue(ULONG index) const;
+	double getFraction(thread_db* tdbb, const dsc* value) const;
+
+	double adjust(double selectivity) const
+	{
+		// Never estimate less than a single row
+		return MAX(selectivity, MAXIMUM_FRACTION / MAX(rowCount, MAXIMUM_FRACTION));
+	}
+
+	USHORT fieldId = 0;
+	dsc format;								// format of the stored values
+	double rowCount = 0;					// table cardinality
+	double nullFraction = 0;				// fraction of NULLs
+	double distinctCount = 1;				// number of distinct values
+	double histogramFraction = 0;			// fraction of values covered by the histogram
+	ULONG mcvCount = 0;						// number of the most common values
+	ULONG boundCount = 0;					// number of the histogram bounds
+	Firebird::Array<double> frequencies;	// frequencies of the most common values
+	Firebird::UCharBuffer values;			// most common values followed by the histogram bounds
+};
+
+class ColumnStatisticsList : public Firebird::ObjectsArray<ColumnStatistics>
+{
+public:
+	explicit ColumnStatisticsList(MemoryPool& p)
+		: Firebird::ObjectsArray<ColumnStatistics>(p)
+	{}
+
+	const ColumnStatistics* find(USHORT fieldId) const
+	{
+		for (const auto& column : *this)
+		{
+			if (column.getFieldId() == fieldId)
+				return &column;
+		}
+
+		return nullptr;
+	}
+};
+
+} // namespace Jrd
+
+#endif // JRD_COLUMN_STATISTICS_H
@@ -0,0 +1,315 @@
+/*
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created for the Firebird Open Source RDBMS project.
+ *
+ *  Copyright (c) 2026 the Firebird Project and all contributors signed below.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../common/gdsassert.h"
+#include "../common/cvt.h"
+#include "../jrd/jrd.h"
+#include "../jrd/req.h"
+#include "../jrd/mov_proto.h"
+
+#include "../jrd/RecordBatch.h"
+
+using namespace Firebird;
+using namespace Jrd;
+
+
+// RecordBatch class
+// -----------------
+
+RecordBatch::RecordBatch(MemoryPool& pool, const StreamType* streams, FB_SIZE_T streamCount)
+	: PermanentStorage(pool),
+	  m_streams(pool),
+	  m_records(pool),
+	  m_numbers(pool),
+	  m_present(pool),
+	  m_selection(pool)
+{
+	m_streams.add(streams, streamCount);
+
+	const FB_SIZE_T slots = CAPACITY * streamCount;
+
+	m_records.resize(slots);
+	memset(m_records.begin(), 0, slots * sizeof(Record*));
+
+	m_numbers.resize(slots);
+	m_present.resize(slots);
+	m_selection.ensureCapacity(CAPACITY);
+}
+
+RecordBatch::~RecordBatch()
+{
+	for (auto record : m_records)
+		delete record;
+}
+
+bool RecordBatch::findStream(StreamType stream, FB_SIZE_T& pos) const
+{
+	for (pos = 0; pos < m_streams.getCount(); pos++)
+	{
+		if (m_streams[pos] == stream)
+			return true;
+	}
+
+	return false;
+}
+
+void RecordBatch::clear()
+{
+	m_selection.clear();
+	m_rows = 0;
+}
+
+// Append copies of the current records of the streams as a new row
+void RecordBatch::add(record_param* rpbs)
+{
+	fb_assert(!isFull());
+
+	FB_SIZE_T slot = m_rows * m_streams.getCount();
+
+	for (const auto stream : m_streams)
+	{
+		const record_param* const rpb = &rpbs[stream];
+
+		m_numbers[slot] = rpb->rpb_number;
+		m_present[slot] = (rpb->rpb_record != nullptr);
+
+		if (rpb->rpb_record)
+		{
+			Record*& record = m_records[slot];
+
+			if (record)
+				record->copyFrom(rpb->rpb_record);
+			else
+				record = FB_NEW_POOL(getPool()) Record(getPool(), rpb->rpb_record);
+		}
+
+		slot++;
+	}
+
+	m_selection.add(m_rows++);
+}
+
+// Append the current records of the streams as a new row, taking them over
+// instead of copying. The streams get the records of a former row (or none)
+// in exchange, so it suits the sources that read every stream record anew
+// for the next row, like table scans do.
+void RecordBatch::exchange(record_param* rpbs)
+{
+	fb_assert(!isFull());
+
+	FB_SIZE_T slot = m_rows * m_streams.getCount();
+
+	for (const auto stream : m_streams)
+	{
+		record_param* const rpb = &rpbs[stream];
+
+		m_numbers[slot] = rpb->rpb_number;
+		m_present[slot] = (rpb->rpb_record != nullptr);
+
+		if (rpb->rpb_record)
+			std::swap(m_records[slot], rpb->rpb_record);
+
+		slot++;
+	}
+
+	m_selection.add(m_rows++);
+}
+
+// Leave selected the given positions of the current selection only
+void RecordBatch::select(const Array<ULONG>& positions)
+{
+	ULONG count = 0;
+
+	for (const auto pos : positions)
+	{
+		fb_assert(pos >= count && pos < m_selection.getCount());
+		m_selection[count++] = m_selection[pos];
+	}
+
+	m_selection.shrink(count);
+}
+
+
+// RecordBatch::RowHolder class
+// ---------------------------
+
+RecordBatch::RowHolder::RowHolder(record_param* rpbs, const RecordBatch& batch)
+	: m_rpbs(rpbs),
+	  m_batch(batch),
+	  m_records(batch.getPool()),
+	  m_numbers(batch.getPool())
+{
+	for (const auto stream : m_batch.m_streams)
+	{
+		m_records.add(m_rpbs[stream].rpb_record);
+		m_numbers.add(m_rpbs[stream].rpb_number);
+	}
+}
+
+RecordBatch::RowHolder::~RowHolder()
+{
+	FB_SIZE_T pos = 0;
+
+	for (const auto stream : m_batch.m_streams)
+	{
+		record_param* const rpb = &m_rpbs[stream];
+
+		rpb->rpb_record = m_records[pos];
+		rpb->rpb_number = m_numbers[pos];
+		pos++;
+	}
+}
+
+// Make the row current in the streams. The streams whose records are missing
+// in the row keep their own ones, like they did before the row was fetched.
+void RecordBatch::RowHolder::set(ULONG row)
+{
+	fb_assert(row < m_batch.m_rows);
+
+	const FB_SIZE_T streamCount = m_batch.m_streams.getCount();
+	FB_SIZE_T slot = row * streamCount;
+
+	for (FB_SIZE_T pos = 0; pos < streamCount; pos++, slot++)
+	{
+		record_param* const rpb = &m_rpbs[m_batch.m_streams[pos]];
+
+		rpb->rpb_number = m_batch.m_numbers[slot];
+		rpb->rpb_record = m_batch.m_present[slot] ? m_batch.m_records[slot] : m_records[pos];
+	}
+}
+
+
+// BatchColumn class
+// -----------------
+
+void BatchColumn::reset(Kind aKind, SCHAR aScale, ULONG aCount)
+{
+	kind = aKind;
+	scale = aScale;
+	count = aCount;
+
+	values.resize(count);
+	nulls.resize(count);
+	memset(nulls.begin(), 0, count);
+}
+
+// Fill the column with the same value, false is returned for unsupported data types
+bool BatchColumn::assign(thread_db* tdbb, const dsc* desc, ULONG aCount)
+{
+	if (!desc)
+	{
+		reset(KIND_EXACT, 0, aCount);
+		memset(nulls.begin(), 1, count);
+		return true;
+	}
+
+	Value value;
+
+	switch (desc->dsc_dtype)
+	{
+		case dtype_short:
+		case dtype_long:
+		case dtype_int64:
+			value.exact = MOV_get_int64(tdbb, desc, desc->dsc_scale);
+			reset(KIND_EXACT, desc->dsc_scale, aCount);
+			break;
+
+		case dtype_double:
+			value.approx = MOV_get_double(tdbb, desc);
+			reset(KIND_APPROX, 0, aCount);
+			break;
+
+		case dtype_boolean:
+			value.exact = *desc->dsc_address ? 1 : 0;
+			reset(KIND_BOOLEAN, 0, aCount);
+			break;
+
+		default:
+			return false;
+	}
+
+	for (auto& item : values)
+		item = value;
+
+	return true;
+}
+
+// Bring exact values to a smaller scale, false is returned on overflow
+bool BatchColumn::rescale(SCHAR newScale)
+{
+	fb_assert(kind == KIND_EXACT && newScale <= scale);
+
+	if (newScale == scale)
+		return true;
+
+	const int diff = scale - newScale;
+
+	if (diff > 18)
+		return false;
+
+	SINT64 factor = 1;
+	for (int i = 0; i < diff; i++)
+		factor *= 10;
+
+	const SINT64 limit = MAX_SINT64 / factor;
+
+	for (ULONG i = 0; i < count; i++)
+	{
+		if (nulls[i])
+			continue;
+
+		SINT64& value = values[i].exact;
+
+		if (value > limit || value < -limit)
+			return false;
+
+		value *= factor;
+	}
+
+	scale = newScale;
+	return true;
+}
+
+// Convert exact values to doubles the same way MOV_get_double does
+void BatchColumn::makeApprox()
+{
+	fb_assert(kind != KIND_BOOLEAN);
+
+	if (kind == KIND_APPROX)
+		return;
+
+	const double factor = scale ? CVT_power_of_ten(scale > 0 ? scale : -scale) : 1;
+
+	for (ULONG i = 0; i < count; i++)
+	{
+		double value = (double) values[i].exact;
+
+		if (scale > 0)
+			value *= factor;
+		else if (scale < 0)
+			value /= factor;
+
+		values[i].approx = value;
+	}
+
+	kind = KIND_APPROX;
+	scale = 0;
+}
@@ -0,0 +1,153 @@
+/*
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created for the Firebird Open Source RDBMS project.
+ *
+ *  Copyright (c) 2026 the Firebird Project and all contributors signed below.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#ifndef JRD_RECORD_BATCH_H
+#define JRD_RECORD_BATCH_H
+
+#include "../common/classes/alloc.h"
+#include "../common/classes/array.h"
+#include "../jrd/RecordNumber.h"
+
+struct dsc;
+
+namespace Jrd {
+
+class Record;
+class thread_db;
+struct record_param;
+
+// Rows fetched from a record source at once. Every row holds its own
+// records of the source streams, the rows that passed the filters so far
+// are listed in the selection. Record parameter blocks are passed as the
+// array indexed by stream, i.e. Request::req_rpb.
+
+class RecordBatch : public Firebird::PermanentStorage
+{
+public:
+	static const ULONG CAPACITY = 1024;
+
+	RecordBatch(MemoryPool& pool, const StreamType* streams, FB_SIZE_T streamCount);
+	~RecordBatch();
+
+	// Number of the selected rows
+	ULONG getCount() const
+	{
+		return m_selection.getCount();
+	}
+
+	bool isFull() const
+	{
+		return m_rows == CAPACITY;
+	}
+
+	// Row number of the selected position
+	ULONG getRow(ULONG pos) const
+	{
+		return m_selection[pos];
+	}
+
+	bool findStream(StreamType stream, FB_SIZE_T& pos) const;
+
+	const Record* getRecord(ULONG row, FB_SIZE_T streamPos) const
+	{
+		const FB_SIZE_T slot = row * m_streams.getCount() + streamPos;
+		return m_present[slot] ? m_records[slot] : nullptr;
+	}
+
+	void clear();
+	void add(record_param* rpbs);
+	void exchange(record_param* rpbs);
+	void select(const Firebird::Array<ULONG>& positions);
+
+	// Makes rows of the batch current in the streams for the row mode
+	// evaluation. The streams are pointed to the batch records instead of
+	// copying them, their own records and positions are given back by the
+	// destructor, so the source may continue reading the streams.
+	class RowHolder
+	{
+	public:
+		RowHolder(record_param* rpbs, const RecordBatch& batch);
+		~RowHolder();
+
+		void set(ULONG row);
+
+	private:
+		record_param* const m_rpbs;
+		const RecordBatch& m_batch;
+		Firebird::HalfStaticArray<Record*, 4> m_records;
+		Firebird::HalfStaticArray<RecordNumber, 4> m_numbers;
+	};
+
+private:
+	Firebird::Array<StreamType> m_streams;
+	Firebird::Array<Record*> m_records;
+	Firebird::Array<RecordNumber> m_numbers;
+	Firebird::Array<UCHAR> m_present;
+	Firebird::Array<ULONG> m_selection;
+	ULONG m_rows = 0;
+};
+
+// Values of an expression computed for the selected rows of a batch.
+// Exact numerics are kept as scaled 64-bit integers, the approximate ones
+// as doubles, and booleans as 0/1 with NULL meaning unknown.
+
+class BatchColumn
+{
+public:
+	enum Kind : UCHAR
+	{
+		KIND_EXACT,
+		KIND_APPROX,
+		KIND_BOOLEAN
+	};
+
+	union Value
+	{
+		SINT64 exact;
+		double approx;
+	};
+
+	explicit BatchColumn(MemoryPool& pool)
+		: values(pool),
+		  nulls(pool)
+	{
+	}
+
+	void reset(Kind aKind, SCHAR aScale, ULONG aCount);
+	bool assign(thread_db* tdbb, const dsc* desc, ULONG aCount);
+	bool rescale(SCHAR newScale);
+	void makeApprox();
+
+	bool isNull(ULONG pos) const
+	{
+		return nulls[pos] != 0;
+	}
+
+public:
+	Kind kind = KIND_EXACT;
+	SCHAR scale = 0;
+	ULONG count = 0;
+	Firebird::Array<Value> values;
+	Firebird::Array<UCHAR> nulls;
+};
+
+} // namespace
+
+#endif // JRD_RECORD_BATCH_H
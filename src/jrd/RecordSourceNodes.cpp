@@ -2149,12 +2149,24 @@ RecordSource* AggregateSourceNode::compile(thread_db* tdbb, Optimizer* opt, bool
 		rse->firstRows = true;
 	}
 
+	// If nobody depends on the groups order, let the optimizer know
+	// that the grouping may be done by hashing instead of sorting
+
+	if (group && !orderedGroup && !rse->rse_aggregate &&
+		AggregatedStream::isHashable(tdbb, csb, stream, &group->expressions, map))
+	{
+		rse->flags |= RseNode::FLAG_HASH_GROUP;
+	}
+
 	RecordSource* const nextRsb = opt->compile(rse, &deliverStack);
 
+	const bool hashed = (rse->flags & RseNode::FLAG_HASH_GROUP);
+	rse->flags &= ~RseNode::FLAG_HASH_GROUP;
+
 	// allocate and optimize the record source block
 
 	AggregatedStream* const rsb = FB_NEW_POOL(*tdbb->getDefaultPool()) AggregatedStream(tdbb, csb,
-		stream, (group ? &group->expressions : NULL), map, nextRsb);
+		stream, (group ? &group->expressions : NULL), map, nextRsb, hashed);
 
 	if (rse->rse_aggregate)
 	{
@@ -2166,6 +2178,10 @@ RecordSource* AggregateSourceNode::compile(thread_db* tdbb, Optimizer* opt, bool
 
 	opt->generateAggregateDistincts(map);
 
+	// Without groups, the parallel scan workers may compute the aggregates themselves
+	if (!group && !rse->rse_aggregate)
+		nextRsb->pushAggregates(map);
+
 	return rsb;
 }
 
@@ -528,7 +528,8 @@ public:
 		  group(NULL),
 		  map(NULL),
 		  rse(NULL),
-		  dsqlWindow(false)
+		  dsqlWindow(false),
+		  orderedGroup(false)
 	{
 	}
 
@@ -578,6 +579,7 @@ private:
 
 public:
 	bool dsqlWindow;
+	bool orderedGroup;		// the parent relies on groups being returned sorted
 };
 
 class UnionSourceNode final : public TypedNode<RecordSourceNode, RecordSourceNode::TYPE_UNION>
@@ -731,7 +733,9 @@ public:
 		FLAG_DSQL_COMPARATIVE	= 0x10,		// transformed from DSQL ComparativeBoolNode
 		FLAG_LATERAL			= 0x20,		// lateral derived table
 		FLAG_SKIP_LOCKED		= 0x40,		// skip locked
-		FLAG_SUB_QUERY			= 0x80		// sub-query
+		FLAG_SUB_QUERY			= 0x80,		// sub-query
+		FLAG_HASH_GROUP			= 0x100,	// grouping may be done by hashing instead of sorting
+		FLAG_READ_ONCE			= 0x200		// read once per execution of the statement
 	};
 
 	bool isInnerJoin() const
@@ -1046,6 +1046,12 @@ void RelationPages::free(RelationPages*& nextFree)
 
 	dpMap.clear();
 	dpMapMark = 0;
+
+	for (auto& hint : leafHints)
+		hint.store(0, std::memory_order_relaxed);
+
+	purgeFailed = false;
+	purgeTraNum = 0;
 }
 
 
@@ -415,11 +415,57 @@ public:
 		dpMapMark -= minMark;
 	}
 
+	// Rightmost leaf page of the index, the insert position hint for
+	// the ascending keys, see BTR_insert
+	ULONG getLastLeaf(MetaId indexId) const noexcept
+	{
+		const FB_UINT64 value = leafHints[indexId % MAX_LEAF_HINTS].load(std::memory_order_relaxed);
+		return ((value >> 32) == indexId) ? (ULONG) value : 0;
+	}
+
+	void setLastLeaf(MetaId indexId, ULONG pageNumber) noexcept
+	{
+		leafHints[indexId % MAX_LEAF_HINTS].store(((FB_UINT64) indexId << 32) | pageNumber,
+			std::memory_order_relaxed);
+	}
+
+	// Record versions are being removed from the data pages while their
+	// index keys are not garbage collected yet, see DPM_mark_purged.
+	// Transactions up to the given number could have seen the keys.
+	void startPurge(TraNumber lastTraNum) noexcept
+	{
+		++purgeCount;
+
+		TraNumber traNum = purgeTraNum.load();
+		while (traNum < lastTraNum && !purgeTraNum.compare_exchange_weak(traNum, lastTraNum))
+			;
+	}
+
+	void finishPurge(bool completed) noexcept
+	{
+		if (!completed)
+			purgeFailed = true;
+		--purgeCount;
+	}
+
+	// No index could keep the keys of the record versions removed so far
+	// and no transaction older than the given one could still use them
+	bool purgesDone(TraNumber oldestActive) const noexcept
+	{
+		return !purgeCount && !purgeFailed && purgeTraNum < oldestActive;
+	}
+
 private:
 	RelationPages*		rel_next_free;
 	std::atomic<SLONG>	useCount = 0;
+	std::atomic<ULONG>	purgeCount = 0;
+	std::atomic<bool>	purgeFailed = false;
+	std::atomic<TraNumber>	purgeTraNum = 0;
 
 	static constexpr ULONG MAX_DPMAP_ITEMS = 64;
+	static constexpr ULONG MAX_LEAF_HINTS = 16;
+
+	std::atomic<FB_UINT64> leafHints[MAX_LEAF_HINTS] = {};
 
 	struct DPItem
 	{
@@ -133,9 +133,26 @@ Statement::Statement(thread_db* tdbb, MemoryPool* p, CompilerScratch* csb)
 
 			// if no fields are referenced and this stream is not intended for update,
 			// mark the stream as not requiring record's data
-			if (!tail->csb_fields && !(tail->csb_flags & csb_update))
+			if (!tail->csb_fields && !(tail->csb_flags & (csb_update | csb_index_only)))
 				 rpb->rpb_stream_flags |= RPB_s_no_data;
 
+			// the index scan checks all the conditions and nothing else accesses the records,
+			// so records of the pages visible to everybody do not need to be fetched
+			if ((tail->csb_flags & csb_index_only) && !tail->csb_data_refs &&
+				!(tail->csb_flags & csb_update))
+			{
+				rpb->rpb_stream_flags |= RPB_s_index_only;
+			}
+
+			// the index payload contains all the referenced fields and
+			// nothing else accesses the records
+
+			if ((tail->csb_flags & csb_index_payload) && !tail->csb_record_refs &&
+				!(tail->csb_flags & csb_update))
+			{
+				rpb->rpb_stream_flags |= RPB_s_index_payload;
+			}
+
 			if (tail->csb_flags & csb_unstable)
 				rpb->rpb_stream_flags |= RPB_s_unstable;
 
@@ -28,8 +28,13 @@
 #include "../common/config/dir_list.h"
 #include "../common/gdsassert.h"
 #include "../common/isc_proto.h"
+#include "../common/os/guid.h"
 #include "../common/os/path_utils.h"
 #include "../jrd/jrd.h"
+#include "../jrd/CryptoManager.h"
+#include "../jrd/sqz.h"
+#include "../jrd/err_proto.h"
+#include <tomcrypt.h>
 
 #include "../jrd/TempSpace.h"
 
@@ -129,6 +134,242 @@ FB_SIZE_T TempSpace::FileBlock::write(offset_t offset, const void* buffer, FB_SI
 	return file->write(offset, buffer, length);
 }
 
+//
+// Packed pages of the file blocks
+//
+
+TempSpace::FilePacker::FilePacker(MemoryPool& p, bool aCompress, bool aEncrypt)
+	: pool(p), cache(p), scratch(p),
+	  cacheOwner(NULL), cacheNumber(0), cacheDirty(false),
+	  compress(aCompress), encrypt(aEncrypt), lastNonce(0)
+{
+	cache.getBuffer(PAGE_SIZE);
+	scratch.getBuffer(PAGE_SIZE);
+
+	// The key lives as long as the temporary space, so nothing written
+	// to disk can be decrypted afterwards
+	if (encrypt)
+		GenerateRandomBytes(key, sizeof(key));
+}
+
+UCHAR* TempSpace::FilePacker::fetch(PackedFileBlock* block, ULONG number)
+{
+	if (!isCached(block, number))
+	{
+		if (cacheDirty)
+		{
+			cacheOwner->storePage(cacheNumber, cache.begin());
+			cacheDirty = false;
+		}
+
+		cacheOwner = NULL;
+		block->loadPage(number, cache.begin());
+		cacheOwner = block;
+		cacheNumber = number;
+	}
+
+	return cache.begin();
+}
+
+void TempSpace::FilePacker::markDirty() noexcept
+{
+	fb_assert(cacheOwner);
+	cacheDirty = true;
+}
+
+void TempSpace::FilePacker::discard(const PackedFileBlock* block, ULONG number) noexcept
+{
+	if (isCached(block, number))
+	{
+		cacheOwner = NULL;
+		cacheDirty = false;
+	}
+}
+
+bool TempSpace::FilePacker::isCached(const PackedFileBlock* block, ULONG number) const noexcept
+{
+	return (cacheOwner == block && cacheNumber == number);
+}
+
+// Returns the length of the data to be written for the page
+
+ULONG TempSpace::FilePacker::pack(const UCHAR* page, const UCHAR*& data, bool& packed, FB_UINT64& nonce)
+{
+	ULONG length = PAGE_SIZE;
+	data = page;
+	packed = false;
+	nonce = 0;
+
+	if (compress)
+	{
+		const Compressor compressor(pool, true, true, PAGE_SIZE, page);
+
+		if (compressor.isPacked())
+		{
+			length = compressor.getPackedLength();
+			compressor.pack(page, scratch.begin());
+			data = scratch.begin();
+			packed = true;
+		}
+	}
+
+	if (encrypt)
+	{
+		if (!packed)
+			memcpy(scratch.begin(), page, length);
+
+		data = scratch.begin();
+		nonce = ++lastNonce;
+		crypt(scratch.begin(), length, nonce);
+	}
+
+	return length;
+}
+
+// Decrypts the data in place and unpacks them into the page
+
+void TempSpace::FilePacker::unpack(UCHAR* data, ULONG length, bool packed, FB_UINT64 nonce, UCHAR* page)
+{
+	if (encrypt)
+		crypt(data, length, nonce);
+
+	if (packed)
+	{
+		if (Compressor::unpack(length, data, PAGE_SIZE, page) != page + PAGE_SIZE)
+			BUGCHECK(179);	// msg 179 decompression overran buffer
+	}
+	else if (data != page)
+	{
+		fb_assert(length == PAGE_SIZE);
+		memcpy(page, data, length);
+	}
+}
+
+// ChaCha20 with the unique nonce per every page written
+
+void TempSpace::FilePacker::crypt(UCHAR* data, ULONG length, FB_UINT64 nonce) const
+{
+	UCHAR iv[sizeof(FB_UINT64)];
+	memcpy(iv, &nonce, sizeof(iv));
+
+	chacha_state chacha;
+
+	if (chacha_setup(&chacha, key, sizeof(key), 20) != CRYPT_OK ||
+		chacha_ivctr64(&chacha, iv, sizeof(iv), 0) != CRYPT_OK ||
+		chacha_crypt(&chacha, data, length, data) != CRYPT_OK)
+	{
+		status_exception::raise(Arg::Gds(isc_tom_crypt_cip) << "CHACHA#20");
+	}
+
+	chacha_done(&chacha);
+}
+
+TempSpace::PackedFileBlock::PageInfo& TempSpace::PackedFileBlock::getPage(ULONG number)
+{
+	// The block may have been extended in the same file
+	if (number >= pages.getCount())
+		pages.grow(static_cast<FB_SIZE_T>(size / FilePacker::PAGE_SIZE));
+
+	fb_assert(number < pages.getCount());
+	return pages[number];
+}
+
+void TempSpace::PackedFileBlock::loadPage(ULONG number, UCHAR* page)
+{
+	const PageInfo& info = getPage(number);
+
+	if (!info.length)
+	{
+		memset(page, 0, FilePacker::PAGE_SIZE);
+		return;
+	}
+
+	// Unpacked pages are read in place
+	UCHAR* const data = (info.packed ? packer->getScratch() : page);
+
+	file->read(seek + (offset_t) number * FilePacker::PAGE_SIZE, data, info.length);
+	packer->unpack(data, info.length, info.packed, info.nonce, page);
+}
+
+void TempSpace::PackedFileBlock::storePage(ULONG number, const UCHAR* page)
+{
+	PageInfo& info = getPage(number);
+
+	const UCHAR* data;
+	bool packed;
+	FB_UINT64 nonce;
+	const ULONG length = packer->pack(page, data, packed, nonce);
+
+	file->write(seek + (offset_t) number * FilePacker::PAGE_SIZE, data, length);
+
+	info.length = length;
+	info.packed = packed;
+	info.nonce = nonce;
+}
+
+FB_SIZE_T TempSpace::PackedFileBlock::read(offset_t offset, void* buffer, FB_SIZE_T length)
+{
+	if (offset + length > size)
+	{
+		length = size - offset;
+	}
+
+	UCHAR* p = static_cast<UCHAR*>(buffer);
+
+	for (FB_SIZE_T l = length; l;)
+	{
+		const ULONG number = static_cast<ULONG>(offset / FilePacker::PAGE_SIZE);
+		const ULONG pageOffset = static_cast<ULONG>(offset % FilePacker::PAGE_SIZE);
+		const FB_SIZE_T n = MIN(l, FilePacker::PAGE_SIZE - pageOffset);
+
+		// Whole pages bypass the cache
+		if (n == FilePacker::PAGE_SIZE && !packer->isCached(this, number))
+			loadPage(number, p);
+		else
+			memcpy(p, packer->fetch(this, number) + pageOffset, n);
+
+		offset += n;
+		p += n;
+		l -= n;
+	}
+
+	return length;
+}
+
+FB_SIZE_T TempSpace::PackedFileBlock::write(offset_t offset, const void* buffer, FB_SIZE_T length)
+{
+	if (offset + length > size)
+	{
+		length = size - offset;
+	}
+
+	const UCHAR* p = static_cast<const UCHAR*>(buffer);
+
+	for (FB_SIZE_T l = length; l;)
+	{
+		const ULONG number = static_cast<ULONG>(offset / FilePacker::PAGE_SIZE);
+		const ULONG pageOffset = static_cast<ULONG>(offset % FilePacker::PAGE_SIZE);
+		const FB_SIZE_T n = MIN(l, FilePacker::PAGE_SIZE - pageOffset);
+
+		if (n == FilePacker::PAGE_SIZE)
+		{
+			packer->discard(this, number);
+			storePage(number, p);
+		}
+		else
+		{
+			memcpy(packer->fetch(this, number) + pageOffset, p, n);
+			packer->markDirty();
+		}
+
+		offset += n;
+		p += n;
+		l -= n;
+	}
+
+	return length;
+}
+
 //
 // FreeSegmentBySize class
 //
@@ -198,11 +439,12 @@ TempSpace::Segment* TempSpace::FreeSegmentBySize::getSegment(FB_SIZE_T size)
 // Constructor
 //
 
-TempSpace::TempSpace(MemoryPool& p, const PathName& prefix, bool dynamic)
+TempSpace::TempSpace(MemoryPool& p, const PathName& prefix, bool dynamic, bool packed)
 		: pool(p), filePrefix(p, prefix),
 		  logicalSize(0), physicalSize(0), localCacheUsage(0),
 		  head(NULL), tail(NULL), tempFiles(p),
 		  initialBuffer(p), initiallyDynamic(dynamic),
+		  packedFiles(packed), packer(NULL),
 		  freeSegments(p), freeSegmentsBySize(p)
 {
 	if (!tempDirs)
@@ -237,6 +479,8 @@ TempSpace::~TempSpace()
 		head = temp;
 	}
 
+	delete packer;
+
 	if (localCacheUsage)
 	{
 		Database* const dbb = GET_DBB();
@@ -419,6 +663,21 @@ void TempSpace::extend(FB_SIZE_T size)
 		{
 			// allocate block in the temp file
 			// Possible error thrown when not enough physical memory
+
+			if (packedFiles && !packer)
+			{
+				// Pack the file blocks if asked to compress or if the database is encrypted
+				Database* const dbb = GET_DBB();
+				const bool compress = dbb->dbb_config->getTempCompression();
+				const bool encrypt = dbb->dbb_crypto_manager &&
+					dbb->dbb_crypto_manager->getPluginName()[0];
+
+				if (compress || encrypt)
+					packer = FB_NEW_POOL(pool) FilePacker(pool, compress, encrypt);
+				else
+					packedFiles = false;
+			}
+
 			TempFile* const file = setupFile(size);
 			fb_assert(file);
 			if (tail && tail->sameFile(file))
@@ -427,7 +686,11 @@ void TempSpace::extend(FB_SIZE_T size)
 				tail->size += size;
 				return;
 			}
-			block = FB_NEW_POOL(pool) FileBlock(file, tail, size);
+
+			if (packer)
+				block = FB_NEW_POOL(pool) PackedFileBlock(pool, packer, file, tail, size);
+			else
+				block = FB_NEW_POOL(pool) FileBlock(file, tail, size);
 		}
 
 		// preserve the initial contents, if any
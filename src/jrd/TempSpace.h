@@ -34,7 +34,7 @@
 class TempSpace : public Firebird::File
 {
 public:
-	TempSpace(MemoryPool& pool, const Firebird::PathName& prefix, bool dynamic = true);
+	TempSpace(MemoryPool& pool, const Firebird::PathName& prefix, bool dynamic = true, bool packed = false);
 	virtual ~TempSpace();
 
 	FB_SIZE_T read(offset_t offset, void* buffer, FB_SIZE_T length) override;
@@ -173,6 +173,93 @@ private:
 		offset_t seek;
 	};
 
+	class PackedFileBlock;
+
+	// Compression and encryption of the file blocks, page by page.
+	// The last used page is cached unpacked.
+	class FilePacker
+	{
+	public:
+		static constexpr ULONG PAGE_SIZE = 64 * 1024;
+
+		FilePacker(MemoryPool& pool, bool compress, bool encrypt);
+
+		UCHAR* fetch(PackedFileBlock* block, ULONG number);
+		void markDirty() noexcept;
+		void discard(const PackedFileBlock* block, ULONG number) noexcept;
+		bool isCached(const PackedFileBlock* block, ULONG number) const noexcept;
+
+		ULONG pack(const UCHAR* page, const UCHAR*& data, bool& packed, FB_UINT64& nonce);
+		void unpack(UCHAR* data, ULONG length, bool packed, FB_UINT64 nonce, UCHAR* page);
+
+		UCHAR* getScratch() noexcept
+		{
+			return scratch.begin();
+		}
+
+	private:
+		void crypt(UCHAR* data, ULONG length, FB_UINT64 nonce) const;
+
+		MemoryPool& pool;
+		Firebird::Array<UCHAR> cache;
+		Firebird::Array<UCHAR> scratch;
+		PackedFileBlock* cacheOwner;
+		ULONG cacheNumber;
+		bool cacheDirty;
+		const bool compress;
+		const bool encrypt;
+		UCHAR key[32];
+		FB_UINT64 lastNonce;
+	};
+
+	// On-disk block consisting of separately packed pages. Every page
+	// has its own slot in the file but occupies as many bytes as needed.
+	class PackedFileBlock : public Block
+	{
+	public:
+		PackedFileBlock(MemoryPool& pool, FilePacker* p, Firebird::TempFile* f, Block* tail, size_t length)
+			: Block(tail, length), packer(p), file(f), pages(pool)
+		{
+			fb_assert(file);
+			fb_assert(length % FilePacker::PAGE_SIZE == 0);
+
+			seek = file->getSize() - length;
+		}
+
+		~PackedFileBlock() {}
+
+		FB_SIZE_T read(offset_t offset, void* buffer, FB_SIZE_T length) override;
+		FB_SIZE_T write(offset_t offset, const void* buffer, FB_SIZE_T length) override;
+
+		UCHAR* inMemory(offset_t /*offset*/, size_t /*a_size*/) const noexcept override
+		{
+			return NULL;
+		}
+
+		bool sameFile(const Firebird::TempFile* aFile) const noexcept override
+		{
+			return (aFile == this->file);
+		}
+
+		void loadPage(ULONG number, UCHAR* page);
+		void storePage(ULONG number, const UCHAR* page);
+
+	private:
+		struct PageInfo
+		{
+			ULONG length;		// zero if never written
+			bool packed;
+			FB_UINT64 nonce;
+		};
+
+		PageInfo& getPage(ULONG number);
+
+		FilePacker* const packer;
+		Firebird::TempFile* file;
+		offset_t seek;
+		Firebird::Array<PageInfo> pages;
+	};
+
 	Block* findBlock(offset_t& offset) const;
 	Firebird::TempFile* setupFile(FB_SIZE_T size);
 
@@ -226,6 +313,8 @@ private:
 	Firebird::Array<Firebird::TempFile*> tempFiles;
 	Firebird::Array<UCHAR> initialBuffer;
 	bool initiallyDynamic;
+	bool packedFiles;
+	FilePacker* packer;
 
 	typedef Firebird::BePlusTree<Segment*, offset_t, Segment> FreeSegmentTree;
 	typedef Firebird::BePlusTree<SegmentsStack, offset_t, SegmentsStack> FreeSegmentsStackTree;
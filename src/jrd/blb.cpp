@@ -2381,10 +2381,8 @@ blob_page* blb::get_next_page(thread_db* tdbb, WIN* window)
 	}
 
 	SET_TDBB(tdbb);
-#ifdef SUPERSERVER_V2
 	Database* dbb = tdbb->getDatabase();
 	ULONG pages[PREFETCH_MAX_PAGES];
-#endif
 
 	const vcl& vector = *blb_pages;
 
@@ -2392,21 +2390,19 @@ blob_page* blb::get_next_page(thread_db* tdbb, WIN* window)
 	// Level 1 blobs are much easier -- page number is in vector.
 	if (blb_level == 1)
 	{
-#ifdef SUPERSERVER_V2
 		// Perform prefetch of blob level 1 data pages.
 
-		if (!(blb_sequence % dbb->dbb_prefetch_sequence))
+		if (dbb->dbb_prefetch_pages && !(blb_sequence % dbb->dbb_prefetch_sequence))
 		{
-			USHORT sequence = blb_sequence;
-			USHORT i = 0;
+			ULONG sequence = blb_sequence;
+			ULONG i = 0;
 			while (i < dbb->dbb_prefetch_pages && sequence <= blb_max_sequence)
 			{
 				 pages[i++] = vector[sequence++];
 			}
 
-			CCH_PREFETCH(tdbb, pages, i);
+			CCH_prefetch(tdbb, blb_pg_space_id, pages, i);
 		}
-#endif
 		window->win_page = vector[blb_sequence];
 		page = (blob_page*) CCH_FETCH(tdbb, window, LCK_read, pag_blob);
 	}
@@ -2414,14 +2410,13 @@ blob_page* blb::get_next_page(thread_db* tdbb, WIN* window)
 	{
 		window->win_page = vector[blb_sequence / blb_pointers];
 		page = (blob_page*) CCH_FETCH(tdbb, window, LCK_read, pag_blob);
-#ifdef SUPERSERVER_V2
 		// Perform prefetch of blob level 2 data pages.
 
-		USHORT sequence = blb_sequence % blb_pointers;
-		if (!(sequence % dbb->dbb_prefetch_sequence))
+		ULONG sequence = blb_sequence % blb_pointers;
+		if (dbb->dbb_prefetch_pages && !(sequence % dbb->dbb_prefetch_sequence))
 		{
 			ULONG abs_sequence = blb_sequence;
-			USHORT i = 0;
+			ULONG i = 0;
 			while (i < dbb->dbb_prefetch_pages && sequence < blb_pointers &&
 				abs_sequence <= blb_max_sequence)
 			{
@@ -2429,9 +2424,8 @@ blob_page* blb::get_next_page(thread_db* tdbb, WIN* window)
 				abs_sequence++;
 			}
 
-			CCH_PREFETCH(tdbb, pages, i);
+			CCH_prefetch(tdbb, blb_pg_space_id, pages, i);
 		}
-#endif
 		page = (blob_page*) CCH_HANDOFF(tdbb, window,
 										page->blp_page[blb_sequence % blb_pointers],
 										LCK_read, pag_blob);
@@ -47,22 +47,7 @@ USHORT IndexNode::computePrefix(const UCHAR* prevString, USHORT prevLength,
  *  to two strings.
  *
  **************************************/
-	USHORT l = MIN(prevLength, length);
-	if (!l) {
-		return 0;
-	}
-
-	const UCHAR* p = prevString;
-
-	while (*p == *string)
-	{
-		++p;
-		++string;
-		if (!--l) {
-			break;
-		}
-	}
-	return (p - prevString);
+	return matchPrefix(prevString, string, MIN(prevLength, length));
 }
 
 
@@ -195,6 +180,9 @@ USHORT IndexNode::getNodeSize(bool leafNode) const
 	else if (isEndBucket) {
 		internalFlags = BTN_END_BUCKET_FLAG;
 	}
+	else if (hasPayload()) {
+		internalFlags = BTN_PAYLOAD_FLAG;
+	}
 	else if (length == 0)
 	{
 		if (prefix == 0) {
@@ -295,6 +283,13 @@ USHORT IndexNode::getNodeSize(bool leafNode) const
 		}
 	}
 
+	if (internalFlags == BTN_PAYLOAD_FLAG)
+	{
+		// Size needed for payload length and payload itself
+		result += (payloadLength & 0xFF80) ? 2 : 1;
+		result += payloadLength;
+	}
+
 	result += length;
 	return result;
 }
@@ -416,14 +411,19 @@ UCHAR* IndexNode::writeNode(UCHAR* pagePointer, bool leafNode, bool withData)
 	// are zero) we don't store the length and prefix
 	// information. This will save at least 2 bytes per node.
 
+	const USHORT payloadSize = hasPayload() ? payloadLength : 0;
+
 	if (!withData)
 	{
 		// First move data so we can't override it.
 		// For older structure node was always the same, but length
 		// from new structure depends on the values.
-		const USHORT offset = getNodeSize(leafNode) - length;
+		// The payload is read from the page right after the data,
+		// so both are moved together.
+		fb_assert(!payloadSize || payload == data + length);
+		const USHORT offset = getNodeSize(leafNode) - length - payloadSize;
 		pagePointer += offset; // set pointer to right position
-		memmove(pagePointer, data, length);
+		memmove(pagePointer, data, length + payloadSize);
 		pagePointer -= offset; // restore pointer to original position
 	}
 
@@ -435,6 +435,9 @@ UCHAR* IndexNode::writeNode(UCHAR* pagePointer, bool leafNode, bool withData)
 	else if (isEndBucket) {
 		internalFlags = BTN_END_BUCKET_FLAG;
 	}
+	else if (hasPayload()) {
+		internalFlags = BTN_PAYLOAD_FLAG;
+	}
 	else if (length == 0)
 	{
 		if (prefix == 0) {
@@ -621,11 +624,33 @@ UCHAR* IndexNode::writeNode(UCHAR* pagePointer, bool leafNode, bool withData)
 		}
 	}
 
+	if (internalFlags == BTN_PAYLOAD_FLAG)
+	{
+		// Write payload length, maximum 14 bits
+		number = payloadLength;
+		tmp = (number & 0x7F);
+		number >>= 7;
+		if (number > 0) {
+			tmp |= 0x80;
+		}
+		*pagePointer++ = tmp;
+		if (number > 0)
+		{
+			tmp = (number & 0x7F);
+			*pagePointer++ = tmp;
+		}
+	}
+
 	// Store data
-	if (withData) {
+	if (withData)
+	{
 		memcpy(pagePointer, data, length);
+
+		// Payload could be read from the same page area
+		if (payloadSize)
+			memmove(pagePointer + length, payload, payloadSize);
 	}
-	pagePointer += length;
+	pagePointer += length + payloadSize;
 
 	return pagePointer;
 }
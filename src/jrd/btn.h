@@ -33,6 +33,11 @@
 #include "../jrd/ods.h"
 #include "../common/classes/array.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BTN_USE_SSE2
+#endif
+
 namespace Jrd {
 
 // Flags (3-bits) used for index node
@@ -42,7 +47,7 @@ inline constexpr int BTN_END_BUCKET_FLAG				= 2;
 inline constexpr int BTN_ZERO_PREFIX_ZERO_LENGTH_FLAG	= 3;
 inline constexpr int BTN_ZERO_LENGTH_FLAG				= 4;
 inline constexpr int BTN_ONE_LENGTH_FLAG				= 5;
-//inline constexpr int BTN_ZERO_PREFIX_ONE_LENGTH_FLAG	= 6;
+inline constexpr int BTN_PAYLOAD_FLAG					= 6;	// leaf node with included columns
 //inline constexpr int BTN_GET_MORE_FLAGS	= 7;
 
 // Firebird B-tree nodes
@@ -56,6 +61,8 @@ struct IndexNode
 	USHORT length;				// length of data in node
 	ULONG pageNumber;			// page number
 	UCHAR* data;				// Data can be read from here
+	UCHAR* payload = nullptr;	// included (non-key) columns, leaf nodes only
+	USHORT payloadLength = 0;	// length of payload
 	RecordNumber recordNumber;	// record number
 	bool isEndBucket;
 	bool isEndLevel;
@@ -66,6 +73,53 @@ struct IndexNode
 	static SLONG findPageInDuplicates(const Ods::btree_page* page, UCHAR* pointer,
 									  SLONG previousNumber, RecordNumber findRecordNumber);
 
+	static USHORT matchPrefix(const UCHAR* p, const UCHAR* q, USHORT length)
+	{
+	/**************************************
+	 *
+	 *	m a t c h P r e f i x
+	 *
+	 **************************************
+	 *
+	 * Functional description
+	 *	Return the number of leading bytes
+	 *  equal in both strings. Long runs are
+	 *  compared a vector or a word at once.
+	 *
+	 **************************************/
+		USHORT count = 0;
+
+#ifdef BTN_USE_SSE2
+		while (count + sizeof(__m128i) <= length)
+		{
+			const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + count));
+			const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + count));
+
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2)) != 0xFFFF)
+				break;
+
+			count += sizeof(__m128i);
+		}
+#endif
+
+		while (count + sizeof(FB_UINT64) <= length)
+		{
+			FB_UINT64 w1, w2;
+			memcpy(&w1, p + count, sizeof(w1));
+			memcpy(&w2, q + count, sizeof(w2));
+
+			if (w1 != w2)
+				break;
+
+			count += sizeof(FB_UINT64);
+		}
+
+		while (count < length && p[count] == q[count])
+			count++;
+
+		return count;
+	}
+
 	bool keyEqual(USHORT length, const UCHAR* data) const
 	{
 		if (length != this->length + this->prefix)
@@ -77,6 +131,17 @@ struct IndexNode
 		return !memcmp(this->data, data + this->prefix, this->length);
 	}
 
+	bool hasPayload() const
+	{
+		return payloadLength && !isEndBucket && !isEndLevel;
+	}
+
+	void setPayload(UCHAR* payload, USHORT payloadLength)
+	{
+		this->payload = payload;
+		this->payloadLength = payloadLength;
+	}
+
 	void setEndBucket()
 	{
 		this->isEndBucket = true;
@@ -91,6 +156,8 @@ struct IndexNode
 		this->length = 0;
 		this->pageNumber = 0;
 		this->recordNumber.setValue(0);
+		this->payload = nullptr;
+		this->payloadLength = 0;
 	}
 
 	void setNode(USHORT prefix = 0, USHORT length = 0,
@@ -103,6 +170,8 @@ struct IndexNode
 		this->length = length;
 		this->recordNumber = recordNumber;
 		this->pageNumber = pageNumber;
+		this->payload = nullptr;
+		this->payloadLength = 0;
 	}
 
 	USHORT getNodeSize(bool leafNode) const;
@@ -132,6 +201,8 @@ struct IndexNode
 
 		isEndLevel = (internalFlags == BTN_END_LEVEL_FLAG);
 		isEndBucket = (internalFlags == BTN_END_BUCKET_FLAG);
+		payload = nullptr;
+		payloadLength = 0;
 
 		// If this is a END_LEVEL marker then we're done
 		if (isEndLevel)
@@ -254,10 +325,29 @@ struct IndexNode
 			}
 		}
 
+		if (internalFlags == BTN_PAYLOAD_FLAG)
+		{
+			// Get payload length
+			tmp = *localPointer++;
+			payloadLength = (tmp & 0x7F);
+			if (tmp & 0x80)
+			{
+				tmp = *localPointer++;
+				payloadLength |= (tmp & 0x7F) << 7; // We get 14 bits at this point
+			}
+		}
+
 		// Get pointer where data starts
 		data = localPointer;
 		localPointer += length;
 
+		// Payload follows the key data
+		if (payloadLength)
+		{
+			payload = localPointer;
+			localPointer += payloadLength;
+		}
+
 		return localPointer;
 	}
 
@@ -65,6 +65,8 @@
 #include "../jrd/tra_proto.h"
 #include "../jrd/tpc_proto.h"
 #include "../dsql/DdlNodes.h"
+#include "../common/Task.h"
+#include "../jrd/WorkerAttachment.h"
 
 using namespace Jrd;
 using namespace Ods;
@@ -98,6 +100,13 @@ namespace
 	// of the main page.
 	inline constexpr ULONG NO_SPLIT = 0;
 
+	// Every column stored in the payload of a leaf node starts with
+	// dtype (0 for NULL), scale, sub-type and length of its value
+	constexpr USHORT PAYLOAD_HEADER_SIZE = 6;
+
+	// Payload length is stored as 14-bit number in the node
+	constexpr USHORT MAX_PAYLOAD_LENGTH = 0x3FFF;
+
 	// Thresholds for determing of a page should be garbage collected
 	// Garbage collect if page size is below GARBAGE_COLLECTION_THRESHOLD
 #define GARBAGE_COLLECTION_BELOW_THRESHOLD	(dbb->dbb_page_size / 4)
@@ -179,21 +188,6 @@ namespace
 
 	typedef HalfStaticArray<IndexJumpNode, 32> JumpNodeList;
 
-	struct FastLoadLevel
-	{
-		temporary_mini_key key;
-		btree_page* bucket;
-		win_for_array window;
-		ULONG splitPage;
-		RecordNumber splitRecordNumber;
-		UCHAR* pointer;
-		UCHAR* newAreaPointer;
-		USHORT totalJumpSize;
-		IndexNode levelNode;
-		JumpNodeList* jumpNodes;
-		temporary_mini_key jumpKey;
-	};
-
 	inline int indexCacheState(thread_db* tdbb, TraNumber descTrans, Cached::Relation* rel, MetaId idxId, bool creating)
 	{
 		auto checkPresence = [tdbb, rel, idxId]()->bool
@@ -247,7 +241,8 @@ static void generate_jump_nodes(thread_db*, btree_page*, JumpNodeList*, USHORT,
 								USHORT*, USHORT*, USHORT*, USHORT);
 
 static ULONG insert_node(thread_db*, WIN*, index_insertion*, temporary_key*,
-						 RecordNumber*, ULONG*, ULONG*);
+						 RecordNumber*, ULONG*, ULONG*, bool = true);
+static bool insert_last_leaf(thread_db*, WIN*, index_insertion*);
 
 static INT64_KEY make_int64_key(SINT64, SSHORT);
 #ifdef DEBUG_INDEXKEY
@@ -1382,6 +1377,7 @@ bool BTR_description(thread_db* tdbb, Cached::Relation* relation, const index_ro
 	idx->idx_id = id;
 	idx->idx_root = rootPage;
 	idx->idx_count = irt_desc->irt_keys;
+	idx->idx_includes = irt_desc->irt_includes;
 	idx->idx_flags = irt_desc->irt_flags;
 	idx->idx_runtime_flags = 0;
 	idx->idx_foreign_dep.clear();
@@ -1396,7 +1392,7 @@ bool BTR_description(thread_db* tdbb, Cached::Relation* relation, const index_ro
 	// pick up field ids and type descriptions for each of the fields
 	const UCHAR* ptr = (UCHAR*) root + irt_desc->irt_desc;
 	index_desc::idx_repeat* idx_desc = idx->idx_rpt;
-	for (int i = 0; i < idx->idx_count; i++, idx_desc++)
+	for (int i = 0; i < idx->idx_count + idx->idx_includes; i++, idx_desc++)
 	{
 		const irtd* key_descriptor = (irtd*) ptr;
 		idx_desc->idx_field = key_descriptor->irtd_field;
@@ -1827,6 +1823,72 @@ btree_page* BTR_find_page(thread_db* tdbb,
 }
 
 
+bool BTR_get_payload(thread_db* tdbb, Record* record, const index_desc* idx,
+					 const UCHAR* payload, USHORT length)
+{
+/**************************************
+ *
+ *	B T R _ g e t _ p a y l o a d
+ *
+ **************************************
+ *
+ * Functional description
+ *	Fill the record fields from the payload of a leaf node.
+ *	Fields not contained in the payload are left untouched.
+ *	Return false if the payload doesn't match the index.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+
+	const Format* const format = record->getFormat();
+	const UCHAR* const end = payload + length;
+
+	// Values are copied to the aligned buffer before conversion
+	HalfStaticArray<SINT64, 32> buffer;
+
+	const index_desc::idx_repeat* tail = idx->idx_rpt;
+	for (USHORT n = 0; n < idx->idx_count + idx->idx_includes; n++, tail++)
+	{
+		if (payload + PAYLOAD_HEADER_SIZE > end)
+			return false;
+
+		dsc source;
+		source.clear();
+		source.dsc_dtype = payload[0];
+		source.dsc_scale = (SCHAR) payload[1];
+		memcpy(&source.dsc_sub_type, payload + 2, sizeof(SSHORT));
+		memcpy(&source.dsc_length, payload + 4, sizeof(USHORT));
+		payload += PAYLOAD_HEADER_SIZE;
+
+		if (payload + source.dsc_length > end)
+			return false;
+
+		const USHORT id = tail->idx_field;
+
+		if (id >= format->fmt_count || format->fmt_desc[id].isUnknown())
+			return false;
+
+		if (source.dsc_dtype == dtype_unknown)
+		{
+			record->setNull(id);
+			continue;
+		}
+
+		UCHAR* const value = (UCHAR*) buffer.getBuffer(source.dsc_length / sizeof(SINT64) + 1);
+		memcpy(value, payload, source.dsc_length);
+		source.dsc_address = value;
+		payload += source.dsc_length;
+
+		dsc target = format->fmt_desc[id];
+		target.dsc_address = record->getData() + (IPTR) target.dsc_address;
+		MOV_move(tdbb, &source, &target);
+		record->clearNull(id);
+	}
+
+	return (payload == end);
+}
+
+
 void BTR_insert(thread_db* tdbb, WIN* root_window, index_insertion* insertion)
 {
 /**************************************
@@ -1841,6 +1903,11 @@ void BTR_insert(thread_db* tdbb, WIN* root_window, index_insertion* insertion)
  **************************************/
 	SET_TDBB(tdbb);
 
+	// Ascending keys are inserted into the rightmost leaf page, try it directly
+	// instead of descending through the upper pages shared by all inserters
+	if (insert_last_leaf(tdbb, root_window, insertion))
+		return;
+
 	index_desc* idx = insertion->iib_descriptor;
 	RelationPages* relPages = insertion->iib_relation->getPages(tdbb);
 	WIN window(relPages->rel_pg_space_id, idx->idx_root);
@@ -1900,6 +1967,8 @@ void BTR_insert(thread_db* tdbb, WIN* root_window, index_insertion* insertion)
 		propagate.iib_descriptor->idx_root = window.win_page.getPageNum();
 		propagate.iib_key = &key;
 		propagate.iib_btr_level = root_level + 1;
+		propagate.iib_payload = nullptr;
+		propagate.iib_payload_length = 0;
 
 		temporary_key ret_key;
 		ret_key.key_flags = 0;
@@ -2150,6 +2219,47 @@ USHORT BTR_key_length(thread_db* tdbb, jrd_rel* relation, index_desc* idx)
 }
 
 
+bool BTR_last_leaf_accepts(const btree_page* page, USHORT relationId, MetaId indexId,
+						   const temporary_key* key)
+{
+/**************************************
+ *
+ *	B T R _ l a s t _ l e a f _ a c c e p t s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Check that the page is the rightmost leaf page of
+ *	the index and the key belongs to it.
+ *
+ **************************************/
+
+	// The page header has room for a byte of index id only
+	if (indexId > MAX_UCHAR)
+		return false;
+
+	if (page->btr_header.pag_type != pag_index ||
+		(page->btr_header.pag_flags & btr_released) ||
+		page->btr_relation != relationId ||
+		page->btr_id != (UCHAR) indexId ||
+		page->btr_level != 0 || page->btr_sibling)
+	{
+		return false;
+	}
+
+	// Keys of the left siblings are not greater than the first key
+	// of the page, so the greater keys belong to this page only
+	IndexNode node;
+	node.readNode(const_cast<UCHAR*>(page->btr_nodes + page->btr_jump_size), true);
+
+	if (node.isEndLevel || node.isEndBucket || node.prefix)
+		return false;
+
+	const int result = memcmp(key->key_data, node.data, MIN(key->key_length, node.length));
+	return (result > 0) || (!result && key->key_length > node.length);
+}
+
+
 bool BTR_lookup(thread_db* tdbb, Cached::Relation* relation, MetaId id, index_desc* buffer,
 				  RelationPages* relPages)
 {
@@ -2516,6 +2626,69 @@ void BTR_make_null_key(thread_db* tdbb, const index_desc* idx, temporary_key* ke
 }
 
 
+void BTR_make_payload(thread_db* tdbb, jrd_rel* relation, Record* record, const index_desc* idx,
+					  UCharBuffer& payload)
+{
+/**************************************
+ *
+ *	B T R _ m a k e _ p a y l o a d
+ *
+ **************************************
+ *
+ * Functional description
+ *	Build the payload stored in the leaf node together with the key.
+ *	It contains the values of all the index columns, key columns first,
+ *	as the key itself may lose the original value. The payload is left
+ *	empty if the index has no included columns or it is too long.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+
+	payload.clear();
+
+	if (!idx->idx_includes)
+		return;
+
+	const index_desc::idx_repeat* tail = idx->idx_rpt;
+	for (USHORT n = 0; n < idx->idx_count + idx->idx_includes; n++, tail++)
+	{
+		dsc desc;
+		UCHAR header[PAYLOAD_HEADER_SIZE];
+		memset(header, 0, sizeof(header));
+
+		const UCHAR* data = nullptr;
+		USHORT length = 0;
+
+		if (EVL_field(relation, record, tail->idx_field, &desc))
+		{
+			if (desc.dsc_dtype == dtype_varying)
+			{
+				const vary* const string = (vary*) desc.dsc_address;
+				desc.dsc_dtype = dtype_text;
+				desc.dsc_length = string->vary_length;
+				desc.dsc_address = (UCHAR*) string->vary_string;
+			}
+
+			header[0] = desc.dsc_dtype;
+			header[1] = (UCHAR) desc.dsc_scale;
+			memcpy(header + 2, &desc.dsc_sub_type, sizeof(SSHORT));
+			memcpy(header + 4, &desc.dsc_length, sizeof(USHORT));
+
+			data = desc.dsc_address;
+			length = desc.dsc_length;
+		}
+
+		payload.push(header, sizeof(header));
+		if (length)
+			payload.push(data, length);
+	}
+
+	// Columns could be made longer after the index was created
+	if (payload.getCount() > MIN(MAX_PAYLOAD_LENGTH, tdbb->getDatabase()->getMaxIndexKeyLength()))
+		payload.clear();
+}
+
+
 // checks is there a need to modify index descriptor
 // if yes - we release index root window
 
@@ -2752,6 +2925,42 @@ bool BTR_next_index(thread_db* tdbb, Cached::Relation* relation, jrd_tra* transa
 }
 
 
+USHORT BTR_payload_length(thread_db* tdbb, jrd_rel* relation, const index_desc* idx)
+{
+/**************************************
+ *
+ *	B T R _ p a y l o a d _ l e n g t h
+ *
+ **************************************
+ *
+ * Functional description
+ *	Compute the maximum length of the leaf node payload
+ *	for the current format of the relation.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+
+	if (!idx->idx_includes)
+		return 0;
+
+	const Format* const format = relation->currentFormat(tdbb);
+
+	ULONG length = 0;
+
+	const index_desc::idx_repeat* tail = idx->idx_rpt;
+	for (USHORT n = 0; n < idx->idx_count + idx->idx_includes; n++, tail++)
+	{
+		const dsc& desc = format->fmt_desc[tail->idx_field];
+		length += PAYLOAD_HEADER_SIZE + desc.dsc_length;
+
+		if (desc.dsc_dtype == dtype_varying)
+			length -= sizeof(USHORT);
+	}
+
+	return (USHORT) MIN(length, MAX_USHORT);
+}
+
+
 bool BTR_cleanup_index(thread_db* tdbb, const QualifiedName& relName, jrd_tra* transaction, MetaId id)
 {
 /**************************************
@@ -2963,7 +3172,7 @@ void BTR_reserve_slot(thread_db* tdbb, IndexCreation& creation, IndexCreateLock&
 
 	for (int retry = 0; retry < 3; ++retry)
 	{
-		len = idx->idx_count * sizeof(irtd);
+		len = (idx->idx_count + idx->idx_includes) * sizeof(irtd);
 
 		space = dbb->dbb_page_size;
 		slot = NULL;
@@ -3039,6 +3248,7 @@ void BTR_reserve_slot(thread_db* tdbb, IndexCreation& creation, IndexCreateLock&
 	slot->irt_desc = space;
 	fb_assert(idx->idx_count <= MAX_UCHAR);
 	slot->irt_keys = (UCHAR) idx->idx_count;
+	slot->irt_includes = (UCHAR) idx->idx_includes;
 	slot->irt_flags = idx->idx_flags;
 	slot->setInProgress(transaction->tra_number);
 
@@ -4019,7 +4229,7 @@ static USHORT compress_root(thread_db* tdbb, index_root_page* page)
 	{
 		if (root_idx->getRoot())
 		{
-			const USHORT len = root_idx->irt_keys * sizeof(irtd);
+			const USHORT len = (root_idx->irt_keys + root_idx->irt_includes) * sizeof(irtd);
 			p -= len;
 			memcpy(p, temp + root_idx->irt_desc, len);
 			root_idx->irt_desc = p - (UCHAR*) page;
@@ -4089,7 +4299,7 @@ static contents delete_node(thread_db* tdbb, WIN* window, UCHAR* pointer)
 	USHORT newNextLength = 0;
 	USHORT length = MAX(removingNode.length + removingNode.prefix, nextNode.length + nextNode.prefix);
 	HalfStaticArray<UCHAR, MAX_KEY> tempBuf;
-	UCHAR* tempData = tempBuf.getBuffer(length);
+	UCHAR* tempData = tempBuf.getBuffer(length + nextNode.payloadLength);
 	length = 0;
 	if (nextNode.prefix > removingNode.prefix)
 	{
@@ -4103,6 +4313,13 @@ static contents delete_node(thread_db* tdbb, WIN* window, UCHAR* pointer)
 	memcpy(tempData + length, nextNode.data, nextNode.length);
 	newNextLength += nextNode.length;
 
+	// The payload could be overwritten by the longer data, save it too
+	if (nextNode.payloadLength)
+	{
+		memcpy(tempData + newNextLength, nextNode.payload, nextNode.payloadLength);
+		nextNode.payload = tempData + newNextLength;
+	}
+
 	// Update the page prefix total.
 	page->btr_prefix_total -= (removingNode.prefix + (nextNode.prefix - newNextPrefix));
 
@@ -4398,6 +4615,15 @@ static void delete_tree(thread_db* tdbb,
 
 		// go through all the sibling pages on this level and release them
 		next = page->btr_sibling;
+
+		// the rightmost leaf page could be remembered as the insert position,
+		// see insert_last_leaf, so make sure it's not taken for a live one
+		if (!page->btr_level && !next.getPageNum())
+		{
+			CCH_MARK(tdbb, &window);
+			page->btr_header.pag_flags |= btr_released;
+		}
+
 		CCH_RELEASE_TAIL(tdbb, &window);
 		PAG_release_page(tdbb, window.win_page, prior);
 		prior = window.win_page;
@@ -4409,743 +4635,1315 @@ static void delete_tree(thread_db* tdbb,
 }
 
 
-static ULONG fast_load(thread_db* tdbb,
-					   IndexCreation& creation,
-					   SelectivityList& selectivity)
+namespace
 {
-/**************************************
- *
- *	f a s t _ l o a d
- *
- **************************************
- *
- * Functional description
- *	Do a fast load.  The indices have already been passed into sort, and
- *	are ripe for the plucking.  This beast is complicated, but, I hope,
- *	comprehendable.
- *
- **************************************/
-#ifdef DEBUG_BTR_PAGES
-	TEXT debugtext[1024];
-#endif
+	// Layout of the pages of the index being bulk loaded
 
-	SET_TDBB(tdbb);
-	const Database* const dbb = tdbb->getDatabase();
-	CHECK_DBB(dbb);
+	struct FastLoadPages
+	{
+		USHORT pageSpaceId;
+		MetaId relationId;
+		MetaId indexId;
+		USHORT pageSize;
+		USHORT jumpAreaSize;
+		USHORT leafFillLimit;		// leaf page is split when its nodes grow above it
+		USHORT pointerFillLimit;	// the same for the pointer pages
 
-	jrd_rel* const relation = creation.relation;
-	index_desc* const idx = creation.index;
-	const USHORT key_length = creation.key_length;
+		btree_page* allocatePage(thread_db* tdbb, WIN* window, UCHAR level) const
+		{
+			// Awkwardly, the bucket header has room for only a byte of index id
+			// and that's part of the ODS.  So, for now, we'll just record the first
+			// byte of the id and hope for the best.  Index buckets are (almost) always
+			// located through the index structure (dmp being an exception used
+			// only for debug) so the id is actually redundant.
+			btree_page* const bucket = (btree_page*) DPM_allocate(tdbb, window);
+			bucket->btr_header.pag_type = pag_index;
+			bucket->btr_relation = relationId;
+			bucket->btr_id = (UCHAR) (indexId % 256);
+			bucket->btr_level = level;
+			bucket->btr_length = BTR_SIZE;
+			bucket->btr_jump_interval = jumpAreaSize;
+			bucket->btr_jump_size = 0;
+			bucket->btr_jump_count = 0;
+
+			return bucket;
+		}
 
-	const USHORT pageSpaceID = relation->getPages(tdbb)->rel_pg_space_id;
+		void deleteTree(thread_db* tdbb, ULONG pageNumber) const
+		{
+			delete_tree(tdbb, relationId, indexId,
+				PageNumber(pageSpaceId, pageNumber), PageNumber(pageSpaceId, 0));
+		}
+	};
 
-	// leaf-page and pointer-page size limits, we always need to
-	// leave room for the END_LEVEL node.
-	const USHORT lp_fill_limit = dbb->dbb_page_size - BTN_LEAF_SIZE;
-	const USHORT pp_fill_limit = dbb->dbb_page_size - BTN_PAGE_SIZE;
+	// Receiver of the pages started while a level is loaded
 
-	// AB: Let's try to determine to size between the jumps to speed up
-	// index search. Of course the size depends on the key_length. The
-	// bigger the key, the less jumps we can make. (Although we must
-	// not forget that mostly the keys are compressed and much smaller
-	// than the maximum possible key!).
-	// These values can easily change without effect on previous created
-	// indices, cause this value is stored on each page.
-	// Remember, the lower the value how more jumpkeys are generated and
-	// how faster jumpkeys are recalculated on insert.
+	class FastLoadSink
+	{
+	public:
+		virtual ~FastLoadSink() {}
 
-	const USHORT jumpAreaSize = 512 + ((int) sqrt((float) key_length) * 16);
+		// The page of the level begins with the key, firstPage is the first page of the level
+		virtual void addPage(thread_db* tdbb, UCHAR level, ULONG firstPage,
+			const temporary_mini_key& key, RecordNumber recordNumber, ULONG pageNumber) = 0;
+	};
 
-	//  key_size  |  jumpAreaSize
-	//  ----------+-----------------
-	//         4  |    544
-	//         8  |    557
-	//        16  |    576
-	//        64  |    640
-	//       128  |    693
-	//       256  |    768
+	// Index level built from the left to the right. Its rightmost page stays
+	// latched until the level is finished.
 
-	WIN* window = NULL;
-	bool error = false;
-	FB_UINT64 count = 0;
-	FB_UINT64 duplicates = 0;
-	const bool unique = (idx->idx_flags & idx_unique);
-	const bool descending = (idx->idx_flags & idx_descending);
-	const ULONG segments = idx->idx_count;
+	class FastLoadLevel
+	{
+	public:
+		FastLoadLevel(MemoryPool& pool, const FastLoadPages& pages, UCHAR level, FastLoadSink* sink)
+			: m_pool(pool),
+			  m_pages(pages),
+			  m_level(level),
+			  m_sink(sink),
+			  m_jumpNodes(pool),
+			  m_payload(pool)
+		{
+			m_window.win_page.setPageSpaceID(pages.pageSpaceId);
+			m_key.key_length = 0;
+			m_key.key_flags = 0;
+			m_jumpKey.key_length = 0;
+			m_jumpKey.key_flags = 0;
+		}
 
-	// hvlad: look at IDX_create_index for explanations about NULL indicator below
-	const int nullIndLen = !descending && (idx->idx_count == 1) ? 1 : 0;
+		~FastLoadLevel()
+		{
+			clearJumpNodes();
+		}
 
-	MemoryPool& pool = *tdbb->getDefaultPool();
+		// Prefix the key has in common with the last key of the level
+		USHORT getPrefix(const UCHAR* key, USHORT length) const
+		{
+			return IndexNode::computePrefix(m_key.key_data, m_key.key_length, key, length);
+		}
 
-	HalfStaticArray<FB_UINT64, 4> duplicatesList(pool);
-	HalfStaticArray<FastLoadLevel, 4> levels(pool);
+		const temporary_mini_key& getKey() const
+		{
+			return m_key;
+		}
 
-	try
+		ULONG getFirstPage() const
+		{
+			return m_firstPage;
+		}
+
+		ULONG getLastPage() const
+		{
+			return m_window.win_page.getPageNum();
+		}
+
+		void add(thread_db* tdbb, USHORT prefix, const UCHAR* key, USHORT length,
+			RecordNumber recordNumber, ULONG pageNumber = 0,
+			const UCHAR* payload = nullptr, USHORT payloadLength = 0);
+		void finish(thread_db* tdbb, const temporary_mini_key* nextKey = nullptr,
+			RecordNumber nextRecordNumber = RecordNumber(0));
+
+		// CCH_unwind does not release page buffers (as we
+		// set TDBB_no_cache_unwind flag), do it after errors
+		void release(thread_db* tdbb)
+		{
+			if (m_window.win_bdb)
+				CCH_RELEASE(tdbb, &m_window);
+		}
+
+	private:
+		void startPage(thread_db* tdbb);
+		void closePage(thread_db* tdbb);
+		void split(thread_db* tdbb);
+		void addJumpNode(const IndexNode& node, USHORT fillLimit);
+		void clearJumpNodes();
+
+		MemoryPool& m_pool;
+		const FastLoadPages& m_pages;
+		const UCHAR m_level;
+		FastLoadSink* const m_sink;
+		win_for_array m_window;
+		btree_page* m_bucket = nullptr;
+		UCHAR* m_lastNode = nullptr;		// the last node of the current page
+		ULONG m_firstPage = 0;
+		USHORT m_nextJumpArea = 0;			// page offset where the next jump node is due
+		USHORT m_totalJumpSize = 0;
+		temporary_mini_key m_key;			// the last key stored, to compress the next one
+		temporary_mini_key m_jumpKey;
+		JumpNodeList m_jumpNodes;
+		HalfStaticArray<UCHAR, 256> m_payload;
+	};
+
+	void FastLoadLevel::add(thread_db* tdbb, USHORT prefix, const UCHAR* key, USHORT length,
+		RecordNumber recordNumber, ULONG pageNumber, const UCHAR* payload, USHORT payloadLength)
 	{
-		levels.resize(1);
-		FastLoadLevel* leafLevel = &levels[0];
-
-		// Initialize level
-		leafLevel->window.win_page.setPageSpaceID(pageSpaceID);
-
-		// Allocate and format the first leaf level bucket.  Awkwardly,
-		// the bucket header has room for only a byte of index id and that's
-		// part of the ODS.  So, for now, we'll just record the first byte
-		// of the id and hope for the best.  Index buckets are (almost) always
-		// located through the index structure (dmp being an exception used
-		// only for debug) so the id is actually redundant.
-		btree_page* bucket = (btree_page*) DPM_allocate(tdbb, &leafLevel->window);
-		bucket->btr_header.pag_type = pag_index;
-		bucket->btr_relation = relation->getId();
-		bucket->btr_id = (UCHAR)(idx->idx_id % 256);
-		bucket->btr_level = 0;
-		bucket->btr_length = BTR_SIZE;
-		bucket->btr_jump_interval = jumpAreaSize;
-		bucket->btr_jump_size = 0;
-		bucket->btr_jump_count = 0;
+		const bool leafPage = (m_level == 0);
 
-#ifdef DEBUG_BTR_PAGES
-		snprintf(debugtext, sizeof(debugtext), "\t new page (%d)", windows[0].win_page);
-		gds__log(debugtext);
-#endif
+		if (!m_bucket)
+			startPage(tdbb);
 
-		UCHAR* pointer = bucket->btr_nodes;
+		IndexNode node;
+		node.setNode(prefix, length - prefix, recordNumber, pageNumber);
+		node.data = const_cast<UCHAR*>(key) + prefix;
+		node.setPayload(const_cast<UCHAR*>(payload), payloadLength);
 
-		leafLevel->levelNode.setNode();
-		leafLevel->jumpNodes = FB_NEW_POOL(pool) JumpNodeList(pool);
-		leafLevel->newAreaPointer = pointer + jumpAreaSize;
+		// If the length of the new node will cause us to overflow the bucket,
+		// form a new bucket.
+		const USHORT fillLimit = leafPage ? m_pages.leafFillLimit : m_pages.pointerFillLimit;
 
-		tdbb->tdbb_flags |= TDBB_no_cache_unwind;
+		if (m_lastNode &&
+			m_bucket->btr_length + m_totalJumpSize + node.getNodeSize(leafPage) > fillLimit)
+		{
+			split(tdbb);
+		}
 
-		leafLevel->bucket = bucket;
+		// Insert the new node in the current bucket
+		m_bucket->btr_prefix_total += prefix;
+		const UCHAR* const pointer = node.writeNode((UCHAR*) m_bucket + m_bucket->btr_length, leafPage);
+		m_lastNode = node.nodePointer;
 
-		duplicatesList.grow(segments);
-		memset(duplicatesList.begin(), 0, segments * sizeof(FB_UINT64));
+		// Update the length of the page.
+		m_bucket->btr_length = pointer - (UCHAR*) m_bucket;
+		if (m_bucket->btr_length > m_pages.pageSize)
+			BUGCHECK(205);	// msg 205 index bucket overfilled
 
-		// If there's an error during index construction, fall
-		// thru to release the last index bucket at each level
-		// of the index. This will prepare for a single attempt
-		// to deallocate the index pages for reuse.
-		IndexNode newNode;
-		IndexNode previousNode;
-		// pointer holds the "main" pointer for inserting new nodes.
+		// Remember the last key inserted to compress the next one.
+		memcpy(m_key.key_data + prefix, key + prefix, length - prefix);
+		m_key.key_length = length;
 
-		win_for_array split_window;
-		split_window.win_page.setPageSpaceID(pageSpaceID);
+		if (m_nextJumpArea < m_bucket->btr_length)
+			addJumpNode(node, fillLimit);
+	}
 
-		temporary_mini_key split_key, temp_key;
-		split_key.key_flags = 0;
-		split_key.key_length = 0;
-		temp_key.key_flags = 0;
-		temp_key.key_length = 0;
-		bool duplicate = false;
+	void FastLoadLevel::finish(thread_db* tdbb, const temporary_mini_key* nextKey,
+		RecordNumber nextRecordNumber)
+	{
+		const bool leafPage = (m_level == 0);
 
-		IndexNode tempNode;
+		if (!m_bucket)
+			startPage(tdbb);
 
-		// Detect the case when set of duplicate keys contains more then one key
-		// from primary record version. It breaks the unique constraint and must
-		// be rejected. Note, it is not always could be detected while sorting.
-		// Set to true when primary record version is found in current set of
-		// duplicate keys.
-		bool primarySeen = false;
+		IndexNode node;
 
-		while (!error)
+		if (nextKey)
 		{
-			// Get the next record in sorted order.
+			// The level is continued by the page built separately. Like after a page
+			// split, the end of bucket marker contains the first node of that page.
+			fb_assert(leafPage);
+
+			const USHORT prefix = getPrefix(nextKey->key_data, nextKey->key_length);
+			node.setNode(prefix, nextKey->key_length - prefix, nextRecordNumber);
+			node.data = const_cast<UCHAR*>(nextKey->key_data) + prefix;
+			node.setEndBucket();
+
+			// The marker is longer than the end of level one the fill limit reserves
+			// room for, move the last node to a new page if it doesn't fit
+			if (m_lastNode &&
+				m_bucket->btr_length + m_totalJumpSize + node.getNodeSize(leafPage) > m_pages.pageSize)
+			{
+				split(tdbb);
+			}
+		}
+		else
+			node.setEndLevel();
 
-			UCHAR* record;
-			creation.sort->get(tdbb, reinterpret_cast<ULONG**>(&record));
+		const UCHAR* const pointer = node.writeNode((UCHAR*) m_bucket + m_bucket->btr_length, leafPage);
+		m_bucket->btr_length = pointer - (UCHAR*) m_bucket;
 
-			if (!record || creation.duplicates.value())
-				break;
+		closePage(tdbb);
+	}
 
-			index_sort_record* isr = (index_sort_record*) (record + key_length);
-			count++;
-			record += nullIndLen;
+	void FastLoadLevel::startPage(thread_db* tdbb)
+	{
+		m_bucket = m_pages.allocatePage(tdbb, &m_window, m_level);
+		m_firstPage = m_window.win_page.getPageNum();
+		m_nextJumpArea = BTR_SIZE + m_pages.jumpAreaSize;
+	}
 
-			leafLevel = &levels[0]; // reset after possible array reallocation
+	void FastLoadLevel::closePage(thread_db* tdbb)
+	{
+		// Store jump nodes on page if needed.
+		if (m_totalJumpSize)
+		{
+			// Slide down current nodes, i.e. move them higher in memory
+			const USHORT l = m_bucket->btr_length - BTR_SIZE;
+			memmove(m_bucket->btr_nodes + m_totalJumpSize, m_bucket->btr_nodes, l);
 
-			// restore previous values
-			bucket = leafLevel->bucket;
-			leafLevel->splitPage = 0;
+			// Update JumpInfo
+			if (m_jumpNodes.getCount() > MAX_UCHAR)
+				BUGCHECK(205);	// msg 205 index bucket overfilled
 
-			temporary_mini_key* const leafKey = &leafLevel->key;
-			JumpNodeList* const leafJumpNodes = leafLevel->jumpNodes;
-			temporary_mini_key* const leafJumpKey = &leafLevel->jumpKey;
+			m_bucket->btr_jump_interval = m_pages.jumpAreaSize;
+			m_bucket->btr_jump_size = m_totalJumpSize;
+			m_bucket->btr_jump_count = (UCHAR) m_jumpNodes.getCount();
 
-			// Compute the prefix as the length in common with the previous record's key.
-			USHORT prefix =
-				IndexNode::computePrefix(leafKey->key_data, leafKey->key_length, record, isr->isr_key_length);
+			// Write jumpnodes on page.
+			UCHAR* pointer = m_bucket->btr_nodes;
+			for (auto& jumpNode : m_jumpNodes)
+			{
+				// Update offset position first.
+				jumpNode.offset += m_totalJumpSize;
+				pointer = jumpNode.writeJumpNode(pointer);
+			}
 
-			// set node values
-			newNode.setNode(prefix, isr->isr_key_length - prefix,
-						    RecordNumber(isr->isr_record_number));
-			newNode.data = record + prefix;
+			m_bucket->btr_length += m_totalJumpSize;
+		}
 
-			// If the length of the new node will cause us to overflow the bucket,
-			// form a new bucket.
-			if (bucket->btr_length + leafLevel->totalJumpSize +
-				newNode.getNodeSize(true) > lp_fill_limit)
-			{
-				// mark the end of the previous page
-				const RecordNumber lastRecordNumber = previousNode.recordNumber;
-				previousNode.readNode(previousNode.nodePointer, true);
-				previousNode.setEndBucket();
-				pointer = previousNode.writeNode(previousNode.nodePointer, true, false);
-				bucket->btr_length = pointer - (UCHAR*) bucket;
-
-				if (leafLevel->totalJumpSize)
-				{
-					// Slide down current nodes;
-					// CVC: Warning, this may overlap. It seems better to use
-					// memmove or to ensure manually that leafLevel->totalJumpSize > l
-					// Also, "sliding down" here is moving contents higher in memory.
-					const USHORT l = bucket->btr_length - BTR_SIZE;
-					memmove(bucket->btr_nodes + leafLevel->totalJumpSize, bucket->btr_nodes, l);
-
-					// Update JumpInfo
-					if (leafJumpNodes->getCount() > MAX_UCHAR)
-						BUGCHECK(205);	// msg 205 index bucket overfilled
-
-					bucket->btr_jump_interval = jumpAreaSize;
-					bucket->btr_jump_size = leafLevel->totalJumpSize;
-					bucket->btr_jump_count = (UCHAR) leafJumpNodes->getCount();
-
-					// Write jumpnodes on page.
-					pointer = bucket->btr_nodes;
-					IndexJumpNode* walkJumpNode = leafJumpNodes->begin();
-					for (size_t i = 0; i < leafJumpNodes->getCount(); i++)
-					{
-						// Update offset position first.
-						walkJumpNode[i].offset += leafLevel->totalJumpSize;
-						pointer = walkJumpNode[i].writeJumpNode(pointer);
-					}
+		if (m_bucket->btr_length > m_pages.pageSize)
+			BUGCHECK(205);	// msg 205 index bucket overfilled
 
-					bucket->btr_length += leafLevel->totalJumpSize;
-				}
+		CCH_RELEASE(tdbb, &m_window);
+		m_bucket = nullptr;
 
-				if (bucket->btr_length > dbb->dbb_page_size)
-					BUGCHECK(205);	// msg 205 index bucket overfilled
-
-				// Allocate new bucket.
-				btree_page* split = (btree_page*) DPM_allocate(tdbb, &split_window);
-				bucket->btr_sibling = split_window.win_page.getPageNum();
-				split->btr_left_sibling = leafLevel->window.win_page.getPageNum();
-				split->btr_header.pag_type = pag_index;
-				split->btr_relation = bucket->btr_relation;
-				split->btr_level = bucket->btr_level;
-				split->btr_id = bucket->btr_id;
-				split->btr_jump_interval = bucket->btr_jump_interval;
-				split->btr_jump_size = 0;
-				split->btr_jump_count = 0;
-
-#ifdef DEBUG_BTR_PAGES
-				snprintf(debugtext, sizeof(debugtext), "\t new page (%d), left page (%d)",
-					split_window.win_page, split->btr_left_sibling);
-				gds__log(debugtext);
-#endif
+		clearJumpNodes();
+	}
 
-				// Reset position and size for generating jumpnode
-				pointer = split->btr_nodes;
-				leafLevel->newAreaPointer = pointer + jumpAreaSize;
-				leafLevel->totalJumpSize = 0;
-				leafJumpKey->key_length = 0;
-
-				// store the first node on the split page
-				IndexNode splitNode;
-				splitNode.setNode(0, leafKey->key_length, lastRecordNumber);
-				splitNode.data = leafKey->key_data;
-				pointer = splitNode.writeNode(pointer, true);
-				previousNode = splitNode;
-
-				// save the page number of the previous page and release it
-				leafLevel->splitPage = leafLevel->window.win_page.getPageNum();
-				leafLevel->splitRecordNumber = splitNode.recordNumber;
-				CCH_RELEASE(tdbb, &leafLevel->window);
-
-#ifdef DEBUG_BTR_PAGES
-				snprintf(debugtext, sizeof(debugtext),
-					"\t release page (%d), left page (%d), right page (%d)",
-					leafLevel->window.win_page,
-					((btr*) leafLevel->window.win_buffer)->btr_left_sibling,
-					((btr*) leafLevel->window.win_buffer)->btr_sibling);
-				gds__log(debugtext);
-#endif
+	void FastLoadLevel::split(thread_db* tdbb)
+	{
+		const bool leafPage = (m_level == 0);
 
-				// set up the new page as the "current" page
-				leafLevel->window = split_window;
-				leafLevel->bucket = bucket = split;
+		// Mark the end of the page. The last node moves to the new page and
+		// the end_bucket marker keeps its key as the first key of that page.
+		IndexNode lastNode;
+		lastNode.readNode(m_lastNode, leafPage);
+		const RecordNumber lastRecordNumber = lastNode.recordNumber;
+		const ULONG lastPageNumber = lastNode.pageNumber;
 
-				// save the first key on page as the page to be propagated
-				copy_key(leafKey, &split_key);
+		// The payload moves together with the last node,
+		// save it before the page is rearranged
+		m_payload.clear();
+		if (lastNode.payloadLength)
+			m_payload.assign(lastNode.payload, lastNode.payloadLength);
 
-				// Clear jumplist.
-				IndexJumpNode* walkJumpNode = leafJumpNodes->begin();
-				for (size_t i = 0; i < leafJumpNodes->getCount(); i++)
-					delete[] walkJumpNode[i].data;
+		lastNode.setEndBucket();
+		const UCHAR* const pointer = lastNode.writeNode(m_lastNode, leafPage, false);
+		m_bucket->btr_length = pointer - (UCHAR*) m_bucket;
 
-				leafJumpNodes->clear();
-			}
+		// Allocate new bucket.
+		win_for_array splitWindow;
+		splitWindow.win_page.setPageSpaceID(m_pages.pageSpaceId);
+		btree_page* const split = m_pages.allocatePage(tdbb, &splitWindow, m_level);
 
-			// Insert the new node in the current bucket
-			bucket->btr_prefix_total += prefix;
-			pointer = newNode.writeNode(pointer, true);
-			previousNode = newNode;
+		m_bucket->btr_sibling = splitWindow.win_page.getPageNum();
+		split->btr_left_sibling = m_window.win_page.getPageNum();
 
-			// if we have a compound-index calculate duplicates per segment.
-			if (segments > 1 && count > 1)
-			{
-				// Initialize variables for segment duplicate check.
-				// count holds the current checking segment (starting by
-				// the maximum segment number to 1).
-				const UCHAR* p1 = leafKey->key_data;
-				const UCHAR* const p1_end = p1 + leafKey->key_length;
-				const UCHAR* p2 = newNode.data;
-				const UCHAR* const p2_end = p2 + newNode.length;
-				SSHORT segment, stuff_count;
-				if (newNode.prefix == 0)
-				{
-					segment = *p2;
-					//pos = 0;
-					stuff_count = 0;
-				}
-				else
-				{
-					const SSHORT pos = newNode.prefix;
-					// find the segment number were we're starting.
-					const SSHORT i = (pos / (STUFF_COUNT + 1)) * (STUFF_COUNT + 1);
-					if (i == pos)
-					{
-						// We _should_ pick number from data if available
-						segment = *p2;
-					}
-					else
-						segment = *(p1 + i);
+		closePage(tdbb);
 
-					// update stuff_count to the current position.
-					stuff_count = STUFF_COUNT + 1 - (pos - i);
-					p1 += pos;
-				}
+		// set up the new page as the "current" page
+		m_window = splitWindow;
+		m_bucket = split;
+		m_nextJumpArea = BTR_SIZE + m_pages.jumpAreaSize;
+		m_totalJumpSize = 0;
+		m_jumpKey.key_length = 0;
 
-				//Look for duplicates in the segments
-				while ((p1 < p1_end) && (p2 < p2_end))
-				{
-					if (stuff_count == 0)
-					{
-						if (*p1 != *p2)
-						{
-							// We're done
-							break;
-						}
-						segment = *p2;
-						p1++;
-						p2++;
-						stuff_count = STUFF_COUNT;
-					}
+		// store the first node on the split page
+		IndexNode splitNode;
+		splitNode.setNode(0, m_key.key_length, lastRecordNumber, lastPageNumber);
+		splitNode.data = m_key.key_data;
+		splitNode.setPayload(m_payload.begin(), (USHORT) m_payload.getCount());
+		const UCHAR* const end = splitNode.writeNode(split->btr_nodes, leafPage);
+		m_lastNode = splitNode.nodePointer;
+		split->btr_length = end - (UCHAR*) split;
+
+		// and propagate the new page upward
+		if (m_sink)
+		{
+			m_sink->addPage(tdbb, m_level, m_firstPage, m_key, lastRecordNumber,
+				m_window.win_page.getPageNum());
+		}
+	}
+
+	void FastLoadLevel::addJumpNode(const IndexNode& node, USHORT fillLimit)
+	{
+		IndexJumpNode jumpNode;
+		jumpNode.prefix = IndexNode::computePrefix(m_jumpKey.key_data, m_jumpKey.key_length,
+			m_key.key_data, node.prefix);
+		jumpNode.length = node.prefix - jumpNode.prefix;
+
+		// Ensure the new jumpnode fits in the bucket
+		const USHORT jumpNodeSize = jumpNode.getJumpNodeSize();
+		if (m_bucket->btr_length + m_totalJumpSize + jumpNodeSize >= fillLimit)
+			return;
+
+		// Initialize the rest of the jumpnode
+		jumpNode.offset = node.nodePointer - (UCHAR*) m_bucket;
+		jumpNode.data = FB_NEW_POOL(m_pool) UCHAR[jumpNode.length];
+		memcpy(jumpNode.data, m_key.key_data + jumpNode.prefix, jumpNode.length);
+		m_jumpNodes.add(jumpNode);
+
+		// Store new data in jumpKey, so a new jump node can calculate prefix
+		memcpy(m_jumpKey.key_data + jumpNode.prefix, jumpNode.data, jumpNode.length);
+		m_jumpKey.key_length = jumpNode.length + jumpNode.prefix;
+
+		// Set new position for generating jumpnode
+		m_nextJumpArea += m_pages.jumpAreaSize;
+		m_totalJumpSize += jumpNodeSize;
+	}
+
+	void FastLoadLevel::clearJumpNodes()
+	{
+		for (auto& jumpNode : m_jumpNodes)
+			delete[] jumpNode.data;
+
+		m_jumpNodes.clear();
+	}
+
+	// Upper levels of the index. A level is created when the first
+	// page of the level below it gets split.
+
+	class FastLoadTree : public FastLoadSink
+	{
+	public:
+		FastLoadTree(MemoryPool& pool, const FastLoadPages& pages)
+			: m_pool(pool),
+			  m_pages(pages),
+			  m_levels(pool)
+		{}
+
+		~FastLoadTree()
+		{
+			for (auto level : m_levels)
+				delete level;
+		}
+
+		void addPage(thread_db* tdbb, UCHAR level, ULONG firstPage,
+			const temporary_mini_key& key, RecordNumber recordNumber, ULONG pageNumber) override
+		{
+			const unsigned upper = level + 1;
+
+			if (upper > m_levels.getCount())
+			{
+				if (upper == MAX_LEVELS)
+				{
+					// Maximum level depth reached
+					status_exception::raise(Arg::Gds(isc_imp_exc) <<
+						Arg::Gds(isc_max_idx_depth) << Arg::Num(MAX_LEVELS));
+				}
+
+				FastLoadLevel* const newLevel = FB_NEW_POOL(m_pool)
+					FastLoadLevel(m_pool, m_pages, (UCHAR) upper, this);
+				m_levels.add(newLevel);
+
+				// since this is the beginning of the level, we propagate the lower-level
+				// page with a "degenerate" zero-length node indicating that this page holds
+				// any key value less than the next node, its record number must be zero
+				newLevel->add(tdbb, 0, key.key_data, 0, RecordNumber(0), firstPage);
+			}
+
+			FastLoadLevel* const currLevel = m_levels[level];
+			currLevel->add(tdbb, currLevel->getPrefix(key.key_data, key.key_length),
+				key.key_data, key.key_length, recordNumber, pageNumber);
+		}
+
+		// Put an end of level marker on the last bucket of each level
+		void finish(thread_db* tdbb)
+		{
+			for (auto level : m_levels)
+				level->finish(tdbb);
+		}
+
+		void release(thread_db* tdbb)
+		{
+			for (auto level : m_levels)
+				level->release(tdbb);
+		}
+
+		// Root page, or zero if the leaf level is the only one
+		ULONG getRoot() const
+		{
+			return m_levels.hasData() ? m_levels.back()->getFirstPage() : 0;
+		}
+
+	private:
+		MemoryPool& m_pool;
+		const FastLoadPages& m_pages;
+		HalfStaticArray<FastLoadLevel*, 4> m_levels;
+	};
+
+	// Counts of the duplicate keys, the index selectivity is computed from them
+
+	class FastLoadStatistics
+	{
+	public:
+		FastLoadStatistics(MemoryPool& pool, const index_desc* idx)
+			: m_segments(idx->idx_count),
+			  m_descending(idx->idx_flags & idx_descending),
+			  m_duplicatesList(pool)
+		{
+			m_duplicatesList.grow(m_segments);
+			memset(m_duplicatesList.begin(), 0, m_segments * sizeof(FB_UINT64));
+		}
+
+		FB_UINT64 getCount() const
+		{
+			return m_count;
+		}
 
+		void addKey()
+		{
+			m_count++;
+		}
+
+		void add(const FastLoadStatistics& other)
+		{
+			m_count += other.m_count;
+			m_duplicates += other.m_duplicates;
+
+			for (ULONG i = 0; i < m_segments; i++)
+				m_duplicatesList[i] += other.m_duplicatesList[i];
+		}
+
+		bool checkDuplicate(const temporary_mini_key& prior, const UCHAR* key, USHORT length, USHORT prefix);
+		void getSelectivity(SelectivityList& selectivity) const;
+
+	private:
+		const ULONG m_segments;
+		const bool m_descending;
+		FB_UINT64 m_count = 0;
+		FB_UINT64 m_duplicates = 0;
+		HalfStaticArray<FB_UINT64, 4> m_duplicatesList;
+	};
+
+	// Account the key following the prior one, return true if they're equal
+
+	bool FastLoadStatistics::checkDuplicate(const temporary_mini_key& prior,
+		const UCHAR* key, USHORT length, USHORT prefix)
+	{
+		// if we have a compound-index calculate duplicates per segment.
+		if (m_segments > 1)
+		{
+			// Initialize variables for segment duplicate check.
+			// count holds the current checking segment (starting by
+			// the maximum segment number to 1).
+			const UCHAR* p1 = prior.key_data;
+			const UCHAR* const p1_end = p1 + prior.key_length;
+			const UCHAR* p2 = key + prefix;
+			const UCHAR* const p2_end = key + length;
+			SSHORT segment, stuff_count;
+			if (prefix == 0)
+			{
+				segment = *p2;
+				//pos = 0;
+				stuff_count = 0;
+			}
+			else
+			{
+				const SSHORT pos = prefix;
+				// find the segment number were we're starting.
+				const SSHORT i = (pos / (STUFF_COUNT + 1)) * (STUFF_COUNT + 1);
+				if (i == pos)
+				{
+					// We _should_ pick number from data if available
+					segment = *p2;
+				}
+				else
+					segment = *(p1 + i);
+
+				// update stuff_count to the current position.
+				stuff_count = STUFF_COUNT + 1 - (pos - i);
+				p1 += pos;
+			}
+
+			//Look for duplicates in the segments
+			while ((p1 < p1_end) && (p2 < p2_end))
+			{
+				if (stuff_count == 0)
+				{
 					if (*p1 != *p2)
 					{
-						//We're done
+						// We're done
 						break;
 					}
-
+					segment = *p2;
 					p1++;
 					p2++;
-					stuff_count--;
+					stuff_count = STUFF_COUNT;
 				}
 
-				// For descending indexes the segment-number is also
-				// complemented, thus reverse it back.
-				// Note: values are complemented per UCHAR base.
-				if (descending)
-					segment = (255 - segment);
+				if (*p1 != *p2)
+				{
+					//We're done
+					break;
+				}
 
-				if ((p1 == p1_end) && (p2 == p2_end))
-					segment = 0; // All segments are duplicates
+				p1++;
+				p2++;
+				stuff_count--;
+			}
 
-				for (ULONG i = segment + 1; i <= segments; i++)
-					duplicatesList[segments - i]++;
+			// For descending indexes the segment-number is also
+			// complemented, thus reverse it back.
+			// Note: values are complemented per UCHAR base.
+			if (m_descending)
+				segment = (255 - segment);
+
+			if ((p1 == p1_end) && (p2 == p2_end))
+				segment = 0; // All segments are duplicates
+
+			for (ULONG i = segment + 1; i <= m_segments; i++)
+				m_duplicatesList[m_segments - i]++;
+		}
+
+		// check if this is a duplicate node
+		const bool duplicate = (length == prefix && prefix == prior.key_length);
+		if (duplicate)
+			++m_duplicates;
+
+		return duplicate;
+	}
+
+	void FastLoadStatistics::getSelectivity(SelectivityList& selectivity) const
+	{
+		// Calculate selectivity, also per segment when newer ODS
+		selectivity.grow(m_segments);
+		if (m_segments > 1)
+		{
+			for (ULONG i = 0; i < m_segments; i++)
+				selectivity[i] = (float) (m_count ? 1.0 / (float) (m_count - m_duplicatesList[i]) : 0.0);
+		}
+		else
+			selectivity[0] = (float) (m_count ? (1.0 / (float) (m_count - m_duplicates)) : 0.0);
+	}
+
+	// Leaf level loaded from the sorted index keys
+
+	class FastLoadLeaf
+	{
+	public:
+		FastLoadLeaf(MemoryPool& pool, IndexCreation& creation, const FastLoadPages& pages,
+				FastLoadSink* sink, FastLoadStatistics& statistics)
+			: level(pool, pages, 0, sink),
+			  m_creation(creation),
+			  m_statistics(statistics)
+		{}
+
+		void put(thread_db* tdbb, const UCHAR* record);
+
+		FastLoadLevel level;
+
+	private:
+		IndexCreation& m_creation;
+		FastLoadStatistics& m_statistics;
+
+		// Detect the case when set of duplicate keys contains more then one key
+		// from primary record version. It breaks the unique constraint and must
+		// be rejected. Note, it is not always could be detected while sorting.
+		// Set to true when primary record version is found in current set of
+		// duplicate keys.
+		bool m_primarySeen = false;
+	};
+
+	// Store the sort record: the key is followed by index_sort_record and the payload
+
+	void FastLoadLeaf::put(thread_db* tdbb, const UCHAR* record)
+	{
+		const index_sort_record* const isr = (const index_sort_record*) (record + m_creation.key_length);
+
+		// hvlad: look at IDX_create_index for explanations about NULL indicator
+		const UCHAR* const key = record + m_creation.nullIndLen;
+		const USHORT length = isr->isr_key_length;
+
+		// Compute the prefix as the length in common with the previous record's key.
+		const USHORT prefix = level.getPrefix(key, length);
+
+		const bool duplicate = m_statistics.getCount() &&
+			m_statistics.checkDuplicate(level.getKey(), key, length, prefix);
+
+		const bool isPrimary = !(isr->isr_flags & ISR_secondary);
+		if (duplicate)
+		{
+			if ((m_creation.index->idx_flags & idx_unique) && m_primarySeen && isPrimary &&
+				!(isr->isr_flags & ISR_null))
+			{
+				++m_creation.duplicates;
+				m_creation.dup_recno = isr->isr_record_number;
 			}
 
-			// check if this is a duplicate node
-			duplicate = (!newNode.length && prefix == leafKey->key_length);
-			const bool isPrimary = !(isr->isr_flags & ISR_secondary);
-			if (duplicate && (count > 1))
+			if (isPrimary)
+				m_primarySeen = true;
+		}
+		else
+			m_primarySeen = isPrimary;
+
+		m_statistics.addKey();
+
+		level.add(tdbb, prefix, key, length, RecordNumber(isr->isr_record_number), 0,
+			(const UCHAR*) (isr + 1), isr->isr_payload_length);
+	}
+
+	// Leaf pages filled by a worker from a batch of the sorted keys. The first
+	// keys of the pages are kept to build the upper levels over them later.
+
+	class FastLoadChain : public FastLoadSink
+	{
+	public:
+		FastLoadChain(MemoryPool& pool, const index_desc* idx)
+			: statistics(pool, idx),
+			  m_pages(pool)
+		{
+			firstKey.key_length = 0;
+			firstKey.key_flags = 0;
+		}
+
+		void addPage(thread_db* /*tdbb*/, UCHAR level, ULONG /*firstPage*/,
+			const temporary_mini_key& key, RecordNumber recordNumber, ULONG pageNumber) override
+		{
+			fb_assert(level == 0);
+
+			const SINT64 number = recordNumber.getValue();
+			m_pages.add((const UCHAR*) &pageNumber, sizeof(pageNumber));
+			m_pages.add((const UCHAR*) &number, sizeof(number));
+			m_pages.add((const UCHAR*) &key.key_length, sizeof(key.key_length));
+			m_pages.add(key.key_data, key.key_length);
+		}
+
+		// Pass the pages of the chain but the first one to the upper levels
+		void propagate(thread_db* tdbb, FastLoadSink* sink, ULONG levelPage) const
+		{
+			temporary_mini_key key;
+			key.key_flags = 0;
+
+			for (const UCHAR* p = m_pages.begin(); p < m_pages.end(); p += key.key_length)
 			{
-				++duplicates;
-				if (unique && primarySeen && isPrimary && !(isr->isr_flags & ISR_null))
-				{
-					++creation.duplicates;
-					creation.dup_recno = isr->isr_record_number;
-				}
+				ULONG pageNumber;
+				memcpy(&pageNumber, p, sizeof(pageNumber));
+				p += sizeof(pageNumber);
 
-				if (isPrimary)
-					primarySeen = true;
+				SINT64 number;
+				memcpy(&number, p, sizeof(number));
+				p += sizeof(number);
+
+				memcpy(&key.key_length, p, sizeof(key.key_length));
+				p += sizeof(key.key_length);
+				memcpy(key.key_data, p, key.key_length);
+
+				sink->addPage(tdbb, 0, levelPage, key, RecordNumber(number), pageNumber);
 			}
-			else
-				primarySeen = isPrimary;
+		}
 
-			// Update the length of the page.
-			bucket->btr_length = pointer - (UCHAR*) bucket;
-			if (bucket->btr_length > dbb->dbb_page_size)
-				BUGCHECK(205);	// msg 205 index bucket overfilled
+		FastLoadStatistics statistics;
+		temporary_mini_key firstKey;
+		RecordNumber firstRecordNumber;
+		ULONG firstPage = 0;
+		ULONG lastPage = 0;
+
+	private:
+		Array<UCHAR> m_pages;	// page number, record number and key of every next page
+	};
+
+	// Builds the leaf level of the index by the parallel workers. Consecutive
+	// batches of the sorted keys are stored into separate chains of leaf pages,
+	// then the chains are linked together and the upper levels are built over
+	// them by the attachment creating the index.
+
+	class IndexBuildTask : public Task
+	{
+	public:
+		IndexBuildTask(thread_db* tdbb, MemoryPool* pool, IndexCreation* creation,
+				const FastLoadPages& pages, int workers)
+			: Task(),
+			  m_pool(pool),
+			  m_dbb(tdbb->getDatabase()),
+			  m_tdbb_flags(tdbb->tdbb_flags),
+			  m_creation(creation),
+			  m_pages(pages),
+			  m_items(*m_pool),
+			  m_chains(*m_pool),
+			  m_pending(*m_pool),
+			  m_boundary(*m_pool, creation->index),
+			  m_stop(false),
+			  m_eof(false)
+		{
+			m_lastKey.key_length = 0;
+			m_lastKey.key_flags = 0;
+
+			for (int i = 0; i < workers; i++)
+				m_items.add(FB_NEW_POOL(*m_pool) Item(this));
 
-			// Remember the last key inserted to compress the next one.
-			leafKey->key_length = isr->isr_key_length;
-			memcpy(leafKey->key_data, record, leafKey->key_length);
+			m_items[0]->m_ownAttach = false;
+			m_items[0]->m_attStable = tdbb->getAttachment()->getStable();
+		}
 
-			if (leafLevel->newAreaPointer < pointer)
+		~IndexBuildTask()
+		{
+			for (auto item : m_items)
+				delete item;
+
+			for (auto chain : m_chains)
+				delete chain;
+		}
+
+		bool handler(WorkItem& _item) override;
+		bool getWorkItem(WorkItem** pItem) override;
+
+		bool getResult(IStatus* status) override
+		{
+			if (status)
 			{
-				// Create a jumpnode
-				IndexJumpNode jumpNode;
-				jumpNode.prefix = IndexNode::computePrefix(leafJumpKey->key_data,
-					leafJumpKey->key_length, leafKey->key_data, newNode.prefix);
-				jumpNode.length = newNode.prefix - jumpNode.prefix;
-
-				const USHORT jumpNodeSize = jumpNode.getJumpNodeSize();
-				// Ensure the new jumpnode fits in the bucket
-				if (bucket->btr_length + leafLevel->totalJumpSize + jumpNodeSize < lp_fill_limit)
-				{
-					// Initialize the rest of the jumpnode
-					jumpNode.offset = (newNode.nodePointer - (UCHAR*) bucket);
-					jumpNode.data = FB_NEW_POOL(pool) UCHAR[jumpNode.length];
-					memcpy(jumpNode.data, leafKey->key_data + jumpNode.prefix, jumpNode.length);
-					// Push node on end in list
-					leafJumpNodes->add(jumpNode);
-					// Store new data in leafJumpKey, so a new jump node can calculate prefix
-					memcpy(leafJumpKey->key_data + jumpNode.prefix, jumpNode.data, jumpNode.length);
-					leafJumpKey->key_length = jumpNode.length + jumpNode.prefix;
-					// Set new position for generating jumpnode
-					leafLevel->newAreaPointer += jumpAreaSize;
-					leafLevel->totalJumpSize += jumpNodeSize;
-				}
+				status->init();
+				status->setErrors(m_status.getErrors());
+			}
+
+			return m_status.isSuccess();
+		}
+
+		int getMaxWorkers() override
+		{
+			return m_items.getCount();
+		}
+
+		ULONG buildTree(thread_db* tdbb, FastLoadStatistics& statistics);
+		void deleteChains(thread_db* tdbb);
+
+	private:
+		// Keys are passed to the workers by batches of about this size
+		static const FB_SIZE_T BATCH_SIZE = 1024 * 1024;
+
+		class Item : public Task::WorkItem
+		{
+		public:
+			Item(IndexBuildTask* task)
+				: Task::WorkItem(task),
+				  m_inuse(false),
+				  m_ownAttach(true),
+				  m_batch(*task->m_pool),
+				  m_hasNext(false)
+			{
+				m_nextKey.key_length = 0;
+				m_nextKey.key_flags = 0;
+			}
+
+			virtual ~Item()
+			{
+				if (!m_ownAttach || !m_attStable)
+					return;
+
+				FbLocalStatus status;
+				WorkerAttachment::releaseAttachment(&status, m_attStable);
 			}
 
-			// If there wasn't a split, we're done.  If there was, propagate the
-			// split upward
-			for (unsigned level = 1; levels[level - 1].splitPage; level++)
+			bool init(thread_db* tdbb)
 			{
-				if (level == MAX_LEVELS)
+				FbStatusVector* status = tdbb->tdbb_status_vector;
+				Attachment* att = NULL;
+
+				if (m_ownAttach && !m_attStable.hasData())
+					m_attStable = WorkerAttachment::getAttachment(status, getTask()->m_dbb);
+
+				if (m_attStable)
+					att = m_attStable->getHandle();
+
+				if (!att)
 				{
-					// Maximum level depth reached
-					status_exception::raise(Arg::Gds(isc_imp_exc) <<
-						Arg::Gds(isc_max_idx_depth) << Arg::Num(MAX_LEVELS));
+					if (!status->hasData())
+						Arg::Gds(isc_bad_db_handle).copyTo(status);
+
+					return false;
 				}
 
-				if (level == levels.getCount())
-					levels.resize(level + 1);
+				tdbb->setDatabase(att->att_database);
+				tdbb->setAttachment(att);
 
-				FastLoadLevel* const currLevel = &levels[level];
-				FastLoadLevel* const priorLevel = &levels[level - 1];
+				return true;
+			}
 
-				// Initialize the current pointers for this level
-				window = &currLevel->window;
-				currLevel->splitPage = 0;
-				UCHAR* levelPointer = currLevel->pointer;
+			IndexBuildTask* getTask() const
+			{
+				return reinterpret_cast<IndexBuildTask*> (m_task);
+			}
 
-				// If there isn't already a bucket at this level, make one.  Remember to
-				// shorten the index id to a byte
-				if (!(bucket = currLevel->bucket))
-				{
-					// Initialize new level
-					currLevel->window.win_page.setPageSpaceID(pageSpaceID);
-
-					currLevel->bucket = bucket = (btree_page*) DPM_allocate(tdbb, window);
-					bucket->btr_header.pag_type = pag_index;
-					bucket->btr_relation = relation->getId();
-					bucket->btr_id = (UCHAR)(idx->idx_id % 256);
-					fb_assert(level <= MAX_UCHAR);
-					bucket->btr_level = (UCHAR) level;
-					bucket->btr_jump_interval = jumpAreaSize;
-					bucket->btr_jump_size = 0;
-					bucket->btr_jump_count = 0;
-
-#ifdef DEBUG_BTR_PAGES
-					snprintf(debugtext, sizeof(debugtext), "\t new page (%d)", window->win_page);
-					gds__log(debugtext);
-#endif
+			bool m_inuse;
+			bool m_ownAttach;
+			RefPtr<StableAttachmentPart> m_attStable;
+			Array<UCHAR> m_batch;				// sort records of the batch
+			bool m_hasNext;						// the next batch follows
+			temporary_mini_key m_nextKey;		// and starts with this key
+			RecordNumber m_nextRecordNumber;
+		};
 
-					// since this is the beginning of the level, we propagate the lower-level
-					// page with a "degenerate" zero-length node indicating that this page holds
-					// any key value less than the next node
+		FB_SIZE_T getRecordLength(const UCHAR* record) const
+		{
+			const index_sort_record* const isr =
+				(const index_sort_record*) (record + m_creation->key_length);
 
-					levelPointer = bucket->btr_nodes;
+			return m_creation->key_length + sizeof(index_sort_record) + isr->isr_payload_length;
+		}
 
-					// First record-number of level must be zero
-					currLevel->levelNode.setNode(0, 0, RecordNumber(0), priorLevel->splitPage);
-					levelPointer = currLevel->levelNode.writeNode(levelPointer, false);
-					bucket->btr_length = levelPointer - (UCHAR*) bucket;
+		void appendRecord(Array<UCHAR>& batch, const UCHAR* record) const
+		{
+			// Keep the next record aligned like in the sort
+			batch.add(record, getRecordLength(record));
+			batch.grow(FB_ALIGN(batch.getCount(), sizeof(SINT64)));
+		}
 
-					currLevel->jumpNodes = FB_NEW_POOL(pool) JumpNodeList(pool);
-					currLevel->newAreaPointer = levelPointer + jumpAreaSize;
-				}
+		FastLoadChain* readBatch(thread_db* tdbb, Item* item);
 
-				temporary_mini_key* const pageKey = &currLevel->key;
-				temporary_mini_key* const pageJumpKey = &currLevel->jumpKey;
-				JumpNodeList* const pageJumpNodes = currLevel->jumpNodes;
+		void setError(IStatus* status, bool stopTask)
+		{
+			const bool copyStatus = (m_status.isSuccess() && status && status->getState() == IStatus::STATE_ERRORS);
+			if (!copyStatus && (!stopTask || m_stop))
+				return;
 
-				// Compute the prefix in preparation of insertion
-				prefix = IndexNode::computePrefix(pageKey->key_data, pageKey->key_length,
-					split_key.key_data, split_key.key_length);
+			MutexLockGuard guard(m_mutex, FB_FUNCTION);
+			if (m_status.isSuccess() && copyStatus)
+				m_status.save(status);
+			if (stopTask)
+				m_stop = true;
+		}
 
-				// Remember the last key inserted to compress the next one.
-				copy_key(&split_key, &temp_key);
+		MemoryPool* m_pool;
+		Database* m_dbb;
+		const ULONG m_tdbb_flags;
+		IndexCreation* m_creation;
+		const FastLoadPages& m_pages;
 
-				// Save current node if we need to split.
-				tempNode = currLevel->levelNode;
-				// Set new node values.
-				currLevel->levelNode.setNode(prefix, temp_key.key_length - prefix,
-					priorLevel->splitRecordNumber, priorLevel->window.win_page.getPageNum());
-				currLevel->levelNode.data = temp_key.key_data + prefix;
+		Mutex m_mutex;
+		HalfStaticArray<Item*, 8> m_items;
+		HalfStaticArray<FastLoadChain*, 64> m_chains;	// in the key order
+		StatusHolder m_status;
 
-				// See if the new node fits in the current bucket.
-				// If not, split the bucket.
-				if (bucket->btr_length + currLevel->totalJumpSize +
-					currLevel->levelNode.getNodeSize(false) > pp_fill_limit)
-				{
-					// mark the end of the page; note that the end_bucket marker must
-					// contain info about the first node on the next page
-					const ULONG lastPageNumber = tempNode.pageNumber;
-					tempNode.readNode(tempNode.nodePointer, false);
-					tempNode.setEndBucket();
-					levelPointer = tempNode.writeNode(tempNode.nodePointer, false, false);
-					bucket->btr_length = levelPointer - (UCHAR*) bucket;
-
-					if (currLevel->totalJumpSize)
-					{
-						// Slide down current nodes;
-						// CVC: Warning, this may overlap. It seems better to use
-						// memmove or to ensure manually that leafLevel->totalJumpSize > l
-						// Also, "sliding down" here is moving contents higher in memory.
-						const USHORT l = bucket->btr_length - BTR_SIZE;
-						memmove(bucket->btr_nodes + currLevel->totalJumpSize, bucket->btr_nodes, l);
-
-						// Update JumpInfo
-						if (pageJumpNodes->getCount() > MAX_UCHAR)
-							BUGCHECK(205);	// msg 205 index bucket overfilled
-
-						bucket->btr_jump_interval = jumpAreaSize;
-						bucket->btr_jump_size = currLevel->totalJumpSize;
-						bucket->btr_jump_count = (UCHAR) pageJumpNodes->getCount();
-
-						// Write jumpnodes on page.
-						levelPointer = bucket->btr_nodes;
-						IndexJumpNode* walkJumpNode = pageJumpNodes->begin();
-						for (size_t i = 0; i < pageJumpNodes->getCount(); i++)
-						{
-							// Update offset position first.
-							walkJumpNode[i].offset += currLevel->totalJumpSize;
-							levelPointer = walkJumpNode[i].writeJumpNode(levelPointer);
-						}
+		Array<UCHAR> m_pending;				// the first record of the next batch
+		temporary_mini_key m_lastKey;		// the last key of the previous batch
+		FastLoadStatistics m_boundary;		// duplicates between the batches
 
-						bucket->btr_length += currLevel->totalJumpSize;
-					}
+		volatile bool m_stop;
+		bool m_eof;
+	};
 
-					if (bucket->btr_length > dbb->dbb_page_size)
-						BUGCHECK(205);	// msg 205 index bucket overfilled
-
-					btree_page* split = (btree_page*) DPM_allocate(tdbb, &split_window);
-					bucket->btr_sibling = split_window.win_page.getPageNum();
-					split->btr_left_sibling = window->win_page.getPageNum();
-					split->btr_header.pag_type = pag_index;
-					split->btr_relation = bucket->btr_relation;
-					split->btr_level = bucket->btr_level;
-					split->btr_id = bucket->btr_id;
-					split->btr_jump_interval = bucket->btr_jump_interval;
-					split->btr_jump_size = 0;
-					split->btr_jump_count = 0;
-
-#ifdef DEBUG_BTR_PAGES
-					snprintf(debugtext, sizeof(debugtext), "\t new page (%d), left page (%d)",
-						split_window.win_page, split->btr_left_sibling);
-					gds__log(debugtext);
-#endif
+	bool IndexBuildTask::handler(WorkItem& _item)
+	{
+		Item* item = reinterpret_cast<Item*>(&_item);
 
-					levelPointer = split->btr_nodes;
-					// Reset position and size for generating jumpnode
-					currLevel->newAreaPointer = levelPointer + jumpAreaSize;
-					currLevel->totalJumpSize = 0;
-					pageJumpKey->key_length = 0;
-
-					// insert the new node in the new bucket
-					IndexNode splitNode;
-					splitNode.setNode(0, pageKey->key_length, tempNode.recordNumber, lastPageNumber);
-					splitNode.data = pageKey->key_data;
-					levelPointer = splitNode.writeNode(levelPointer, false);
-					tempNode = splitNode;
-
-					// indicate to propagate the page we just split from
-					currLevel->splitPage = window->win_page.getPageNum();
-					currLevel->splitRecordNumber = splitNode.recordNumber;
-					CCH_RELEASE(tdbb, window);
+		ThreadContextHolder tdbb(NULL);
+		tdbb->tdbb_flags = m_tdbb_flags;
 
-#ifdef DEBUG_BTR_PAGES
-					snprintf(debugtext, sizeof(debugtext),
-						"\t release page (%d), left page (%d), right page (%d)",
-						window->win_page,
-						((btr*)window->win_buffer)->btr_left_sibling,
-						((btr*)window->win_buffer)->btr_sibling);
-					gds__log(debugtext);
-#endif
+		if (!item->init(tdbb))
+		{
+			setError(tdbb->tdbb_status_vector, true);
+			return false;
+		}
 
-					// and make the new page the current page
-					*window = split_window;
-					currLevel->bucket = bucket = split;
-					copy_key(pageKey, &split_key);
+		try
+		{
+			WorkerContextHolder holder(tdbb, FB_FUNCTION);
+
+			FastLoadChain* const chain = readBatch(tdbb, item);
+			if (!chain)
+				return false;
 
-					// Clear jumplist.
-					IndexJumpNode* walkJumpNode = pageJumpNodes->begin();
-					for (size_t i = 0; i < pageJumpNodes->getCount(); i++)
-						delete[] walkJumpNode[i].data;
+			FastLoadLeaf leaf(*m_pool, *m_creation, m_pages, chain, chain->statistics);
 
-					pageJumpNodes->clear();
+			try
+			{
+				for (const UCHAR* record = item->m_batch.begin(); record < item->m_batch.end();
+					record += FB_ALIGN(getRecordLength(record), sizeof(SINT64)))
+				{
+					if (m_creation->duplicates.value())
+						break;
+
+					leaf.put(tdbb, record);
+					JRD_reschedule(tdbb);
 				}
 
-				// Now propagate up the lower-level bucket by storing a "pointer" to it.
-				bucket->btr_prefix_total += prefix;
-				levelPointer = currLevel->levelNode.writeNode(levelPointer, false);
+				leaf.level.finish(tdbb, item->m_hasNext ? &item->m_nextKey : nullptr,
+					item->m_nextRecordNumber);
+
+				// The pages cached by the worker attachment are not flushed
+				// together with the pages of the main attachment in Classic
+				if (!(m_dbb->dbb_flags & DBB_shared))
+					CCH_flush(tdbb, FLUSH_ALL, 0);
+			}
+			catch (const Exception&)
+			{
+				leaf.level.release(tdbb);
+
+				if (leaf.level.getFirstPage())
+					m_pages.deleteTree(tdbb, leaf.level.getFirstPage());
+
+				throw;
+			}
+
+			chain->firstPage = leaf.level.getFirstPage();
+			chain->lastPage = leaf.level.getLastPage();
+		}
+		catch (const Exception& ex)
+		{
+			ex.stuffException(tdbb->tdbb_status_vector);
+			setError(tdbb->tdbb_status_vector, true);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool IndexBuildTask::getWorkItem(WorkItem** pItem)
+	{
+		Item* item = reinterpret_cast<Item*> (*pItem);
+
+		MutexLockGuard guard(m_mutex, FB_FUNCTION);
 
-				// Update the length of the page.
-				bucket->btr_length = levelPointer - (UCHAR*) bucket;
-				if (bucket->btr_length > dbb->dbb_page_size)
-					BUGCHECK(205);	// msg 205 index bucket overfilled
+		if (m_stop)
+			return false;
 
-				if (currLevel->newAreaPointer < levelPointer)
+		if (item == NULL)
+		{
+			for (Item** p = m_items.begin(); p < m_items.end(); p++)
+			{
+				if (!(*p)->m_inuse)
 				{
-					// Create a jumpnode
-					IndexJumpNode jumpNode;
-					jumpNode.prefix = IndexNode::computePrefix(pageJumpKey->key_data,
-															   pageJumpKey->key_length,
-															   temp_key.key_data,
-															   currLevel->levelNode.prefix);
-					jumpNode.length = currLevel->levelNode.prefix - jumpNode.prefix;
-
-					const USHORT jumpNodeSize = jumpNode.getJumpNodeSize();
-					// Ensure the new jumpnode fits in the bucket
-					if (bucket->btr_length + currLevel->totalJumpSize + jumpNodeSize < pp_fill_limit)
-					{
-						// Initialize the rest of the jumpnode
-						jumpNode.offset = (currLevel->levelNode.nodePointer - (UCHAR*) bucket);
-						jumpNode.data = FB_NEW_POOL(pool) UCHAR[jumpNode.length];
-						memcpy(jumpNode.data, temp_key.key_data + jumpNode.prefix, jumpNode.length);
-						// Push node on end in list
-						pageJumpNodes->add(jumpNode);
-						// Store new data in jumpKey, so a new jump node can calculate prefix
-						memcpy(pageJumpKey->key_data + jumpNode.prefix, jumpNode.data, jumpNode.length);
-						pageJumpKey->key_length = jumpNode.length + jumpNode.prefix;
-						// Set new position for generating jumpnode
-						currLevel->newAreaPointer += jumpAreaSize;
-						currLevel->totalJumpSize += jumpNodeSize;
-					}
+					(*p)->m_inuse = true;
+					*pItem = item = *p;
+					break;
 				}
+			}
+		}
+
+		if (!item)
+			return false;
+
+		item->m_inuse = !m_eof;
+		return item->m_inuse;
+	}
+
+	// Read the next batch of the sorted keys, the sort is read by one worker at a time
 
-				// Now restore the current key value and save this node as the
-				// current node on this level; also calculate the new page length.
-				copy_key(&temp_key, pageKey);
-				currLevel->pointer = levelPointer;
+	FastLoadChain* IndexBuildTask::readBatch(thread_db* tdbb, Item* item)
+	{
+		const USHORT keyLength = m_creation->key_length;
+		const USHORT nullIndLen = m_creation->nullIndLen;
+		const bool unique = (m_creation->index->idx_flags & idx_unique);
+
+		item->m_batch.clear();
+		item->m_hasNext = false;
+
+		MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+		if (m_stop || m_eof)
+			return nullptr;
+
+		if (m_pending.hasData())
+		{
+			item->m_batch.assign(m_pending);
+			m_pending.clear();
+		}
+		else
+		{
+			UCHAR* record;
+			m_creation->sort->get(tdbb, reinterpret_cast<ULONG**>(&record));
+
+			if (!record)
+			{
+				m_eof = true;
+				return nullptr;
 			}
 
-			try
+			appendRecord(item->m_batch, record);
+		}
+
+		FB_SIZE_T last = 0;		// offset of the last record of the batch
+
+		while (true)
+		{
+			UCHAR* record;
+			m_creation->sort->get(tdbb, reinterpret_cast<ULONG**>(&record));
+
+			if (!record || m_creation->duplicates.value())
 			{
-				JRD_reschedule(tdbb);
+				m_eof = true;
+				break;
 			}
-			catch (const Exception&)
+
+			if (item->m_batch.getCount() >= BATCH_SIZE)
 			{
-				error = true;
+				// Equal keys of the unique index are checked by the same worker
+				const index_sort_record* const isr = (const index_sort_record*) (record + keyLength);
+				const UCHAR* const prior = item->m_batch.begin() + last;
+				const index_sort_record* const priorIsr = (const index_sort_record*) (prior + keyLength);
+
+				if (!unique || (isr->isr_flags & ISR_null) ||
+					isr->isr_key_length != priorIsr->isr_key_length ||
+					memcmp(record, prior, nullIndLen + isr->isr_key_length))
+				{
+					appendRecord(m_pending, record);
+
+					item->m_hasNext = true;
+					item->m_nextKey.key_length = isr->isr_key_length;
+					memcpy(item->m_nextKey.key_data, record + nullIndLen, isr->isr_key_length);
+					item->m_nextRecordNumber.setValue(isr->isr_record_number);
+					break;
+				}
 			}
+
+			last = item->m_batch.getCount();
+			appendRecord(item->m_batch, record);
 		}
 
-		// To finish up, put an end of level marker on the last bucket
-		// of each level.
-		for (unsigned i = 0; i < levels.getCount(); i++)
+		FastLoadChain* const chain = FB_NEW_POOL(*m_pool) FastLoadChain(*m_pool, m_creation->index);
+		m_chains.add(chain);
+
+		const UCHAR* const first = item->m_batch.begin();
+		const index_sort_record* const firstIsr = (const index_sort_record*) (first + keyLength);
+		chain->firstKey.key_length = firstIsr->isr_key_length;
+		memcpy(chain->firstKey.key_data, first + nullIndLen, firstIsr->isr_key_length);
+		chain->firstRecordNumber.setValue(firstIsr->isr_record_number);
+
+		// The workers count duplicates inside the batches, the keys
+		// around the boundaries of the batches are compared here
+		if (m_chains.getCount() > 1)
 		{
-			FastLoadLevel* const currLevel = &levels[i];
+			const USHORT prefix = IndexNode::computePrefix(m_lastKey.key_data, m_lastKey.key_length,
+				chain->firstKey.key_data, chain->firstKey.key_length);
+			m_boundary.checkDuplicate(m_lastKey, chain->firstKey.key_data, chain->firstKey.key_length, prefix);
+		}
 
-			bucket = currLevel->bucket;
-			if (!bucket)
-				break;
+		const UCHAR* const lastRecord = item->m_batch.begin() + last;
+		const index_sort_record* const lastIsr = (const index_sort_record*) (lastRecord + keyLength);
+		m_lastKey.key_length = lastIsr->isr_key_length;
+		memcpy(m_lastKey.key_data, lastRecord + nullIndLen, lastIsr->isr_key_length);
 
-			// retain the top level window for returning to the calling routine
-			const bool leafPage = (bucket->btr_level == 0);
-			window = &currLevel->window;
+		return chain;
+	}
 
-			// store the end of level marker
-			pointer = (UCHAR*) bucket + bucket->btr_length;
-			currLevel->levelNode.setEndLevel();
-			pointer = currLevel->levelNode.writeNode(pointer, leafPage);
+	// Link the chains built by the workers into the leaf level and build the
+	// upper levels over it. Return the root page of the index.
 
-			// and update the final page length
-			bucket->btr_length = pointer - (UCHAR*) bucket;
-			if (bucket->btr_length > dbb->dbb_page_size)
-				BUGCHECK(205);	// msg 205 index bucket overfilled
+	ULONG IndexBuildTask::buildTree(thread_db* tdbb, FastLoadStatistics& statistics)
+	{
+		MemoryPool& pool = *tdbb->getDefaultPool();
+
+		if (m_chains.isEmpty())
+		{
+			// No keys at all
+			FastLoadLevel leaf(pool, m_pages, 0, nullptr);
+			leaf.finish(tdbb);
+			return leaf.getFirstPage();
+		}
 
-			// Store jump nodes on page if needed.
-			JumpNodeList* const pageJumpNodes = currLevel->jumpNodes;
-			if (currLevel->totalJumpSize)
+		FastLoadTree tree(pool, m_pages);
+		const ULONG firstPage = m_chains[0]->firstPage;
+		FB_SIZE_T linked = 1;	// chains being the part of the leaf level
+
+		try
+		{
+			for (FB_SIZE_T i = 0; i < m_chains.getCount(); i++)
 			{
-				// Slide down current nodes;
-				// CVC: Warning, this may overlap. It seems better to use
-				// memmove or to ensure manually that leafLevel->totalJumpSize > l
-				// Also, "sliding down" here is moving contents higher in memory.
-				const USHORT l = bucket->btr_length - BTR_SIZE;
-				memmove(bucket->btr_nodes + currLevel->totalJumpSize, bucket->btr_nodes, l);
-
-				// Update JumpInfo
-				if (pageJumpNodes->getCount() > MAX_UCHAR)
-					BUGCHECK(205);	// msg 205 index bucket overfilled
-
-				bucket->btr_jump_interval = jumpAreaSize;
-				bucket->btr_jump_size = currLevel->totalJumpSize;
-				bucket->btr_jump_count = (UCHAR) pageJumpNodes->getCount();
-
-				// Write jumpnodes on page.
-				pointer = bucket->btr_nodes;
-				IndexJumpNode* walkJumpNode = pageJumpNodes->begin();
-				for (size_t i = 0; i < pageJumpNodes->getCount(); i++)
+				const FastLoadChain* const chain = m_chains[i];
+				fb_assert(chain->firstPage);
+
+				if (i)
 				{
-					// Update offset position first.
-					walkJumpNode[i].offset += currLevel->totalJumpSize;
-					pointer = walkJumpNode[i].writeJumpNode(pointer);
+					const ULONG prior = m_chains[i - 1]->lastPage;
+
+					WIN window(m_pages.pageSpaceId, prior);
+					btree_page* page = (btree_page*) CCH_FETCH(tdbb, &window, LCK_write, pag_index);
+					CCH_MARK(tdbb, &window);
+					page->btr_sibling = chain->firstPage;
+					CCH_RELEASE(tdbb, &window);
+
+					linked = i + 1;
+
+					WIN nextWindow(m_pages.pageSpaceId, chain->firstPage);
+					page = (btree_page*) CCH_FETCH(tdbb, &nextWindow, LCK_write, pag_index);
+					CCH_MARK(tdbb, &nextWindow);
+					page->btr_left_sibling = prior;
+					CCH_RELEASE(tdbb, &nextWindow);
+
+					tree.addPage(tdbb, 0, firstPage, chain->firstKey, chain->firstRecordNumber,
+						chain->firstPage);
 				}
 
-				bucket->btr_length += currLevel->totalJumpSize;
+				chain->propagate(tdbb, &tree, firstPage);
+				statistics.add(chain->statistics);
+
+				JRD_reschedule(tdbb);
 			}
 
-			if (bucket->btr_length > dbb->dbb_page_size)
-				BUGCHECK(205);	// msg 205 index bucket overfilled
+			tree.finish(tdbb);
+		}
+		catch (const Exception&)
+		{
+			tree.release(tdbb);
 
-			CCH_RELEASE(tdbb, &currLevel->window);
+			// The upper levels and the linked chains are deleted together
+			m_pages.deleteTree(tdbb, tree.getRoot() ? tree.getRoot() : firstPage);
 
-#ifdef DEBUG_BTR_PAGES
-			snprintf(debugtext, sizeof(debugtext),
-				"\t release page (%d), left page (%d), right page (%d)",
-				currLevel->window.win_page,
-				((btr*) currLevel->window.win_buffer)->btr_left_sibling,
-				((btr*) currLevel->window.win_buffer)->btr_sibling);
-			gds__log(debugtext);
-#endif
+			for (FB_SIZE_T i = linked; i < m_chains.getCount(); i++)
+				m_pages.deleteTree(tdbb, m_chains[i]->firstPage);
+
+			throw;
 		}
 
-		// Finally clean up dynamic memory used.
-		for (unsigned i = 0; i < levels.getCount(); i++)
+		statistics.add(m_boundary);
+
+		return tree.getRoot() ? tree.getRoot() : firstPage;
+	}
+
+	// Release the pages of the chains after the workers failed
+
+	void IndexBuildTask::deleteChains(thread_db* tdbb)
+	{
+		for (auto chain : m_chains)
 		{
-			JumpNodeList* const freeJumpNodes = levels[i].jumpNodes;
+			if (chain->firstPage)
+				m_pages.deleteTree(tdbb, chain->firstPage);
+		}
+	}
+
+} // namespace
+
+
+static ULONG fast_load(thread_db* tdbb,
+					   IndexCreation& creation,
+					   SelectivityList& selectivity)
+{
+/**************************************
+ *
+ *	f a s t _ l o a d
+ *
+ **************************************
+ *
+ * Functional description
+ *	Do a fast load.  The indices have already been passed into sort, and
+ *	are ripe for the plucking.  The keys are appended to the leaf level
+ *	and the new pages of every level are propagated to the level above.
+ *	With parallel workers available, they build the leaf level by parts.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	Database* const dbb = tdbb->getDatabase();
+	CHECK_DBB(dbb);
+
+	jrd_rel* const relation = creation.relation;
+	index_desc* const idx = creation.index;
+	const USHORT key_length = creation.key_length;
+
+	FastLoadPages pages;
+	pages.pageSpaceId = relation->getPages(tdbb)->rel_pg_space_id;
+	pages.relationId = relation->getId();
+	pages.indexId = idx->idx_id;
+	pages.pageSize = dbb->dbb_page_size;
+
+	// leaf-page and pointer-page size limits, we always need to
+	// leave room for the END_LEVEL node. Pages are filled up to the
+	// configured percent only, the rest is left for the new keys.
+	const USHORT fillLimit = (USHORT) ((ULONG) dbb->dbb_page_size *
+		dbb->dbb_config->getIndexFillFactor() / 100);
+	pages.leafFillLimit = MIN(fillLimit, dbb->dbb_page_size - BTN_LEAF_SIZE);
+	pages.pointerFillLimit = MIN(fillLimit, dbb->dbb_page_size - BTN_PAGE_SIZE);
+
+	// AB: Let's try to determine to size between the jumps to speed up
+	// index search. Of course the size depends on the key_length. The
+	// bigger the key, the less jumps we can make. (Although we must
+	// not forget that mostly the keys are compressed and much smaller
+	// than the maximum possible key!).
+	// These values can easily change without effect on previous created
+	// indices, cause this value is stored on each page.
+	// Remember, the lower the value how more jumpkeys are generated and
+	// how faster jumpkeys are recalculated on insert.
+
+	// The search walks through the jump nodes and then through the nodes
+	// of a single area, so it's the cheapest when both walks are about of
+	// the same length, i.e. the area is the square root of the page size
+	// multiplied by the node size. For short keys on small pages this makes
+	// the jump table denser.
+
+	pages.jumpAreaSize = MIN(512 + ((int) sqrt((float) key_length) * 16),
+		(int) sqrt((float) dbb->dbb_page_size * (key_length + BTN_LEAF_SIZE)));
+
+	//  key_size  |  jumpAreaSize  |  8K page
+	//  ----------+----------------+-----------
+	//         4  |    544         |    286
+	//         8  |    557         |    338
+	//        16  |    576         |    424
+	//        64  |    640         |    640
+	//       128  |    693         |    693
+	//       256  |    768         |    768
+
+	const Attachment* const attachment = tdbb->getAttachment();
+
+	int workers = 1;
+	if (attachment->att_parallel_workers > 0)
+		workers = attachment->att_parallel_workers;
+
+	// Classic in single-user shutdown mode can't create additional worker attachments
+	if ((dbb->isShutdown(shut_mode_single) && !(dbb->dbb_flags & DBB_shared)) ||
+		relation->isTemporary())
+	{
+		workers = 1;
+	}
+
+	MemoryPool& pool = *tdbb->getDefaultPool();
+	FastLoadStatistics statistics(pool, idx);
+	ULONG root = 0;
+
+	tdbb->tdbb_flags |= TDBB_no_cache_unwind;
+
+	try
+	{
+		if (workers > 1)
+		{
+			IndexBuildTask task(tdbb, dbb->dbb_permanent, &creation, pages, workers);
 
-			if (freeJumpNodes)
 			{
-				IndexJumpNode* walkJumpNode = freeJumpNodes->begin();
-				for (size_t i = 0; i < freeJumpNodes->getCount(); i++)
-					delete[] walkJumpNode[i].data;
+				EngineCheckout cout(tdbb, FB_FUNCTION);
 
-				delete freeJumpNodes;
+				Coordinator coord(dbb->dbb_permanent);
+				coord.runSync(&task);
 			}
+
+			FbLocalStatus status;
+			if (!task.getResult(&status))
+			{
+				task.deleteChains(tdbb);
+				status.raise();
+			}
+
+			root = task.buildTree(tdbb, statistics);
 		}
-	}	// try
-	catch (const Exception& ex)
+		else
+		{
+			FastLoadTree tree(pool, pages);
+			FastLoadLeaf leaf(pool, creation, pages, &tree, statistics);
+
+			// If there's an error during index construction, release
+			// the last index bucket at each level of the index and try
+			// to deallocate the index pages for reuse.
+			try
+			{
+				while (true)
+				{
+					// Get the next record in sorted order.
+
+					UCHAR* record;
+					creation.sort->get(tdbb, reinterpret_cast<ULONG**>(&record));
+
+					if (!record || creation.duplicates.value())
+						break;
+
+					leaf.put(tdbb, record);
+					JRD_reschedule(tdbb);
+				}
+
+				leaf.level.finish(tdbb);
+				tree.finish(tdbb);
+			}
+			catch (const Exception&)
+			{
+				leaf.level.release(tdbb);
+				tree.release(tdbb);
+
+				const ULONG top = tree.getRoot() ? tree.getRoot() : leaf.level.getFirstPage();
+				if (top)
+					pages.deleteTree(tdbb, top);
+
+				throw;
+			}
+
+			root = tree.getRoot() ? tree.getRoot() : leaf.level.getFirstPage();
+		}
+	}
+	catch (const Exception&)
 	{
-		ex.stuffException(tdbb->tdbb_status_vector);
-		error = true;
+		tdbb->tdbb_flags &= ~TDBB_no_cache_unwind;
+		throw;
 	}
 
 	tdbb->tdbb_flags &= ~TDBB_no_cache_unwind;
@@ -5154,44 +5952,18 @@ static ULONG fast_load(thread_db* tdbb,
 	// If the index delete fails, just go ahead and punt.
 	try
 	{
-		if (error)
-			ERR_punt();
-
 		if (!relation->isTemporary())
 			CCH_flush(tdbb, FLUSH_ALL, 0);
-
-		// Calculate selectivity, also per segment when newer ODS
-		selectivity.grow(segments);
-		if (segments > 1)
-		{
-			for (ULONG i = 0; i < segments; i++)
-				selectivity[i] = (float) (count ? 1.0 / (float) (count - duplicatesList[i]) : 0.0);
-		}
-		else
-			selectivity[0] = (float) (count ? (1.0 / (float) (count - duplicates)) : 0.0);
-	}	// try
-	catch (const Exception& ex)
+	}
+	catch (const Exception&)
 	{
-		ex.stuffException(tdbb->tdbb_status_vector);
-
-		// CCH_unwind does not released page buffers (as we
-		// set TDBB_no_cache_unwind flag), do it now
-		for (unsigned i = 0; i < levels.getCount(); i++)
-		{
-			if (levels[i].window.win_bdb)
-				CCH_RELEASE(tdbb, &levels[i].window);
-		}
-
-		if (window)
-		{
-			delete_tree(tdbb, relation->getId(), idx->idx_id,
-						window->win_page, PageNumber(window->win_page.getPageSpaceID(), 0));
-		}
-
+		pages.deleteTree(tdbb, root);
 		throw;
 	}
 
-	return window->win_page.getPageNum();
+	statistics.getSelectivity(selectivity);
+
+	return root;
 }
 
 
@@ -5229,6 +6001,21 @@ static const index_root_page* fetch_root(thread_db* tdbb, WIN* window, const Rel
 }
 
 
+// Advance both pointers past the bytes they have in common. Search loops
+// below make their decision at the first difference only, so the equal
+// run may be skipped at once instead of byte by byte.
+static inline void skip_common_prefix(const UCHAR*& p, const UCHAR* const pEnd,
+									  const UCHAR*& q, const UCHAR* const qEnd)
+{
+	if (p < pEnd && q < qEnd)
+	{
+		const USHORT common = IndexNode::matchPrefix(p, q, (USHORT) MIN(pEnd - p, qEnd - q));
+		p += common;
+		q += common;
+	}
+}
+
+
 static UCHAR* find_node_start_point(btree_page* bucket, temporary_key* key,
 									UCHAR* value,
 									USHORT* return_value, bool descending,
@@ -5306,6 +6093,8 @@ static UCHAR* find_node_start_point(btree_page* bucket, temporary_key* key,
 			const UCHAR* const nodeEnd = q + node.length;
 			if (descending)
 			{
+				skip_common_prefix(p, key_end, q, nodeEnd);
+
 				while (true)
 				{
 					if (q == nodeEnd)
@@ -5333,6 +6122,8 @@ static UCHAR* find_node_start_point(btree_page* bucket, temporary_key* key,
 			else if (node.length > 0 || firstPass)
 			{
 				firstPass = false;
+				skip_common_prefix(p, key_end, q, nodeEnd);
+
 				while (true)
 				{
 					if (p == key_end)
@@ -5440,6 +6231,8 @@ static UCHAR* find_area_start_point(btree_page* bucket, const temporary_key* key
 
 		if ((jumpNode.prefix <= testPrefix) && descending)
 		{
+			skip_common_prefix(keyPointer, keyEnd, q, nodeEnd);
+
 			while (true)
 			{
 				if (q == nodeEnd)
@@ -5519,6 +6312,8 @@ static UCHAR* find_area_start_point(btree_page* bucket, const temporary_key* key
 		}
 		else if (jumpNode.prefix <= testPrefix)
 		{
+			skip_common_prefix(keyPointer, keyEnd, q, nodeEnd);
+
 			while (true)
 			{
 				if (keyPointer == keyEnd)
@@ -5702,6 +6497,8 @@ static ULONG find_page(btree_page* bucket, const temporary_key* key,
 			if (descending)
 			{
 				// Descending indexes
+				skip_common_prefix(p, keyEnd, q, nodeEnd);
+
 				while (true)
 				{
 					// Check for exact match and if we need to do
@@ -5731,6 +6528,8 @@ static ULONG find_page(btree_page* bucket, const temporary_key* key,
 			{
 				firstPass = false;
 				// Ascending index
+				skip_common_prefix(p, keyEnd, q, nodeEnd);
+
 				while (true)
 				{
 					if (p == keyEnd)
@@ -6114,6 +6913,7 @@ static contents garbage_collect(thread_db* tdbb, WIN* window, ULONG parent_numbe
 	leftNode.setNode(prefix, gcNode.length - prefix, gcNode.recordNumber,
 				     gcNode.pageNumber, gcNode.isEndBucket, gcNode.isEndLevel);
 	leftNode.data = gcNode.data + prefix;
+	leftNode.setPayload(gcNode.payload, gcNode.payloadLength);
 	leftPointer = leftNode.writeNode(leftPointer, leafPage);
 
 	// Update page-size.
@@ -6434,7 +7234,8 @@ static ULONG insert_node(thread_db* tdbb,
 						 temporary_key* new_key,
 						 RecordNumber* new_record_number,
 						 ULONG* original_page,
-						 ULONG* sibling_page)
+						 ULONG* sibling_page,
+						 bool splitAllowed)
 {
 /**************************************
  *
@@ -6447,6 +7248,8 @@ static ULONG insert_node(thread_db* tdbb,
  *  If this isn't the right bucket, return NO_VALUE.
  *  If it splits, return the split page number and
  *	leading string.  This is the workhorse for add_node.
+ *	If the page has to split but splitAllowed is false,
+ *	leave it unchanged and return NO_VALUE.
  *
  **************************************/
 
@@ -6583,7 +7386,9 @@ static ULONG insert_node(thread_db* tdbb,
 	IndexNode newNode;
 	newNode.setNode(prefix, key->key_length - prefix, newRecordNumber);
 	newNode.data = key->key_data + prefix;
-	if (!leafPage)
+	if (leafPage)
+		newNode.setPayload(insertion->iib_payload, insertion->iib_payload_length);
+	else
 		newNode.pageNumber = insertion->iib_number.getValue();
 
 	// Compute the delta between current and new page.
@@ -6633,7 +7438,7 @@ static ULONG insert_node(thread_db* tdbb,
 		// If we're adding a node at the end we don't want that a page
 		// splits in the middle, but at the end. We can never be sure
 		// that this will happen, but at least give it a bigger chance.
-		ensureEndInsert = 6 + key->key_length;
+		ensureEndInsert = 6 + key->key_length + newNode.payloadLength;
 	}
 
 	// Get the total size of the jump nodes currently in use.
@@ -6747,6 +7552,16 @@ static ULONG insert_node(thread_db* tdbb,
 		bucket->btr_prefix_total = newBucket->btr_prefix_total;
 		bucket->btr_length = newBucket->btr_length + jumpersNewSize - jumpersOriginalSize;
 
+		// remember the rightmost leaf page for the next insert
+		if (leafPage && !bucket->btr_sibling)
+		{
+			RelationPages* const relPages = insertion->iib_relation->getPages(tdbb);
+			const ULONG pageNumber = window->win_page.getPageNum();
+
+			if (relPages->getLastLeaf(idx->idx_id) != pageNumber)
+				relPages->setLastLeaf(idx->idx_id, pageNumber);
+		}
+
 		CCH_RELEASE(tdbb, window);
 
 		jumpNodes->clear();
@@ -6754,6 +7569,21 @@ static ULONG insert_node(thread_db* tdbb,
 		return NO_SPLIT;
 	}
 
+	// The caller can't propagate the split, leave the page intact
+	if (!splitAllowed)
+	{
+		if (fragmentedOffset)
+		{
+			IndexJumpNode* walkJumpNode = jumpNodes->begin();
+			for (size_t i = 0; i < jumpNodes->getCount(); i++)
+				delete[] walkJumpNode[i].data;
+		}
+
+		jumpNodes->clear();
+
+		return NO_VALUE_PAGE;
+	}
+
 	// We've a bucket split in progress.  We need to determine the split point.
 	// Set it halfway through the page, unless we are at the end of the page,
 	// in which case put only the new node on the new page.  This will ensure
@@ -6772,7 +7602,10 @@ static ULONG insert_node(thread_db* tdbb,
 		splitpoint = node.readNode(newNode.nodePointer, leafPage);
 		IndexNode dummyNode = newNode;
 		dummyNode.setEndBucket();
-		const USHORT deltaSize = dummyNode.getNodeSize(leafPage) - newNode.getNodeSize(leafPage);
+		// Payload is not copied into the end bucket marker, so it could be shorter
+		const USHORT endBucketSize = dummyNode.getNodeSize(leafPage);
+		const USHORT newNodeSize = newNode.getNodeSize(leafPage);
+		const USHORT deltaSize = (endBucketSize > newNodeSize) ? endBucketSize - newNodeSize : 0;
 		if (endOfPage && ((splitpoint + jumpersNewSize - jumpersOriginalSize) <=
 			(UCHAR*) newBucket + dbb->dbb_page_size - deltaSize))
 		{
@@ -6854,7 +7687,10 @@ static ULONG insert_node(thread_db* tdbb,
 		splitpoint = newNode.readNode(newNode.nodePointer, leafPage);
 		IndexNode dummyNode = newNode;
 		dummyNode.setEndBucket();
-		const USHORT deltaSize = dummyNode.getNodeSize(leafPage) - newNode.getNodeSize(leafPage);
+		// Payload is not copied into the end bucket marker, so it could be shorter
+		const USHORT endBucketSize = dummyNode.getNodeSize(leafPage);
+		const USHORT newNodeSize = newNode.getNodeSize(leafPage);
+		const USHORT deltaSize = (endBucketSize > newNodeSize) ? endBucketSize - newNodeSize : 0;
 		if (endOfPage && ((UCHAR*) splitpoint <= (UCHAR*) newBucket + dbb->dbb_page_size - deltaSize))
 		{
 			midpoint = splitpoint;
@@ -6899,6 +7735,8 @@ static ULONG insert_node(thread_db* tdbb,
 
 	// Format the first node on the overflow page
 	newNode.setNode(0, new_key->key_length, node.recordNumber, node.pageNumber);
+	if (leafPage)
+		newNode.setPayload(node.payload, node.payloadLength);
 	// Return first record number on split page to caller.
 	newNode.data = new_key->key_data;
 	*new_record_number = newNode.recordNumber;
@@ -7054,6 +7892,62 @@ static ULONG insert_node(thread_db* tdbb,
 }
 
 
+static bool insert_last_leaf(thread_db* tdbb, WIN* root_window, index_insertion* insertion)
+{
+/**************************************
+ *
+ *	i n s e r t _ l a s t _ l e a f
+ *
+ **************************************
+ *
+ * Functional description
+ *	Insert a node into the rightmost leaf page remembered by
+ *	the previous insert, if the key belongs there and the page
+ *	has room for it.  Return false if the node should be inserted
+ *	the usual way, descending from the top of the index.
+ *
+ **************************************/
+	index_desc* const idx = insertion->iib_descriptor;
+	RelationPages* const relPages = insertion->iib_relation->getPages(tdbb);
+
+	const ULONG pageNumber = relPages->getLastLeaf(idx->idx_id);
+	if (!pageNumber || pageNumber == idx->idx_root)
+		return false;
+
+	// The page could be released and reused since we saw it, so make sure
+	// it's still the rightmost leaf page of the index
+	WIN window(relPages->rel_pg_space_id, pageNumber);
+	btree_page* const page = (btree_page*) CCH_FETCH(tdbb, &window, LCK_write, pag_undefined);
+
+	if (!BTR_last_leaf_accepts(page, insertion->iib_relation->getId(), idx->idx_id, insertion->iib_key))
+	{
+		CCH_RELEASE(tdbb, &window);
+		relPages->setLastLeaf(idx->idx_id, 0);
+		return false;
+	}
+
+	temporary_key newKey;
+	newKey.key_flags = 0;
+	newKey.key_length = 0;
+
+	RecordNumber recordNumber(0);
+	BtrPageGCLock lock(tdbb);
+	insertion->iib_dont_gc_lock = &lock;
+
+	// We don't know the parent page, so the page mustn't split. Keep the root
+	// page until the node is inserted, BTR_insert() needs it otherwise.
+	if (insert_node(tdbb, &window, insertion, &newKey, &recordNumber, NULL, NULL, false) != NO_SPLIT)
+	{
+		CCH_RELEASE(tdbb, &window);
+		relPages->setLastLeaf(idx->idx_id, 0);
+		return false;
+	}
+
+	CCH_RELEASE(tdbb, root_window);
+	return true;
+}
+
+
 static INT64_KEY make_int64_key(SINT64 q, SSHORT scale)
 {
 /**************************************
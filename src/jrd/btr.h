@@ -94,6 +94,7 @@ struct index_desc
 	MetaId	idx_primary_index;				// id for primary key partner index
 	MetaId	idx_primary_relation;			// id for primary key partner relation
 	USHORT	idx_count;						// number of keys
+	USHORT	idx_includes;					// number of included (non-key) columns, follow the keys in idx_rpt
 	dep		idx_foreign_dep;				// foreign key partner
 	ValueExprNode* idx_expression_node;		// node tree for indexed expression
 	dsc		idx_expression_desc;			// descriptor for expression result
@@ -169,6 +170,8 @@ struct index_insertion
 	jrd_tra*	iib_transaction;	// insertion transaction
 	BtrPageGCLock*	iib_dont_gc_lock;	// lock to prevent removal of splitted page
 	UCHAR	iib_btr_level;			// target level to propagate split page to
+	UCHAR*	iib_payload = nullptr;	// included columns stored in the leaf node
+	USHORT	iib_payload_length = 0;	// length of the payload, zero if none
 };
 
 
@@ -206,6 +209,7 @@ struct index_sort_record
 	SINT64 isr_record_number;
 	USHORT isr_key_length;
 	USHORT isr_flags;
+	USHORT isr_payload_length;		// payload of included columns follows the record
 };
 #pragma pack()
 
@@ -340,6 +344,7 @@ struct IndexCreation
 	PartitionedSort* sort;
 	sort_key_def* key_desc;
 	USHORT key_length;
+	USHORT payload_length;			// maximum length of the leaf node payload
 	USHORT nullIndLen;
 	SINT64 dup_recno;
 	Firebird::AtomicCounter duplicates;
@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <algorithm>
 #include "../jrd/jrd.h"
 #include "../jrd/que.h"
 #include "../jrd/lck.h"
@@ -63,18 +64,9 @@
 #include "../common/classes/MsgPrint.h"
 #include "../jrd/CryptoManager.h"
 #include "../common/utils_proto.h"
+#include "../common/os/os_utils.h"
 #include "../jrd/PageToBufferMap.h"
-
-#ifndef CDS_UNAVAILABLE
-// Use lock-free lists in hash table implementation
-#define HASH_USE_CDS_LIST
-#endif
-
-
-#ifdef HASH_USE_CDS_LIST
-#include <cds/container/michael_kvlist_dhp.h>
-#include "../jrd/InitCDSLib.h"
-#endif
+#include "../jrd/BCBHashTable.h"
 
 
 using namespace Jrd;
@@ -91,10 +83,6 @@ using namespace Firebird;
 IMPLEMENT_TRACE_ROUTINE(cch_trace, "CCH")
 #endif
 
-#ifdef SUPERSERVER_V2
-#define CACHE_READER
-#endif
-
 
 static inline void PAGE_LOCK_RELEASE(thread_db* tdbb, BufferControl* bcb, Lock* lock)
 {
@@ -129,28 +117,29 @@ enum LatchState
 
 static void adjust_scan_count(WIN* window, bool mustRead);
 static int blocking_ast_bdb(void*);
-#ifdef CACHE_READER
-static void prefetch_epilogue(Prefetch*, FbStatusVector *);
-static void prefetch_init(Prefetch*, thread_db*);
-static void prefetch_io(Prefetch*, FbStatusVector *);
-static void prefetch_prologue(Prefetch*, SLONG *);
-#endif
 static void cacheBuffer(Attachment* att, BufferDesc* bdb);
 static void check_precedence(thread_db*, WIN*, PageNumber);
 static void clear_precedence(thread_db*, BufferDesc*);
 static void down_grade(thread_db*, BufferDesc*, int high = 0);
 static bool expand_buffers(thread_db*, ULONG);
-static BufferDesc* get_buffer(thread_db*, const PageNumber, SyncType, int);
+static void init_nodes(thread_db*, BufferControl*);
+static ULONG allocate_buffers(thread_db*, BufferControl*, ULONG);
+static void set_cache_limits(thread_db*, BufferControl*);
+static bool shrink_buffers(thread_db*, ULONG);
+static ULONG evict_buffers(thread_db*, BufferNode*, ULONG);
+static void retire_buffer(BufferControl*, BufferDesc*);
+static BufferDesc* get_buffer(thread_db*, const PageNumber, SyncType, int, bool);
 static int get_related(BufferDesc*, PagesArray&, int, const ULONG);
 static ULONG get_prec_walk_mark(BufferControl*);
 static LockState lock_buffer(thread_db*, BufferDesc*, const SSHORT, const SCHAR);
-static ULONG memory_init(thread_db*, BufferControl*, ULONG);
+static ULONG memory_init(thread_db*, BufferControl*, BufferNode*, ULONG);
 static void page_validation_error(thread_db*, win*, SSHORT);
 static void purgePrecedence(BufferControl*, BufferDesc*);
 static SSHORT related(BufferDesc*, const BufferDesc*, SSHORT, const ULONG);
 static int write_buffer(thread_db*, BufferDesc*, const PageNumber, const bool, FbStatusVector* const,
 	const bool);
 static bool write_page(thread_db*, BufferDesc*, FbStatusVector* const, const bool);
+static void page_written(thread_db*, BufferDesc*);
 static bool set_diff_page(thread_db*, BufferDesc*);
 static void clear_dirty_flag_and_nbak_state(thread_db*, BufferDesc*);
 
@@ -170,6 +159,12 @@ static inline void insertDirty(BufferControl* bcb, BufferDesc* bdb)
 
 	bcb->bcb_dirty_count++;
 	QUE_INSERT(bcb->bcb_dirty, bdb->bdb_dirty);
+
+	if (bcb->bcb_dirty_target && bcb->bcb_dirty_count > bcb->bcb_dirty_target &&
+		(bcb->bcb_flags & BCB_cache_writer) && !(bcb->bcb_flags & BCB_writer_active))
+	{
+		bcb->bcb_writer_sem.release();
+	}
 }
 
 static inline void removeDirty(BufferControl* bcb, BufferDesc* bdb)
@@ -192,100 +187,142 @@ static inline void removeDirty(BufferControl* bcb, BufferDesc* bdb)
 
 static void flushDirty(thread_db* tdbb, SLONG transaction_mask, const bool sys_only);
 static void flushAll(thread_db* tdbb, USHORT flush_flag);
+static FB_SIZE_T flushOldest(thread_db* tdbb, SLONG target);
 static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, FB_SIZE_T count);
 
 static void recentlyUsed(BufferDesc* bdb);
-static void requeueRecentlyUsed(BufferControl* bcb);
+static void requeueRecentlyUsed(BufferNode* node);
 
+static void load_hot_pages(thread_db* tdbb, Array<ULONG>& pages);
+static bool save_hot_pages(thread_db* tdbb);
 
-constexpr ULONG MIN_BUFFER_SEGMENT = 65536;
 
-// Given pointer a field in the block, find the block
+// LRU ques maintenance, bcn_syncLRU of the buffer node must be locked exclusively
 
-#define BLOCK(fld_ptr, type, fld) (type*)((SCHAR*) fld_ptr - offsetof(type, fld))
+static inline void removeLRU(BufferDesc* bdb)
+{
+	QUE_DELETE(bdb->bdb_in_use);
 
-constexpr int PRE_SEARCH_LIMIT	= 256;
-constexpr int PRE_EXISTS		= -1;
-constexpr int PRE_UNKNOWN		= -2;
+	if (bdb->bdb_flags & BDB_probation)
+	{
+		BufferNode* const node = bdb->bdb_node;
+		fb_assert(node->bcn_probation_count > 0);
 
-namespace Jrd
+		bdb->bdb_flags &= ~BDB_probation;
+		node->bcn_probation_count--;
+	}
+}
+
+static inline void insertLRU(BufferDesc* bdb, bool probation)
 {
+	BufferNode* const node = bdb->bdb_node;
 
-#ifdef HASH_USE_CDS_LIST
+	if (probation)
+	{
+		bdb->bdb_flags |= BDB_probation;
+		node->bcn_probation_count++;
+		QUE_INSERT(node->bcn_probation, bdb->bdb_in_use);
+	}
+	else
+		QUE_INSERT(node->bcn_in_use, bdb->bdb_in_use);
+}
 
-template <typename T>
-class ListNodeAllocator
+static inline void moveToLRUTail(BufferDesc* bdb)
 {
-public:
-	typedef T value_type;
+	BufferNode* const node = bdb->bdb_node;
+
+	QUE_DELETE(bdb->bdb_in_use);
+	QUE_APPEND((bdb->bdb_flags & BDB_probation) ? node->bcn_probation : node->bcn_in_use,
+		bdb->bdb_in_use);
+}
 
-	ListNodeAllocator() {};
+// Order in which LRU ques are searched for the buffer to preempt. With 2Q policy
+// buffers are taken from the probation que while it exceeds its limit.
 
-	template <class U>
-	constexpr ListNodeAllocator(const ListNodeAllocator<U>&) noexcept {}
+static inline void orderLRU(BufferNode* node, que* ques[2])
+{
+	const bool probation = node->bcn_probation_count > node->bcn_probation_limit;
 
-	T* allocate(std::size_t n);
-	void deallocate(T* p, std::size_t n);
+	ques[0] = probation ? &node->bcn_probation : &node->bcn_in_use;
+	ques[1] = probation ? &node->bcn_in_use : &node->bcn_probation;
+}
 
-private:
-};
+// Node of the page cache the current thread takes new buffers from
 
-struct BdbTraits : public cds::container::michael_list::traits
+static inline BufferNode* currentNode(const BufferControl* bcb)
 {
-	typedef ListNodeAllocator<int> allocator;
-	//typedef std::less<PageNumber> compare;
-};
+	if (bcb->bcb_nodes.getCount() == 1)
+		return bcb->bcb_nodes[0];
+
+	const int cpu = os_utils::getCurrentCpu();
 
-typedef cds::container::MichaelKVList<cds::gc::DHP, PageNumber, BufferDesc*, BdbTraits> BdbList;
+	if (cpu < 0)
+		return bcb->bcb_nodes[0];
 
-#endif // HASH_USE_CDS_LIST
+	if ((ULONG) cpu < bcb->bcb_cpu_nodes.getCount())
+		return bcb->bcb_nodes[bcb->bcb_cpu_nodes[cpu]];
+
+	return bcb->bcb_nodes[cpu % bcb->bcb_nodes.getCount()];
+}
 
+// Account the page found in cache, per node stats are kept for multi-node cache only
 
-class BCBHashTable
+static inline void countHit(const BufferControl* bcb, const BufferDesc* bdb)
 {
-#ifdef HASH_USE_CDS_LIST
-	using chain_type = BdbList;
-#else
-	using chain_type = que;
-#endif
+	if (bcb->bcb_nodes.getCount() == 1)
+		return;
 
-public:
-	BCBHashTable(MemoryPool& pool, ULONG count) :
-		m_pool(pool),
-		m_count(0),
-		m_chains(nullptr)
-	{
-		resize(count);
-	}
+	BufferNode* const current = currentNode(bcb);
+	current->bcn_hits++;
 
-	~BCBHashTable()
-	{
-		clear();
-	}
+	if (bdb->bdb_node != current)
+		current->bcn_remote_hits++;
+}
 
-	void resize(ULONG count);
-	void clear();
 
-	BufferDesc* find(const PageNumber& page) const;
+constexpr ULONG MIN_BUFFER_SEGMENT = 65536;
 
-	// tries to put bdb into hash slot by page
-	// if succeed, removes bdb from old slot, if necessary, and returns NULL
-	// else, returns BufferDesc that is currently occupies target slot
-	BufferDesc* emplace(BufferDesc* bdb, const PageNumber& page, bool remove);
+// Cache writer writes at most WRITER_BATCH_PAGES dirty pages at once and makes
+// a WRITER_PACING_MS pause after it, thus background writes don't saturate I/O
 
-	void remove(BufferDesc* bdb);
-private:
-	ULONG hash(const PageNumber& pageno) const
-	{
-		return pageno.getPageNum() % m_count;
-	}
+constexpr FB_SIZE_T WRITER_BATCH_PAGES	= 64;
+constexpr int WRITER_PACING_MS			= 10;
+
+// Numbers of the hot pages are periodically saved by the cache writer into
+// the <database>.cache file and read back into the cache when the database
+// is opened next time. Page type and owner are saved to read pages needed by
+// almost every request first.
 
-	MemoryPool& m_pool;
-	ULONG m_count;
-	chain_type* m_chains;
+constexpr ULONG HOT_PAGES_MAGIC			= 0x48504753;	// "HPGS"
+constexpr USHORT HOT_PAGES_VERSION		= 1;
+
+struct HotPagesHeader
+{
+	ULONG hph_magic;
+	USHORT hph_version;
+	USHORT hph_reserved;
+	ULONG hph_page_size;
+	ULONG hph_count;					// number of HotPage records
+	UCHAR hph_guid[Guid::SIZE];			// database GUID
 };
 
-}
+struct HotPage
+{
+	ULONG hp_page;						// page number in the main page space
+	USHORT hp_relation;					// owner relation, if known
+	UCHAR hp_type;						// page type
+	UCHAR hp_index;						// owner index, if known
+};
+
+static_assert(sizeof(HotPage) == 8, "Unexpected HotPage size");
+
+// Given pointer a field in the block, find the block
+
+#define BLOCK(fld_ptr, type, fld) (type*)((SCHAR*) fld_ptr - offsetof(type, fld))
+
+constexpr int PRE_SEARCH_LIMIT	= 256;
+constexpr int PRE_EXISTS		= -1;
+constexpr int PRE_UNKNOWN		= -2;
 
 
 void CCH_clean_page(thread_db* tdbb, PageNumber page)
@@ -352,14 +389,13 @@ void CCH_clean_page(thread_db* tdbb, PageNumber page)
 	}
 
 	{
-		Sync lruSync(&bcb->bcb_syncLRU, "CCH_release");
+		Sync lruSync(&bdb->bdb_node->bcn_syncLRU, "CCH_release");
 		lruSync.lock(SYNC_EXCLUSIVE);
 
 		if (bdb->bdb_flags & BDB_lru_chained)
-			requeueRecentlyUsed(bcb);
+			requeueRecentlyUsed(bdb->bdb_node);
 
-		QUE_DELETE(bdb->bdb_in_use);
-		QUE_APPEND(bcb->bcb_in_use, bdb->bdb_in_use);
+		moveToLRUTail(bdb);
 	}
 
 	bdb->release(tdbb, true);
@@ -719,7 +755,7 @@ pag* CCH_fake(thread_db* tdbb, WIN* window, int wait)
 	if (dbb->dbb_ast_flags & DBB_get_shadows)
 		SDW_get_shadows(tdbb);
 
-	BufferDesc* bdb = get_buffer(tdbb, window->win_page, SYNC_EXCLUSIVE, wait);
+	BufferDesc* bdb = get_buffer(tdbb, window->win_page, SYNC_EXCLUSIVE, wait, false);
 	if (!bdb)
 		return NULL;			// latch timeout occurred
 
@@ -877,10 +913,17 @@ LockState CCH_fetch_lock(thread_db* tdbb, WIN* window, int lock_type, int wait,
 	if (dbb->dbb_ast_flags & DBB_get_shadows)
 		SDW_get_shadows(tdbb);
 
+	// Pages fetched by large scans, sweep, backup and validation should not push
+	// frequently used pages out of the cache. Keep pointer and index root pages
+	// walked by such scans as usual though, they are needed by everyone else.
+
+	const bool useOnce = bcb->bcb_probation_limit && (window->win_flags & WIN_use_once) &&
+		page_type != pag_pointer && page_type != pag_root;
+
 	// Look for the page in the cache.
 
 	BufferDesc* bdb = get_buffer(tdbb, window->win_page,
-		((lock_type >= LCK_write) ? SYNC_EXCLUSIVE : SYNC_SHARED), wait);
+		((lock_type >= LCK_write) ? SYNC_EXCLUSIVE : SYNC_SHARED), wait, useOnce);
 
 	if (wait != 1 && bdb == 0)
 		return lsLatchTimeout; // latch timeout
@@ -1110,11 +1153,13 @@ void CCH_forget_page(thread_db* tdbb, WIN* window)
 
 	removeDirty(bcb, bdb);
 
+	BufferNode* const node = bdb->bdb_node;
+
 	// remove from LRU list
 	{
-		SyncLockGuard lruSync(&bcb->bcb_syncLRU, SYNC_EXCLUSIVE, FB_FUNCTION);
-		requeueRecentlyUsed(bcb);
-		QUE_DELETE(bdb->bdb_in_use);
+		SyncLockGuard lruSync(&node->bcn_syncLRU, SYNC_EXCLUSIVE, FB_FUNCTION);
+		requeueRecentlyUsed(node);
+		removeLRU(bdb);
 	}
 
 	// remove from hash table and put into empty list
@@ -1122,18 +1167,16 @@ void CCH_forget_page(thread_db* tdbb, WIN* window)
 	{
 		SyncLockGuard bcbSync(&bcb->bcb_syncObject, SYNC_EXCLUSIVE, FB_FUNCTION);
 		bcb->bcb_hashTable->remove(bdb);
-		QUE_INSERT(bcb->bcb_empty, bdb->bdb_que);
-		bcb->bcb_inuse--;
 	}
 #else
 	bcb->bcb_hashTable->remove(bdb);
+#endif
 
 	{
-		SyncLockGuard syncEmpty(&bcb->bcb_syncEmpty, SYNC_EXCLUSIVE, FB_FUNCTION);
-		QUE_INSERT(bcb->bcb_empty, bdb->bdb_que);
-		bcb->bcb_inuse--;
+		SyncLockGuard syncEmpty(&node->bcn_syncEmpty, SYNC_EXCLUSIVE, FB_FUNCTION);
+		QUE_INSERT(node->bcn_empty, bdb->bdb_que);
+		node->bcn_inuse--;
 	}
-#endif
 
 	bdb->bdb_flags = 0;
 
@@ -1184,6 +1227,16 @@ void CCH_fini(thread_db* tdbb)
 	while (bcb->bcb_memory.hasData())
 		bcb->bcb_bufferpool->deallocate(bcb->bcb_memory.pop());
 
+	for (const auto& blk : bcb->bcb_huge_memory)
+		os_utils::freeHugePages(blk.m_memory, blk.m_size);
+
+	bcb->bcb_huge_memory.clear();
+
+	for (auto node : bcb->bcb_nodes)
+		delete node;
+
+	bcb->bcb_nodes.clear();
+
 	BufferControl::destroy(bcb);
 	dbb->dbb_bcb = NULL;
 }
@@ -1614,15 +1667,22 @@ void CCH_init(thread_db* tdbb, ULONG number)
 	bcb->bcb_flags = shared ? BCB_exclusive : 0;
 	//bcb->bcb_flags = BCB_exclusive;	// TODO detect real state using LM
 
-	QUE_INIT(bcb->bcb_in_use);
 	QUE_INIT(bcb->bcb_dirty);
 	bcb->bcb_dirty_count = 0;
-	QUE_INIT(bcb->bcb_empty);
+	QUE_INIT(bcb->bcb_retired);
+
+	init_nodes(tdbb, bcb);
 
 	// initialization of memory is system-specific
 
-	bcb->bcb_count = memory_init(tdbb, bcb, number);
-	bcb->bcb_free_minimum = (SSHORT) MIN(bcb->bcb_count / 4, 128);
+	bcb->bcb_count = allocate_buffers(tdbb, bcb, number);
+
+	// 2Q policy keeps quarter of the cache for the pages referenced only once
+
+	if (NoCaseString(dbb->dbb_config->getPageReplacementPolicy()) == PageReplacement2Q)
+		bcb->bcb_probation_limit = bcb->bcb_count / 4;
+
+	set_cache_limits(tdbb, bcb);
 
 	if (bcb->bcb_count < MIN_PAGE_BUFFERS)
 		ERR_post(Arg::Gds(isc_cache_too_small));
@@ -1652,17 +1712,6 @@ void CCH_init2(thread_db* tdbb)
 	if (!(bcb->bcb_flags & BCB_exclusive) || (bcb->bcb_flags & (BCB_cache_writer | BCB_writer_start)))
 		return;
 
-#ifdef CACHE_READER
-	if (gds__thread_start(cache_reader, dbb, THREAD_high, 0, 0))
-	{
-		ERR_bugcheck_msg("cannot start thread");
-	}
-
-	{ // scope
-		Database::Checkout dcoHolder(dbb, FB_FUNCTION);
-		dbb->dbb_reader_init.enter();
-	}
-#endif
 
 	const Attachment* att = tdbb->getAttachment();
 	if (!(dbb->dbb_flags & DBB_read_only) && !(att->att_flags & ATT_security_db))
@@ -1857,8 +1906,7 @@ void CCH_precedence(thread_db* tdbb, WIN* window, PageNumber page)
 }
 
 
-#ifdef CACHE_READER
-void CCH_prefetch(thread_db* tdbb, SLONG* pages, SSHORT count)
+void CCH_prefetch(thread_db* tdbb, USHORT pageSpaceId, const ULONG* pages, ULONG count)
 {
 /**************************************
  *
@@ -1867,76 +1915,121 @@ void CCH_prefetch(thread_db* tdbb, SLONG* pages, SSHORT count)
  **************************************
  *
  * Functional description
- *	Given a vector of pages, set corresponding bits
- *	in global prefetch bitmap. Initiate an asynchronous
- *	I/O and get the cache reader reading in our behalf
- *	as well.
+ *	Given a vector of pages, read the ones not in cache yet
+ *	into free buffers using single multi-page request.
+ *	Read errors are not reported here, buffer is left in the
+ *	read pending state and the page is read again (with proper
+ *	error handling) when it is fetched.
  *
  **************************************/
 	SET_TDBB(tdbb);
-	Database* dbb = tdbb->getDatabase();
-	BufferControl* bcb = dbb->dbb_bcb;
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
 
-	if (!count || !(bcb->bcb_flags & BCB_cache_reader))
-	{
-		// Caller isn't really serious.
+	// Page locks are not taken here, thus read-ahead is possible only
+	// when page cache is not shared with another process
+
+	if (!count || !(bcb->bcb_flags & BCB_exclusive))
 		return;
-	}
 
-	// Switch default pool to permanent pool for setting bits in prefetch bitmap.
-	Jrd::ContextPoolHolder context(tdbb, bcb->bcb_bufferpool);
+	const auto pageSpace = dbb->dbb_page_manager.findPageSpace(pageSpaceId);
+	fb_assert(pageSpace);
+
+	// Don't bother with pages that could live in the difference file
+
+	BackupManager::StateReadGuard stateGuard(tdbb);
+
+	if (!pageSpace->isTemporary() && dbb->dbb_backup_manager->getState() != Ods::hdr_nbak_normal)
+		return;
+
+	// Don't let read-ahead to evict too much of the cache
+
+	count = MIN(count, MIN(PREFETCH_MAX_PAGES, bcb->bcb_count / 4));
 
-	// The global prefetch bitmap is the key to the I/O coalescense mechanism which dovetails
-	// all thread prefetch requests to minimize sequential I/O requests.
-	// It also enables multipage I/O by implicitly sorting page vector requests.
+	HalfStaticArray<PageIoRequest, PREFETCH_MAX_PAGES> requests;
 
-	SLONG first_page = 0;
-	for (const SLONG* const end = pages + count; pages < end;)
+	for (const ULONG* const end = pages + count; pages < end; pages++)
 	{
-		const SLONG page = *pages++;
-		if (page)
+		if (!*pages)
+			continue;
+
+		const PageNumber page(pageSpaceId, *pages);
+
+		{	// scope
+#ifndef HASH_USE_CDS_LIST
+			SyncLockGuard bcbSync(&bcb->bcb_syncObject, SYNC_SHARED, FB_FUNCTION);
+#endif
+			if (bcb->bcb_hashTable->find(page))
+				continue;
+		}
+
+		BufferDesc* const bdb = get_buffer(tdbb, page, SYNC_EXCLUSIVE, 0, true);
+		if (!bdb)
+			continue;
+
+		if (!(bdb->bdb_flags & BDB_read_pending))
 		{
-			SBM_set(tdbb, &bcb->bcb_prefetch, page);
-			if (!first_page)
-				first_page = page;
+			bdb->release(tdbb, true);
+			continue;
 		}
+
+		PageIoRequest& request = requests.add();
+		request.bdb = bdb;
+		request.page = bdb->bdb_buffer;
+		request.done = false;
 	}
 
-	// Not likely that the caller's page vector was empty but check anyway.
+	if (requests.isEmpty())
+		return;
+
+	PIO_read_pages(tdbb, pageSpace->file, requests.begin(), requests.getCount());
 
-	if (first_page)
+	// Page image is already read by PIO_read_pages(). Read it again if
+	// it was not read or if crypto manager asks for it once more.
+
+	class Pio : public CryptoManager::IOCallback
 	{
-		prf prefetch;
+	public:
+		Pio(jrd_file* f, const PageIoRequest& r)
+			: file(f), request(r), first(true)
+		{ }
 
-		prefetch_init(&prefetch, tdbb);
-		prefetch_prologue(&prefetch, &first_page);
-		prefetch_io(&prefetch, tdbb->tdbb_status_vector);
-		prefetch_epilogue(&prefetch, tdbb->tdbb_status_vector);
-	}
-}
+		bool callback(thread_db* tdbb, FbStatusVector* status, Ods::pag* page)
+		{
+			if (first && request.done)
+			{
+				first = false;
+				return true;
+			}
 
+			return PIO_read(tdbb, file, request.bdb, page, status);
+		}
 
-bool CCH_prefetch_pages(thread_db* tdbb)
-{
-/**************************************
- *
- *	C C H _ p r e f e t c h _ p a g e s
- *
- **************************************
- *
- * Functional description
- *	Check the prefetch bitmap for a set
- *	of pages and read them into the cache.
- *
- **************************************/
+	private:
+		jrd_file* file;
+		const PageIoRequest& request;
+		bool first;
+	};
 
-	// Placeholder to be implemented when predictive prefetch is
-	// enabled. This is called by VIO/garbage_collector() when it
-	// is idle to help satisfy the prefetch demand.
+	FbLocalStatus localStatus;
 
-	return false;
+	for (const auto& request : requests)
+	{
+		BufferDesc* const bdb = request.bdb;
+		Pio io(pageSpace->file, request);
+
+		if (dbb->dbb_crypto_manager->read(tdbb, &localStatus, request.page, &io))
+		{
+			bdb->bdb_incarnation = ++bcb->bcb_page_incarnation;
+			tdbb->bumpStats(PageStatType::READS, pageSpaceId);
+
+			bdb->bdb_flags &= ~(BDB_not_valid | BDB_read_pending);
+			bdb->bdb_flags |= BDB_prefetch;
+		}
+
+		bdb->release(tdbb, true);
+	}
 }
-#endif // CACHE_READER
 
 
 bool set_diff_page(thread_db* tdbb, BufferDesc* bdb)
@@ -2127,17 +2220,16 @@ void CCH_release(thread_db* tdbb, WIN* window, const bool release_tail)
 				if (window->win_flags & WIN_garbage_collector)
 					bdb->bdb_flags &= ~BDB_garbage_collect;
 
-				{ // bcb_syncLRU scope
-					Sync lruSync(&bcb->bcb_syncLRU, "CCH_release");
+				{ // bcn_syncLRU scope
+					Sync lruSync(&bdb->bdb_node->bcn_syncLRU, "CCH_release");
 					lruSync.lock(SYNC_EXCLUSIVE);
 
 					if (bdb->bdb_flags & BDB_lru_chained)
 					{
-						requeueRecentlyUsed(bcb);
+						requeueRecentlyUsed(bdb->bdb_node);
 					}
 
-					QUE_DELETE(bdb->bdb_in_use);
-					QUE_APPEND(bcb->bcb_in_use, bdb->bdb_in_use);
+					moveToLRUTail(bdb);
 				}
 
 				if ((bcb->bcb_flags & BCB_cache_writer) &&
@@ -2185,6 +2277,30 @@ void CCH_release_exclusive(thread_db* tdbb)
 }
 
 
+bool CCH_resize(thread_db* tdbb, ULONG number)
+{
+/**************************************
+ *
+ *	C C H _ r e s i z e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Grow or shrink the cache to the given number of buffers
+ *	while the database is in use. Return true if the cache
+ *	size was changed.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	BufferControl* const bcb = tdbb->getDatabase()->dbb_bcb;
+
+	if (number > bcb->bcb_count)
+		return expand_buffers(tdbb, number);
+
+	return shrink_buffers(tdbb, number);
+}
+
+
 bool CCH_rollover_to_shadow(thread_db* tdbb, Database* dbb, jrd_file* file, const bool inAst)
 {
 /**************************************
@@ -2236,16 +2352,6 @@ void CCH_shutdown(thread_db* tdbb)
 	if (!bcb)
 		return;
 
-#ifdef CACHE_READER
-	// Shutdown the dedicated cache reader for this database
-
-	if (bcb->bcb_flags & BCB_cache_reader)
-	{
-		bcb->bcb_flags &= ~BCB_cache_reader;
-		dbb->dbb_reader_sem.release();
-		dbb->dbb_reader_fini.enter();
-	}
-#endif
 
 	// Wait for cache writer startup to complete
 
@@ -2554,6 +2660,15 @@ static void adjust_scan_count(WIN* window, bool mustRead)
  **************************************/
 	BufferDesc* bdb = window->win_bdb;
 
+	// Page read ahead by CCH_prefetch() is first referenced now,
+	// handle it the same way as if it was just read from disk
+
+	if (bdb->bdb_flags & BDB_prefetch)
+	{
+		bdb->bdb_flags &= ~BDB_prefetch;
+		mustRead = true;
+	}
+
 	// If a page was read or prefetched on behalf of a large scan
 	// then load the window scan count into the buffer descriptor.
 	// This buffer scan count is decremented by releasing a buffer
@@ -2564,7 +2679,7 @@ static void adjust_scan_count(WIN* window, bool mustRead)
 
 	if (window->win_flags & WIN_large_scan)
 	{
-		if (mustRead || (bdb->bdb_flags & BDB_prefetch) || bdb->bdb_scan_count < 0)
+		if (mustRead || bdb->bdb_scan_count < 0)
 			bdb->bdb_scan_count = window->win_scans;
 	}
 	else if (window->win_flags & WIN_garbage_collector)
@@ -2708,6 +2823,50 @@ static void flushDirty(thread_db* tdbb, SLONG transaction_mask, const bool sys_o
 }
 
 
+// Write the oldest dirty pages not used at the moment, used by the cache writer
+// to keep the number of dirty pages below the target and by the cache shrink.
+// Returns number of pages written.
+static FB_SIZE_T flushOldest(thread_db* tdbb, SLONG target)
+{
+	SET_TDBB(tdbb);
+	Database* dbb = tdbb->getDatabase();
+	BufferControl* bcb = dbb->dbb_bcb;
+	Firebird::HalfStaticArray<BufferDesc*, WRITER_BATCH_PAGES> flush;
+
+	{  // dirtySync scope
+		Sync dirtySync(&bcb->bcb_syncDirtyBdbs, "flushOldest");
+		dirtySync.lock(SYNC_EXCLUSIVE);
+
+		SLONG excess = bcb->bcb_dirty_count - target;
+
+		QUE que_inst = bcb->bcb_dirty.que_backward, prev;
+		for (; que_inst != &bcb->bcb_dirty && excess > 0 && flush.getCount() < WRITER_BATCH_PAGES;
+			que_inst = prev)
+		{
+			prev = que_inst->que_backward;
+			BufferDesc* bdb = BLOCK(que_inst, BufferDesc, bdb_dirty);
+
+			if (!(bdb->bdb_flags & BDB_dirty))
+			{
+				removeDirty(bcb, bdb);
+				excess--;
+				continue;
+			}
+
+			// don't wait for pages someone works with right now
+			if (bdb->bdb_use_count)
+				continue;
+
+			flush.add(bdb);
+			excess--;
+		}
+	}
+
+	flushPages(tdbb, 0, flush.begin(), flush.getCount());
+	return flush.getCount();
+}
+
+
 // Collect pages modified by garbage collector or all dirty pages or release page
 // locks - depending of flush_flag, and write it to disk.
 // See also comments in flushPages.
@@ -2789,229 +2948,293 @@ extern "C" {
 // no such pages (i.e. all of not written yet pages have high precedence pages)
 // then write them all at last iteration (of course write_buffer will also check
 // for precedence before write).
-static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, FB_SIZE_T count)
+namespace
 {
-	FbStatusVector* const status = tdbb->tdbb_status_vector;
-	const bool all_flag = (flush_flag & FLUSH_ALL) != 0;
-	const bool release_flag = (flush_flag & FLUSH_RLSE) != 0;
-	const bool write_thru = release_flag;
-
-	qsort(begin, count, sizeof(BufferDesc*), cmpBdbs);
-
-	MarkIterator<BufferDesc*> iter(begin, count);
-
-	FB_SIZE_T written = 0;
-	bool writeAll = false;
+	// Set of dirty pages collected by flushPages() to be written using single
+	// PIO_write_pages() call. Pages are kept latched until the batch is written.
+	// Only pages that don't need precedence, backup or shadow handling are
+	// accepted, everything else goes through the usual write_buffer().
 
-	while (!iter.isEmpty())
+	class PageWriteBatch
 	{
-		bool found = false;
-		for (; !iter.isEof(); ++iter)
-		{
-			BufferDesc* bdb = *iter;
-			fb_assert(bdb);
-			if (!bdb)
-				continue;
+	public:
+		static const FB_SIZE_T MAX_PAGES = 64;
 
-			bdb->addRef(tdbb, release_flag ? SYNC_EXCLUSIVE : SYNC_SHARED);
+		PageWriteBatch(thread_db* tdbb, bool writeThru, bool release)
+			: m_tdbb(tdbb), m_writeThru(writeThru), m_release(release), m_count(0)
+		{ }
 
-			BufferControl* bcb = bdb->bdb_bcb;
-			if (!writeAll)
-				purgePrecedence(bcb, bdb);
+		bool accepts(const BufferDesc* bdb) const
+		{
+			const Database* const dbb = m_tdbb->getDatabase();
 
-			if (writeAll || QUE_EMPTY(bdb->bdb_higher))
-			{
-				if (release_flag)
-				{
-					if (bdb->bdb_use_count > 1)
-						BUGCHECK(210);	// msg 210 page in use during flush
-				}
+			if (dbb->dbb_shadow || dbb->dbb_backup_manager->getState() != Ods::hdr_nbak_normal)
+				return false;
 
-				if (!all_flag || bdb->bdb_flags & (BDB_db_dirty | BDB_dirty))
-				{
-					if (!write_buffer(tdbb, bdb, bdb->bdb_page, write_thru, status, true))
-						CCH_unwind(tdbb, true);
-				}
+			if (bdb->bdb_page == HEADER_PAGE_NUMBER || QUE_NOT_EMPTY(bdb->bdb_higher))
+				return false;
 
-				// release lock before losing control over bdb, it prevents
-				// concurrent operations on released lock
-				if (release_flag)
-					PAGE_LOCK_RELEASE(tdbb, bcb, bdb->bdb_lock);
+			return (bdb->bdb_flags & BDB_dirty) || (m_writeThru && (bdb->bdb_flags & BDB_db_dirty));
+		}
 
-				bdb->release(tdbb, !release_flag && !(bdb->bdb_flags & BDB_dirty));
+		bool fits(const BufferDesc* bdb) const
+		{
+			return !m_count || (m_count < MAX_PAGES &&
+				m_bdbs[0]->bdb_page.getPageSpaceID() == bdb->bdb_page.getPageSpaceID());
+		}
 
-				iter.mark();
-				found = true;
-				written++;
-			}
-			else
-			{
-				bdb->release(tdbb, false);
-			}
+		void add(BufferDesc* bdb)
+		{
+			fb_assert(m_count < MAX_PAGES);
+			m_bdbs[m_count++] = bdb;
 		}
 
-		if (!found)
-			writeAll = true;
+		bool write();
 
-		iter.rewind();
-	}
+	private:
+		enum PageState { PAGE_CLEAN, PAGE_QUEUED, PAGE_WRITTEN, PAGE_RETRY };
 
-	fb_assert(count == written);
-}
-
-
-#ifdef CACHE_READER
-void BufferControl::cache_reader(BufferControl* bcb)
-{
-/**************************************
- *
- *	c a c h e _ r e a d e r
- *
- **************************************
- *
- * Functional description
- *	Prefetch pages into cache for sequential scans.
- *	Use asynchronous I/O to keep two prefetch requests
- *	busy at a time.
- *
- **************************************/
-	Database* dbb = bcb->bcb_database;
-	Database::SyncGuard dsGuard(dbb);
+		thread_db* const m_tdbb;
+		const bool m_writeThru;
+		const bool m_release;
+		FB_SIZE_T m_count;
+		BufferDesc* m_bdbs[MAX_PAGES];
+	};
 
-	FbLocalStatus status_vector;
+	bool PageWriteBatch::write()
+	{
+		if (!m_count)
+			return true;
 
-	// Establish a thread context.
-	ThreadContextHolder tdbb(status_vector);
+		thread_db* const tdbb = m_tdbb;
+		Database* const dbb = tdbb->getDatabase();
 
-	// Dummy attachment needed for lock owner identification.
-	tdbb->setDatabase(dbb);
-	Jrd::Attachment* const attachment = Attachment::create(dbb, nullptr);
-	tdbb->setAttachment(attachment);
-	attachment->att_filename = dbb->dbb_filename;
-	Jrd::ContextPoolHolder context(tdbb, bcb->bcb_bufferpool);
+		const ULONG pageSpaceId = m_bdbs[0]->bdb_page.getPageSpaceID();
+		PageSpace* const pageSpace = dbb->dbb_page_manager.findPageSpace(pageSpaceId);
+		fb_assert(pageSpace);
 
-	// This try block is specifically to protect the LCK_init call: if
-	// LCK_init fails we won't be able to accomplish anything anyway, so
-	// return, unlike the other try blocks further down the page.
+		// Plain page image is queued to be written later, while encrypted
+		// image lives in the temporary buffer and is written immediately
 
-	BufferControl* bcb = NULL;
+		class Queue : public CryptoManager::IOCallback
+		{
+		public:
+			Queue(jrd_file* f, BufferDesc* b, PageIoRequest* r)
+				: queued(false), file(f), bdb(b), request(r)
+			{ }
 
-	try {
+			bool callback(thread_db* tdbb, FbStatusVector* status, Ods::pag* page)
+			{
+				if (page != bdb->bdb_buffer)
+					return PIO_write(tdbb, file, bdb, page, status);
 
-		LCK_init(tdbb, LCK_OWNER_attachment);
-		TRA_init(attachment);
-		bcb = dbb->dbb_bcb;
-		bcb->bcb_flags |= BCB_cache_reader;
-		dbb->dbb_reader_init.post();	// Notify our creator that we have started
-	}
-	catch (const Firebird::Exception& ex)
-	{
-		ex.stuffException(status_vector);
-		iscDbLogStatus(dbb->dbb_filename.c_str(), status_vector);
-		return 0;
-	}
+				request->bdb = bdb;
+				request->page = page;
+				request->done = false;
+				queued = true;
+				return true;
+			}
 
-	try {
+			bool queued;
 
-	// Set up dual prefetch control blocks to keep multiple prefetch
-	// requests active at a time. Also helps to prevent the cache reader
-	// from becoming dedicated or locked into a single request's prefetch demands.
+		private:
+			jrd_file* file;
+			BufferDesc* bdb;
+			PageIoRequest* request;
+		};
 
-	prf prefetch1, prefetch2;
-	prefetch_init(&prefetch1, tdbb);
-	prefetch_init(&prefetch2, tdbb);
+		PageState states[MAX_PAGES];
+		PageIoRequest requests[MAX_PAGES];
+		PageIoRequest* bdbRequests[MAX_PAGES];
+		ULONG queued = 0;
 
-	while (bcb->bcb_flags & BCB_cache_reader)
-	{
-		bcb->bcb_flags |= BCB_reader_active;
-		bool found = false;
-		SLONG starting_page = -1;
-		prf* next_prefetch = &prefetch1;
+		FbLocalStatus localStatus;
 
-		if (dbb->dbb_flags & DBB_suspend_bgio)
+		for (FB_SIZE_T i = 0; i < m_count; i++)
 		{
-			Database::Checkout dcoHolder(dbb, FB_FUNCTION);
-			dbb->dbb_reader_sem.tryEnter(10);
-			continue;
-		}
+			BufferDesc* const bdb = m_bdbs[i];
+			bdb->lockIO(tdbb);
 
-		// Make a pass thru the global prefetch bitmap looking for something
-		// to read. When the entire bitmap has been scanned and found to be
-		// empty then wait for new requests.
+			// Page could be written by someone else after it was added to the batch
 
-		do {
-			if (!(prefetch1.prf_flags & PRF_active) &&
-				SBM_next(bcb->bcb_prefetch, &starting_page, RSE_get_forward))
+			if ((bdb->bdb_flags & BDB_marked) ||
+				!((bdb->bdb_flags & BDB_dirty) || (m_writeThru && (bdb->bdb_flags & BDB_db_dirty))))
 			{
-				found = true;
-				prefetch_prologue(&prefetch1, &starting_page);
-				prefetch_io(&prefetch1, status_vector);
+				states[i] = PAGE_CLEAN;
+				continue;
 			}
 
-			if (!(prefetch2.prf_flags & PRF_active) &&
-				SBM_next(bcb->bcb_prefetch, &starting_page, RSE_get_forward))
+			if ((bdb->bdb_flags & BDB_not_valid) || !accepts(bdb))
 			{
-				found = true;
-				prefetch_prologue(&prefetch2, &starting_page);
-				prefetch_io(&prefetch2, status_vector);
+				states[i] = PAGE_RETRY;
+				continue;
 			}
 
-			prf* post_prefetch = next_prefetch;
-			next_prefetch = (post_prefetch == &prefetch1) ? &prefetch2 : &prefetch1;
+			CCH_TRACE(("WRITE   %d:%06d", pageSpaceId, bdb->bdb_page.getPageNum()));
+
+			pag* const page = bdb->bdb_buffer;
+			page->pag_generation++;
+			page->pag_pageno = bdb->bdb_page.getPageNum();
 
-			if (post_prefetch->prf_flags & PRF_active)
-				prefetch_epilogue(post_prefetch, status_vector);
+			Queue io(pageSpace->file, bdb, &requests[queued]);
 
-			if (found)
+			if (!dbb->dbb_crypto_manager->write(tdbb, &localStatus, page, &io))
+				states[i] = PAGE_RETRY;
+			else if (io.queued)
 			{
-				// If the cache writer or garbage collector is idle, put
-				// them to work prefetching pages.
-#ifdef CACHE_WRITER
-				if ((bcb->bcb_flags & BCB_cache_writer) && !(bcb->bcb_flags & BCB_writer_active))
-					dbb_writer_sem.release();
-#endif
-#ifdef GARBAGE_THREAD
-				if ((dbb->dbb_flags & DBB_garbage_collector) && !(dbb->dbb_flags & DBB_gc_active))
-					dbb->dbb_gc_sem.release();
-#endif
+				states[i] = PAGE_QUEUED;
+				bdbRequests[i] = &requests[queued++];
 			}
-		} while (prefetch1.prf_flags & PRF_active || prefetch2.prf_flags & PRF_active);
+			else
+				states[i] = PAGE_WRITTEN;
+		}
 
-		// If there's more work to do voluntarily ask to be rescheduled.
-		// Otherwise, wait for event notification.
-		BufferDesc* bdb;
-		if (found)
-			JRD_reschedule(tdbb, true);
-		else if (bcb->bcb_flags & BCB_free_pending && (bdb = get_dirty_buffer(tdbb)))
-		{
-			// In our spare time, help writer clean the cache.
+		if (queued)
+			PIO_write_pages(tdbb, pageSpace->file, requests, queued);
 
-			write_buffer(tdbb, bdb, bdb->bdb_page, true, status_vector, true);
-		}
-		else
+		FbStatusVector* const status = tdbb->tdbb_status_vector;
+		bool result = true;
+
+		for (FB_SIZE_T i = 0; i < m_count; i++)
 		{
-			bcb->bcb_flags &= ~BCB_reader_active;
-			Database::Checkout dcoHolder(dbb, FB_FUNCTION);
-			dbb->dbb_reader_sem.tryEnter(10);
+			BufferDesc* const bdb = m_bdbs[i];
+			BufferControl* const bcb = bdb->bdb_bcb;
+			bool done = true;
+
+			if (states[i] == PAGE_QUEUED)
+				states[i] = bdbRequests[i]->done ? PAGE_WRITTEN : PAGE_RETRY;
+
+			if (states[i] == PAGE_WRITTEN)
+			{
+				tdbb->bumpStats(PageStatType::WRITES, pageSpaceId);
+				page_written(tdbb, bdb);
+			}
+			else if (states[i] == PAGE_RETRY)
+			{
+				// Let write_page() deal with the error, i.e. retry write,
+				// switch to the shadow and report the failure properly
+				done = write_page(tdbb, bdb, status, false);
+			}
+
+			bdb->unLockIO(tdbb);
+
+			if (done)
+			{
+				clear_precedence(tdbb, bdb);
+
+				// release lock before losing control over bdb, see flushPages()
+				if (m_release)
+					PAGE_LOCK_RELEASE(tdbb, bcb, bdb->bdb_lock);
+			}
+			else
+				result = false;
+
+			bdb->release(tdbb, done && !m_release && !(bdb->bdb_flags & BDB_dirty));
 		}
-		bcb = dbb->dbb_bcb;
+
+		m_count = 0;
+		return result;
 	}
+} // namespace
 
-	LCK_fini(tdbb, LCK_OWNER_attachment);
-	Jrd::Attachment::destroy(attachment);	// no need saving warning error strings here
-	tdbb->setAttachment(NULL);
-	bcb->bcb_flags &= ~BCB_cache_reader;
-	dbb->dbb_reader_fini.post();
 
-	}	// try
-	catch (const Firebird::Exception& ex)
+static void flushPages(thread_db* tdbb, USHORT flush_flag, BufferDesc** begin, FB_SIZE_T count)
+{
+	FbStatusVector* const status = tdbb->tdbb_status_vector;
+	const bool all_flag = (flush_flag & FLUSH_ALL) != 0;
+	const bool release_flag = (flush_flag & FLUSH_RLSE) != 0;
+	const bool write_thru = release_flag;
+	const SyncType syncType = release_flag ? SYNC_EXCLUSIVE : SYNC_SHARED;
+
+	qsort(begin, count, sizeof(BufferDesc*), cmpBdbs);
+
+	MarkIterator<BufferDesc*> iter(begin, count);
+	PageWriteBatch batch(tdbb, write_thru, release_flag);
+
+	FB_SIZE_T written = 0;
+	bool writeAll = false;
+
+	while (!iter.isEmpty())
 	{
-		ex.stuffException(status_vector);
-		iscDbLogStatus(dbb->dbb_filename.c_str(), status_vector);
+		bool found = false;
+		for (; !iter.isEof(); ++iter)
+		{
+			BufferDesc* bdb = *iter;
+			fb_assert(bdb);
+			if (!bdb)
+				continue;
+
+			// Don't wait for the latch while holding latches of the batched pages
+
+			if (!bdb->addRefConditional(tdbb, syncType))
+			{
+				if (!batch.write())
+					CCH_unwind(tdbb, true);
+
+				bdb->addRef(tdbb, syncType);
+			}
+
+			BufferControl* bcb = bdb->bdb_bcb;
+			if (!writeAll)
+				purgePrecedence(bcb, bdb);
+
+			if (writeAll || QUE_EMPTY(bdb->bdb_higher))
+			{
+				if (release_flag)
+				{
+					if (bdb->bdb_use_count > 1)
+						BUGCHECK(210);	// msg 210 page in use during flush
+				}
+
+				if (!all_flag || bdb->bdb_flags & (BDB_db_dirty | BDB_dirty))
+				{
+					if (!writeAll && batch.accepts(bdb))
+					{
+						if (!batch.fits(bdb) && !batch.write())
+							CCH_unwind(tdbb, true);
+
+						// buffer is released by the batch after write
+						batch.add(bdb);
+
+						iter.mark();
+						found = true;
+						written++;
+						continue;
+					}
+
+					if (!write_buffer(tdbb, bdb, bdb->bdb_page, write_thru, status, true))
+						CCH_unwind(tdbb, true);
+				}
+
+				// release lock before losing control over bdb, it prevents
+				// concurrent operations on released lock
+				if (release_flag)
+					PAGE_LOCK_RELEASE(tdbb, bcb, bdb->bdb_lock);
+
+				bdb->release(tdbb, !release_flag && !(bdb->bdb_flags & BDB_dirty));
+
+				iter.mark();
+				found = true;
+				written++;
+			}
+			else
+			{
+				bdb->release(tdbb, false);
+			}
+		}
+
+		// Lower precedence pages could wait for the batched ones
+		if (!batch.write())
+			CCH_unwind(tdbb, true);
+
+		if (!found)
+			writeAll = true;
+
+		iter.rewind();
 	}
-	return 0;
+
+	fb_assert(count == written);
 }
-#endif
 
 
 void BufferControl::cache_writer(BufferControl* bcb)
@@ -3060,12 +3283,21 @@ void BufferControl::cache_writer(BufferControl* bcb)
 			// Notify our creator that we have started
 			bcb->bcb_writer_init.release();
 
+			// Hot pages saved by the previous run are read back in small
+			// portions between the regular writer duties
+
+			ULONG dumpInterval = dbb->dbb_config->getCacheDumpInterval();
+			time_t lastDump = time(NULL);
+
+			Array<ULONG> warmupPages;
+			FB_SIZE_T warmupPos = 0;
+
+			if (dumpInterval)
+				load_hot_pages(tdbb, warmupPages);
+
 			while (bcb->bcb_flags & BCB_cache_writer)
 			{
 				bcb->bcb_flags |= BCB_writer_active;
-#ifdef CACHE_READER
-				SLONG starting_page = -1;
-#endif
 
 				if (dbb->dbb_flags & DBB_suspend_bgio)
 				{
@@ -3093,25 +3325,50 @@ void BufferControl::cache_writer(BufferControl* bcb)
 						attachment->mergeStats();
 					}
 				}
+				else if (bcb->bcb_dirty_target && bcb->bcb_dirty_count > bcb->bcb_dirty_target)
+				{
+					// Too many dirty pages - write the oldest ones ahead of
+					// time to spread the flush work over time
+
+					if (flushOldest(tdbb, bcb->bcb_dirty_target))
+						attachment->mergeStats();
+				}
+				else if (warmupPos < warmupPages.getCount())
+				{
+					const ULONG count = MIN(warmupPages.getCount() - warmupPos,
+						MIN(PREFETCH_MAX_PAGES, bcb->bcb_count / 4));
+
+					CCH_prefetch(tdbb, DB_PAGE_SPACE, warmupPages.begin() + warmupPos, count);
+					attachment->mergeStats();
+
+					warmupPos += count;
+					if (warmupPos == warmupPages.getCount())
+					{
+						warmupPages.free();
+						warmupPos = 0;
+					}
+				}
+
+				// Don't overwrite the list until warm-up is done, the cache is not hot yet
+
+				if (dumpInterval && !warmupPages.hasData() && time(NULL) - lastDump >= (time_t) dumpInterval)
+				{
+					if (!save_hot_pages(tdbb))
+						dumpInterval = 0;
+
+					lastDump = time(NULL);
+				}
 
 				// If there's more work to do voluntarily ask to be rescheduled.
 				// Otherwise, wait for event notification.
 
-				if ((bcb->bcb_flags & BCB_free_pending) || dbb->dbb_flush_cycle)
+				if ((bcb->bcb_flags & BCB_free_pending) || dbb->dbb_flush_cycle || warmupPages.hasData())
 					JRD_reschedule(tdbb, true);
-#ifdef CACHE_READER
-				else if (SBM_next(bcb->bcb_prefetch, &starting_page, RSE_get_forward))
+				else if (bcb->bcb_dirty_target && bcb->bcb_dirty_count > bcb->bcb_dirty_target)
 				{
-					// Prefetch some pages in our spare time and in the process
-					// garbage collect the prefetch bitmap.
-					prf prefetch;
-
-					prefetch_init(&prefetch, tdbb);
-					prefetch_prologue(&prefetch, &starting_page);
-					prefetch_io(&prefetch, status_vector);
-					prefetch_epilogue(&prefetch, status_vector);
+					EngineCheckout cout(tdbb, FB_FUNCTION);
+					bcb->bcb_writer_sem.tryEnter(0, WRITER_PACING_MS);
 				}
-#endif
 				else
 				{
 					bcb->bcb_flags &= ~BCB_writer_active;
@@ -3119,6 +3376,11 @@ void BufferControl::cache_writer(BufferControl* bcb)
 					bcb->bcb_writer_sem.tryEnter(10);
 				}
 			}
+
+			// Save the list of hot pages on database close to warm up the cache next time
+
+			if (dumpInterval && !warmupPages.hasData())
+				save_hot_pages(tdbb);
 		}
 		catch (const Firebird::Exception& ex)
 		{
@@ -3154,87 +3416,276 @@ void BufferControl::cache_writer(BufferControl* bcb)
 }
 
 
-void BufferControl::exceptionHandler(const Firebird::Exception& ex, BcbThreadSync::ThreadRoutine*)
+static void load_hot_pages(thread_db* tdbb, Array<ULONG>& pages)
 {
-	FbLocalStatus status_vector;
-	ex.stuffException(&status_vector);
-	iscDbLogStatus(bcb_database->dbb_filename.c_str(), &status_vector);
-}
+/**************************************
+ *
+ *	l o a d _ h o t _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read the list of hot pages saved by the previous run of
+ *	the cache writer. B-tree, index root and pointer pages
+ *	go first, then the rest of pages. Each group is sorted
+ *	by page number to be read by large sequential requests.
+ *
+ **************************************/
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
 
+	const PathName fileName = dbb->dbb_filename + HOT_PAGES_SUFFIX;
+	Array<HotPage> hotPages;
 
-static void cacheBuffer(Attachment* att, BufferDesc* bdb)
-{
-	if (att)
+	{	// scope
+		EngineCheckout cout(tdbb, FB_FUNCTION);
+
+		FILE* const file = os_utils::fopen(fileName.c_str(), "rb");
+		if (!file)
+			return;
+
+		// List saved for another database or page size is ignored
+
+		HotPagesHeader header;
+
+		if (fread(&header, sizeof(header), 1, file) == 1 &&
+			header.hph_magic == HOT_PAGES_MAGIC &&
+			header.hph_version == HOT_PAGES_VERSION &&
+			header.hph_page_size == dbb->dbb_page_size &&
+			Guid(header.hph_guid) == dbb->dbb_guid)
+		{
+			// Don't read more pages than fit into the cache along with clean pages reserve
+
+			const ULONG count = MIN(header.hph_count, bcb->bcb_count - bcb->bcb_count / 4);
+			HotPage* const buffer = hotPages.getBuffer(count, false);
+			hotPages.shrink(fread(buffer, sizeof(HotPage), count, file));
+		}
+
+		fclose(file);
+	}
+
+	pages.ensureCapacity(hotPages.getCount());
+
+	for (int pass = 0; pass < 2; pass++)
 	{
-		if (!att->att_bdb_cache)
-			att->att_bdb_cache = FB_NEW_POOL(*att->att_pool) PageToBufferMap(*att->att_pool);
+		const FB_SIZE_T start = pages.getCount();
 
-		att->att_bdb_cache->put(bdb);
+		for (const auto& hotPage : hotPages)
+		{
+			const bool upper = hotPage.hp_type == pag_index || hotPage.hp_type == pag_root ||
+				hotPage.hp_type == pag_pointer;
+
+			if (upper == (pass == 0))
+				pages.add(hotPage.hp_page);
+		}
+
+		std::sort(pages.begin() + start, pages.end());
 	}
 }
 
 
-static void check_precedence(thread_db* tdbb, WIN* window, PageNumber page)
+static bool save_hot_pages(thread_db* tdbb)
 {
 /**************************************
  *
- *	c h e c k _ p r e c e d e n c e
+ *	s a v e _ h o t _ p a g e s
  *
  **************************************
  *
  * Functional description
- *	Given a window accessed for write and a page number,
- *	establish a precedence relationship such that the
- *	specified page will always be written before the page
- *	associated with the window.
- *
- *	If the "page number" is negative, it is really a transaction
- *	id.  In this case, the precedence relationship is to the
- *	database header page from which the transaction id was
- *	obtained.  If the header page has been written since the
- *	transaction id was assigned, no precedence relationship
- *	is required.
+ *	Save numbers and owners of the pages present in the cache,
+ *	most recently used first, to warm up the cache when the
+ *	database is opened next time. Return false if the list
+ *	can't be written.
  *
  **************************************/
-	SET_TDBB(tdbb);
-	Database* dbb = tdbb->getDatabase();
-	BufferControl* bcb = dbb->dbb_bcb;
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
 
-	// If this is really a transaction id, sort things out
+	Array<HotPage> hotPages;
+	hotPages.ensureCapacity(bcb->bcb_count);
 
-	switch(page.getPageSpaceID())
+	// Shared lock is enough to walk LRU ques. Recently used buffers which
+	// are not requeued yet keep their previous place in the list.
+
+	for (BufferNode* const node : bcb->bcb_nodes)
 	{
-		case DB_PAGE_SPACE:
-			break;
+		SyncLockGuard lruSync(&node->bcn_syncLRU, SYNC_SHARED, FB_FUNCTION);
 
-		case TRANS_PAGE_SPACE:
-			if (page.getPageNum() <= tdbb->getDatabase()->dbb_last_header_write)
-				return;
-			page = PageNumber(DB_PAGE_SPACE, 0);
-			break;
+		que* const lruQues[2] = {&node->bcn_in_use, &node->bcn_probation};
 
-		default:
-			fb_assert(false);
-			return;
-	}
+		for (que* const lruQue : lruQues)
+		{
+			for (QUE que_inst = lruQue->que_forward; que_inst != lruQue; que_inst = que_inst->que_forward)
+			{
+				const BufferDesc* const bdb = BLOCK(que_inst, BufferDesc, bdb_in_use);
 
-	// In the past negative value, passed here, meant not page, but transaction number.
-	// When we finally move to 32 (not 31) bit page numbers, this should be removed,
-	// but currently I add:
-	fb_assert(!(page.getPageNum() & 0x80000000));
-	// to help detect cases, when something possibly negative is passed.
-	// AP - 2011.
+				if (bdb->bdb_page.getPageSpaceID() != DB_PAGE_SPACE ||
+					(bdb->bdb_flags & (BDB_not_valid | BDB_read_pending)))
+				{
+					continue;
+				}
 
-	// Start by finding the buffer containing the high priority page
+				// Page image is not latched, its owner is just a hint
 
-#ifndef HASH_USE_CDS_LIST
-	Sync bcbSync(&bcb->bcb_syncObject, FB_FUNCTION);
-	bcbSync.lock(SYNC_SHARED);
-#endif
+				const pag* const page = bdb->bdb_buffer;
 
-	BufferDesc* high = bcb->bcb_hashTable->find(page);
-#ifndef HASH_USE_CDS_LIST
-	bcbSync.unlock();
+				HotPage& hotPage = hotPages.add();
+				hotPage.hp_page = bdb->bdb_page.getPageNum();
+				hotPage.hp_type = page->pag_type;
+				hotPage.hp_relation = 0;
+				hotPage.hp_index = 0;
+
+				switch (page->pag_type)
+				{
+				case pag_pointer:
+					hotPage.hp_relation = ((const pointer_page*) page)->ppg_relation;
+					break;
+
+				case pag_data:
+					hotPage.hp_relation = ((const data_page*) page)->dpg_relation;
+					break;
+
+				case pag_root:
+					hotPage.hp_relation = ((const index_root_page*) page)->irt_relation;
+					break;
+
+				case pag_index:
+					hotPage.hp_relation = ((const btree_page*) page)->btr_relation;
+					hotPage.hp_index = ((const btree_page*) page)->btr_id;
+					break;
+				}
+			}
+		}
+	}
+
+	HotPagesHeader header;
+	memset(&header, 0, sizeof(header));
+	header.hph_magic = HOT_PAGES_MAGIC;
+	header.hph_version = HOT_PAGES_VERSION;
+	header.hph_page_size = dbb->dbb_page_size;
+	header.hph_count = hotPages.getCount();
+	dbb->dbb_guid.copyTo(header.hph_guid);
+
+	// Write the list into temporary file and rename it then, thus
+	// a crash never leaves partially written list
+
+	const PathName fileName = dbb->dbb_filename + HOT_PAGES_SUFFIX;
+	const PathName tempName = fileName + ".tmp";
+
+	EngineCheckout cout(tdbb, FB_FUNCTION);
+
+	FILE* const file = os_utils::fopen(tempName.c_str(), "wb");
+
+	bool written = file &&
+		fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(hotPages.begin(), sizeof(HotPage), hotPages.getCount(), file) == hotPages.getCount();
+
+	if (file && fclose(file) != 0)
+		written = false;
+
+	if (written)
+	{
+#ifdef WIN_NT
+		remove(fileName.c_str());
+#endif
+		written = (rename(tempName.c_str(), fileName.c_str()) == 0);
+	}
+
+	if (!written)
+	{
+		gds__log("Database: %s\n\tCannot save list of hot pages to %s, errno %d",
+			dbb->dbb_filename.c_str(), fileName.c_str(), errno);
+
+		if (file)
+			remove(tempName.c_str());
+	}
+
+	return written;
+}
+
+
+void BufferControl::exceptionHandler(const Firebird::Exception& ex, BcbThreadSync::ThreadRoutine*)
+{
+	FbLocalStatus status_vector;
+	ex.stuffException(&status_vector);
+	iscDbLogStatus(bcb_database->dbb_filename.c_str(), &status_vector);
+}
+
+
+static void cacheBuffer(Attachment* att, BufferDesc* bdb)
+{
+	if (att)
+	{
+		if (!att->att_bdb_cache)
+			att->att_bdb_cache = FB_NEW_POOL(*att->att_pool) PageToBufferMap(*att->att_pool);
+
+		att->att_bdb_cache->put(bdb);
+	}
+}
+
+
+static void check_precedence(thread_db* tdbb, WIN* window, PageNumber page)
+{
+/**************************************
+ *
+ *	c h e c k _ p r e c e d e n c e
+ *
+ **************************************
+ *
+ * Functional description
+ *	Given a window accessed for write and a page number,
+ *	establish a precedence relationship such that the
+ *	specified page will always be written before the page
+ *	associated with the window.
+ *
+ *	If the "page number" is negative, it is really a transaction
+ *	id.  In this case, the precedence relationship is to the
+ *	database header page from which the transaction id was
+ *	obtained.  If the header page has been written since the
+ *	transaction id was assigned, no precedence relationship
+ *	is required.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	Database* dbb = tdbb->getDatabase();
+	BufferControl* bcb = dbb->dbb_bcb;
+
+	// If this is really a transaction id, sort things out
+
+	switch(page.getPageSpaceID())
+	{
+		case DB_PAGE_SPACE:
+			break;
+
+		case TRANS_PAGE_SPACE:
+			if (page.getPageNum() <= tdbb->getDatabase()->dbb_last_header_write)
+				return;
+			page = PageNumber(DB_PAGE_SPACE, 0);
+			break;
+
+		default:
+			fb_assert(false);
+			return;
+	}
+
+	// In the past negative value, passed here, meant not page, but transaction number.
+	// When we finally move to 32 (not 31) bit page numbers, this should be removed,
+	// but currently I add:
+	fb_assert(!(page.getPageNum() & 0x80000000));
+	// to help detect cases, when something possibly negative is passed.
+	// AP - 2011.
+
+	// Start by finding the buffer containing the high priority page
+
+#ifndef HASH_USE_CDS_LIST
+	Sync bcbSync(&bcb->bcb_syncObject, FB_FUNCTION);
+	bcbSync.lock(SYNC_SHARED);
+#endif
+
+	BufferDesc* high = bcb->bcb_hashTable->find(page);
+#ifndef HASH_USE_CDS_LIST
+	bcbSync.unlock();
 #endif
 
 	if (!high)
@@ -3419,194 +3870,530 @@ static void down_grade(thread_db* tdbb, BufferDesc* bdb, int high)
 			return; // true
 		}
 
-		if (!oldBlocking)
-			bdb->bdb_ast_flags &= ~BDB_blocking;
+		if (!oldBlocking)
+			bdb->bdb_ast_flags &= ~BDB_blocking;
+
+		justWrite = true;
+	}
+
+	// If the page isn't dirty, the lock can be quietly downgraded.
+
+	if (!(bdb->bdb_flags & BDB_dirty))
+	{
+		bdb->bdb_ast_flags &= ~BDB_blocking;
+		LCK_downgrade(tdbb, lock);
+		bdb->release(tdbb, false);
+		return; // true;
+	}
+
+	bool in_use = false, invalid = false;
+
+	if (bdb->bdb_flags & BDB_not_valid)
+		invalid = true;
+
+	// If there are higher precedence guys, see if they can be written.
+
+	while (QUE_NOT_EMPTY(bdb->bdb_higher))
+	{ // syncPrec scope
+		Sync syncPrec(&bcb->bcb_syncPrecedence, "down_grade");
+		syncPrec.lock(SYNC_EXCLUSIVE);
+
+		bool found = false;
+		for (QUE que_inst = bdb->bdb_higher.que_forward; que_inst != &bdb->bdb_higher;
+			 que_inst = que_inst->que_forward)
+		{
+			Precedence* precedence = BLOCK(que_inst, Precedence, pre_higher);
+			if (precedence->pre_flags & PRE_cleared)
+				continue;
+
+			if (invalid)
+			{
+				precedence->pre_flags |= PRE_cleared;
+				continue;
+			}
+
+			BufferDesc* blocking_bdb = precedence->pre_hi;
+			if (blocking_bdb->bdb_flags & BDB_dirty)
+			{
+				found = true;
+				syncPrec.unlock();
+				down_grade(tdbb, blocking_bdb, high + 1);
+
+				if ((blocking_bdb->bdb_flags & BDB_dirty) && !(precedence->pre_flags & PRE_cleared))
+					in_use = true;
+
+				if (blocking_bdb->bdb_flags & BDB_not_valid)
+				{
+					invalid = true;
+					in_use = false;
+					que_inst = bdb->bdb_higher.que_forward;
+				}
+
+				break;
+			}
+		}
+
+		// If any higher precedence buffer can't be written, mark this buffer as blocking and exit.
+
+		if (in_use)
+		{
+			if (justWrite)
+				bdb->unLockIO(tdbb);
+			else
+				bdb->release(tdbb, false);
+
+			return; // false;
+		}
+
+		if (!found)
+			break;
+	} // syncPrec scope
+
+	// Everything is clear to write this buffer.  Do so and reduce the lock
+
+	if (!justWrite)
+		bdb->lockIO(tdbb);
+
+	const bool written = !(bdb->bdb_flags & BDB_dirty) ||
+		write_page(tdbb, bdb, tdbb->tdbb_status_vector, true);
+
+	if (!justWrite)
+		bdb->unLockIO(tdbb);
+
+	if (invalid || !written)
+	{
+		bdb->bdb_flags |= BDB_not_valid;
+		clear_dirty_flag_and_nbak_state(tdbb, bdb);
+		bdb->bdb_ast_flags &= ~BDB_blocking;
+		TRA_invalidate(tdbb, bdb->bdb_transactions);
+		bdb->bdb_transactions = 0;
+		PAGE_LOCK_RELEASE(tdbb, bcb, bdb->bdb_lock);
+	}
+	else if (!justWrite)
+	{
+		bdb->bdb_ast_flags &= ~BDB_blocking;
+		LCK_downgrade(tdbb, lock);
+	}
+
+	// Clear precedence relationships to lower precedence buffers.  Since it
+	// isn't safe to tweak the que pointers from AST level, just mark the precedence
+	// links as cleared.  Somebody else will clean up the precedence blocks.
+
+	while (QUE_NOT_EMPTY(bdb->bdb_lower))
+	{ // syncPrec scope
+		Sync syncPrec(&bcb->bcb_syncPrecedence, "down_grade");
+		syncPrec.lock(SYNC_EXCLUSIVE);
+
+		bool found = false;
+		for (QUE que_inst = bdb->bdb_lower.que_forward; que_inst != &bdb->bdb_lower;
+			 que_inst = que_inst->que_forward)
+		{
+			Precedence* precedence = BLOCK(que_inst, Precedence, pre_lower);
+			if (precedence->pre_flags & PRE_cleared)
+				continue;
+
+			BufferDesc* blocking_bdb = precedence->pre_low;
+			if (bdb->bdb_flags & BDB_not_valid) {
+				blocking_bdb->bdb_flags |= BDB_not_valid;
+			}
+
+			precedence->pre_flags |= PRE_cleared;
+			if ((blocking_bdb->bdb_flags & BDB_not_valid) || (blocking_bdb->bdb_ast_flags & BDB_blocking))
+			{
+				found = true;
+				syncPrec.unlock();
+				down_grade(tdbb, blocking_bdb);
+				break;
+			}
+		}
+
+		if (!found)
+			break;
+	} // syncPrec scope
+
+	bdb->bdb_flags &= ~BDB_not_valid;
+
+	if (justWrite)
+		bdb->unLockIO(tdbb);
+	else
+		bdb->release(tdbb, false);
+
+	return; // true;
+}
+
+
+static bool expand_buffers(thread_db* tdbb, ULONG number)
+{
+/**************************************
+ *
+ *	e x p a n d _ b u f f e r s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Expand the cache to at least a given number of buffers.
+ *	If it's already that big, don't do anything.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
+
+	if (number <= bcb->bcb_count || number > MAX_PAGE_BUFFERS)
+		return false;
+
+	MutexLockGuard resizeGuard(bcb->bcb_resizeMutex, FB_FUNCTION);
+	SyncLockGuard syncBcb(&bcb->bcb_syncObject, SYNC_EXCLUSIVE, FB_FUNCTION);
+
+	if (number <= bcb->bcb_count)
+		return false;
+
+	// Expand hash table only if there is no concurrent attachments
+	if ((tdbb->getAttachment()->att_flags & ATT_exclusive) || !(bcb->bcb_flags & BCB_exclusive))
+		bcb->bcb_hashTable->resize(number);
+
+	// Buffers retired by shrink_buffers() are reused before new memory is allocated
+
+	while (bcb->bcb_count < number && QUE_NOT_EMPTY(bcb->bcb_retired))
+	{
+		QUE que_inst = bcb->bcb_retired.que_forward;
+		QUE_DELETE(*que_inst);
+
+		BufferDesc* const bdb = BLOCK(que_inst, BufferDesc, bdb_que);
+		BufferNode* const node = bdb->bdb_node;
+
+		SyncLockGuard syncEmpty(&node->bcn_syncEmpty, SYNC_EXCLUSIVE, FB_FUNCTION);
+		QUE_INSERT(node->bcn_empty, bdb->bdb_que);
+		node->bcn_count++;
+
+		bcb->bcb_retired_count--;
+		bcb->bcb_count++;
+	}
+
+	if (number > bcb->bcb_count)
+		bcb->bcb_count += allocate_buffers(tdbb, bcb, number - bcb->bcb_count);
+
+	set_cache_limits(tdbb, bcb);
+
+	return true;
+}
+
+
+static void init_nodes(thread_db* tdbb, BufferControl* bcb)
+{
+/**************************************
+ *
+ *	i n i t _ n o d e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Create page cache nodes and assign every CPU to one of them.
+ *	By default there is single node. If the number of nodes is
+ *	the same as the number of NUMA nodes in the system, CPUs are
+ *	assigned to their own NUMA nodes and buffers memory is bound
+ *	to them. Otherwise nodes are simulated and CPUs are spread
+ *	evenly over them.
+ *
+ **************************************/
+	Database* const dbb = tdbb->getDatabase();
+	MemoryPool& pool = *bcb->bcb_bufferpool;
+
+	SortedArray<int> numaNodes;
+	HalfStaticArray<int, 64> cpuNumaNodes;
+
+	const unsigned cpuCount = os_utils::getCpuCount();
+
+	for (unsigned cpu = 0; cpu < cpuCount; cpu++)
+	{
+		const int numaNode = os_utils::getCpuNumaNode(cpu);
+		cpuNumaNodes.add(numaNode);
+
+		if (numaNode >= 0 && !numaNodes.exist(numaNode))
+			numaNodes.add(numaNode);
+	}
+
+	ULONG count = dbb->dbb_config->getPageCacheNumaNodes();
+
+	if (!count)
+		count = MAX(numaNodes.getCount(), 1);
+
+	const bool simulated = (count != numaNodes.getCount());
+
+	for (ULONG n = 0; n < count; n++)
+	{
+		const int numaNode = (simulated || count == 1) ? -1 : numaNodes[n];
+		bcb->bcb_nodes.add(FB_NEW_POOL(pool) BufferNode(n, numaNode));
+	}
+
+	for (unsigned cpu = 0; cpu < cpuCount; cpu++)
+	{
+		FB_SIZE_T pos;
+
+		if (!simulated && numaNodes.find(cpuNumaNodes[cpu], pos))
+			bcb->bcb_cpu_nodes.add((UCHAR) pos);
+		else
+			bcb->bcb_cpu_nodes.add((UCHAR) (cpu % count));
+	}
+}
+
+
+static ULONG allocate_buffers(thread_db* tdbb, BufferControl* bcb, ULONG number)
+{
+/**************************************
+ *
+ *	a l l o c a t e _ b u f f e r s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Allocate given number of buffers spreading them evenly
+ *	over the page cache nodes. Return number of buffers
+ *	allocated.
+ *
+ **************************************/
+	const ULONG count = bcb->bcb_nodes.getCount();
+	ULONG allocated = 0;
+
+	for (auto node : bcb->bcb_nodes)
+	{
+		const ULONG share = number / count + (node->bcn_number < number % count ? 1 : 0);
+
+		if (share)
+			allocated += memory_init(tdbb, bcb, node, share);
+	}
+
+	return allocated;
+}
+
+
+static void set_cache_limits(thread_db* tdbb, BufferControl* bcb)
+{
+/**************************************
+ *
+ *	s e t _ c a c h e _ l i m i t s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Adjust thresholds which depend on the cache size
+ *	after it was allocated or resized.
+ *
+ **************************************/
+	Database* const dbb = tdbb->getDatabase();
+
+	bcb->bcb_free_minimum = (SSHORT) MIN(bcb->bcb_count / 4, 128);	// 25% clean page reserve
+
+	if (bcb->bcb_probation_limit)
+	{
+		bcb->bcb_probation_limit = MAX(bcb->bcb_count / 4, 1);
+
+		for (auto node : bcb->bcb_nodes)
+			node->bcn_probation_limit = node->bcn_count / 4;
+	}
+
+	bcb->bcb_dirty_target = (SLONG) ((FB_UINT64) bcb->bcb_count *
+		dbb->dbb_config->getDirtyPageTarget() / 100);
+}
+
+
+static bool shrink_buffers(thread_db* tdbb, ULONG number)
+{
+/**************************************
+ *
+ *	s h r i n k _ b u f f e r s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Shrink the cache to the given number of buffers. Empty
+ *	buffers are retired first, then the least recently used
+ *	clean ones. Dirty buffers are written before retirement.
+ *	Buffers in use are never waited for, thus the cache may
+ *	stay somewhat bigger than requested.
+ *
+ **************************************/
+	SET_TDBB(tdbb);
+	Database* const dbb = tdbb->getDatabase();
+	BufferControl* const bcb = dbb->dbb_bcb;
+
+	if (number >= bcb->bcb_count || number < MIN_PAGE_BUFFERS)
+		return false;
+
+	MutexLockGuard resizeGuard(bcb->bcb_resizeMutex, FB_FUNCTION);
+
+	if (number >= bcb->bcb_count)
+		return false;
+
+	const ULONG target = bcb->bcb_count - number;
+	ULONG retired = 0;
+
+	for (auto node : bcb->bcb_nodes)
+	{
+		SyncLockGuard syncEmpty(&node->bcn_syncEmpty, SYNC_EXCLUSIVE, FB_FUNCTION);
+
+		while (retired < target && QUE_NOT_EMPTY(node->bcn_empty))
+		{
+			QUE que_inst = node->bcn_empty.que_forward;
+			QUE_DELETE(*que_inst);
+
+			retire_buffer(bcb, BLOCK(que_inst, BufferDesc, bdb_que));
+			node->bcn_count--;
+			bcb->bcb_count--;
+			retired++;
+		}
+	}
+
+	// Evict clean buffers in small portions to not hold LRU latch for long,
+	// write dirty pages when there are no more clean ones to evict. Every
+	// node gives away its share of buffers.
+
+	const ULONG nodeCount = bcb->bcb_nodes.getCount();
+
+	while (retired < target)
+	{
+		const ULONG share = (target - retired + nodeCount - 1) / nodeCount;
+		ULONG evicted = 0;
+
+		for (auto node : bcb->bcb_nodes)
+		{
+			if (retired + evicted < target)
+				evicted += evict_buffers(tdbb, node, MIN(share, target - retired - evicted));
+		}
+
+		retired += evicted;
 
-		justWrite = true;
+		if (!evicted && !flushOldest(tdbb, 0))
+			break;
 	}
 
-	// If the page isn't dirty, the lock can be quietly downgraded.
+	set_cache_limits(tdbb, bcb);
 
-	if (!(bdb->bdb_flags & BDB_dirty))
-	{
-		bdb->bdb_ast_flags &= ~BDB_blocking;
-		LCK_downgrade(tdbb, lock);
-		bdb->release(tdbb, false);
-		return; // true;
-	}
+	return retired != 0;
+}
 
-	bool in_use = false, invalid = false;
 
-	if (bdb->bdb_flags & BDB_not_valid)
-		invalid = true;
+static ULONG evict_buffers(thread_db* tdbb, BufferNode* node, ULONG number)
+{
+/**************************************
+ *
+ *	e v i c t _ b u f f e r s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Remove up to the given number of clean and unused buffers
+ *	of the node from the cache, starting from the least recently
+ *	used. Return number of buffers evicted.
+ *
+ **************************************/
+	BufferControl* const bcb = tdbb->getDatabase()->dbb_bcb;
+	HalfStaticArray<BufferDesc*, WRITER_BATCH_PAGES> victims;
 
-	// If there are higher precedence guys, see if they can be written.
+	{	// lruSync scope
+		SyncLockGuard lruSync(&node->bcn_syncLRU, SYNC_EXCLUSIVE, FB_FUNCTION);
+		requeueRecentlyUsed(node);
 
-	while (QUE_NOT_EMPTY(bdb->bdb_higher))
-	{ // syncPrec scope
-		Sync syncPrec(&bcb->bcb_syncPrecedence, "down_grade");
-		syncPrec.lock(SYNC_EXCLUSIVE);
+		que* lruQues[2];
+		orderLRU(node, lruQues);
 
-		bool found = false;
-		for (QUE que_inst = bdb->bdb_higher.que_forward; que_inst != &bdb->bdb_higher;
-			 que_inst = que_inst->que_forward)
+		for (que* const lruQue : lruQues)
 		{
-			Precedence* precedence = BLOCK(que_inst, Precedence, pre_higher);
-			if (precedence->pre_flags & PRE_cleared)
-				continue;
-
-			if (invalid)
+			QUE que_inst = lruQue->que_backward, prev;
+			for (; que_inst != lruQue && victims.getCount() < MIN(number, WRITER_BATCH_PAGES);
+				que_inst = prev)
 			{
-				precedence->pre_flags |= PRE_cleared;
-				continue;
-			}
+				prev = que_inst->que_backward;
+				BufferDesc* const bdb = BLOCK(que_inst, BufferDesc, bdb_in_use);
 
-			BufferDesc* blocking_bdb = precedence->pre_hi;
-			if (blocking_bdb->bdb_flags & BDB_dirty)
-			{
-				found = true;
-				syncPrec.unlock();
-				down_grade(tdbb, blocking_bdb, high + 1);
+				if (bdb->bdb_use_count ||
+					(bdb->bdb_flags & (BDB_dirty | BDB_db_dirty | BDB_free_pending | BDB_lru_chained)) ||
+					QUE_NOT_EMPTY(bdb->bdb_higher) || QUE_NOT_EMPTY(bdb->bdb_lower))
+				{
+					continue;
+				}
 
-				if ((blocking_bdb->bdb_flags & BDB_dirty) && !(precedence->pre_flags & PRE_cleared))
-					in_use = true;
+				if (!bdb->addRefConditional(tdbb, SYNC_EXCLUSIVE))
+					continue;
 
-				if (blocking_bdb->bdb_flags & BDB_not_valid)
+				// page could be marked between the check above and the latch
+				if (bdb->bdb_flags & (BDB_dirty | BDB_db_dirty))
 				{
-					invalid = true;
-					in_use = false;
-					que_inst = bdb->bdb_higher.que_forward;
+					bdb->release(tdbb, true);
+					continue;
 				}
 
-				break;
+				removeLRU(bdb);
+				victims.add(bdb);
 			}
 		}
+	}
 
-		// If any higher precedence buffer can't be written, mark this buffer as blocking and exit.
-
-		if (in_use)
+	for (BufferDesc* const bdb : victims)
+	{
+#ifndef HASH_USE_CDS_LIST
 		{
-			if (justWrite)
-				bdb->unLockIO(tdbb);
-			else
-				bdb->release(tdbb, false);
-
-			return; // false;
+			SyncLockGuard bcbSync(&bcb->bcb_syncObject, SYNC_EXCLUSIVE, FB_FUNCTION);
+			bcb->bcb_hashTable->remove(bdb);
 		}
+#else
+		bcb->bcb_hashTable->remove(bdb);
+#endif
 
-		if (!found)
-			break;
-	} // syncPrec scope
-
-	// Everything is clear to write this buffer.  Do so and reduce the lock
-
-	if (!justWrite)
-		bdb->lockIO(tdbb);
-
-	const bool written = !(bdb->bdb_flags & BDB_dirty) ||
-		write_page(tdbb, bdb, tdbb->tdbb_status_vector, true);
-
-	if (!justWrite)
-		bdb->unLockIO(tdbb);
-
-	if (invalid || !written)
-	{
-		bdb->bdb_flags |= BDB_not_valid;
-		clear_dirty_flag_and_nbak_state(tdbb, bdb);
-		bdb->bdb_ast_flags &= ~BDB_blocking;
-		TRA_invalidate(tdbb, bdb->bdb_transactions);
-		bdb->bdb_transactions = 0;
 		PAGE_LOCK_RELEASE(tdbb, bcb, bdb->bdb_lock);
-	}
-	else if (!justWrite)
-	{
-		bdb->bdb_ast_flags &= ~BDB_blocking;
-		LCK_downgrade(tdbb, lock);
-	}
 
-	// Clear precedence relationships to lower precedence buffers.  Since it
-	// isn't safe to tweak the que pointers from AST level, just mark the precedence
-	// links as cleared.  Somebody else will clean up the precedence blocks.
+		// Somebody who found the buffer before it was removed from the hash
+		// table will see another page number after the latch is released
 
-	while (QUE_NOT_EMPTY(bdb->bdb_lower))
-	{ // syncPrec scope
-		Sync syncPrec(&bcb->bcb_syncPrecedence, "down_grade");
-		syncPrec.lock(SYNC_EXCLUSIVE);
+		bdb->bdb_page = PageNumber(INVALID_PAGE_SPACE, 0);
+		bdb->bdb_flags = 0;
+		bdb->bdb_scan_count = 0;
 
-		bool found = false;
-		for (QUE que_inst = bdb->bdb_lower.que_forward; que_inst != &bdb->bdb_lower;
-			 que_inst = que_inst->que_forward)
 		{
-			Precedence* precedence = BLOCK(que_inst, Precedence, pre_lower);
-			if (precedence->pre_flags & PRE_cleared)
-				continue;
-
-			BufferDesc* blocking_bdb = precedence->pre_low;
-			if (bdb->bdb_flags & BDB_not_valid) {
-				blocking_bdb->bdb_flags |= BDB_not_valid;
-			}
+			SyncLockGuard syncEmpty(&node->bcn_syncEmpty, SYNC_EXCLUSIVE, FB_FUNCTION);
 
-			precedence->pre_flags |= PRE_cleared;
-			if ((blocking_bdb->bdb_flags & BDB_not_valid) || (blocking_bdb->bdb_ast_flags & BDB_blocking))
-			{
-				found = true;
-				syncPrec.unlock();
-				down_grade(tdbb, blocking_bdb);
-				break;
-			}
+			retire_buffer(bcb, bdb);
+			node->bcn_inuse--;
+			node->bcn_count--;
+			bcb->bcb_count--;
 		}
 
-		if (!found)
-			break;
-	} // syncPrec scope
-
-	bdb->bdb_flags &= ~BDB_not_valid;
-
-	if (justWrite)
-		bdb->unLockIO(tdbb);
-	else
 		bdb->release(tdbb, false);
+	}
 
-	return; // true;
+	return victims.getCount();
 }
 
 
-static bool expand_buffers(thread_db* tdbb, ULONG number)
+static void retire_buffer(BufferControl* bcb, BufferDesc* bdb)
 {
 /**************************************
  *
- *	e x p a n d _ b u f f e r s
+ *	r e t i r e _ b u f f e r
  *
  **************************************
  *
  * Functional description
- *	Expand the cache to at least a given number of buffers.
- *	If it's already that big, don't do anything.
+ *	Put unused buffer aside until the cache is expanded again
+ *	and let the system reclaim memory of its page image.
+ *	bcb_resizeMutex must be locked.
  *
  **************************************/
-	SET_TDBB(tdbb);
-	Database* const dbb = tdbb->getDatabase();
-	BufferControl* const bcb = dbb->dbb_bcb;
-
-	if (number <= bcb->bcb_count || number > MAX_PAGE_BUFFERS)
-		return false;
-
-	SyncLockGuard syncBcb(&bcb->bcb_syncObject, SYNC_EXCLUSIVE, FB_FUNCTION);
 
-	if (number <= bcb->bcb_count)
-		return false;
+	QUE_INSERT(bcb->bcb_retired, bdb->bdb_que);
+	bcb->bcb_retired_count++;
 
-	// Expand hash table only if there is no concurrent attachments
-	if ((tdbb->getAttachment()->att_flags & ATT_exclusive) || !(bcb->bcb_flags & BCB_exclusive))
-		bcb->bcb_hashTable->resize(number);
+	// Memory mapped from huge pages can't be released partially
 
-	SyncLockGuard syncEmpty(&bcb->bcb_syncEmpty, SYNC_EXCLUSIVE, FB_FUNCTION);
-	ULONG allocated = memory_init(tdbb, bcb, number - bcb->bcb_count);
+	const UCHAR* const buffer = (UCHAR*) bdb->bdb_buffer;
 
-	bcb->bcb_count += allocated;
-	bcb->bcb_free_minimum = (SSHORT) MIN(bcb->bcb_count / 4, 128);	// 25% clean page reserve
+	for (const auto& blk : bcb->bcb_huge_memory)
+	{
+		if (buffer >= blk.m_memory && buffer < blk.m_memory + blk.m_size)
+			return;
+	}
 
-	return true;
+	os_utils::discardMemory(bdb->bdb_buffer, bcb->bcb_page_size);
 }
 
 
@@ -3618,111 +4405,135 @@ static BufferDesc* get_dirty_buffer(thread_db* tdbb)
 	SET_TDBB(tdbb);
 	Database* dbb = tdbb->getDatabase();
 	BufferControl* bcb = dbb->dbb_bcb;
-	int walk = bcb->bcb_free_minimum;
-	int chained = walk;
+	const ULONG nodeCount = bcb->bcb_nodes.getCount();
+	bool requeued = false;
 
-	Sync lruSync(&bcb->bcb_syncLRU, FB_FUNCTION);
-	lruSync.lock(SYNC_SHARED);
+	// Every node keeps its share of free buffers
 
-	for (QUE que_inst = bcb->bcb_in_use.que_backward;
-		 que_inst != &bcb->bcb_in_use; que_inst = que_inst->que_backward)
+	for (BufferNode* const node : bcb->bcb_nodes)
 	{
-		BufferDesc* bdb = BLOCK(que_inst, BufferDesc, bdb_in_use);
+		int walk = (bcb->bcb_free_minimum + nodeCount - 1) / nodeCount;
+		int chained = walk;
 
-		if (bdb->bdb_flags & BDB_lru_chained)
+		Sync lruSync(&node->bcn_syncLRU, FB_FUNCTION);
+		lruSync.lock(SYNC_SHARED);
+
+		que* lruQues[2];
+		orderLRU(node, lruQues);
+
+		for (que* const lruQue : lruQues)
 		{
-			if (!--chained)
+			for (QUE que_inst = lruQue->que_backward;
+				 que_inst != lruQue; que_inst = que_inst->que_backward)
+			{
+				BufferDesc* bdb = BLOCK(que_inst, BufferDesc, bdb_in_use);
+
+				if (bdb->bdb_flags & BDB_lru_chained)
+				{
+					if (!--chained)
+						break;
+					continue;
+				}
+
+				if (bdb->bdb_use_count || (bdb->bdb_flags & BDB_free_pending))
+					continue;
+
+				if (bdb->bdb_flags & BDB_db_dirty)
+				{
+					//tdbb->bumpStats(PageStatType::FETCHES); shouldn't it be here?
+					return bdb;
+				}
+
+				if (!--walk)
+					break;
+			}
+
+			if (!chained || !walk)
 				break;
-			continue;
 		}
 
-		if (bdb->bdb_use_count || (bdb->bdb_flags & BDB_free_pending))
-			continue;
-
-		if (bdb->bdb_flags & BDB_db_dirty)
+		if (!chained)
 		{
-			//tdbb->bumpStats(PageStatType::FETCHES); shouldn't it be here?
-			return bdb;
+			lruSync.unlock();
+			lruSync.lock(SYNC_EXCLUSIVE);
+			requeueRecentlyUsed(node);
+			requeued = true;
 		}
-
-		if (!--walk)
-			break;
 	}
 
-	if (!chained)
-	{
-		lruSync.unlock();
-		lruSync.lock(SYNC_EXCLUSIVE);
-		requeueRecentlyUsed(bcb);
-	}
-	else
+	if (!requeued)
 		bcb->bcb_flags &= ~BCB_free_pending;
 
 	return NULL;
 }
 
 
-static BufferDesc* get_oldest_buffer(thread_db* tdbb, BufferControl* bcb)
+static BufferDesc* get_oldest_buffer(thread_db* tdbb, BufferNode* node)
 {
 /**************************************
  * Function description:
- *       Get candidate for preemption
+ *       Get candidate for preemption from the given node
  *       Found page buffer must have SYNC_EXCLUSIVE lock.
  **************************************/
 
-	int walk = bcb->bcb_free_minimum;
+	BufferControl* const bcb = tdbb->getDatabase()->dbb_bcb;
+	const ULONG nodeCount = bcb->bcb_nodes.getCount();
+	int walk = (bcb->bcb_free_minimum + nodeCount - 1) / nodeCount;
 	BufferDesc* bdb = nullptr;
 
-	Sync lruSync(&bcb->bcb_syncLRU, FB_FUNCTION);
-	if (bcb->bcb_lru_chain.load() != NULL)
+	Sync lruSync(&node->bcn_syncLRU, FB_FUNCTION);
+	if (node->bcn_lru_chain.load() != NULL)
 	{
 		lruSync.lock(SYNC_EXCLUSIVE);
-		requeueRecentlyUsed(bcb);
+		requeueRecentlyUsed(node);
 		lruSync.downgrade(SYNC_SHARED);
 	}
 	else
 		lruSync.lock(SYNC_SHARED);
 
-	for (QUE que_inst = bcb->bcb_in_use.que_backward;
-		 que_inst != &bcb->bcb_in_use;
-		 que_inst = que_inst->que_backward)
-	{
-		bdb = nullptr;
+	que* lruQues[2];
+	orderLRU(node, lruQues);
 
-		// get the oldest buffer as the least recently used -- note
-		// that since there are no empty buffers this queue cannot be empty
+	for (que* const lruQue : lruQues)
+	{
+		for (QUE que_inst = lruQue->que_backward;
+			 que_inst != lruQue;
+			 que_inst = que_inst->que_backward)
+		{
+			bdb = nullptr;
 
-		if (bcb->bcb_in_use.que_forward == &bcb->bcb_in_use)
-			BUGCHECK(213);	// msg 213 insufficient cache size
+			BufferDesc* oldest = BLOCK(que_inst, BufferDesc, bdb_in_use);
 
-		BufferDesc* oldest = BLOCK(que_inst, BufferDesc, bdb_in_use);
+			if (oldest->bdb_flags & BDB_lru_chained)
+				continue;
 
-		if (oldest->bdb_flags & BDB_lru_chained)
-			continue;
+			if (oldest->bdb_use_count || !oldest->addRefConditional(tdbb, SYNC_EXCLUSIVE))
+				continue;
 
-		if (oldest->bdb_use_count || !oldest->addRefConditional(tdbb, SYNC_EXCLUSIVE))
-			continue;
+			/*if (!writeable(oldest))
+			{
+				oldest->release(tdbb, true);
+				continue;
+			}*/
 
-		/*if (!writeable(oldest))
-		{
-			oldest->release(tdbb, true);
-			continue;
-		}*/
+			bdb = oldest;
+			if (!(bdb->bdb_flags & (BDB_dirty | BDB_db_dirty)) || !walk)
+				break;
 
-		bdb = oldest;
-		if (!(bdb->bdb_flags & (BDB_dirty | BDB_db_dirty)) || !walk)
-			break;
+			if (!(bcb->bcb_flags & BCB_cache_writer))
+				break;
 
-		if (!(bcb->bcb_flags & BCB_cache_writer))
-			break;
+			bcb->bcb_flags |= BCB_free_pending;
+			if (!(bcb->bcb_flags & BCB_writer_active))
+				bcb->bcb_writer_sem.release();
 
-		bcb->bcb_flags |= BCB_free_pending;
-		if (!(bcb->bcb_flags & BCB_writer_active))
-			bcb->bcb_writer_sem.release();
+			bdb->release(tdbb, true);
+			bdb = nullptr;
+			--walk;
+		}
 
-		bdb->release(tdbb, true);
-		bdb = nullptr;
-		--walk;
+		if (bdb)
+			break;
 	}
 
 	lruSync.unlock();
@@ -3773,7 +4584,8 @@ static BufferDesc* get_oldest_buffer(thread_db* tdbb, BufferControl* bcb)
 }
 
 
-static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType syncType, int wait)
+static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType syncType, int wait,
+	bool useOnce)
 {
 /**************************************
  *
@@ -3794,6 +4606,8 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
  *			0 => If the lock can't be acquired immediately,
  *				give up and return 0;
  *			<negative number> => Latch timeout interval in seconds.
+ *	useOnce:	page is not expected to be referenced again soon,
+ *				don't count this reference by replacement policy.
  *
  * return
  *	BufferDesc pointer if successful.
@@ -3816,7 +4630,9 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 			{
 				if (bdb->bdb_page == page)
 				{
-					recentlyUsed(bdb);
+					if (!useOnce)
+						recentlyUsed(bdb);
+					countHit(bcb, bdb);
 					tdbb->bumpStats(PageStatType::FETCHES, pageSpaceId);
 					return bdb;
 				}
@@ -3859,7 +4675,9 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 				// ensure the found page buffer is still for the same page after latch
 				if (bdb->bdb_page == page)
 				{
-					recentlyUsed(bdb);
+					if (!useOnce)
+						recentlyUsed(bdb);
+					countHit(bcb, bdb);
 					tdbb->bumpStats(PageStatType::FETCHES, pageSpaceId);
 					cacheBuffer(att, bdb);
 					return bdb;
@@ -3871,19 +4689,30 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 				continue;
 			}
 
-			// try empty list
-			if (QUE_NOT_EMPTY(bcb->bcb_empty))
+			// Try empty lists and then LRU ques, local node first. Buffers of
+			// other nodes are used only when the local node has nothing to offer.
+
+			const ULONG nodeCount = bcb->bcb_nodes.getCount();
+			BufferNode* const current = currentNode(bcb);
+			const ULONG first = current->bcn_number;
+
+			for (ULONG n = 0; n < nodeCount && !bdb; n++)
 			{
-				SyncLockGuard bcbSync(&bcb->bcb_syncEmpty, SYNC_EXCLUSIVE, FB_FUNCTION);
-				if (QUE_NOT_EMPTY(bcb->bcb_empty))
+				BufferNode* const node = bcb->bcb_nodes[(first + n) % nodeCount];
+
+				if (QUE_NOT_EMPTY(node->bcn_empty))
 				{
-					QUE que_inst = bcb->bcb_empty.que_forward;
-					QUE_DELETE(*que_inst);
-					QUE_INIT(*que_inst);
-					bdb = BLOCK(que_inst, BufferDesc, bdb_que);
+					SyncLockGuard emptySync(&node->bcn_syncEmpty, SYNC_EXCLUSIVE, FB_FUNCTION);
+					if (QUE_NOT_EMPTY(node->bcn_empty))
+					{
+						QUE que_inst = node->bcn_empty.que_forward;
+						QUE_DELETE(*que_inst);
+						QUE_INIT(*que_inst);
+						bdb = BLOCK(que_inst, BufferDesc, bdb_que);
 
-					bcb->bcb_inuse++;
-					is_empty = true;
+						node->bcn_inuse++;
+						is_empty = true;
+					}
 				}
 			}
 
@@ -3891,7 +4720,24 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 				bdb->addRef(tdbb, SYNC_EXCLUSIVE);
 			else
 			{
-				bdb = get_oldest_buffer(tdbb, bcb);
+				bool lruEmpty = true;
+
+				for (ULONG n = 0; n < nodeCount && !bdb; n++)
+				{
+					BufferNode* const node = bcb->bcb_nodes[(first + n) % nodeCount];
+
+					if (QUE_EMPTY(node->bcn_in_use) && QUE_EMPTY(node->bcn_probation))
+						continue;
+
+					lruEmpty = false;
+					bdb = get_oldest_buffer(tdbb, node);
+				}
+
+				// note that since there are no empty buffers LRU ques cannot be empty
+
+				if (lruEmpty)
+					BUGCHECK(213);	// msg 213 insufficient cache size
+
 				if (!bdb)
 				{
 					Thread::yield();
@@ -3899,7 +4745,8 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 				else if (bdb->bdb_page == page)
 				{
 					bdb->downgrade(syncType);
-					recentlyUsed(bdb);
+					if (!useOnce)
+						recentlyUsed(bdb);
 					tdbb->bumpStats(PageStatType::FETCHES, pageSpaceId);
 					cacheBuffer(att, bdb);
 					return bdb;
@@ -3923,7 +4770,8 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 				if (!bdb2)
 				{
 					bdb->bdb_page = page;
-					bdb->bdb_flags &= BDB_lru_chained; // yes, clear all except BDB_lru_chained
+					// yes, clear all except LRU state
+					bdb->bdb_flags &= (BDB_lru_chained | BDB_lru_new | BDB_probation);
 					bdb->bdb_flags |= BDB_read_pending;
 					bdb->bdb_scan_count = 0;
 					if (bdb->bdb_lock)
@@ -3933,17 +4781,30 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 					bcbSync.unlock();
 #endif
 
+					// With 2Q policy new page is put into probation que and
+					// moves into main LRU que when referenced once again
+
 					if (!(bdb->bdb_flags & BDB_lru_chained))
 					{
-						Sync syncLRU(&bcb->bcb_syncLRU, FB_FUNCTION);
+						const bool probation = (bcb->bcb_probation_limit != 0);
+
+						Sync syncLRU(&bdb->bdb_node->bcn_syncLRU, FB_FUNCTION);
 						if (syncLRU.lockConditional(SYNC_EXCLUSIVE))
 						{
-							QUE_DELETE(bdb->bdb_in_use);
-							QUE_INSERT(bcb->bcb_in_use, bdb->bdb_in_use);
+							removeLRU(bdb);
+							insertLRU(bdb, probation);
 						}
 						else
+						{
+							if (probation)
+								bdb->bdb_flags |= BDB_lru_new;
 							recentlyUsed(bdb);
+						}
 					}
+
+					if (bcb->bcb_nodes.getCount() > 1)
+						currentNode(bcb)->bcn_misses++;
+
 					tdbb->bumpStats(PageStatType::FETCHES, pageSpaceId);
 					cacheBuffer(att, bdb);
 					return bdb;
@@ -3961,7 +4822,8 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 					bdb2->release(tdbb, true);
 					continue;
 				}
-				recentlyUsed(bdb2);
+				if (!useOnce)
+					recentlyUsed(bdb2);
 				tdbb->bumpStats(PageStatType::FETCHES, pageSpaceId);
 				cacheBuffer(att, bdb2);
 			}
@@ -3971,9 +4833,11 @@ static BufferDesc* get_buffer(thread_db* tdbb, const PageNumber page, SyncType s
 			bdb->release(tdbb, true);
 			if (is_empty)
 			{
-				SyncLockGuard syncEmpty(&bcb->bcb_syncEmpty, SYNC_EXCLUSIVE, FB_FUNCTION);
-				QUE_INSERT(bcb->bcb_empty, bdb->bdb_que);
-				bcb->bcb_inuse--;
+				BufferNode* const node = bdb->bdb_node;
+
+				SyncLockGuard syncEmpty(&node->bcn_syncEmpty, SYNC_EXCLUSIVE, FB_FUNCTION);
+				QUE_INSERT(node->bcn_empty, bdb->bdb_que);
+				node->bcn_inuse--;
 			}
 
 			if (!bdb2 && wait > 0)
@@ -4219,7 +5083,7 @@ static LockState lock_buffer(thread_db* tdbb, BufferDesc* bdb, const SSHORT wait
 }
 
 
-static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, ULONG number)
+static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, BufferNode* node, ULONG number)
 {
 /**************************************
  *
@@ -4228,7 +5092,7 @@ static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, ULONG number)
  **************************************
  *
  * Functional description
- *	Initialize memory for the cache.
+ *	Initialize memory for the buffers of the cache node.
  *	Return number of buffers allocated.
  *
  **************************************/
@@ -4248,29 +5112,72 @@ static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, ULONG number)
 	const size_t lock_size = (bcb->bcb_flags & BCB_exclusive) ? 0 :
 		FB_ALIGN(sizeof(Lock) + lock_key_extra, alignof(Lock));
 
+	const ULONG huge_page_size = (bcb->bcb_flags & BCB_no_huge_pages) ? 0 :
+		dbb->dbb_config->getHugePageSize();
+
 	while (number)
 	{
 		if (!memory)
 		{
 			// Allocate memory block big enough to accommodate BufferDesc's, Lock's and page buffers.
 
-			ULONG to_alloc = number;
+			ULONG to_alloc = number;
+
+			while (true)
+			{
+				const size_t memory_size = (sizeof(BufferDesc) + lock_size + page_size) * (to_alloc + 1);
+
+				fb_assert(memory_size > 0);
+				if (memory_size < MIN_BUFFER_SEGMENT && to_alloc < number)
+				{
+					// Diminishing returns
+					return buffers;
+				}
+
+				if (huge_page_size && !(bcb->bcb_flags & BCB_no_huge_pages))
+				{
+					// Block is rounded up to the whole number of huge pages, the
+					// tail is left unused as the buffers layout depends on to_alloc
+
+					const size_t huge_size = FB_ALIGN(memory_size, huge_page_size);
+					memory = (UCHAR*) os_utils::allocHugePages(huge_size, huge_page_size);
+
+					if (memory)
+					{
+						BufferControl::HugeBlock blk;
+						blk.m_memory = memory;
+						blk.m_size = huge_size;
+						bcb->bcb_huge_memory.add(blk);
+
+						bcb->bcb_huge_page_size = huge_page_size;
+						memory_end = memory + memory_size;
+
+						if (node->bcn_numa_node >= 0)
+							os_utils::bindMemoryToNumaNode(memory, huge_size, node->bcn_numa_node);
+						break;
+					}
+
+					// Not enough huge pages are reserved in the system,
+					// use ordinary memory for the rest of the cache
 
-			while (true)
-			{
-				const size_t memory_size = (sizeof(BufferDesc) + lock_size + page_size) * (to_alloc + 1);
+					gds__log("Database: %s\n\tHuge pages of %u KB are not available, "
+							 "page cache uses ordinary memory",
+						dbb->dbb_filename.c_str(), huge_page_size / 1024);
 
-				fb_assert(memory_size > 0);
-				if (memory_size < MIN_BUFFER_SEGMENT)
-				{
-					// Diminishing returns
-					return buffers;
+					bcb->bcb_flags |= BCB_no_huge_pages;
 				}
 
 				try
 				{
 					memory = (UCHAR*) bcb->bcb_bufferpool->allocate(memory_size);
 					memory_end = memory + memory_size;
+					bcb->bcb_memory.push(memory);
+
+					// Memory is not touched yet, thus its pages are placed on the
+					// preferred node when buffers are initialized below
+
+					if (node->bcn_numa_node >= 0)
+						os_utils::bindMemoryToNumaNode(memory, memory_size, node->bcn_numa_node);
 					break;
 				}
 				catch (Firebird::BadAlloc&)
@@ -4282,7 +5189,6 @@ static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, ULONG number)
 					to_alloc >>= 1;
 				}
 			}
-			bcb->bcb_memory.push(memory);
 
 			tail = (BufferDesc*) FB_ALIGN(memory, alignof(BufferDesc));
 
@@ -4305,7 +5211,7 @@ static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, ULONG number)
 			fb_assert(memory_end >= memory + page_size * to_alloc);
 		}
 
-		tail = ::new(tail) BufferDesc(bcb);
+		tail = ::new(tail) BufferDesc(bcb, node);
 
 		if (!(bcb->bcb_flags & BCB_exclusive))
 		{
@@ -4318,7 +5224,11 @@ static ULONG memory_init(thread_db* tdbb, BufferControl* bcb, ULONG number)
 		tail->bdb_buffer = (pag*) memory;
 		memory += bcb->bcb_page_size;
 
-		QUE_INSERT(bcb->bcb_empty, tail->bdb_que);
+		{	// scope
+			SyncLockGuard emptySync(&node->bcn_syncEmpty, SYNC_EXCLUSIVE, FB_FUNCTION);
+			QUE_INSERT(node->bcn_empty, tail->bdb_que);
+			node->bcn_count++;
+		}
 		tail++;
 
 		buffers++;				// Allocated buffers
@@ -4388,200 +5298,6 @@ static void page_validation_error(thread_db* tdbb, WIN* window, SSHORT type)
 }
 
 
-#ifdef CACHE_READER
-static void prefetch_epilogue(Prefetch* prefetch, FbStatusVector* status_vector)
-{
-/**************************************
- *
- *	p r e f e t c h _ e p i l o g u e
- *
- **************************************
- *
- * Functional description
- *	Stall on asynchronous I/O completion.
- *	Move data from prefetch buffer to database
- *	buffers, compute the checksum, and release
- *	the latch.
- *
- **************************************/
-	if (!(prefetch->prf_flags & PRF_active))
-		return;
-
-	thread_db* tdbb = prefetch->prf_tdbb;
-	Database* dbb = tdbb->getDatabase();
-
-	prefetch->prf_piob.piob_wait = TRUE;
-	const bool async_status = PIO_status(dbb, &prefetch->prf_piob, status_vector);
-
-	// If there was an I/O error release all buffer latches acquired for the prefetch request.
-
-	if (!async_status)
-	{
-		BufferDesc** next_bdb = prefetch->prf_bdbs;
-		for (USHORT i = 0; i < prefetch->prf_max_prefetch; i++)
-		{
-			if (*next_bdb)
-				release_bdb(tdbb, *next_bdb, true, false, false);
-
-			next_bdb++;
-		}
-		prefetch->prf_flags &= ~PRF_active;
-		return;
-	}
-
-	const SCHAR* next_buffer = prefetch->prf_io_buffer;
-	BufferDesc** next_bdb = prefetch->prf_bdbs;
-
-	for (USHORT i = 0; i < prefetch->prf_max_prefetch; i++)
-	{
-		if (*next_bdb)
-		{
-			pag* page = (*next_bdb)->bdb_buffer;
-			if (next_buffer != reinterpret_cast<char*>(page))
-				memcpy(page, next_buffer, (ULONG) dbb->dbb_page_size);
-
-			if (page->pag_pageno == (*next_bdb)->bdb_page.getPageNum())
-			{
-				(*next_bdb)->bdb_flags &= ~(BDB_read_pending | BDB_not_valid);
-				(*next_bdb)->bdb_flags |= BDB_prefetch;
-			}
-
-			release_bdb(tdbb, *next_bdb, true, false, false);
-		}
-
-		next_buffer += dbb->dbb_page_size;
-		next_bdb++;
-	}
-
-	prefetch->prf_flags &= ~PRF_active;
-}
-
-
-static void prefetch_init(Prefetch* prefetch, thread_db* tdbb)
-{
-/**************************************
- *
- *	p r e f e t c h _ i n i t
- *
- **************************************
- *
- * Functional description
- *	Initialize prefetch data structure.
- *	Most systems that allow access to "raw" I/O
- *	interfaces want the buffer address aligned.
- *
- **************************************/
-	Database* dbb = tdbb->getDatabase();
-
-	prefetch->prf_tdbb = tdbb;
-	prefetch->prf_flags = 0;
-	prefetch->prf_max_prefetch = PREFETCH_MAX_TRANSFER / dbb->dbb_page_size;
-	prefetch->prf_aligned_buffer =
-		(SCHAR*) (((U_IPTR) &prefetch->prf_unaligned_buffer + MIN_PAGE_SIZE - 1) &
-		~((U_IPTR) MIN_PAGE_SIZE - 1));
-}
-
-
-static void prefetch_io(Prefetch* prefetch, FbStatusVector* status_vector)
-{
-/**************************************
- *
- *	p r e f e t c h _ i o
- *
- **************************************
- *
- * Functional description
- *	Queue an asynchronous I/O to read
- *	multiple pages into prefetch buffer.
- *
- **************************************/
-	thread_db* tdbb = prefetch->prf_tdbb;
-	Database* dbb = tdbb->getDatabase();
-
-	if (!prefetch->prf_page_count)
-		prefetch->prf_flags &= ~PRF_active;
-	else
-	{
-		// Get the cache reader working on our behalf too
-
-		if (!(dbb->dbb_bcb->bcb_flags & BCB_reader_active))
-			dbb->dbb_reader_sem.post();
-
-		const bool async_status =
-			PIO_read_ahead(dbb, prefetch->prf_start_page, prefetch->prf_io_buffer,
-						   prefetch->prf_page_count, &prefetch->prf_piob, status_vector);
-		if (!async_status)
-		{
-			BufferDesc** next_bdb = prefetch->prf_bdbs;
-			for (USHORT i = 0; i < prefetch->prf_max_prefetch; i++)
-			{
-				if (*next_bdb)
-					release_bdb(tdbb, *next_bdb, true, false, false);
-
-				next_bdb++;
-			}
-			prefetch->prf_flags &= ~PRF_active;
-		}
-	}
-}
-
-
-static void prefetch_prologue(Prefetch* prefetch, SLONG* start_page)
-{
-/**************************************
- *
- *	p r e f e t c h _ p r o l o g u e
- *
- **************************************
- *
- * Functional description
- *	Search for consecutive pages to be prefetched
- *	and latch them for I/O.
- *
- **************************************/
-	thread_db* tdbb = prefetch->prf_tdbb;
-	Database* dbb = tdbb->getDatabase();
-	BufferControl* bcb = dbb->dbb_bcb;
-
-	prefetch->prf_start_page = *start_page;
-	prefetch->prf_page_count = 0;
-	prefetch->prf_flags |= PRF_active;
-
-	BufferDesc** next_bdb = prefetch->prf_bdbs;
-	for (USHORT i = 0; i < prefetch->prf_max_prefetch; i++)
-	{
-		*next_bdb = 0;
-		if (SBM_clear(bcb->bcb_prefetch, *start_page) &&
-			(*next_bdb = get_buffer(tdbb, *start_page, LATCH_shared, 0)))
-		{
-			if ((*next_bdb)->bdb_flags & BDB_read_pending)
-				prefetch->prf_page_count = i + 1;
-			else
-			{
-				release_bdb(tdbb, *next_bdb, true, false, false);
-				*next_bdb = 0;
-			}
-		}
-
-		next_bdb++;
-		(*start_page)++;
-	}
-
-	// Optimize non-sequential list prefetching to transfer directly to database buffers.
-
-	BufferDesc* bdb;
-	if (prefetch->prf_page_count == 1 && (bdb = prefetch->prf_bdbs[0]))
-		prefetch->prf_io_buffer = reinterpret_cast<char*>(bdb->bdb_buffer);
-	else
-		prefetch->prf_io_buffer = prefetch->prf_aligned_buffer;
-
-	// Reset starting page for next bitmap walk
-
-	--(*start_page);
-}
-#endif // CACHE_READER
-
-
 static SSHORT related(BufferDesc* low, const BufferDesc* high, SSHORT limit, const ULONG mark)
 {
 /**************************************
@@ -5039,8 +5755,6 @@ static bool write_page(thread_db* tdbb, BufferDesc* bdb, FbStatusVector* const s
 			}
 		}
 
-		if (result)
-			bdb->bdb_flags &= ~BDB_db_dirty;
 	}
 
 	if (!result)
@@ -5054,34 +5768,51 @@ static bool write_page(thread_db* tdbb, BufferDesc* bdb, FbStatusVector* const s
 		dbb->dbb_flags |= DBB_suspend_bgio;
 	}
 	else
-	{
-		// clear the dirty bit vector, since the buffer is now
-		// clean regardless of which transactions have modified it
+		page_written(tdbb, bdb);
 
-		// Destination difference page number is only valid between MARK and
-		// write_page so clean it now to avoid confusion
-		bdb->bdb_difference_page = 0;
-		bdb->bdb_transactions = 0;
-		bdb->bdb_mark_transaction = 0;
+	return result;
+}
 
-		if (!(bdb->bdb_bcb->bcb_flags & BCB_keep_pages))
-			removeDirty(bdb->bdb_bcb, bdb);
 
-		bdb->bdb_flags &= ~(BDB_must_write | BDB_system_dirty);
-		clear_dirty_flag_and_nbak_state(tdbb, bdb);
+static void page_written(thread_db* tdbb, BufferDesc* bdb)
+{
+/**************************************
+ *
+ *	p a g e _ w r i t t e n
+ *
+ **************************************
+ *
+ * Functional description
+ *	Page image was successfully written, mark buffer as clean.
+ *
+ **************************************/
 
-		if (bdb->bdb_flags & BDB_io_error)
-		{
-			// If a write error has cleared, signal background threads
-			// to resume their regular duties. If someone has freed up
-			// disk space these errors will spontaneously go away.
+	bdb->bdb_flags &= ~BDB_db_dirty;
 
-			bdb->bdb_flags &= ~BDB_io_error;
-			dbb->dbb_flags &= ~DBB_suspend_bgio;
-		}
-	}
+	// clear the dirty bit vector, since the buffer is now
+	// clean regardless of which transactions have modified it
 
-	return result;
+	// Destination difference page number is only valid between MARK and
+	// write_page so clean it now to avoid confusion
+	bdb->bdb_difference_page = 0;
+	bdb->bdb_transactions = 0;
+	bdb->bdb_mark_transaction = 0;
+
+	if (!(bdb->bdb_bcb->bcb_flags & BCB_keep_pages))
+		removeDirty(bdb->bdb_bcb, bdb);
+
+	bdb->bdb_flags &= ~(BDB_must_write | BDB_system_dirty);
+	clear_dirty_flag_and_nbak_state(tdbb, bdb);
+
+	if (bdb->bdb_flags & BDB_io_error)
+	{
+		// If a write error has cleared, signal background threads
+		// to resume their regular duties. If someone has freed up
+		// disk space these errors will spontaneously go away.
+
+		bdb->bdb_flags &= ~BDB_io_error;
+		tdbb->getDatabase()->dbb_flags &= ~DBB_suspend_bgio;
+	}
 }
 
 static void clear_dirty_flag_and_nbak_state(thread_db* tdbb, BufferDesc* bdb)
@@ -5106,10 +5837,10 @@ void recentlyUsed(BufferDesc* bdb)
 	if (oldFlags & BDB_lru_chained)
 		return;
 
-	BufferControl* bcb = bdb->bdb_bcb;
+	BufferNode* const node = bdb->bdb_node;
 
 #ifdef DEV_BUILD
-	volatile BufferDesc* chain = bcb->bcb_lru_chain;
+	volatile BufferDesc* chain = node->bcn_lru_chain;
 	for (; chain; chain = chain->bdb_lru_chain)
 	{
 		if (chain == bdb)
@@ -5118,14 +5849,14 @@ void recentlyUsed(BufferDesc* bdb)
 #endif
 	for (;;)
 	{
-		bdb->bdb_lru_chain = bcb->bcb_lru_chain;
-		if (bcb->bcb_lru_chain.compare_exchange_strong(bdb->bdb_lru_chain, bdb))
+		bdb->bdb_lru_chain = node->bcn_lru_chain;
+		if (node->bcn_lru_chain.compare_exchange_strong(bdb->bdb_lru_chain, bdb))
 			break;
 	}
 }
 
 
-void requeueRecentlyUsed(BufferControl* bcb)
+void requeueRecentlyUsed(BufferNode* node)
 {
 	BufferDesc* chain = NULL;
 
@@ -5133,8 +5864,8 @@ void requeueRecentlyUsed(BufferControl* bcb)
 
 	for (;;)
 	{
-		chain = bcb->bcb_lru_chain;
-		if (bcb->bcb_lru_chain.compare_exchange_strong(chain, NULL))
+		chain = node->bcn_lru_chain;
+		if (node->bcn_lru_chain.compare_exchange_strong(chain, NULL))
 			break;
 	}
 
@@ -5156,14 +5887,17 @@ void requeueRecentlyUsed(BufferControl* bcb)
 	while ((bdb = reversed) != NULL)
 	{
 		reversed = bdb->bdb_lru_chain;
-		QUE_DELETE(bdb->bdb_in_use);
-		QUE_INSERT(bcb->bcb_in_use, bdb->bdb_in_use);
+
+		// Buffer referenced again moves from probation que into main one
+
+		removeLRU(bdb);
+		insertLRU(bdb, bdb->bdb_flags & BDB_lru_new);
 
 		bdb->bdb_lru_chain = NULL;
-		bdb->bdb_flags &= ~BDB_lru_chained;
+		bdb->bdb_flags &= ~(BDB_lru_chained | BDB_lru_new);
 	}
 
-	chain = bcb->bcb_lru_chain;
+	chain = node->bcn_lru_chain;
 }
 
 
@@ -5302,231 +6036,3 @@ void BufferDesc::unLockIO(thread_db* tdbb)
 
 	bdb_syncIO.unlock(NULL, SYNC_EXCLUSIVE);
 }
-
-
-namespace Jrd {
-
-/// class BCBHashTable
-
-void BCBHashTable::resize(ULONG count)
-{
-	const ULONG old_count = m_count;
-	chain_type* const old_chains = m_chains;
-
-	chain_type* new_chains = FB_NEW_POOL(m_pool) chain_type[count];
-	m_count = count;
-	m_chains = new_chains;
-
-#ifndef HASH_USE_CDS_LIST
-	// Initialize all new new_chains
-	for (chain_type* que = new_chains; que < new_chains + count; que++)
-		QUE_INIT(*que);
-#endif
-
-	if (!old_chains)
-		return;
-
-	const chain_type* const old_end = old_chains + old_count;
-
-	// Move any active buffers from old hash table to new
-	for (chain_type* old_tail = old_chains; old_tail < old_end; old_tail++)
-	{
-#ifndef HASH_USE_CDS_LIST
-		while (QUE_NOT_EMPTY(*old_tail))
-		{
-			QUE que_inst = old_tail->que_forward;
-			BufferDesc* bdb = BLOCK(que_inst, BufferDesc, bdb_que);
-			QUE_DELETE(*que_inst);
-			QUE mod_que = &new_chains[hash(bdb->bdb_page)];
-			QUE_INSERT(*mod_que, *que_inst);
-		}
-#else
-		while (!old_tail->empty())
-		{
-			auto n = old_tail->begin();
-			old_tail->erase(n->first);				// bdb_page
-
-			chain_type* new_chain = &m_chains[hash(n->first)];
-			new_chain->insert(n->first, n->second);	// bdb_page, bdb
-		}
-#endif
-	}
-
-	delete[] old_chains;
-}
-
-void BCBHashTable::clear()
-{
-	if (!m_chains)
-		return;
-
-#ifdef HASH_USE_CDS_LIST
-	const chain_type* const end = m_chains + m_count;
-	for (chain_type* tail = m_chains; tail < end; tail++)
-		tail->clear();
-#endif
-
-	delete[] m_chains;
-	m_chains = nullptr;
-	m_count = 0;
-}
-
-inline BufferDesc* BCBHashTable::find(const PageNumber& page) const
-{
-	auto& list = m_chains[hash(page)];
-
-#ifndef HASH_USE_CDS_LIST
-	QUE que_inst = list.que_forward;
-	for (; que_inst != &list; que_inst = que_inst->que_forward)
-	{
-		BufferDesc* bdb = BLOCK(que_inst, BufferDesc, bdb_que);
-		if (bdb->bdb_page == page)
-			return bdb;
-	}
-
-#else // HASH_USE_CDS_LIST
-	auto ptr = list.get(page);
-	if (!ptr.empty())
-	{
-		fb_assert(ptr->second != nullptr);
-#ifdef DEV_BUILD
-		// Original libcds have no update(key, value), use this code with it,
-		// see also comment in get_buffer()
-		while (ptr->second == nullptr)
-			cds::backoff::pause();
-#endif
-		if (ptr->second->bdb_page == page)
-			return ptr->second;
-	}
-#endif
-
-	return nullptr;
-}
-
-inline BufferDesc* BCBHashTable::emplace(BufferDesc* bdb, const PageNumber& page, bool remove)
-{
-#ifndef HASH_USE_CDS_LIST
-	// bcb_syncObject should be locked in EX mode
-
-	BufferDesc* bdb2 = find(page);
-	if (!bdb2)
-	{
-		if (remove)
-			QUE_DELETE(bdb->bdb_que);
-
-		que& mod_que = m_chains[hash(page)];
-		QUE_INSERT(mod_que, bdb->bdb_que);
-	}
-	return bdb2;
-#else // HASH_USE_CDS_LIST
-
-	BufferDesc* bdb2 = nullptr;
-	BdbList& list = m_chains[hash(page)];
-
-/*
-	// Original libcds have no update(key, value), use this code with it
-
-	auto ret = list.update(page, [bdb, &bdb2](bool bNew, BdbList::value_type& val)
-		{
-			if (bNew)
-				val.second = bdb;
-			else
-				while (!(bdb2 = val.second))
-					cds::backoff::pause();
-		},
-		true);
-*/
-
-	auto ret = list.update(page, bdb, [&bdb2](bool bNew, BdbList::value_type& val)
-		{
-			// someone might have put a page buffer in the chain concurrently, so
-			// we store it for the further investigation
-			if (!bNew)
-				bdb2 = val.second;
-		},
-		true);
-	fb_assert(ret.first);
-
-	// if we have inserted the page buffer that we found (empty or oldest)
-	if (bdb2 == nullptr)
-	{
-		fb_assert(ret.second);
-#ifdef DEV_BUILD
-		auto p1 = list.get(page);
-		fb_assert(!p1.empty() && p1->first == page && p1->second == bdb);
-#endif
-
-		if (remove)
-		{
-			// remove the page buffer from old hash slot
-			const PageNumber oldPage = bdb->bdb_page;
-			BdbList& oldList = m_chains[hash(oldPage)];
-
-#ifdef DEV_BUILD
-			p1 = oldList.get(oldPage);
-			fb_assert(!p1.empty() && p1->first == oldPage && p1->second == bdb);
-#endif
-
-			const bool ok = oldList.erase(oldPage);
-			fb_assert(ok);
-
-#ifdef DEV_BUILD
-			p1 = oldList.get(oldPage);
-			fb_assert(p1.empty() || p1->second != bdb);
-#endif
-		}
-
-#ifdef DEV_BUILD
-		p1 = list.get(page);
-		fb_assert(!p1.empty() && p1->first == page && p1->second == bdb);
-#endif
-	}
-	return bdb2;
-#endif
-}
-
-
-void BCBHashTable::remove(BufferDesc* bdb)
-{
-#ifndef HASH_USE_CDS_LIST
-	QUE_DELETE(bdb->bdb_que);
-#else
-	BdbList& list = m_chains[hash(bdb->bdb_page)];
-
-#ifdef DEV_BUILD
-	auto p = list.get(bdb->bdb_page);
-	fb_assert(!p.empty() && p->first == bdb->bdb_page && p->second == bdb);
-#endif
-
-	list.erase(bdb->bdb_page);
-#endif
-}
-
-
-}; // namespace Jrd
-
-
-#ifdef HASH_USE_CDS_LIST
-
-static InitInstance<InitPool> initPool;
-
-
-template <typename T>
-T* ListNodeAllocator<T>::allocate(std::size_t n)
-{
-	return static_cast<T*>(initPool().alloc(n * sizeof(T)));
-}
-
-template <typename T>
-void ListNodeAllocator<T>::deallocate(T* p, std::size_t /* n */)
-{
-	// It uses the correct pool stored within memory block itself
-	MemoryPool::globalFree(p);
-}
-
-void suspend()
-{
-	cds::backoff::pause();
-}
-
-#endif // HASH_USE_CDS_LIST
@@ -30,10 +30,6 @@
 #include "../common/classes/semaphore.h"
 #include "../common/classes/SyncObject.h"
 #include "../common/ThreadStart.h"
-#ifdef SUPERSERVER_V2
-#include "../jrd/sbm.h"
-#include "../jrd/pag.h"
-#endif
 
 #include "../jrd/que.h"
 #include "../jrd/lls.h"
@@ -73,6 +69,52 @@ inline constexpr ULONG MAX_PAGE_BUFFERS = 131072;
 inline constexpr ULONG MAX_PAGE_BUFFERS = MAX_SLONG - 1;
 #endif
 
+// BufferNode -- part of the page cache with buffers allocated on the same NUMA
+// node. Every node has its own LRU and empty buffers ques, thus threads running
+// on different nodes don't contend for the same LRU latch and don't touch memory
+// of another node. Buffer for the page read by a thread is taken from the node
+// the thread runs on. Page cache of single node works as before partitioning.
+
+class BufferNode
+{
+public:
+	explicit BufferNode(ULONG number, int numaNode)
+		: bcn_number(number),
+		  bcn_numa_node(numaNode)
+	{
+		QUE_INIT(bcn_in_use);
+		QUE_INIT(bcn_probation);
+		QUE_INIT(bcn_empty);
+	}
+
+	const ULONG	bcn_number;			// Node number in the page cache
+	const int	bcn_numa_node;		// System NUMA node, -1 if node is simulated
+
+	que			bcn_in_use;			// Que of buffers in use, main LRU que
+	que			bcn_probation;		// Que of buffers referenced once, used by 2Q policy only
+	que			bcn_empty;			// Que of empty buffers
+
+	// Recently used buffer put there without locking LRU que (bcn_in_use).
+	// When bcn_syncLRU is locked this chain is merged into bcn_in_use. See also
+	// requeueRecentlyUsed() and recentlyUsed()
+	std::atomic<BufferDesc*>	bcn_lru_chain = nullptr;
+
+	ULONG		bcn_count = 0;				// Number of buffers of the node, retired ones excluded
+	ULONG		bcn_inuse = 0;				// Number of buffers taken from empty que
+	ULONG		bcn_probation_count = 0;	// Number of buffers in probation que
+	ULONG		bcn_probation_limit = 0;	// Max size of probation que, zero for LRU policy
+
+	Firebird::SyncObject	bcn_syncEmpty;
+	Firebird::SyncObject	bcn_syncLRU;
+
+	// Page requests of the threads running on the node, counted when there are
+	// more than one node only
+	std::atomic<FB_UINT64>	bcn_hits = 0;			// page found in cache
+	std::atomic<FB_UINT64>	bcn_remote_hits = 0;	// page found in buffer of another node
+	std::atomic<FB_UINT64>	bcn_misses = 0;			// page read into new buffer
+};
+
+
 // BufferControl -- Buffer control block -- one per system
 
 class BufferControl : public pool_alloc<type_bcb>
@@ -81,27 +123,29 @@ class BufferControl : public pool_alloc<type_bcb>
 		: bcb_bufferpool(&p),
 		  bcb_memory_stats(&parentStats),
 		  bcb_memory(p),
+		  bcb_huge_memory(p),
+		  bcb_nodes(p),
+		  bcb_cpu_nodes(p),
 		  bcb_writer_fini(p, cache_writer, THREAD_medium),
 		  bcb_bdbBlocks(p)
 	{
 		bcb_database = NULL;
-		QUE_INIT(bcb_in_use);
 		QUE_INIT(bcb_pending);
-		QUE_INIT(bcb_empty);
+		QUE_INIT(bcb_retired);
 		QUE_INIT(bcb_dirty);
 		bcb_dirty_count = 0;
+		bcb_dirty_target = 0;
 		bcb_free = NULL;
 		bcb_flags = 0;
 		bcb_free_minimum = 0;
 		bcb_count = 0;
-		bcb_inuse = 0;
+		bcb_probation_limit = 0;
+		bcb_retired_count = 0;
 		bcb_prec_walk_mark = 0;
 		bcb_page_size = 0;
 		bcb_page_incarnation = 0;
+		bcb_huge_page_size = 0;
 		bcb_hashTable = nullptr;
-#ifdef SUPERSERVER_V2
-		bcb_prefetch = NULL;
-#endif
 	}
 
 public:
@@ -115,51 +159,53 @@ public:
 	Firebird::MemoryStats bcb_memory_stats;
 
 	UCharStack	bcb_memory;			// Large block partitioned into buffers
-	que			bcb_in_use;			// Que of buffers in use, main LRU que
-	que			bcb_pending;		// Que of buffers which are going to be freed and reassigned
-	que			bcb_empty;			// Que of empty buffers
 
-	// Recently used buffer put there without locking common LRU que (bcb_in_use).
-	// When bcb_syncLRU is locked this chain is merged into bcb_in_use. See also
-	// requeueRecentlyUsed() and recentlyUsed()
-	std::atomic<BufferDesc*>	bcb_lru_chain;
+	// Large block mapped from huge pages, see HugePageSize in firebird.conf
+	struct HugeBlock
+	{
+		UCHAR* m_memory;
+		size_t m_size;
+	};
+	Firebird::Array<HugeBlock>	bcb_huge_memory;
+
+	// Page cache nodes, see PageCacheNumaNodes in firebird.conf
+	Firebird::Array<BufferNode*>	bcb_nodes;
+	Firebird::Array<UCHAR>	bcb_cpu_nodes;	// Node number for every CPU
+
+	que			bcb_pending;		// Que of buffers which are going to be freed and reassigned
+	que			bcb_retired;		// Que of buffers removed from cache by shrink, not counted in bcb_count
 
 	que			bcb_dirty;			// que of dirty buffers
 	SLONG		bcb_dirty_count;	// count of pages in dirty page btree
+	SLONG		bcb_dirty_target;	// cache writer keeps bcb_dirty_count below it, zero if disabled
 
 	Precedence*	bcb_free;			// Free precedence blocks
 	Firebird::AtomicCounter	bcb_flags;	// see below
 	SSHORT		bcb_free_minimum;	// Threshold to activate cache writer
 	ULONG		bcb_count;			// Number of buffers allocated
-	ULONG		bcb_inuse;			// Number of buffers in use
+	ULONG		bcb_probation_limit;	// Max size of probation ques of all nodes, zero for LRU policy
+	ULONG		bcb_retired_count;	// Number of buffers in retired que
 	ULONG		bcb_prec_walk_mark;	// mark value used in precedence graph walk
 	ULONG		bcb_page_size;		// Database page size in bytes
 	ULONG		bcb_page_incarnation;	// Cache page incarnation counter
+	ULONG		bcb_huge_page_size;	// Size of huge pages backing buffers, zero if not used
 
 	Firebird::SyncObject	bcb_syncObject;
 	Firebird::SyncObject	bcb_syncDirtyBdbs;
-	Firebird::SyncObject	bcb_syncEmpty;
 	Firebird::SyncObject	bcb_syncPrecedence;
-	Firebird::SyncObject	bcb_syncLRU;
 
 	// If we make bcb_flags atomic this mutex will become unneeded: XCHG of bcb_flags is enough
 	Firebird::Mutex			bcb_threadStartup;
 
+	// Serializes cache grow and shrink, see CCH_resize()
+	Firebird::Mutex			bcb_resizeMutex;
+
 	typedef ThreadFinishSync<BufferControl*> BcbThreadSync;
 
 	static void cache_writer(BufferControl* bcb);
 	Firebird::Semaphore bcb_writer_sem;		// Wake up cache writer
 	Firebird::Semaphore bcb_writer_init;	// Cache writer initialization
 	BcbThreadSync bcb_writer_fini;			// Cache writer finalization
-#ifdef SUPERSERVER_V2
-	static void cache_reader(BufferControl* bcb);
-	// the code in cch.cpp is not tested for semaphore instead event !!!
-	Firebird::Semaphore bcb_reader_sem;		// Wake up cache reader
-	Firebird::Semaphore bcb_reader_init;	// Cache reader initialization
-	BcbThreadSync bcb_reader_fini;			// Cache reader finalization
-
-	PageBitmap*	bcb_prefetch;		// Bitmap of pages to prefetch
-#endif
 
 	void exceptionHandler(const Firebird::Exception& ex, BcbThreadSync::ThreadRoutine* routine);
 
@@ -178,12 +224,9 @@ inline constexpr int BCB_keep_pages		= 1;	// set during btc_flush(), pages not r
 inline constexpr int BCB_cache_writer	= 2;	// cache writer thread has been started
 inline constexpr int BCB_writer_start	= 4;    // cache writer thread is starting now
 inline constexpr int BCB_writer_active	= 8;	// no need to post writer event count
-#ifdef SUPERSERVER_V2
-inline constexpr int BCB_cache_reader	= 16;	// cache reader thread has been started
-inline constexpr int BCB_reader_active	= 32;	// cache reader not blocked on event
-#endif
 inline constexpr int BCB_free_pending	= 64;	// request cache writer to free pages
 inline constexpr int BCB_exclusive		= 128;	// there is only BCB in whole system
+inline constexpr int BCB_no_huge_pages	= 256;	// huge pages are not available, don't try again
 
 
 // BufferDesc -- Buffer descriptor block
@@ -191,8 +234,15 @@ inline constexpr int BCB_exclusive		= 128;	// there is only BCB in whole system
 class BufferDesc : public pool_alloc<type_bdb>
 {
 public:
+	// Descriptor of a temporary buffer outside of the page cache, used for
+	// direct I/O only, it doesn't belong to any node
 	explicit BufferDesc(BufferControl* bcb)
+		: BufferDesc(bcb, nullptr)
+	{ }
+
+	BufferDesc(BufferControl* bcb, BufferNode* node)
 		: bdb_bcb(bcb),
+		  bdb_node(node),
 		  bdb_page(0, 0)
 	{
 		bdb_lock = NULL;
@@ -239,9 +289,10 @@ public:
 	}
 
 	BufferControl*	bdb_bcb;
+	BufferNode*	bdb_node;				// Page cache node buffer memory belongs to
 	Firebird::SyncObject	bdb_syncPage;
 	Lock*		bdb_lock;				// Lock block for buffer
-	que			bdb_que;				// Either mod que in hash table or bcb_empty que if never used
+	que			bdb_que;				// Either mod que in hash table or bcn_empty que if never used
 	que			bdb_in_use;				// queue of buffers in use
 	que			bdb_dirty;				// dirty pages LRU queue
 	BufferDesc*	bdb_lru_chain;			// pending LRU chain
@@ -291,6 +342,8 @@ inline constexpr int BDB_prefetch			= 0x4000;	// page has been prefetched but no
 inline constexpr int BDB_no_blocking_ast	= 0x8000;	// No blocking AST registered with page lock
 inline constexpr int BDB_lru_chained		= 0x10000;	// buffer is in pending LRU chain
 inline constexpr int BDB_nbak_state_lock	= 0x20000;	// nbak state lock should be released after buffer is written
+inline constexpr int BDB_probation			= 0x40000;	// buffer is in probation LRU que
+inline constexpr int BDB_lru_new			= 0x80000;	// new buffer in pending LRU chain, goes to probation que
 
 // bdb_ast_flags
 
@@ -348,34 +401,13 @@ enum LATCH
 
 
 
-#ifdef SUPERSERVER_V2
-#include "../jrd/os/pio.h"
-
-// Constants used by prefetch mechanism
+// Maximum number of pages read ahead by single CCH_prefetch() call
 
-inline constexpr int PREFETCH_MAX_TRANSFER	= 16384;	// maximum block I/O transfer (bytes)
-// maximum pages allowed per prefetch request
-inline constexpr int PREFETCH_MAX_PAGES		= (2 * PREFETCH_MAX_TRANSFER / MIN_PAGE_SIZE);
+inline constexpr ULONG PREFETCH_MAX_PAGES = 256;
 
-// Prefetch block
-
-class Prefetch : public pool_alloc<type_prf>
-{
-public:
-	thread_db*	prf_tdbb;			// thread database context
-	SLONG		prf_start_page;		// starting page of multipage prefetch
-	USHORT		prf_max_prefetch;	// maximum no. of pages to prefetch
-	USHORT		prf_page_count;		// actual no. of pages being prefetched
-	phys_io_blk	prf_piob;			// physical I/O status block
-	SCHAR*		prf_aligned_buffer;	// buffer address aligned for raw (OS cache bypass) I/O
-	SCHAR*		prf_io_buffer;		// I/O buffer address
-	UCHAR		prf_flags;
-	BufferDesc*	prf_bdbs[PREFETCH_MAX_TRANSFER / MIN_PAGE_SIZE];
-	SCHAR		prf_unaligned_buffer[PREFETCH_MAX_TRANSFER + MIN_PAGE_SIZE];
-};
+// Suffix of the file with list of hot pages saved next to the database
 
-inline constexpr int PRF_active = 1;		// prefetch block currently in use
-#endif // SUPERSERVER_V2
+inline constexpr const char* HOT_PAGES_SUFFIX = ".cache";
 
 typedef Firebird::SortedArray<SLONG, Firebird::InlineStorage<SLONG, 256>, SLONG> PagesArray;
 
@@ -34,6 +34,7 @@ namespace Jrd
 {
 	class blb;
 	class jrd_rel;
+	class RelationPages;
 	struct record_param;
 	class Record;
 	class jrd_tra;
@@ -56,10 +57,12 @@ namespace Ods
 }
 
 Ods::pag* DPM_allocate(Jrd::thread_db*, Jrd::win*);
+bool	DPM_all_visible(Jrd::thread_db*, Jrd::jrd_rel*, ULONG);
 void	DPM_backout(Jrd::thread_db*, Jrd::record_param*);
 void	DPM_backout_mark(Jrd::thread_db*, Jrd::record_param*, const Jrd::jrd_tra*);
 double	DPM_cardinality(Jrd::thread_db*, Jrd::jrd_rel*, const Jrd::Format*);
 bool	DPM_chain(Jrd::thread_db*, Jrd::record_param*, Jrd::record_param*);
+UCHAR	DPM_clear_purged_bits(const UCHAR*, USHORT, const Jrd::RelationPages*, TraNumber);
 void	DPM_create_relation(Jrd::thread_db*, Jrd::Cached::Relation*);
 ULONG	DPM_data_pages(Jrd::thread_db*, Jrd::Cached::Relation*);
 void	DPM_delete(Jrd::thread_db*, Jrd::record_param*, ULONG);
@@ -71,18 +74,19 @@ void	DPM_fetch_fragment(Jrd::thread_db*, Jrd::record_param*, USHORT);
 SINT64	DPM_gen_id(Jrd::thread_db*, SLONG, bool, SINT64);
 bool	DPM_get(Jrd::thread_db*, Jrd::record_param*, SSHORT);
 ULONG	DPM_get_blob(Jrd::thread_db*, Jrd::blb*, Jrd::jrd_rel*, RecordNumber, bool, ULONG);
+void	DPM_mark_purged(Jrd::thread_db*, Jrd::record_param*);
 void	DPM_mark_relation(Jrd::thread_db*, Jrd::Cached::Relation*);
 bool	DPM_next(Jrd::thread_db*, Jrd::record_param*, USHORT, Jrd::FindNextRecordScope);
+UCHAR	DPM_page_bits(const UCHAR*, USHORT, UCHAR, bool);
 void	DPM_pages(Jrd::thread_db*, SSHORT, int, ULONG, ULONG);
-#ifdef SUPERSERVER_V2
-SLONG	DPM_prefetch_bitmap(Jrd::thread_db*, Jrd::jrd_rel*, Jrd::PageBitmap*, SLONG);
-#endif
+FB_UINT64	DPM_prefetch_bitmap(Jrd::thread_db*, Jrd::jrd_rel*, Jrd::RecordBitmap*, FB_UINT64);
 ULONG	DPM_pointer_pages(Jrd::thread_db*, Jrd::jrd_rel*);
 void	DPM_scan_pages(Jrd::thread_db*);
 void	DPM_store(Jrd::thread_db*, Jrd::record_param*, Jrd::PageStack&, const Jrd::RecordStorageType type);
 RecordNumber DPM_store_blob(Jrd::thread_db*, Jrd::blb*, Jrd::jrd_rel*, Jrd::Record*);
 void	DPM_rewrite_header(Jrd::thread_db*, Jrd::record_param*);
 void	DPM_scan_marker(Jrd::thread_db*, MetaId);
+UCHAR	DPM_swept_flags(const Ods::data_page*, TraNumber, TraNumber);
 void	DPM_update(Jrd::thread_db*, Jrd::record_param*, Jrd::PageStack*, const Jrd::jrd_tra*);
 
 void DPM_create_relation_pages(Jrd::thread_db*, Jrd::RelationPermanent*, Jrd::RelationPages*);
@@ -243,6 +243,9 @@ enum drq_type_t
 	drq_l_rel_con,			// lookup relation constraint
 	drq_l_rel_fld_name,		// lookup relation field name
 	drq_g_nxt_package_id,	// lookup next package ID
+	drq_e_col_stats,		// erase column statistics
+	drq_s_col_stats,		// store column statistics
+	drq_e_rel_col_stats,	// erase column statistics of a relation
 
 	drq_MAX
 };
@@ -91,6 +91,7 @@ class MessageNode;
 class PlanNode;
 class RecordSource;
 class Select;
+class ColumnStatisticsList;
 
 // Direction for each column in sort order
 enum SortDirection { ORDER_ANY, ORDER_ASC, ORDER_DESC };
@@ -126,6 +127,8 @@ inline constexpr int csb_unmatched		= 512;		// stream has conjuncts unmatched by
 inline constexpr int csb_update			= 1024;		// erase or modify for relation
 inline constexpr int csb_unstable		= 2048;		// unstable explicit cursor
 inline constexpr int csb_skip_locked	= 4096;		// skip locked record
+inline constexpr int csb_index_only		= 8192;		// records may be found by the index alone
+inline constexpr int csb_index_payload	= 16384;	// records may be built of the index payload
 
 
 // Aggregate Sort Block (for DISTINCT aggregates)
@@ -651,7 +654,10 @@ public:
 		const Format* csb_format;		// Default Format for stream
 		Format* csb_internal_format;	// Statement internal format
 		UInt32Bitmap* csb_fields;		// Fields referenced
+		ULONG csb_data_refs;			// Number of nodes accessing the record data
+		ULONG csb_record_refs;			// Number of nodes accessing the record header
 		double csb_cardinality;			// Cardinality of relation
+		ColumnStatisticsList* csb_statistics;	// Column statistics of relation
 		PlanNode* csb_plan;				// user-specified plan for this relation
 		StreamType* csb_map;			// Stream map for views
 		RecordSource** csb_rsb_ptr;		// point to rsb for nod_stream
@@ -676,7 +682,10 @@ inline CompilerScratch::csb_repeat::csb_repeat() noexcept
 	  csb_format(0),
 	  csb_internal_format(0),
 	  csb_fields(0),
+	  csb_data_refs(0),
+	  csb_record_refs(0),
 	  csb_cardinality(0.0),	// TMN: Non-natural cardinality?!
+	  csb_statistics(0),
 	  csb_plan(0),
 	  csb_map(0),
 	  csb_rsb_ptr(0),
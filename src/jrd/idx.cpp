@@ -390,7 +390,7 @@ public:
 
 				m_sort = FB_NEW_POOL(m_tra->tra_sorts.getPool())
 							Sort(att->att_database, &m_tra->tra_sorts,
-								 creation->key_length + sizeof(index_sort_record),
+								 creation->key_length + sizeof(index_sort_record) + creation->payload_length,
 								 2, 1, creation->key_desc, callback, callback_arg);
 
 				creation->sort->addPartition(m_sort);
@@ -581,6 +581,7 @@ bool IndexCreateTask::handler(WorkItem& _item)
 
 	IndexKey key(tdbb, relation, idx);
 	IndexCondition condition(tdbb, idx);
+	UCharBuffer payload;
 
 	// Loop thru the relation computing index keys.  If there are old versions, find them, too.
 	while (DPM_next(tdbb, &primary, LCK_read, DPM_next_pointer_page))
@@ -732,6 +733,19 @@ bool IndexCreateTask::handler(WorkItem& _item)
 			isr->isr_record_number = primary.rpb_number.getValue();
 			isr->isr_key_length = key->key_length;
 			isr->isr_flags = ((stack.hasData() || deleted) ? ISR_secondary : 0) | (key_is_null ? ISR_null : 0);
+			isr->isr_payload_length = 0;
+
+			if (m_creation->payload_length)
+			{
+				BTR_make_payload(tdbb, relation, record, idx, payload);
+
+				if (payload.getCount() <= m_creation->payload_length)
+				{
+					isr->isr_payload_length = (USHORT) payload.getCount();
+					memcpy(isr + 1, payload.begin(), payload.getCount());
+				}
+			}
+
 			if (record != gc_record)
 				delete record;
 		}
@@ -876,7 +890,10 @@ void IDX_create_index(thread_db* tdbb,
 	const int nullIndLen = !isDescending && (idx->idx_count == 1) ? 1 : 0;
 	const USHORT key_length = ROUNDUP(BTR_key_length(tdbb, relation, idx) + nullIndLen, sizeof(SINT64));
 
-	if (key_length >= dbb->getMaxIndexKeyLength())
+	// Included columns are stored in the leaf nodes together with the key
+	const USHORT payload_length = BTR_payload_length(tdbb, relation, idx);
+
+	if (key_length + payload_length >= dbb->getMaxIndexKeyLength())
 	{
 		ERR_post(Arg::Gds(isc_no_meta_update) <<
 				 Arg::Gds(isc_keytoobig) << index_name.toQuotedString());
@@ -896,6 +913,7 @@ void IDX_create_index(thread_db* tdbb,
 	creation.transaction = transaction;
 	creation.sort = NULL;
 	creation.key_length = key_length;
+	creation.payload_length = payload_length;
 	creation.nullIndLen = nullIndLen;
 	creation.dup_recno = -1;
 	creation.duplicates.setValue(0);
@@ -2062,11 +2080,23 @@ static idx_e insert_key(thread_db* tdbb,
 	idx_e result = idx_e_ok;
 	index_desc* idx = insertion->iib_descriptor;
 
+	// Included columns are stored in the leaf node together with the key.
+	// Note the payload is not refreshed when a record is updated but its
+	// key is not changed, index scans trust it for all visible pages only.
+
+	UCharBuffer payload;
+	BTR_make_payload(tdbb, relation, record, idx, payload);
+	insertion->iib_payload = payload.begin();
+	insertion->iib_payload_length = (USHORT) payload.getCount();
+
 	// Insert the key into the index.  If the index is unique, btr will keep track of duplicates.
 
 	insertion->iib_duplicates = NULL;
 	BTR_insert(tdbb, window_ptr, insertion);
 
+	insertion->iib_payload = nullptr;
+	insertion->iib_payload_length = 0;
+
 	if (insertion->iib_duplicates)
 	{
 		result = check_duplicates(tdbb, record, idx, insertion, NULL);
@@ -541,6 +541,11 @@ static inline constexpr struct ini_idx_t indices[] =
 	// define index RDB$INDEX_100 for RDB$PACKAGES unique RDB$PACKAGE_ID;
 	INDEX(99, rel_packages, idx_unique, 1, ODS_14_0)
 		SEGMENT(f_pkg_id, idx_numeric)				// constant id
+	}},
+	// define index RDB$INDEX_100 for RDB$COLUMN_STATISTICS RDB$SCHEMA_NAME, RDB$RELATION_NAME;
+	INDEX(100, rel_column_statistics, 0, 2, ODS_14_0)
+		SEGMENT(f_cst_schema, idx_metadata),		// schema name
+		SEGMENT(f_cst_rname, idx_metadata)			// relation name
 	}}
 };
 
@@ -347,6 +347,32 @@ void INF_database_info(thread_db* tdbb,
 			length = INF_convert(dbb->dbb_page_buffers, buffer);
 			break;
 
+		case fb_info_page_cache_huge_page_size:
+			length = INF_convert(dbb->dbb_bcb->bcb_huge_page_size, buffer);
+			break;
+
+		case fb_info_page_cache_nodes:
+			// One item per node: node number, number of buffers and counters
+			// of hits, remote hits and misses of the threads running on it
+			for (const BufferNode* const node : dbb->dbb_bcb->bcb_nodes)
+			{
+				p = buffer;
+				put_vax_long(p, node->bcn_number);
+				p += sizeof(SLONG);
+				put_vax_long(p, node->bcn_count);
+				p += sizeof(SLONG);
+				put_vax_int64(p, node->bcn_hits);
+				p += sizeof(SINT64);
+				put_vax_int64(p, node->bcn_remote_hits);
+				p += sizeof(SINT64);
+				put_vax_int64(p, node->bcn_misses);
+				p += sizeof(SINT64);
+
+				if (!(info = INF_put_item(item, p - buffer, buffer, info, end)))
+					return;
+			}
+			continue;
+
 		case isc_info_logfile:
 			length = INF_convert(FALSE, buffer);
 			break;
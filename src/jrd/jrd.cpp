@@ -997,6 +997,7 @@ namespace Jrd
 		SLONG	dpb_sweep_interval;
 		ULONG	dpb_page_buffers;
 		bool	dpb_set_page_buffers;
+		ULONG	dpb_page_cache;
 		ULONG	dpb_buffers;
 		USHORT	dpb_verify;
 		USHORT	dpb_sweep;
@@ -2171,6 +2172,12 @@ JAttachment* JProvider::internalAttach(CheckStatusWrapper* user_status, const ch
 				}
 			}
 
+			if (options.dpb_page_cache)
+			{
+				validateAccess(tdbb, attachment, CHANGE_HEADER_SETTINGS);
+				CCH_resize(tdbb, options.dpb_page_cache);
+			}
+
 			if (options.dpb_parallel_workers)
 			{
 				attachment->att_parallel_workers = options.dpb_parallel_workers;
@@ -3561,6 +3568,10 @@ void JAttachment::internalDropDatabase(CheckStatusWrapper* user_status)
 				for (; shadow; shadow = shadow->sdw_next)
 					err = drop_file(dbb, shadow->sdw_file) || err;
 
+				// List of hot pages saved by the cache writer is useless too
+				const PathName hotPages = dbb->dbb_filename + HOT_PAGES_SUFFIX;
+				unlink(hotPages.c_str());
+
 				tdbb->setDatabase(NULL);
 				Database::destroy(dbb);
 
@@ -7012,6 +7023,15 @@ void DatabaseOptions::get(const UCHAR* dpb, FB_SIZE_T dpb_length, bool& invalid_
 			dpb_set_page_buffers = true;
 			break;
 
+		case isc_dpb_page_cache:
+			dpb_page_cache = rdr.getInt();
+			if (dpb_page_cache < MIN_PAGE_BUFFERS || dpb_page_cache > MAX_PAGE_BUFFERS)
+			{
+				ERR_post(Arg::Gds(isc_bad_dpb_content) << Arg::Gds(isc_baddpb_buffers_range) <<
+						 Arg::Num(MIN_PAGE_BUFFERS) << Arg::Num(MAX_PAGE_BUFFERS));
+			}
+			break;
+
 		case isc_dpb_num_buffers:
 			if (Config::getServerMode() != MODE_SUPER)
 			{
@@ -190,6 +190,7 @@ inline constexpr USHORT WIN_large_scan			= 1;	// large sequential scan
 inline constexpr USHORT WIN_secondary			= 2;	// secondary stream
 inline constexpr USHORT WIN_garbage_collector	= 4;	// garbage collector's window
 inline constexpr USHORT WIN_garbage_collect		= 8;	// scan left a page for garbage collector
+inline constexpr USHORT WIN_use_once			= 16;	// pages are not expected to be referenced again soon
 
 // Helper class to temporarily activate sweeper context
 class ThreadSweepGuard
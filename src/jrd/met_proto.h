@@ -64,6 +64,7 @@ namespace Jrd
 	class RelationPermanent;
 	class Triggers;
 	class TrigArray;
+	class ColumnStatisticsList;
 
 	typedef Firebird::HalfStaticArray<QualifiedName, 4> CharsetVariants;
 
@@ -91,6 +92,7 @@ void		MET_delete_dependencies(Jrd::thread_db*, const Jrd::QualifiedName&, int);
 void		MET_delete_shadow(Jrd::thread_db*, USHORT);
 void		MET_error(const TEXT*, ...);
 bool		MET_get_char_coll_subtype_info(Jrd::thread_db*, USHORT, Jrd::SubtypeInfo* info);
+void		MET_get_column_statistics(Jrd::thread_db*, Jrd::jrd_rel*, Jrd::ColumnStatisticsList&);
 Jrd::DmlNode*	MET_get_dependencies(Jrd::thread_db*, Jrd::jrd_rel*, const UCHAR*, const ULONG,
 								Jrd::CompilerScratch*, Jrd::bid*, Jrd::Statement**,
 								Jrd::CompilerScratch**, const Jrd::QualifiedName&, int, USHORT,
@@ -496,6 +496,8 @@ NAME("RDB$CONSTANTS", nam_constants)
 NAME("RDB$CONSTANT_NAME", nam_const_name)
 NAME("RDB$CONSTANT_BLR", nam_const_blr)
 NAME("RDB$CONSTANT_SOURCE", nam_const_source)
+NAME("RDB$COLUMN_STATISTICS", nam_column_statistics)
+NAME("RDB$HISTOGRAM", nam_histogram)
 
 NAME("MON$TABLE_TYPE", nam_mon_tab_type)
 NAME("MON$LOCAL_TEMPORARY_TABLES", nam_mon_local_temp_tables)
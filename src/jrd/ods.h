@@ -369,6 +369,7 @@ inline constexpr UCHAR dpg_large		= 0x04;		// Large object is on page
 inline constexpr UCHAR dpg_swept		= 0x08;		// Sweep has nothing to do on this page
 inline constexpr UCHAR dpg_secondary	= 0x10;		// Primary record versions not stored on this page
 													// Set in dpm.epp's extend_relation() but never tested.
+inline constexpr UCHAR dpg_visible		= 0x20;		// All records on this page are visible to everybody
 
 
 // Index root page
@@ -393,7 +394,8 @@ struct index_root_page
 		USHORT irt_flags;				// index flags
 		UCHAR irt_state;				// index state
 		UCHAR irt_keys;					// number of keys in index
-		USHORT irt_dummy;				// alignment to 8-byte boundary
+		UCHAR irt_includes;				// number of included (non-key) columns
+		UCHAR irt_dummy;				// alignment to 8-byte boundary
 
 	private:
 		void setState(UCHAR newState);
@@ -424,6 +426,7 @@ struct index_root_page
 	static_assert(offsetof(struct irt_repeat, irt_flags) == 18, "irt_flags offset mismatch");
 	static_assert(offsetof(struct irt_repeat, irt_state) == 20, "irt_state offset mismatch");
 	static_assert(offsetof(struct irt_repeat, irt_keys) == 21, "irt_keys offset mismatch");
+	static_assert(offsetof(struct irt_repeat, irt_includes) == 22, "irt_includes offset mismatch");
 };
 
 static_assert(sizeof(struct index_root_page) == 48, "struct index_root_page size mismatch");
@@ -846,6 +849,10 @@ inline constexpr UCHAR ppg_dp_swept			= 0x04;		// Sweep has nothing to do on dat
 inline constexpr UCHAR ppg_dp_secondary		= 0x08;		// Primary record versions not stored on data page
 inline constexpr UCHAR ppg_dp_empty			= 0x10;		// Data page is empty
 inline constexpr UCHAR ppg_dp_reserved		= 0x20;		// Slot is reserved for bulk insert
+inline constexpr UCHAR ppg_dp_visible		= 0x40;		// All records on data page are visible to everybody
+inline constexpr UCHAR ppg_dp_purged		= 0x80;		// Record versions were removed from the slot, so
+														// indices could still contain their keys, until
+														// sweep finds the page visible again
 
 inline constexpr UCHAR PPG_DP_ALL_BITS	= (1 << PPG_DP_BITS_NUM) - 1;
 
@@ -856,6 +863,10 @@ inline constexpr UCHAR PPG_DP_ALL_BITS	= (1 << PPG_DP_BITS_NUM) - 1;
 #define PPG_DP_BIT_SET(flags, slot, bit)	(PPG_DP_BITS_BYTE((flags), (slot)) |= PPG_DP_BIT_MASK((slot), (bit)))
 #define PPG_DP_BIT_CLEAR(flags, slot, bit)	(PPG_DP_BITS_BYTE((flags), (slot)) &= ~PPG_DP_BIT_MASK((slot), (bit)))
 
+// Records of the data page may be returned by index-only scans without fetching them
+#define PPG_DP_ALL_VISIBLE(flags, slot)	\
+	(PPG_DP_BIT_TEST((flags), (slot), ppg_dp_visible | ppg_dp_purged) == PPG_DP_BIT_MASK((slot), ppg_dp_visible))
+
 
 // Transaction Inventory Page
 
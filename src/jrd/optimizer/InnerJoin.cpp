@@ -227,13 +227,30 @@ void InnerJoin::estimateCost(unsigned position,
 		//  - probing the hash table and copying the matched rows
 
 		const auto hashCardinality = stream->baseSelectivity * streamCardinality;
-		const auto hashCost = stream->baseCost +
+		const auto buildCost = stream->baseCost +
 			// hashing cost
-			hashCardinality * (COST_FACTOR_MEMCOPY + COST_FACTOR_HASHING) +
-			// probing + copying cost
-			cardinality * (COST_FACTOR_HASHING + currentCardinality * COST_FACTOR_MEMCOPY);
+			hashCardinality * (COST_FACTOR_MEMCOPY + COST_FACTOR_HASHING);
+		// probing + copying cost
+		const auto probeCost = COST_FACTOR_HASHING + currentCardinality * COST_FACTOR_MEMCOPY;
+		const auto hashCost = buildCost + cardinality * probeCost;
 
-		if (hashCost <= loopCost && hashCardinality <= HashJoin::maxCapacity())
+		// Even if nested loops look cheaper, hashing wins when the prior streams
+		// produce more rows than estimated. Unless the first rows are favored,
+		// let the join choose at runtime, having counted the rows up to the point
+		// where both costs are equal. This is pointless if that point is too far
+		// from the estimation.
+
+		double threshold = 0;
+
+		if (hashCost > loopCost && candidate->cost > probeCost && !optimizer->favorFirstRows())
+		{
+			threshold = buildCost / (candidate->cost - probeCost);
+
+			if (threshold > MIN(cardinality * ADAPTIVE_CARDINALITY_FACTOR, MAXIMUM_ADAPTIVE_THRESHOLD))
+				threshold = 0;
+		}
+
+		if (hashCost <= loopCost || threshold >= MINIMUM_CARDINALITY)
 		{
 			auto& equiMatches = joinedStreams[position].equiMatches;
 			fb_assert(!equiMatches.hasData());
@@ -267,7 +284,12 @@ void InnerJoin::estimateCost(unsigned position,
 
 			// Adjust the actual cost value, if hash joining is both possible and preferrable
 			if (equiMatches.hasData())
-				cost = hashCost;
+			{
+				if (hashCost <= loopCost)
+					cost = hashCost;
+				else
+					joinedStreams[position].adaptiveThreshold = (ULONG) threshold;
+			}
 		}
 	}
 
@@ -523,7 +545,7 @@ River* InnerJoin::formRiver()
 		//    - existing sort was not utilized using an index
 
 		if (rsbs.hasData() && // this is not the first stream
-			stream.equiMatches.hasData() &&
+			stream.equiMatches.hasData() && !stream.adaptiveThreshold &&
 			(!optimizer->favorFirstRows() || !sortUtilized))
 		{
 			fb_assert(streams.hasData());
@@ -547,27 +569,10 @@ River* InnerJoin::formRiver()
 			keys.add(FB_NEW_POOL(getPool()) NestValueArray(getPool()));
 			keys.add(FB_NEW_POOL(getPool()) NestValueArray(getPool()));
 
-			for (const auto match : stream.equiMatches)
-			{
-				NestConst<ValueExprNode> node1;
-				NestConst<ValueExprNode> node2;
-
-				if (!optimizer->getEquiJoinKeys(match, &node1, &node2))
-					fb_assert(false);
-
-				if (!node2->containsStream(stream.number))
-				{
-					fb_assert(node1->containsStream(stream.number));
-
-					// Swap the sides
-					std::swap(node1, node2);
-				}
-
-				keys[0]->add(node1);
-				keys[1]->add(node2);
+			makeHashKeys(stream, keys[0], keys[1]);
 
+			for (const auto match : stream.equiMatches)
 				equiMatches.add(match);
-			}
 
 			// Ensure the smallest stream is the one to be hashed,
 			// unless the prior record source is already a join.
@@ -587,6 +592,19 @@ River* InnerJoin::formRiver()
 			// Clear priorly processed rsb's, as they're already incorporated into a hash join
 			rsbs.clear();
 		}
+		else if (rsbs.hasData() && stream.adaptiveThreshold && !sortUtilized)
+		{
+			fb_assert(stream.equiMatches.hasData());
+
+			// Create a nested loop join from the priorly processed streams
+			const auto priorRsb = (rsbs.getCount() == 1) ? rsbs[0] :
+				FB_NEW_POOL(getPool()) NestedLoopJoin(csb, JoinType::INNER, rsbs.getCount(), rsbs.begin());
+
+			rsb = generateAdaptiveJoin(stream, priorRsb, streams);
+
+			// Clear priorly processed rsb's, as they're already incorporated into an adaptive join
+			rsbs.clear();
+		}
 		else
 		{
 			rsb = optimizer->generateRetrieval(stream.number, sortPtr, false, false);
@@ -622,6 +640,114 @@ River* InnerJoin::formRiver()
 }
 
 
+//
+// Extract the keys of the equi-join conditions for hashing
+//
+
+void InnerJoin::makeHashKeys(const JoinedStreamInfo& stream, NestValueArray* priorKeys, NestValueArray* streamKeys)
+{
+	for (const auto match : stream.equiMatches)
+	{
+		NestConst<ValueExprNode> node1;
+		NestConst<ValueExprNode> node2;
+
+		if (!optimizer->getEquiJoinKeys(match, &node1, &node2))
+			fb_assert(false);
+
+		if (!node2->containsStream(stream.number))
+		{
+			fb_assert(node1->containsStream(stream.number));
+
+			// Swap the sides
+			std::swap(node1, node2);
+		}
+
+		priorKeys->add(node1);
+		streamKeys->add(node2);
+	}
+}
+
+
+//
+// Join the stream to the prior ones either using nested loops or hashing,
+// as decided at runtime. Both retrievals of the stream are generated from
+// the same state of conjuncts, the ones applied by the dependent retrieval
+// only are checked after hashing.
+//
+
+RecordSource* InnerJoin::generateAdaptiveJoin(const JoinedStreamInfo& stream,
+											  RecordSource* priorRsb,
+											  const StreamList& priorStreams)
+{
+	HalfStaticArray<unsigned, OPT_STATIC_ITEMS> orgFlags, hashFlags;
+
+	for (auto iter = optimizer->getConjuncts(); iter.hasData(); ++iter)
+		orgFlags.add(iter.getFlags());
+
+	RecordSource* hashedRsb;
+
+	{	// scope
+		// Deactivate priorly joined streams
+		StreamStateHolder stateHolder(csb, priorStreams);
+		stateHolder.deactivate();
+
+		// Create an independent retrieval
+		hashedRsb = optimizer->generateRetrieval(stream.number, nullptr, false, false);
+	}
+
+	FB_SIZE_T pos = 0;
+	for (auto iter = optimizer->getConjuncts(); iter.hasData(); ++iter, pos++)
+	{
+		hashFlags.add(iter.getFlags());
+
+		// Restore the original flags
+		iter.reset(*iter);
+		iter |= orgFlags[pos];
+	}
+
+	// Create a dependent retrieval
+	const auto loopRsb = optimizer->generateRetrieval(stream.number, nullptr, false, false);
+
+	BoolExprNode* boolean = nullptr;
+
+	pos = 0;
+	for (auto iter = optimizer->getConjuncts(); iter.hasData(); ++iter, pos++)
+	{
+		if ((iter & Optimizer::CONJUNCT_USED) && !(hashFlags[pos] & Optimizer::CONJUNCT_USED))
+		{
+			boolean = boolean ?
+				FB_NEW_POOL(getPool()) BinaryBoolNode(getPool(), blr_and, boolean, *iter) : *iter;
+		}
+	}
+
+	// Prepare the hash join, the prior streams are always the leading ones.
+	// They are buffered while the strategy is chosen and the hash join
+	// continues reading them after the buffered rows.
+	const auto outerRsb = FB_NEW_POOL(getPool()) BufferedStream(csb, priorRsb);
+
+	RecordSource* hashJoinRsbs[] = {outerRsb, hashedRsb};
+
+	NestValueArray* keys[] = {
+		FB_NEW_POOL(getPool()) NestValueArray(getPool()),
+		FB_NEW_POOL(getPool()) NestValueArray(getPool())
+	};
+
+	makeHashKeys(stream, keys[0], keys[1]);
+
+	RecordSource* hashJoin = FB_NEW_POOL(getPool())
+		HashJoin(tdbb, csb, JoinType::INNER, 2, hashJoinRsbs, keys, stream.selectivity);
+
+	if (boolean)
+	{
+		hashJoin = FB_NEW_POOL(getPool())
+			FilteredStream(csb, hashJoin, boolean, MAXIMUM_SELECTIVITY);
+	}
+
+	return FB_NEW_POOL(getPool())
+		AdaptiveJoin(csb, outerRsb, loopRsb, hashedRsb, hashJoin, stream.adaptiveThreshold);
+}
+
+
 //
 // Check if the testStream can use a index when the baseStream is active. If so
 // then we create a indexRelationship and fill it with the needed information.
@@ -53,6 +53,7 @@
 #include "../jrd/met.h"
 #include "../jrd/intl.h"
 #include "../jrd/Collation.h"
+#include "../jrd/ColumnStatistics.h"
 #include "../common/gdsassert.h"
 #include "../jrd/btr_proto.h"
 #include "../jrd/cch_proto.h"
@@ -578,6 +579,307 @@ namespace
 		}
 	}
 
+	bool useParallelScan(thread_db* tdbb, const CompilerScratch* csb, const RseNode* rse,
+		bool readOnce, StreamType stream)
+	{
+		// Parallel workers read the table in their own read-only transactions,
+		// so the records may not be locked, changed or seen by triggers
+
+		static constexpr double MIN_PARALLEL_SCAN_CARDINALITY = 100000;
+
+		// Starting the workers costs too much to do it every time the scan is reopened.
+		// So the stream must be read once per execution of the statement, i.e. it must
+		// not depend on other streams, being e.g. the inner one of a nested loop join.
+
+		if (!readOnce)
+			return false;
+
+		for (StreamType i = 0; i < csb->csb_n_stream; i++)
+		{
+			if (i != stream && (csb->csb_rpt[i].csb_flags & csb_active))
+				return false;
+		}
+
+		const auto attachment = tdbb->getAttachment();
+		if (!attachment || attachment->att_parallel_workers <= 1)
+			return false;
+
+		if (csb->csb_g_flags & (csb_pre_trigger | csb_post_trigger | csb_validation | csb_computed_field))
+			return false;
+
+		if (rse && (rse->hasWriteLock() || rse->hasSkipLocked()))
+			return false;
+
+		const auto tail = &csb->csb_rpt[stream];
+		const auto relation = tail->csb_relation;
+
+		if (tail->csb_flags & (csb_view_update | csb_trigger | csb_store | csb_modify |
+							   csb_erase | csb_update | csb_skip_locked))
+		{
+			return false;
+		}
+
+		if (relation()->isSystem() || relation()->isTemporary())
+			return false;
+
+		return tail->csb_cardinality >= MIN_PARALLEL_SCAN_CARDINALITY;
+	}
+
+
+	// Return statistics of the column referenced by the node, if any
+
+	const ColumnStatistics* getColumnStatistics(const CompilerScratch* csb, const ValueExprNode* node)
+	{
+		const auto fieldNode = nodeAs<FieldNode>(node);
+
+		if (!fieldNode)
+			return nullptr;
+
+		const auto statistics = csb->csb_rpt[fieldNode->fieldStream].csb_statistics;
+		return statistics ? statistics->find(fieldNode->fieldId) : nullptr;
+	}
+
+	const dsc* getLiteralValue(const ValueExprNode* node)
+	{
+		const auto literal = nodeAs<LiteralNode>(node);
+		return (literal && !literal->litDesc.isNull()) ? &literal->litDesc : nullptr;
+	}
+
+	double getComparativeSelectivity(thread_db* tdbb, const CompilerScratch* csb, const ComparativeBoolNode* cmpNode)
+	{
+		auto blrOp = cmpNode->blrOp;
+		const ValueExprNode* field = cmpNode->arg1;
+		const ValueExprNode* value = cmpNode->arg2;
+
+		auto column = getColumnStatistics(csb, field);
+
+		if (!column && blrOp != blr_between)
+		{
+			// Try the mirrored comparison
+			column = getColumnStatistics(csb, value);
+			std::swap(field, value);
+
+			switch (blrOp)
+			{
+				case blr_lss:
+					blrOp = blr_gtr;
+					break;
+
+				case blr_leq:
+					blrOp = blr_geq;
+					break;
+
+				case blr_gtr:
+					blrOp = blr_lss;
+					break;
+
+				case blr_geq:
+					blrOp = blr_leq;
+					break;
+			}
+		}
+
+		if (!column)
+			return 0;
+
+		const auto stream = nodeAs<FieldNode>(field)->fieldStream;
+		const auto literal = getLiteralValue(value);
+
+		switch (blrOp)
+		{
+			case blr_eql:
+			case blr_equiv:
+				if (literal)
+					return column->getEqualitySelectivity(tdbb, literal);
+
+				// Values depending on the same stream are not estimated
+				if (value->containsStream(stream))
+					return 0;
+
+				if (const auto other = getColumnStatistics(csb, value))
+					return column->getJoinSelectivity(*other);
+
+				return column->getAverageSelectivity();
+
+			case blr_lss:
+			case blr_leq:
+				return literal ? column->getRangeSelectivity(tdbb, nullptr, false, literal, blrOp == blr_leq) : 0;
+
+			case blr_gtr:
+			case blr_geq:
+				return literal ? column->getRangeSelectivity(tdbb, literal, blrOp == blr_geq, nullptr, false) : 0;
+
+			case blr_between:
+			{
+				const auto upper = getLiteralValue(cmpNode->arg3);
+				return (literal && upper) ? column->getRangeSelectivity(tdbb, literal, true, upper, true) : 0;
+			}
+		}
+
+		return 0;
+	}
+
+	// Estimate the boolean selectivity using the column statistics.
+	// If it cannot be done, the default reduction factors remain in use.
+
+	void applyColumnStatistics(thread_db* tdbb, const CompilerScratch* csb, BoolExprNode* node)
+	{
+		double selectivity = 0;
+
+		try
+		{
+			if (const auto missingNode = nodeAs<MissingBoolNode>(node))
+			{
+				if (const auto column = getColumnStatistics(csb, missingNode->arg))
+					selectivity = column->getNullSelectivity();
+			}
+			else if (const auto listNode = nodeAs<InListBoolNode>(node))
+			{
+				if (const auto column = getColumnStatistics(csb, listNode->arg))
+				{
+					for (const auto item : listNode->list->items)
+					{
+						const auto literal = getLiteralValue(item);
+
+						selectivity += literal ?
+							column->getEqualitySelectivity(tdbb, literal) :
+							column->getAverageSelectivity();
+					}
+				}
+			}
+			else if (const auto cmpNode = nodeAs<ComparativeBoolNode>(node))
+				selectivity = getComparativeSelectivity(tdbb, csb, cmpNode);
+		}
+		catch (const Exception&)
+		{
+			// Values not comparable with the column are left to the default estimation
+			tdbb->tdbb_status_vector->init();
+			selectivity = 0;
+		}
+
+		node->estimatedSelectivity = MIN(selectivity, MAXIMUM_SELECTIVITY);
+	}
+
+
+	// Check whether the index scan alone finds exactly the records matching the
+	// comparison of the indexed column with a value, i.e. the index key keeps the
+	// column value as is and the value is converted to the key without rounding
+
+	bool isExactIndexMatch(thread_db* tdbb, CompilerScratch* csb, const index_desc* idx,
+		FieldNode* field, ValueExprNode* value)
+	{
+		if (value->containsStream(field->fieldStream))
+			return false;
+
+		dsc fieldDesc, valueDesc;
+		field->getDesc(tdbb, csb, &fieldDesc);
+		value->getDesc(tdbb, csb, &valueDesc);
+
+		switch (idx->idx_rpt[0].idx_itype)
+		{
+			case idx_numeric:
+			case idx_numeric2:
+			{
+				// Double keys are exact for 32-bit integers only
+				const bool allowBig = (idx->idx_rpt[0].idx_itype == idx_numeric2);
+
+				const auto isExact = [allowBig](const dsc& desc)
+				{
+					return desc.dsc_dtype == dtype_short || desc.dsc_dtype == dtype_long ||
+						(allowBig && desc.dsc_dtype == dtype_int64);
+				};
+
+				return isExact(fieldDesc) && isExact(valueDesc) &&
+					valueDesc.dsc_scale == fieldDesc.dsc_scale;
+			}
+
+			case idx_sql_date:
+			case idx_sql_time:
+			case idx_timestamp:
+			case idx_boolean:
+				return valueDesc.dsc_dtype == fieldDesc.dsc_dtype;
+		}
+
+		return false;
+	}
+
+	// Check whether the boolean compares the indexed column with one of the bounds
+	// the index is scanned with, so the scan evaluates it exactly
+
+	bool matchIndexOnly(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
+		const IndexRetrieval* retrieval, BoolExprNode* boolean, SortedArray<const FieldNode*>& fields)
+	{
+		const auto cmpNode = nodeAs<ComparativeBoolNode>(boolean);
+
+		if (!cmpNode || cmpNode->dsqlFlag != ComparativeBoolNode::DFLAG_NONE)
+			return false;
+
+		const auto idx = &retrieval->irb_desc;
+		fb_assert(idx->idx_count == 1);
+
+		const auto isIndexed = [stream, idx](const FieldNode* field)
+		{
+			return field && field->fieldStream == stream && field->fieldId == idx->idx_rpt[0].idx_field;
+		};
+
+		auto field = nodeAs<FieldNode>(cmpNode->arg1);
+		ValueExprNode* value = cmpNode->arg2;
+		bool forward = true;
+
+		if (!isIndexed(field) && cmpNode->blrOp != blr_between)
+		{
+			field = nodeAs<FieldNode>(cmpNode->arg2);
+			value = cmpNode->arg1;
+			forward = false;
+		}
+
+		if (!isIndexed(field) || !isExactIndexMatch(tdbb, csb, idx, field, value))
+			return false;
+
+		ValueExprNode* lower = nullptr;
+		ValueExprNode* upper = nullptr;
+
+		switch (cmpNode->blrOp)
+		{
+			case blr_eql:
+				lower = upper = value;
+				break;
+
+			case blr_gtr:
+			case blr_geq:
+				(forward ? lower : upper) = value;
+				break;
+
+			case blr_lss:
+			case blr_leq:
+				(forward ? upper : lower) = value;
+				break;
+
+			case blr_between:
+				if (!isExactIndexMatch(tdbb, csb, idx, field, cmpNode->arg3))
+					return false;
+				lower = value;
+				upper = cmpNode->arg3;
+				break;
+
+			default:
+				return false;
+		}
+
+		// Weaker conditions of the same column are also matched to the index,
+		// but the scan is limited by the strongest ones only
+
+		if ((lower && (!retrieval->irb_lower_count || retrieval->irb_value[0] != lower)) ||
+			(upper && (!retrieval->irb_upper_count || retrieval->irb_value[1] != upper)))
+		{
+			return false;
+		}
+
+		if (!fields.exist(field))
+			fields.add(field);
+
+		return true;
+	}
 } // namespace
 
 
@@ -659,6 +961,9 @@ Optimizer::~Optimizer()
 	{
 		delete csb->csb_rpt[compileStream].csb_idx;
 		csb->csb_rpt[compileStream].csb_idx = nullptr;
+
+		delete csb->csb_rpt[compileStream].csb_statistics;
+		csb->csb_rpt[compileStream].csb_statistics = nullptr;
 	}
 
 	if (debugFile)
@@ -677,6 +982,10 @@ RecordSource* Optimizer::compile(RseNode* subRse, BoolExprNodeStack* parentStack
 	const bool subFirstRows = firstRows && !rse->rse_sorted && !rse->rse_aggregate;
 
 	Optimizer subOpt(tdbb, csb, subRse, subFirstRows);
+
+	// The only sub-stream is read as many times as we are
+	subOpt.readOnce = readOnce && !subRse->isLateral() && rse->rse_relations.getCount() == 1;
+
 	const auto rsb = subOpt.compile(parentStack);
 
 	if (parentStack && !subRse->isFullJoin())
@@ -856,6 +1165,10 @@ RecordSource* Optimizer::compile(BoolExprNodeStack* parentStack)
 		conjunctCount++;
 	}
 
+	// Estimate selectivities of the conjunctions using the column statistics
+	for (auto iter = getConjuncts(); iter.hasData(); ++iter)
+		applyColumnStatistics(tdbb, csb, iter);
+
 	// Clear the csb_active flag of all streams in the RseNode
 	StreamList rseStreams;
 	rse->computeRseStreams(rseStreams);
@@ -1137,6 +1450,17 @@ RecordSource* Optimizer::compile(BoolExprNodeStack* parentStack)
 
 	checkIndices();
 
+	// Grouping by hashing doesn't need the sort. If the index navigation
+	// has been chosen instead, let the caller know the input is ordered.
+
+	if (rse->flags & RseNode::FLAG_HASH_GROUP)
+	{
+		if (sort && sort == rse->rse_sorted)
+			sort = nullptr;
+		else
+			rse->flags &= ~RseNode::FLAG_HASH_GROUP;
+	}
+
 	if (project || sort)
 	{
 		// Eliminate any duplicate dbkey streams
@@ -1151,9 +1475,25 @@ RecordSource* Optimizer::compile(BoolExprNodeStack* parentStack)
 		if (project)
 			rsb = generateSort(bedStreams, &keyStreams, rsb, project, favorFirstRows(), true);
 
-		// Handle sort clause if present
+		// Handle sort clause if present. If only a few first records are
+		// to be fetched and the limits may be re-evaluated safely, let the
+		// sort keep just those records.
+
 		if (sort)
-			rsb = generateSort(bedStreams, &keyStreams, rsb, sort, favorFirstRows(), false);
+		{
+			const auto sortedStream =
+				generateSort(bedStreams, &keyStreams, rsb, sort, favorFirstRows(), false);
+
+			const auto isSimpleLimit = [](const ValueExprNode* node)
+			{
+				return !node || nodeIs<LiteralNode>(node) || nodeIs<ParameterNode>(node);
+			};
+
+			if (rse->rse_first && isSimpleLimit(rse->rse_first) && isSimpleLimit(rse->rse_skip))
+				sortedStream->setLimit(rse->rse_first, rse->rse_skip);
+
+			rsb = sortedStream;
+		}
 	}
 
 	// Add invariant booleans, if any. They should be evaluated before
@@ -1346,6 +1686,19 @@ void Optimizer::compileRelation(StreamType stream)
 		if (tail->csb_plan)
 			markIndices(tail, relation()->getId());
 	}
+
+	tail->csb_statistics = nullptr;
+
+	if ((needIndices || rse->rse_boolean) && !(csb->csb_g_flags & csb_internal) &&
+		!relation()->isSystem() && !relation()->isVirtual() && !relation()->getExtFile() &&
+		!relation()->isTemporary() && !relation()->isLTT())
+	{
+		AutoPtr<ColumnStatisticsList> statistics(FB_NEW_POOL(getPool()) ColumnStatisticsList(getPool()));
+		MET_get_column_statistics(tdbb, relation(tdbb), *statistics);
+
+		if (statistics->hasData())
+			tail->csb_statistics = statistics.release();
+	}
 }
 
 
@@ -1766,8 +2119,17 @@ SortedStream* Optimizer::generateSort(const StreamList& streams,
 		map->flags |= SortedStream::FLAG_PROJECT;
 
 	if (refetchFlag)
+	{
 		map->flags |= SortedStream::FLAG_REFETCH;
 
+		// Records are fetched again after sorting
+		for (const auto stream : streams)
+		{
+			csb->csb_rpt[stream].csb_data_refs++;
+			csb->csb_rpt[stream].csb_record_refs++;
+		}
+	}
+
 	if (sort->unique)
 		map->flags |= SortedStream::FLAG_UNIQUE;
 
@@ -1942,7 +2304,6 @@ SortedStream* Optimizer::generateSort(const StreamList& streams,
 		{
 			sortKey.skd_vary_offset = map_length;
 			map_length += sizeof(USHORT);
-			map->flags |= SortedStream::FLAG_KEY_VARY;
 		}
 	}
 
@@ -2024,6 +2385,119 @@ void Optimizer::checkIndices()
 }
 
 
+//
+// Check whether the index scan alone is able to find records of the stream,
+// i.e. the booleans are evaluated exactly by the index keys and nothing else
+// accesses the record data
+//
+
+bool Optimizer::checkIndexOnly(StreamType stream, const InversionNode* inversion,
+	const BooleanList& booleans)
+{
+	const auto tail = &csb->csb_rpt[stream];
+	const auto relation = tail->csb_relation();
+
+	if (relation->isSystem() || relation->isTemporary() ||
+		(tail->csb_flags & csb_update) ||
+		(rse && (rse->hasWriteLock() || rse->hasSkipLocked())))
+	{
+		return false;
+	}
+
+	if (inversion->type != InversionNode::TYPE_INDEX)
+		return false;
+
+	const auto retrieval = inversion->retrieval;
+	const auto idx = &retrieval->irb_desc;
+
+	// NULL keys must be skipped by the scan itself
+
+	if (idx->idx_count != 1 || (idx->idx_flags & (idx_descending | idx_expression | idx_condition)) ||
+		retrieval->irb_list || (retrieval->irb_generic & (irb_starting | irb_multi_starting)) ||
+		!(retrieval->irb_generic & irb_ignore_null_value_key))
+	{
+		return false;
+	}
+
+	SortedArray<const FieldNode*> fields;
+
+	for (const auto boolean : booleans)
+	{
+		if (!matchIndexOnly(tdbb, csb, stream, retrieval, boolean, fields))
+			return false;
+	}
+
+	// Other conjuncts may share the field nodes with the matched ones
+
+	for (auto iter = getConjuncts(); iter.hasData(); ++iter)
+	{
+		if (iter->containsStream(stream) && !booleans.exist(*iter))
+			return false;
+	}
+
+	// Every reference to the record data must be among the matched booleans
+
+	if (tail->csb_data_refs != fields.getCount())
+		return false;
+
+	tail->csb_data_refs = 0;
+	tail->csb_flags |= csb_index_only;
+
+	delete tail->csb_fields;
+	tail->csb_fields = nullptr;
+
+	return true;
+}
+
+
+//
+// Check whether records of the stream may be built of the index payload,
+// i.e. all the referenced fields are among the index columns
+//
+
+bool Optimizer::checkIndexPayload(StreamType stream, const InversionNode* inversion)
+{
+	const auto tail = &csb->csb_rpt[stream];
+	const auto relation = tail->csb_relation();
+
+	if (relation->isSystem() || relation->isTemporary() ||
+		(tail->csb_flags & csb_update) || tail->csb_record_refs || !tail->csb_fields ||
+		(rse && (rse->hasWriteLock() || rse->hasSkipLocked())))
+	{
+		return false;
+	}
+
+	if (inversion->type != InversionNode::TYPE_INDEX)
+		return false;
+
+	const auto idx = &inversion->retrieval->irb_desc;
+
+	if (!idx->idx_includes || (idx->idx_flags & idx_expression))
+		return false;
+
+	UInt32Bitmap::Accessor accessor(tail->csb_fields);
+
+	if (accessor.getFirst())
+	{
+		do
+		{
+			const auto id = accessor.current();
+			bool found = false;
+
+			for (USHORT i = 0; i < idx->idx_count + idx->idx_includes && !found; i++)
+				found = (idx->idx_rpt[i].idx_field == id);
+
+			if (!found)
+				return false;
+		} while (accessor.getNext());
+	}
+
+	tail->csb_flags |= csb_index_payload;
+
+	return true;
+}
+
+
 //
 // Try to optimize out unnecessary sorting
 //
@@ -2077,6 +2551,7 @@ void Optimizer::checkSorts()
 			{
 				setDirection(project, group);
 				project = rse->rse_projection = nullptr;
+				aggregate->orderedGroup = true;
 			}
 		}
 
@@ -2107,6 +2582,7 @@ void Optimizer::checkSorts()
 				setDirection(sort, group);
 				setPosition(sort, group, map);
 				sort = rse->rse_sorted = nullptr;
+				aggregate->orderedGroup = true;
 			}
 		}
 	}
@@ -2836,7 +3312,7 @@ bool Optimizer::generateEquiJoin(RiverList& rivers, JoinType joinType)
 	RiverList joinedRivers;
 	HalfStaticArray<NestValueArray*, OPT_STATIC_ITEMS> keys;
 	unsigned position = 0, maxCardinalityPosition = 0, lowestPosition = MAX_ULONG;
-	double maxCardinality1 = 0, maxCardinality2 = 0;
+	double maxCardinality = 0;
 
 	for (auto iter = orgRivers.begin(); iter < orgRivers.end(); position++)
 	{
@@ -2858,14 +3334,11 @@ bool Optimizer::generateEquiJoin(RiverList& rivers, JoinType joinType)
 		const auto* rsb = river->getRecordSource();
 		const auto cardinality = rsb->getCardinality();
 
-		if (cardinality > maxCardinality1)
+		if (cardinality > maxCardinality)
 		{
-			maxCardinality2 = maxCardinality1;
-			maxCardinality1 = cardinality;
+			maxCardinality = cardinality;
 			maxCardinalityPosition = joinedRivers.getCount();
 		}
-		else if (cardinality > maxCardinality2)
-			maxCardinality2 = cardinality;
 
 		streams.join(river->getStreams());
 		joinedRivers.add(river);
@@ -2879,66 +3352,32 @@ bool Optimizer::generateEquiJoin(RiverList& rivers, JoinType joinType)
 			keys.back()->add(eq_class[position]);
 	}
 
-	const bool hashOverflow = (maxCardinality2 > HashJoin::maxCapacity());
-
-	// If any of to-be-hashed rivers is too large to be hashed efficiently,
-	// then prefer a merge join instead of a hash join.
-
-	const bool useMergeJoin = hashOverflow && (joinType == JoinType::INNER);
-
 	// Build a join stream
 
 	HalfStaticArray<RecordSource*, OPT_STATIC_ITEMS> rsbs;
-	RecordSource* finalRsb = nullptr;
 
-	// MERGE JOIN does not support other join types yet
-	if (useMergeJoin && joinType == JoinType::INNER)
+	if (joinType == JoinType::INNER)
 	{
-		position = 0;
-		for (const auto river : joinedRivers)
-		{
-			const auto sort = FB_NEW_POOL(getPool()) SortNode(getPool());
-
-			for (const auto key : *keys[position++])
-			{
-				fb_assert(river->isReferenced(key));
-
-				sort->direction.add(ORDER_ASC);	// ascending sort
-				sort->nullOrder.add(NULLS_DEFAULT);	// default nulls placement
-				sort->expressions.add(key);
-			}
+		// Ensure that the largest river is placed at the first position.
+		// It's important for a hash join to be efficient.
 
-			const auto rsb = generateSort(river->getStreams(), nullptr,
-				river->getRecordSource(), sort, favorFirstRows(), false);
+		const auto maxCardinalityRiver = joinedRivers[maxCardinalityPosition];
+		joinedRivers[maxCardinalityPosition] = joinedRivers[0];
+		joinedRivers[0] = maxCardinalityRiver;
 
-			rsbs.add(rsb);
-		}
-
-		finalRsb = FB_NEW_POOL(getPool())
-			MergeJoin(csb, rsbs.getCount(), (SortedStream**) rsbs.begin(), keys.begin());
+		const auto maxCardinalityKey = keys[maxCardinalityPosition];
+		keys[maxCardinalityPosition] = keys[0];
+		keys[0] = maxCardinalityKey;
 	}
-	else
-	{
-		if (joinType == JoinType::INNER)
-		{
-			// Ensure that the largest river is placed at the first position.
-			// It's important for a hash join to be efficient.
 
-			const auto maxCardinalityRiver = joinedRivers[maxCardinalityPosition];
-			joinedRivers[maxCardinalityPosition] = joinedRivers[0];
-			joinedRivers[0] = maxCardinalityRiver;
-
-			const auto maxCardinalityKey = keys[maxCardinalityPosition];
-			keys[maxCardinalityPosition] = keys[0];
-			keys[0] = maxCardinalityKey;
-		}
+	for (const auto river : joinedRivers)
+		rsbs.add(river->getRecordSource());
 
-		for (const auto river : joinedRivers)
-			rsbs.add(river->getRecordSource());
+	// Hash join spills its hash table into the temporary space if the inner rivers
+	// are too large for memory, so it's used regardless of their cardinality
 
-		finalRsb = FB_NEW_POOL(getPool())
-			HashJoin(tdbb, csb, joinType, rsbs.getCount(), rsbs.begin(), keys.begin());
-	}
+	RecordSource* finalRsb = FB_NEW_POOL(getPool())
+		HashJoin(tdbb, csb, joinType, rsbs.getCount(), rsbs.begin(), keys.begin());
 
 	// Pick up any boolean that may apply
 	finalRsb = applyLocalBoolean(finalRsb, streams, iter);
@@ -3094,6 +3533,9 @@ RecordSource* Optimizer::generateRetrieval(StreamType stream,
 
 			navigation->setInversion(inversion, condition);
 
+			if (!outerFlag && checkIndexPayload(stream, navigation->getIndex()))
+				navigation->setPayload();
+
 			rsb = navigation;
 		}
 	}
@@ -3111,8 +3553,10 @@ RecordSource* Optimizer::generateRetrieval(StreamType stream,
 	// booleans.  When one is found, roll it into a final boolean and mark
 	// it used. If a computable boolean didn't match against an index then
 	// mark the stream to denote unmatched booleans.
-	BooleanList filters;
+	BooleanList filters, matches;
 	BoolExprNode* boolean = nullptr;
+	unsigned booleanCount = 0;
+	bool allMatched = true;
 
 	for (auto iter = getConjuncts(outerFlag, innerFlag); iter.hasData(); ++iter)
 	{
@@ -3129,13 +3573,18 @@ RecordSource* Optimizer::generateRetrieval(StreamType stream,
 				(!inversion && iter->computable(csb, stream, true)))
 			{
 				compose(getPool(), &boolean, iter);
+				booleanCount++;
 				iter |= CONJUNCT_USED;
 
 				if (!(iter & CONJUNCT_MATCHED))
 				{
+					allMatched = false;
+
 					if (!outerFlag)
 						tail->csb_flags |= csb_unmatched;
 				}
+				else
+					matches.add(*iter);
 
 				if (!(iter & (CONJUNCT_MATCHED | CONJUNCT_JOINED)))
 					filters.add(*iter);
@@ -3159,11 +3608,64 @@ RecordSource* Optimizer::generateRetrieval(StreamType stream,
 
 			rsb = FB_NEW_POOL(getPool()) ConditionalStream(csb, rsb1, rsb2, condition);
 		}
+		else if (inversion && boolean && allMatched && !outerFlag &&
+			checkIndexOnly(stream, inversion, matches))
+		{
+			// The index scan evaluates the whole boolean, so it's rechecked
+			// only for the records being fetched
+
+			rsb = FB_NEW_POOL(getPool()) BitmapTableScan(csb, alias, stream, relation,
+				inversion, scanSelectivity, boolean);
+
+			boolean = nullptr;
+		}
+		else if (inversion && !outerFlag && checkIndexPayload(stream, inversion))
+		{
+			// The index payload contains all the fields being accessed, so
+			// walk the index to avoid fetching records of the visible pages
+
+			const auto idx = &inversion->retrieval->irb_desc;
+			const USHORT keyLength =
+				ROUNDUP(BTR_key_length(tdbb, relation(tdbb), idx), sizeof(SLONG));
+
+			const auto scan = FB_NEW_POOL(getPool()) IndexTableScan(csb, alias, stream, relation,
+				inversion, keyLength, scanSelectivity);
+			scan->setPayload();
+
+			rsb = scan;
+		}
 		else if (inversion)
 		{
 			rsb = FB_NEW_POOL(getPool()) BitmapTableScan(csb, alias, stream, relation,
 				inversion, scanSelectivity);
 		}
+		else if (dbkeyRanges.isEmpty() && useParallelScan(tdbb, csb, rse, readOnce, stream))
+		{
+			// The workers skip the records not matching the conditions they can
+			// evaluate, the filter still checks the whole boolean afterwards
+
+			BoolExprNode* workerBoolean = nullptr;
+			unsigned workerCount = 0;
+
+			for (const auto filter : filters)
+			{
+				if (isWorkerComputable(filter, stream))
+				{
+					compose(getPool(), &workerBoolean, filter);
+					workerCount++;
+				}
+			}
+
+			// The workers evaluate the whole boolean, so they may also
+			// aggregate the records, see ParallelTableScan::pushAggregates()
+			if (workerCount == booleanCount)
+				workerBoolean = boolean;
+
+			rsb = FB_NEW_POOL(getPool()) ParallelTableScan(csb, alias, stream, relation, workerBoolean);
+
+			if (boolean)
+				csb->csb_rpt[stream].csb_flags |= csb_unmatched;
+		}
 		else
 		{
 			rsb = FB_NEW_POOL(getPool()) FullTableScan(csb, alias, stream, relation, dbkeyRanges);
@@ -3177,6 +3679,43 @@ RecordSource* Optimizer::generateRetrieval(StreamType stream,
 }
 
 
+//
+// Check that the expression can be evaluated for a batch of the stream records without
+// the request, so the parallel scan workers could do that. It's true for comparisons
+// and arithmetics of the stream fields and literals, see executeBatch() of the nodes.
+//
+
+bool Optimizer::isWorkerComputable(const ExprNode* node, StreamType stream)
+{
+	if (const auto fieldNode = nodeAs<FieldNode>(node))
+		return fieldNode->fieldStream == stream && !fieldNode->cursorNumber.has_value();
+
+	if (nodeIs<LiteralNode>(node))
+		return true;
+
+	if (const auto binaryNode = nodeAs<BinaryBoolNode>(node))
+	{
+		return isWorkerComputable(binaryNode->arg1, stream) &&
+			isWorkerComputable(binaryNode->arg2, stream);
+	}
+
+	if (const auto cmpNode = nodeAs<ComparativeBoolNode>(node))
+	{
+		return !cmpNode->arg3 &&
+			isWorkerComputable(cmpNode->arg1, stream) &&
+			isWorkerComputable(cmpNode->arg2, stream);
+	}
+
+	if (const auto arithmeticNode = nodeAs<ArithmeticNode>(node))
+	{
+		return isWorkerComputable(arithmeticNode->arg1, stream) &&
+			isWorkerComputable(arithmeticNode->arg2, stream);
+	}
+
+	return false;
+}
+
+
 //
 // Compose a filter including all computable booleans
 //
@@ -69,6 +69,11 @@ inline constexpr double MINIMUM_CARDINALITY = 1.0;
 inline constexpr double THRESHOLD_CARDINALITY = 5.0;
 inline constexpr double DEFAULT_CARDINALITY = 1000.0;
 
+// Adaptive joins are used if the outer rows making hashing cheaper are
+// at most that many times more than estimated, but not too many anyway
+inline constexpr double ADAPTIVE_CARDINALITY_FACTOR = 1000.0;
+inline constexpr double MAXIMUM_ADAPTIVE_THRESHOLD = 100000.0;
+
 // Default depth of an index tree (including one leaf page),
 // also representing the minimal cost of the index scan.
 // We assume that the root page would be always cached,
@@ -392,6 +397,9 @@ public:
 
 	static double getSelectivity(const BoolExprNode* node)
 	{
+		if (node->estimatedSelectivity > 0)
+			return node->estimatedSelectivity;
+
 		auto factor = REDUCE_SELECTIVITY_FACTOR_OTHER;
 
 		if (const auto notNode = nodeAs<NotBoolNode>(node))
@@ -457,6 +465,7 @@ public:
 	}
 
 	static double estimateSelectivity(const BooleanList& filters, double cardinality = 0, unsigned priorConjuncts = 0);
+	static bool isWorkerComputable(const ExprNode* node, StreamType stream);
 
 	double getDependentSelectivity();
 
@@ -502,7 +511,9 @@ public:
 			firstRows = attachment->att_opt_first_rows.valueOr(defaultFirstRows);
 		}
 
-		return Optimizer(tdbb, csb, rse, firstRows).compile(nullptr);
+		Optimizer opt(tdbb, csb, rse, firstRows);
+		opt.readOnce = (rse->flags & RseNode::FLAG_READ_ONCE);
+		return opt.compile(nullptr);
 	}
 
 	~Optimizer();
@@ -595,6 +606,8 @@ private:
 	RecordSource* compile(BoolExprNodeStack* parentStack);
 
 	void checkIndices();
+	bool checkIndexOnly(StreamType stream, const InversionNode* inversion, const BooleanList& booleans);
+	bool checkIndexPayload(StreamType stream, const InversionNode* inversion);
 	void checkSorts();
 	unsigned distributeEqualities(BoolExprNodeStack& orgStack, unsigned baseCount);
 	void findDependentStreams(const RiverList& rivers,
@@ -628,6 +641,7 @@ private:
 	RseNode* const rse;
 
 	bool firstRows = false;					// optimize for first rows
+	bool readOnce = false;					// rse is opened once per execution of the statement
 	double cardinality = 0;					// self or parent cardinality
 
 	FILE* debugFile = nullptr;
@@ -936,11 +950,13 @@ class InnerJoin final : private Firebird::PermanentStorage
 		{
 			number = num;
 			selectivity = 0.0;
+			adaptiveThreshold = 0;
 			equiMatches.clear();
 		}
 
 		StreamType number;			// stream in position of join order
 		double selectivity = 0.0;	// position selectivity
+		ULONG adaptiveThreshold = 0;	// outer rows making hashing cheaper than nested loops
 		Firebird::Vector<BoolExprNode*, MAX_EQUI_MATCHES> equiMatches;
 	};
 
@@ -963,6 +979,9 @@ public:
 protected:
 	void calculateStreamInfo();
 	void estimateCost(unsigned position, const StreamInfo* stream, double& cost, double& cardinality);
+	RecordSource* generateAdaptiveJoin(const JoinedStreamInfo& stream, RecordSource* priorRsb,
+		const StreamList& priorStreams);
+	void makeHashKeys(const JoinedStreamInfo& stream, NestValueArray* priorKeys, NestValueArray* streamKeys);
 	void findBestOrder(unsigned position, StreamInfo* stream,
 		IndexedRelationships& processList, double cost, double cardinality);
 	void getIndexedRelationships(StreamInfo* testStream);
@@ -112,6 +112,32 @@ namespace
 		return false;
 	};
 
+	// Combine selectivities estimated for the segment matches using the column statistics.
+	// Zero is returned if some of the matches are not estimated.
+
+	double getEstimatedSelectivity(const BooleanList& matches, bool range)
+	{
+		if (matches.isEmpty())
+			return 0;
+
+		double result = MAXIMUM_SELECTIVITY;
+
+		for (const auto match : matches)
+		{
+			const auto selectivity = match->estimatedSelectivity;
+
+			if (selectivity <= 0)
+				return 0;
+
+			// Range bounds overlap, equalities are just the same condition
+			result = range ?
+				MAX(result + selectivity - MAXIMUM_SELECTIVITY, result * selectivity) :
+				MIN(result, selectivity);
+		}
+
+		return result;
+	}
+
 } // namespace
 
 
@@ -1025,6 +1051,21 @@ void Retrieval::getInversionCandidates(InversionCandidateList& inversions,
 				if (useDefaultSelectivity)
 					selectivity = MAX(scratch.selectivity * DEFAULT_SELECTIVITY, minSelectivity);
 
+				// The leading segment is better estimated by the column statistics, if any.
+				// The index selectivity is an average one and ignores the actual values.
+				double estimatedSelectivity = 0;
+
+				if (j == 0)
+				{
+					const bool range = (scanType == segmentScanBetween ||
+						scanType == segmentScanLess || scanType == segmentScanGreater);
+
+					estimatedSelectivity = getEstimatedSelectivity(segment.matches, range);
+
+					if (estimatedSelectivity)
+						estimatedSelectivity = MAX(estimatedSelectivity, minSelectivity);
+				}
+
 				if (scanType == segmentScanList)
 				{
 					if (listCount) // we cannot have more than one list matched to an index
@@ -1035,6 +1076,9 @@ void Retrieval::getInversionCandidates(InversionCandidateList& inversions,
 
 					listCount = list->getCount();
 					maxSelectivity = scratch.selectivity;
+
+					// The list items are accounted below
+					estimatedSelectivity /= listCount;
 				}
 
 				// Check if this is the last usable segment
@@ -1050,7 +1094,7 @@ void Retrieval::getInversionCandidates(InversionCandidateList& inversions,
 					scratch.nonFullMatchedSegments = idx->idx_count - (j + 1);
 					// Add matches for this segment to the main matches list
 					matches.join(segment.matches);
-					scratch.selectivity = selectivity;
+					scratch.selectivity = estimatedSelectivity ? estimatedSelectivity : selectivity;
 
 					// An equality scan for any unique index cannot retrieve more
 					// than one row. The same is true for an equivalence scan for
@@ -1128,7 +1172,8 @@ void Retrieval::getInversionCandidates(InversionCandidateList& inversions,
 						const double diffSelectivity = scratch.selectivity - selectivity;
 						selectivity += (diffSelectivity * factor);
 						fb_assert(selectivity <= scratch.selectivity);
-						scratch.selectivity = selectivity;
+						scratch.selectivity = estimatedSelectivity ?
+							MIN(estimatedSelectivity, scratch.selectivity) : selectivity;
 
 						scratch.nonFullMatchedSegments = idx->idx_count - j;
 						matches.join(segment.matches);
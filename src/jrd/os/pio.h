@@ -34,8 +34,14 @@
 #include "../common/classes/array.h"
 #include "../common/classes/File.h"
 
+namespace Ods {
+	struct pag;
+}
+
 namespace Jrd {
 
+class BufferDesc;
+
 #ifdef UNIX
 
 class jrd_file : public pool_alloc_rpt<SCHAR, type_fil>
@@ -80,6 +86,16 @@ inline constexpr USHORT FIL_sh_write		= 8;	// file opened in shared write mode
 inline constexpr USHORT FIL_no_fast_extend	= 16;	// file not supports fast extending
 inline constexpr USHORT FIL_raw_device		= 32;	// file is raw device
 
+// Page I/O request, used to read or write a number of pages at once,
+// see PIO_read_pages() and PIO_write_pages()
+
+struct PageIoRequest
+{
+	BufferDesc* bdb;		// buffer descriptor, defines page number
+	Ods::pag* page;			// page image to read into or write from
+	bool done;				// set when request completed successfully
+};
+
 // Physical IO trace events
 
 inline constexpr SSHORT trace_create	= 1;
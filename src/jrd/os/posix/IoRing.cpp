@@ -0,0 +1,349 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		IoRing.cpp
+ *	DESCRIPTION:	Linux io_uring based batched physical I/O
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created for the Firebird Open Source RDBMS project.
+ *
+ *  Copyright (c) 2026 the Firebird Project and all contributors signed below.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ *
+ */
+
+#include "firebird.h"
+#include "../jrd/os/posix/IoRing.h"
+
+#ifdef HAVE_LINUX_IO_URING_H
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <atomic>
+
+#include "../common/gdsassert.h"
+#include "../common/os/os_utils.h"
+
+using namespace Jrd;
+
+namespace
+{
+	// Set when the kernel refused to create a ring, no need to retry in other threads
+	std::atomic<bool> ringUnsupported(false);
+
+	class ThreadRing
+	{
+	public:
+		~ThreadRing()
+		{
+			delete ring;
+		}
+
+		IoRing* ring = nullptr;
+		bool failed = false;
+	};
+
+	thread_local ThreadRing threadRing;
+
+	inline unsigned loadAcquire(const unsigned* p)
+	{
+		return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+	}
+
+	inline void storeRelease(unsigned* p, unsigned value)
+	{
+		__atomic_store_n(p, value, __ATOMIC_RELEASE);
+	}
+}
+
+
+IoRing* IoRing::getThreadRing()
+{
+	if (threadRing.ring)
+		return threadRing.ring->m_broken ? nullptr : threadRing.ring;
+
+	if (threadRing.failed || ringUnsupported.load(std::memory_order_relaxed))
+		return nullptr;
+
+	IoRing* const ring = FB_NEW IoRing;
+
+	if (!ring->init(RING_ENTRIES))
+	{
+		delete ring;
+		threadRing.failed = true;
+		return nullptr;
+	}
+
+	threadRing.ring = ring;
+	return ring;
+}
+
+
+IoRing::~IoRing()
+{
+	if (m_sqes)
+		munmap(m_sqes, m_sqesSize);
+
+	if (m_cqMemory && m_cqMemory != m_sqMemory)
+		munmap(m_cqMemory, m_cqSize);
+
+	if (m_sqMemory)
+		munmap(m_sqMemory, m_sqSize);
+
+	if (m_fd >= 0)
+		close(m_fd);
+}
+
+
+bool IoRing::init(unsigned entries)
+{
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	m_fd = syscall(__NR_io_uring_setup, entries, &params);
+	if (m_fd < 0)
+	{
+		if (errno == ENOSYS || errno == EPERM || errno == EACCES)
+			ringUnsupported = true;
+
+		return false;
+	}
+
+	os_utils::setCloseOnExec(m_fd);
+
+	m_entries = params.sq_entries;
+
+	m_sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	m_cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+	const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP);
+	if (singleMmap)
+		m_sqSize = m_cqSize = MAX(m_sqSize, m_cqSize);
+
+	m_sqMemory = mmap(nullptr, m_sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		m_fd, IORING_OFF_SQ_RING);
+
+	if (m_sqMemory == MAP_FAILED)
+	{
+		m_sqMemory = nullptr;
+		return false;
+	}
+
+	if (singleMmap)
+		m_cqMemory = m_sqMemory;
+	else
+	{
+		m_cqMemory = mmap(nullptr, m_cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			m_fd, IORING_OFF_CQ_RING);
+
+		if (m_cqMemory == MAP_FAILED)
+		{
+			m_cqMemory = nullptr;
+			return false;
+		}
+	}
+
+	m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* const sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		m_fd, IORING_OFF_SQES);
+
+	if (sqes == MAP_FAILED)
+		return false;
+
+	m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+	UCHAR* const sq = static_cast<UCHAR*>(m_sqMemory);
+	m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	m_sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+	UCHAR* const cq = static_cast<UCHAR*>(m_cqMemory);
+	m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	m_cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+	return true;
+}
+
+
+int IoRing::enter(unsigned toSubmit, unsigned minComplete)
+{
+	const unsigned flags = minComplete ? IORING_ENTER_GETEVENTS : 0;
+	const int rc = syscall(__NR_io_uring_enter, m_fd, toSubmit, minComplete, flags, nullptr, 0);
+	return (rc < 0) ? -errno : rc;
+}
+
+
+void IoRing::prepare(const Request& request, ULONG tag)
+{
+	const unsigned tail = *m_sqTail;
+	const unsigned index = tail & *m_sqMask;
+
+	io_uring_sqe* const sqe = &m_sqes[index];
+	memset(sqe, 0, sizeof(io_uring_sqe));
+
+	switch (request.op)
+	{
+	case OP_READ:
+		sqe->opcode = IORING_OP_READV;
+		break;
+
+	case OP_WRITE:
+		sqe->opcode = IORING_OP_WRITEV;
+		break;
+
+	case OP_FSYNC:
+		sqe->opcode = IORING_OP_FSYNC;
+		break;
+	}
+
+	sqe->fd = request.fd;
+
+	if (request.op != OP_FSYNC)
+	{
+		sqe->addr = (U_IPTR) request.iov;
+		sqe->len = request.iovCount;
+		sqe->off = request.offset;
+	}
+
+	sqe->user_data = tag;
+
+	m_sqArray[index] = index;
+	storeRelease(m_sqTail, tail + 1);
+}
+
+
+unsigned IoRing::reap(Request* requests, unsigned count)
+{
+	unsigned head = *m_cqHead;
+	const unsigned tail = loadAcquire(m_cqTail);
+	unsigned reaped = 0;
+
+	for (; head != tail; ++head, ++reaped)
+	{
+		const io_uring_cqe* const cqe = &m_cqes[head & *m_cqMask];
+
+		// All requests of the previous call are completed before it returns,
+		// thus the tag always belongs to the current batch
+		fb_assert(cqe->user_data < count);
+
+		if (cqe->user_data < count)
+			requests[cqe->user_data].result = cqe->res;
+	}
+
+	storeRelease(m_cqHead, head);
+
+	fb_assert(m_inFlight >= reaped);
+	m_inFlight -= reaped;
+
+	return reaped;
+}
+
+
+unsigned IoRing::drain(Request* requests, unsigned count)
+{
+	// The kernel may still access the buffers of the submitted requests,
+	// so never return to the caller before all of them are completed
+
+	unsigned completed = reap(requests, count);
+	bool canWait = true;
+
+	while (m_inFlight)
+	{
+		if (canWait)
+		{
+			const int rc = enter(0, 1);
+
+			if (rc < 0 && rc != -EINTR && rc != -EAGAIN && rc != -EBUSY)
+			{
+				// Ring can't be waited on, don't use it anymore. Completions
+				// are still posted by the kernel, poll for them.
+				m_broken = true;
+				canWait = false;
+			}
+		}
+		else
+			usleep(1000);
+
+		completed += reap(requests, count);
+	}
+
+	return completed;
+}
+
+
+void IoRing::execute(Request* requests, unsigned count)
+{
+	unsigned prepared = 0, completed = 0, pending = 0;
+
+	while (completed < count)
+	{
+		// Fill the submission queue as much as possible
+
+		while (prepared < count && m_inFlight + pending < m_entries)
+		{
+			prepare(requests[prepared], prepared);
+			++prepared;
+			++pending;
+		}
+
+		const int rc = enter(pending, 1);
+
+		if (rc >= 0)
+		{
+			fb_assert((unsigned) rc <= pending);
+			pending -= rc;
+			m_inFlight += rc;
+		}
+		else if (rc != -EINTR && rc != -EAGAIN && rc != -EBUSY)
+		{
+			// Submission failed, kernel didn't consume queued entries. Take them back
+			// and report the error for every request that was not submitted.
+
+			if (pending)
+			{
+				storeRelease(m_sqTail, loadAcquire(m_sqHead));
+				prepared -= pending;
+				pending = 0;
+			}
+
+			for (unsigned i = prepared; i < count; i++)
+			{
+				requests[i].result = rc;
+				++completed;
+			}
+
+			prepared = count;
+
+			// Wait for the requests that are already running and stop
+			// using the ring, the caller falls back to the system calls
+
+			completed += drain(requests, count);
+			m_broken = true;
+			break;
+		}
+
+		completed += reap(requests, count);
+	}
+
+	fb_assert(!pending && !m_inFlight);
+}
+
+#endif // HAVE_LINUX_IO_URING_H
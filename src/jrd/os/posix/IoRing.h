@@ -0,0 +1,117 @@
+/*
+ *	PROGRAM:	JRD Access Method
+ *	MODULE:		IoRing.h
+ *	DESCRIPTION:	Linux io_uring based batched physical I/O
+ *
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created for the Firebird Open Source RDBMS project.
+ *
+ *  Copyright (c) 2026 the Firebird Project and all contributors signed below.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ *
+ */
+
+#ifndef JRD_OS_POSIX_IO_RING_H
+#define JRD_OS_POSIX_IO_RING_H
+
+#include "firebird.h"
+
+#ifdef HAVE_LINUX_IO_URING_H
+
+#include <sys/uio.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace Jrd {
+
+// Minimal wrapper around the io_uring interface. No liburing is required,
+// the ring is set up and driven with raw system calls.
+//
+// Every thread gets its own ring, so a caller can keep a whole batch of
+// requests in flight without any synchronization with other threads.
+// If the kernel doesn't support io_uring (or it's forbidden by the seccomp
+// policy) getThreadRing() returns NULL and caller should fall back to the
+// usual synchronous system calls.
+
+class IoRing
+{
+public:
+	enum Operation : UCHAR
+	{
+		OP_READ,
+		OP_WRITE,
+		OP_FSYNC
+	};
+
+	struct Request
+	{
+		int fd;
+		Operation op;
+		const iovec* iov;		// not used by OP_FSYNC
+		unsigned iovCount;
+		FB_UINT64 offset;
+		SINT64 result;			// bytes transferred or -errno
+	};
+
+	static constexpr unsigned RING_ENTRIES = 64;
+
+	~IoRing();
+
+	// Returns ring bound to the current thread, creating it on demand
+	static IoRing* getThreadRing();
+
+	// Submit all requests and wait for their completion.
+	// Result of every request is stored in its result field.
+	// It never returns while the kernel still works with any of them.
+	void execute(Request* requests, unsigned count);
+
+private:
+	IoRing() = default;
+
+	bool init(unsigned entries);
+	int enter(unsigned toSubmit, unsigned minComplete);
+	void prepare(const Request& request, ULONG tag);
+	unsigned reap(Request* requests, unsigned count);
+	unsigned drain(Request* requests, unsigned count);
+
+	int m_fd = -1;
+	unsigned m_entries = 0;
+	unsigned m_inFlight = 0;
+	bool m_broken = false;			// ring failed, requests can't be submitted anymore
+
+	void* m_sqMemory = nullptr;
+	size_t m_sqSize = 0;
+	void* m_cqMemory = nullptr;
+	size_t m_cqSize = 0;
+	io_uring_sqe* m_sqes = nullptr;
+	size_t m_sqesSize = 0;
+
+	unsigned* m_sqHead = nullptr;
+	unsigned* m_sqTail = nullptr;
+	unsigned* m_sqMask = nullptr;
+	unsigned* m_sqArray = nullptr;
+
+	unsigned* m_cqHead = nullptr;
+	unsigned* m_cqTail = nullptr;
+	unsigned* m_cqMask = nullptr;
+	io_uring_cqe* m_cqes = nullptr;
+};
+
+} // namespace Jrd
+
+#endif // HAVE_LINUX_IO_URING_H
+
+#endif // JRD_OS_POSIX_IO_RING_H
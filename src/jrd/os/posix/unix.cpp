@@ -76,6 +76,7 @@
 #include "../jrd/os/pio_proto.h"
 #include "../common/classes/init.h"
 #include "../common/os/os_utils.h"
+#include "../jrd/os/posix/IoRing.h"
 
 using namespace Jrd;
 using namespace Firebird;
@@ -90,6 +91,9 @@ using namespace Firebird;
 
 #define IO_RETRY	20
 
+// Max number of adjacent pages transferred by single vectored request
+#define MAX_IO_RUN	128
+
 #ifdef O_SYNC
 #define SYNC		O_SYNC
 #endif
@@ -148,6 +152,7 @@ static int  raw_devices_unlink_database (const PathName&);
 #endif
 static int	openFile(const Firebird::PathName&, const bool, const bool, const bool);
 static void	maybeCloseFile(int&);
+static ULONG batch_io(thread_db*, jrd_file*, PageIoRequest*, ULONG, const bool);
 
 
 void PIO_close(jrd_file* file)
@@ -803,6 +808,26 @@ bool PIO_read(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+ULONG PIO_read_pages(thread_db* tdbb, jrd_file* file, PageIoRequest* requests, ULONG count)
+{
+/**************************************
+ *
+ *	P I O _ r e a d _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read a set of pages at once. Return number of
+ *	successfully read pages, failed requests are
+ *	left not done and should be retried by caller
+ *	using PIO_read to get proper error reporting.
+ *
+ **************************************/
+
+	return batch_io(tdbb, file, requests, count, false);
+}
+
+
 bool PIO_write(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page, FbStatusVector* status_vector)
 {
 /**************************************
@@ -847,6 +872,183 @@ bool PIO_write(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+ULONG PIO_write_pages(thread_db* tdbb, jrd_file* file, PageIoRequest* requests, ULONG count)
+{
+/**************************************
+ *
+ *	P I O _ w r i t e _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write a set of pages at once, see also PIO_read_pages.
+ *
+ **************************************/
+
+	return batch_io(tdbb, file, requests, count, true);
+}
+
+
+static ULONG batch_io(thread_db* tdbb, jrd_file* file, PageIoRequest* requests, ULONG count,
+	const bool write)
+{
+/**************************************
+ *
+ *	b a t c h _ i o
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read or write a set of pages. Runs of adjacent pages are
+ *	transferred by a single vectored request. Use io_uring to
+ *	have all of them in flight at once, if possible. Otherwise
+ *	just issue preadv/pwritev one by one.
+ *
+ **************************************/
+	ULONG done = 0;
+
+	for (ULONG i = 0; i < count; i++)
+		requests[i].done = false;
+
+	if (!count || file->fil_desc == -1)
+		return 0;
+
+	Database* const dbb = tdbb->getDatabase();
+	const SLONG size = dbb->dbb_page_size;
+
+	EngineCheckout cout(tdbb, FB_FUNCTION, EngineCheckout::UNNECESSARY);
+
+	HalfStaticArray<iovec, MAX_IO_RUN> iovs;
+	iovec* const iov = iovs.getBuffer(count);
+
+	for (ULONG i = 0; i < count; i++)
+	{
+		iov[i].iov_base = requests[i].page;
+		iov[i].iov_len = size;
+	}
+
+	// Number of adjacent pages starting from the given request
+
+	const auto runLength = [requests, count](ULONG first, ULONG maxRun)
+	{
+		ULONG n = 1;
+		ULONG pageNum = requests[first].bdb->bdb_page.getPageNum();
+
+		while (first + n < count && n < maxRun &&
+			requests[first + n].bdb->bdb_page.getPageNum() == ++pageNum)
+		{
+			n++;
+		}
+
+		return n;
+	};
+
+#ifdef HAVE_LINUX_IO_URING_H
+	IoRing* const ring = (count > 1) ? IoRing::getThreadRing() : nullptr;
+
+	if (ring)
+	{
+		HalfStaticArray<IoRing::Request, IoRing::RING_ENTRIES> ioRequests;
+		HalfStaticArray<ULONG, IoRing::RING_ENTRIES> runStarts;
+
+		IoRing::Request* const ioRequest = ioRequests.getBuffer(count);
+		ULONG* const runStart = runStarts.getBuffer(count);
+		ULONG runs = 0;
+
+		for (ULONG first = 0; first < count; runs++)
+		{
+			const ULONG n = runLength(first, MAX_IO_RUN);
+
+			runStart[runs] = first;
+
+			ioRequest[runs].fd = file->fil_desc;
+			ioRequest[runs].op = write ? IoRing::OP_WRITE : IoRing::OP_READ;
+			ioRequest[runs].iov = &iov[first];
+			ioRequest[runs].iovCount = n;
+			ioRequest[runs].offset = (FB_UINT64) requests[first].bdb->bdb_page.getPageNum() * size;
+			ioRequest[runs].result = 0;
+
+			first += n;
+		}
+
+		ring->execute(ioRequest, runs);
+
+		for (ULONG run = 0; run < runs; run++)
+		{
+			// Short transfer leaves the tail of the run not done
+
+			if (ioRequest[run].result <= 0)
+				continue;
+
+			const ULONG pages = MIN((ULONG) ioRequest[run].result / size, ioRequest[run].iovCount);
+
+			for (ULONG i = runStart[run]; i < runStart[run] + pages; i++)
+				requests[i].done = true;
+
+			done += pages;
+		}
+
+		return done;
+	}
+#endif // HAVE_LINUX_IO_URING_H
+
+#if defined(HAVE_PREADV) && defined(HAVE_PWRITEV)
+	const ULONG maxRun = MAX_IO_RUN;
+#else
+	const ULONG maxRun = 1;
+#endif
+
+	for (ULONG first = 0; first < count; )
+	{
+		const ULONG n = runLength(first, maxRun);
+		const FB_UINT64 offset = (FB_UINT64) requests[first].bdb->bdb_page.getPageNum() * size;
+
+		if (offset == (FB_UINT64) LSEEK_OFFSET_CAST offset)
+		{
+			for (int i = 0; i < IO_RETRY; i++)
+			{
+				SINT64 bytes;
+
+#if defined(HAVE_PREADV) && defined(HAVE_PWRITEV)
+				if (n > 1)
+				{
+					bytes = write ?
+						os_utils::pwritev(file->fil_desc, &iov[first], n, LSEEK_OFFSET_CAST offset) :
+						os_utils::preadv(file->fil_desc, &iov[first], n, LSEEK_OFFSET_CAST offset);
+				}
+				else
+#endif
+				{
+					bytes = write ?
+						os_utils::pwrite(file->fil_desc, iov[first].iov_base, size, LSEEK_OFFSET_CAST offset) :
+						os_utils::pread(file->fil_desc, iov[first].iov_base, size, LSEEK_OFFSET_CAST offset);
+				}
+
+				if (bytes >= 0)
+				{
+					// Short transfer leaves the tail of the run not done
+
+					const ULONG pages = MIN((ULONG) (bytes / size), n);
+
+					for (ULONG j = first; j < first + pages; j++)
+						requests[j].done = true;
+
+					done += pages;
+					break;
+				}
+
+				if (!SYSCALL_INTERRUPTED(errno))
+					break;
+			}
+		}
+
+		first += n;
+	}
+
+	return done;
+}
+
+
 static bool seek_file(jrd_file* file, BufferDesc* bdb, FB_UINT64* offset,
 					  FbStatusVector* status_vector)
 {
@@ -572,6 +572,36 @@ bool PIO_read(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+ULONG PIO_read_pages(thread_db* tdbb, jrd_file* file, PageIoRequest* requests, ULONG count)
+{
+/**************************************
+ *
+ *	P I O _ r e a d _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Read a set of pages. There is no batched I/O
+ *	support here, pages are read one by one.
+ *	Return number of successfully read pages,
+ *	failed requests are left not done.
+ *
+ **************************************/
+	ULONG done = 0;
+
+	for (PageIoRequest* request = requests; request < requests + count; request++)
+	{
+		FbLocalStatus status;
+		request->done = PIO_read(tdbb, file, request->bdb, request->page, &status);
+
+		if (request->done)
+			done++;
+	}
+
+	return done;
+}
+
+
 #ifdef SUPERSERVER_V2
 bool PIO_read_ahead(thread_db*	tdbb,
 				   SLONG	start_page,
@@ -731,6 +761,33 @@ bool PIO_write(thread_db* tdbb, jrd_file* file, BufferDesc* bdb, Ods::pag* page,
 }
 
 
+ULONG PIO_write_pages(thread_db* tdbb, jrd_file* file, PageIoRequest* requests, ULONG count)
+{
+/**************************************
+ *
+ *	P I O _ w r i t e _ p a g e s
+ *
+ **************************************
+ *
+ * Functional description
+ *	Write a set of pages, see also PIO_read_pages.
+ *
+ **************************************/
+	ULONG done = 0;
+
+	for (PageIoRequest* request = requests; request < requests + count; request++)
+	{
+		FbLocalStatus status;
+		request->done = PIO_write(tdbb, file, request->bdb, request->page, &status);
+
+		if (request->done)
+			done++;
+	}
+
+	return done;
+}
+
+
 ULONG PIO_get_number_of_pages(const jrd_file* file, const USHORT pagesize)
 {
 /**************************************
@@ -1205,13 +1205,15 @@ void PAG_init(thread_db* tdbb)
 	dbb->dbb_max_records = Ods::maxRecsPerDP(dbb->dbb_page_size);
 	dbb->dbb_max_idx = Ods::maxIndices(dbb->dbb_page_size);
 
-	// Compute prefetch constants from database page size and maximum prefetch
-	// transfer size. Double pages per prefetch request so that cache reader
-	// can overlap prefetch I/O with database computation over previously prefetched pages.
-#ifdef SUPERSERVER_V2
-	dbb->dbb_prefetch_sequence = PREFETCH_MAX_TRANSFER / dbb->dbb_page_size;
-	dbb->dbb_prefetch_pages = dbb->dbb_prefetch_sequence * 2;
-#endif
+	// Compute read-ahead constants from database page size and configured
+	// read-ahead size. Next prefetch request is issued when half of pages
+	// requested by the previous one are consumed, so the read-ahead keeps
+	// going in front of the cursor.
+	const ULONG prefetchPages = MIN(dbb->dbb_config->getReadAheadSize() / dbb->dbb_page_size,
+		PREFETCH_MAX_PAGES);
+
+	dbb->dbb_prefetch_pages = (prefetchPages > 1) ? prefetchPages : 0;
+	dbb->dbb_prefetch_sequence = MAX(prefetchPages / 2, 1);
 }
 
 
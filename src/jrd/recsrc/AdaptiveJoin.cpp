@@ -0,0 +1,208 @@
+/*
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created for the Firebird Open Source RDBMS project.
+ *
+ *  Copyright (c) 2026 the Firebird Project and all contributors signed below.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../jrd/jrd.h"
+#include "../jrd/req.h"
+#include "../jrd/optimizer/Optimizer.h"
+
+#include "RecordSource.h"
+
+using namespace Firebird;
+using namespace Jrd;
+
+// --------------------------
+// Data access: adaptive join
+// --------------------------
+
+// The outer stream is buffered while deciding. If it ends within the threshold,
+// the buffered rows are joined to the inner stream using nested loops. Otherwise
+// the buffer is the leading stream of the hash join: it returns the rows read so
+// far and then continues the outer stream, so no outer row is read twice.
+
+AdaptiveJoin::AdaptiveJoin(CompilerScratch* csb, BufferedStream* outer, RecordSource* inner,
+						   RecordSource* hashedInner, RecordSource* hashJoin, ULONG threshold)
+	: Join(csb, 2, JoinType::INNER),
+	  m_outer(outer),
+	  m_hashedInner(hashedInner),
+	  m_hashJoin(hashJoin),
+	  m_threshold(threshold)
+{
+	fb_assert(outer && inner && hashedInner && hashJoin);
+	fb_assert(m_threshold);
+
+	m_impure = csb->allocImpure<Impure>();
+	m_cardinality = outer->getCardinality() * inner->getCardinality();
+
+	m_args.add(outer);
+	m_args.add(inner);
+}
+
+void AdaptiveJoin::internalOpen(thread_db* tdbb) const
+{
+	Request* const request = tdbb->getRequest();
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	impure->irsb_flags = irsb_open | irsb_first | irsb_mustread;
+	impure->irsb_hashed = false;
+
+	// Don't replay the outer rows of the prior execution
+	m_hashJoin->close(tdbb);
+	m_outer->close(tdbb);
+}
+
+void AdaptiveJoin::close(thread_db* tdbb) const
+{
+	Request* const request = tdbb->getRequest();
+
+	invalidateRecords(request);
+
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	if (impure->irsb_flags & irsb_open)
+	{
+		impure->irsb_flags &= ~irsb_open;
+
+		Join::close(tdbb);
+		m_hashJoin->close(tdbb);
+	}
+}
+
+bool AdaptiveJoin::internalGetRecord(thread_db* tdbb) const
+{
+	JRD_reschedule(tdbb);
+
+	Request* const request = tdbb->getRequest();
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	if (!(impure->irsb_flags & irsb_open))
+		return false;
+
+	if (impure->irsb_flags & irsb_first)
+	{
+		chooseStrategy(tdbb, impure);
+		impure->irsb_flags &= ~irsb_first;
+	}
+
+	if (impure->irsb_hashed)
+		return m_hashJoin->getRecord(tdbb);
+
+	const auto inner = m_args[1];
+
+	while (true)
+	{
+		if (impure->irsb_flags & irsb_mustread)
+		{
+			if (!m_outer->getRecord(tdbb))
+				return false;
+
+			inner->open(tdbb);
+			impure->irsb_flags &= ~irsb_mustread;
+		}
+
+		if (inner->getRecord(tdbb))
+			return true;
+
+		inner->close(tdbb);
+		impure->irsb_flags |= irsb_mustread;
+	}
+}
+
+void AdaptiveJoin::getLegacyPlan(thread_db* tdbb, string& plan, unsigned level) const
+{
+	// Nested loops is what the optimizer has estimated to be cheaper
+	level++;
+	plan += "JOIN (";
+	Join::getLegacyPlan(tdbb, plan, level);
+	plan += ")";
+}
+
+void AdaptiveJoin::internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsigned level, bool recurse) const
+{
+	planEntry.className = "AdaptiveJoin";
+
+	string extras;
+	extras.printf(" (nested loop up to %" ULONGFORMAT" outer rows, hash join otherwise", m_threshold);
+
+	switch (m_lastStrategy.load(std::memory_order_relaxed))
+	{
+		case Strategy::LOOP:
+			extras += ", last chosen: nested loop";
+			break;
+
+		case Strategy::HASH:
+			extras += ", last chosen: hash join";
+			break;
+
+		default:
+			break;
+	}
+
+	planEntry.lines.add().text = "Adaptive Join " + printType() + extras + ")";
+	printOptInfo(planEntry.lines);
+
+	// The outer stream, the inner one joined by nested loops and the inner one being hashed
+	if (recurse)
+	{
+		++level;
+
+		for (const auto& arg : m_args)
+			arg->getPlan(tdbb, planEntry.children.add(), level, recurse);
+
+		m_hashedInner->getPlan(tdbb, planEntry.children.add(), level, recurse);
+	}
+}
+
+void AdaptiveJoin::markRecursive()
+{
+	Join::markRecursive();
+	m_hashJoin->markRecursive();
+}
+
+void AdaptiveJoin::invalidateRecords(Request* request) const
+{
+	Join::invalidateRecords(request);
+	m_hashJoin->invalidateRecords(request);
+}
+
+void AdaptiveJoin::chooseStrategy(thread_db* tdbb, Impure* impure) const
+{
+	m_outer->open(tdbb);
+
+	ULONG count = 0;
+
+	while (count <= m_threshold && m_outer->getRecord(tdbb))
+		count++;
+
+	if (count <= m_threshold)
+	{
+		// The outer stream is exhausted and buffered completely, replay it
+		m_outer->locate(tdbb, 0);
+		m_lastStrategy.store(Strategy::LOOP, std::memory_order_relaxed);
+		return;
+	}
+
+	// The hash join reads the buffered rows first, then the rest of the outer stream
+	m_outer->replay(tdbb);
+	m_hashJoin->open(tdbb);
+
+	impure->irsb_hashed = true;
+	m_lastStrategy.store(Strategy::HASH, std::memory_order_relaxed);
+}
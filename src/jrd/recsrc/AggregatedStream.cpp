@@ -18,12 +18,17 @@
  */
 
 #include "firebird.h"
+#include "../common/classes/Aligner.h"
+#include "../common/classes/Hash.h"
 #include "../jrd/jrd.h"
+#include "../jrd/intl.h"
+#include "../jrd/sort.h"
 #include "../dsql/Nodes.h"
 #include "../dsql/ExprNodes.h"
 #include "../jrd/cmp_proto.h"
 #include "../jrd/evl_proto.h"
 #include "../jrd/exe_proto.h"
+#include "../jrd/intl_proto.h"
 #include "../jrd/mov_proto.h"
 #include "../jrd/vio_proto.h"
 #include "../jrd/Attachment.h"
@@ -377,11 +382,325 @@ template class Jrd::BaseAggWinStream<WindowedStream::WindowStream, BaseBufferedS
 
 // ------------------------------
 
+// Hash aggregation.
+//
+// GROUP BY with aggregates whose partial states may be combined doesn't need the input
+// to be sorted. Every record is routed to its group found by hashing the group key, and
+// the running states of the aggregates are swapped in and out of the request impure area.
+// When the groups don't fit the memory limit, their partial states are put into a sort
+// keyed by the group key and the table is emptied. After the input is exhausted, the
+// partial states of every group are read back in the key order and combined.
+
+namespace
+{
+	const ULONG MAX_GROUP_KEY_LENGTH = MAX_USHORT;
+	const unsigned MAX_AGG_STATES = 4;
+
+	// Partial state of an aggregate as it's stored in the sort, followed by the value
+	struct SpilledState
+	{
+		dsc desc;
+		SINT64 count;
+	};
+
+	const ULONG STATE_HEADER_LENGTH = FB_ALIGN(sizeof(SpilledState), FB_DOUBLE_ALIGN);
+}
+
+class AggregatedStream::HashTable
+{
+	static const FB_SIZE_T MIN_BUCKETS = 64;
+
+public:
+	struct Group
+	{
+		Group* next;				// next group in the same bucket
+		impure_value_ex* states;	// running states of the aggregates
+		UCHAR* key;					// group key
+		UCHAR* data;				// output record with the grouped items assigned
+		ULONG hash;
+	};
+
+	HashTable(MemoryPool& pool, ULONG stateCount, FB_UINT64 memoryLimit)
+		: m_parentPool(pool),
+		  m_pool(MemoryPool::createPool(&pool)),
+		  m_buckets(pool),
+		  m_groups(pool),
+		  m_stateCount(stateCount),
+		  m_memoryLimit(memoryLimit),
+		  m_memory(0),
+		  m_position(0),
+		  sort(nullptr),
+		  current(pool),
+		  pending(pool),
+		  hasPending(false)
+	{
+		m_buckets.resize(MIN_BUCKETS);
+		memset(m_buckets.begin(), 0, m_buckets.getCount() * sizeof(Group*));
+	}
+
+	~HashTable()
+	{
+		clear();
+		MemoryPool::deletePool(m_pool);
+		delete sort;
+	}
+
+	Group* find(ULONG hash, const UCHAR* key, ULONG keyLength) const
+	{
+		for (Group* group = m_buckets[hash & (m_buckets.getCount() - 1)]; group; group = group->next)
+		{
+			if (group->hash == hash && !memcmp(group->key, key, keyLength))
+				return group;
+		}
+
+		return nullptr;
+	}
+
+	Group* add(ULONG hash, const UCHAR* key, ULONG keyLength, ULONG dataLength)
+	{
+		if (m_groups.getCount() >= m_buckets.getCount())
+			grow();
+
+		const ULONG statesOffset = FB_ALIGN(sizeof(Group), FB_ALIGNMENT);
+		const ULONG keyOffset = statesOffset + m_stateCount * sizeof(impure_value_ex);
+		const ULONG dataOffset = FB_ALIGN(keyOffset + keyLength, FB_ALIGNMENT);
+		const ULONG size = dataOffset + dataLength;
+
+		UCHAR* const block = FB_NEW_POOL(*m_pool) UCHAR[size];
+		memset(block, 0, size);
+
+		Group* const group = reinterpret_cast<Group*>(block);
+		group->states = reinterpret_cast<impure_value_ex*>(block + statesOffset);
+		group->key = block + keyOffset;
+		group->data = block + dataOffset;
+		group->hash = hash;
+		memcpy(group->key, key, keyLength);
+
+		Group** const bucket = &m_buckets[hash & (m_buckets.getCount() - 1)];
+		group->next = *bucket;
+		*bucket = group;
+
+		m_groups.add(group);
+		m_memory += size + 2 * sizeof(Group*);
+
+		return group;
+	}
+
+	bool isFull() const
+	{
+		return m_memory > m_memoryLimit;
+	}
+
+	FB_SIZE_T getCount() const
+	{
+		return m_groups.getCount();
+	}
+
+	Group* getGroup(FB_SIZE_T pos) const
+	{
+		return m_groups[pos];
+	}
+
+	Group* next()
+	{
+		return (m_position < m_groups.getCount()) ? m_groups[m_position++] : nullptr;
+	}
+
+	void clear()
+	{
+		// Strings of MIN/MAX values are allocated by the aggregates themselves
+		for (const auto group : m_groups)
+		{
+			for (ULONG i = 0; i < m_stateCount; i++)
+				delete group->states[i].vlu_string;
+		}
+
+		m_groups.clear();
+		m_buckets.shrink(MIN_BUCKETS);
+		memset(m_buckets.begin(), 0, m_buckets.getCount() * sizeof(Group*));
+
+		MemoryPool::deletePool(m_pool);
+		m_pool = MemoryPool::createPool(&m_parentPool);
+
+		m_memory = 0;
+		m_position = 0;
+	}
+
+private:
+	void grow()
+	{
+		const FB_SIZE_T count = m_buckets.getCount() * 2;
+		m_buckets.resize(count);
+		memset(m_buckets.begin(), 0, count * sizeof(Group*));
+
+		for (const auto group : m_groups)
+		{
+			Group** const bucket = &m_buckets[group->hash & (count - 1)];
+			group->next = *bucket;
+			*bucket = group;
+		}
+
+		m_memory += count / 2 * sizeof(Group*);
+	}
+
+	MemoryPool& m_parentPool;
+	MemoryPool* m_pool;
+	Firebird::Array<Group*> m_buckets;
+	Firebird::Array<Group*> m_groups;
+	const ULONG m_stateCount;
+	const FB_UINT64 m_memoryLimit;
+	FB_UINT64 m_memory;
+	FB_SIZE_T m_position;
+
+public:
+	Sort* sort;					// partial states of the groups that didn't fit
+	Firebird::UCharBuffer current;
+	Firebird::UCharBuffer pending;
+	bool hasPending;
+};
+
+// ------------------------------
+
 AggregatedStream::AggregatedStream(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
-			const NestValueArray* group, MapNode* map, RecordSource* next)
-	: BaseAggWinStream(tdbb, csb, stream, group, map, !group, next)
+			const NestValueArray* group, MapNode* map, RecordSource* next, bool hashed)
+	: BaseAggWinStream(tdbb, csb, stream, group, map, !group, next),
+	  m_keyLengths(nullptr),
+	  m_keyLength(0),
+	  m_stateCount(0),
+	  m_stateLength(0),
+	  m_spillLength(0),
+	  m_hashed(hashed)
 {
 	fb_assert(map);
+
+	if (m_hashed)
+	{
+		fb_assert(group);
+
+		m_keyLengths = FB_NEW_POOL(csb->csb_pool) ULONG[group->getCount()];
+		m_spillLength = getHashLayout(tdbb, csb, stream, group, map,
+			m_keyLengths, m_keyLength, m_stateCount, m_stateLength);
+
+		fb_assert(m_spillLength);
+	}
+}
+
+// Check whether the grouping may be done by hashing
+bool AggregatedStream::isHashable(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
+	const NestValueArray* group, MapNode* map)
+{
+	ULONG keyLength, stateCount, stateLength;
+
+	return group && group->hasData() &&
+		getHashLayout(tdbb, csb, stream, group, map, nullptr, keyLength, stateCount, stateLength);
+}
+
+// Calculate the lengths of the group key and of the spilled group record.
+// Zero is returned if the group cannot be hashed.
+ULONG AggregatedStream::getHashLayout(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
+	const NestValueArray* group, MapNode* map,
+	ULONG* keyLengths, ULONG& keyLength, ULONG& stateCount, ULONG& stateLength)
+{
+	keyLength = 0;
+
+	for (FB_SIZE_T i = 0; i < group->getCount(); i++)
+	{
+		// Descriptors are not changed by the compiled nodes
+		const auto node = const_cast<ValueExprNode*>((*group)[i].getObject());
+
+		dsc desc;
+		node->getDesc(tdbb, csb, &desc);
+
+		if (desc.isBlob())
+			return 0;
+
+		ULONG length = desc.isText() ? desc.getStringLength() : desc.dsc_length;
+
+		if (IS_INTL_DATA(&desc))
+			length = INTL_key_length(tdbb, INTL_INDEX_TYPE(&desc), length);
+		else if (desc.isTime())
+			length = sizeof(ISC_TIME);
+		else if (desc.isTimeStamp())
+			length = sizeof(ISC_TIMESTAMP);
+		else if (desc.dsc_dtype == dtype_dec64)
+			length = Decimal64::getKeyLength();
+		else if (desc.dsc_dtype == dtype_dec128)
+			length = Decimal128::getKeyLength();
+
+		// The leading byte is the NULL flag
+		length++;
+
+		if (keyLengths)
+			keyLengths[i] = length;
+
+		keyLength += length;
+	}
+
+	if (keyLength > MAX_GROUP_KEY_LENGTH)
+		return 0;
+
+	ULONG valueLength = sizeof(impure_value::vlu_misc);
+	stateCount = 0;
+
+	for (auto& source : map->sourceList)
+	{
+		const auto aggNode = nodeAs<AggNode>(source);
+
+		if (!aggNode)
+			continue;
+
+		if (!aggNode->isCombinable() || aggNode->getStateCount() > MAX_AGG_STATES)
+			return 0;
+
+		dsc desc;
+		source->getDesc(tdbb, csb, &desc);
+		valueLength = MAX(valueLength, desc.dsc_length);
+
+		stateCount += aggNode->getStateCount();
+	}
+
+	stateLength = FB_ALIGN(STATE_HEADER_LENGTH + valueLength, FB_DOUBLE_ALIGN);
+
+	const Format* const format = csb->csb_rpt[stream].csb_format;
+	const ULONG length = FB_ALIGN(keyLength, FB_DOUBLE_ALIGN) +
+		FB_ALIGN(format->fmt_length, FB_DOUBLE_ALIGN) + stateCount * stateLength;
+
+	return (length <= MAX_SORT_RECORD) ? length : 0;
+}
+
+void AggregatedStream::internalOpen(thread_db* tdbb) const
+{
+	Request* const request = tdbb->getRequest();
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	delete impure->irsb_hash_table;
+	impure->irsb_hash_table = nullptr;
+
+	// The batch is kept between the openings of the stream, as groupValues are
+
+	impure->irsb_batched = isBatchable(tdbb);
+
+	if (impure->irsb_batched && !impure->irsb_batch)
+	{
+		StreamList streams;
+		m_next->findUsedStreams(streams);
+
+		MemoryPool& pool = *tdbb->getDefaultPool();
+		impure->irsb_batch = FB_NEW_POOL(pool) RecordBatch(pool, streams.begin(), streams.getCount());
+	}
+
+	BaseAggWinStream::internalOpen(tdbb);
+}
+
+void AggregatedStream::close(thread_db* tdbb) const
+{
+	Request* const request = tdbb->getRequest();
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	delete impure->irsb_hash_table;
+	impure->irsb_hash_table = nullptr;
+
+	BaseAggWinStream::close(tdbb);
 }
 
 void AggregatedStream::getLegacyPlan(thread_db* tdbb, string& plan, unsigned level) const
@@ -393,7 +712,7 @@ void AggregatedStream::internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, un
 {
 	planEntry.className = "AggregatedStream";
 
-	planEntry.lines.add().text = "Aggregate";
+	planEntry.lines.add().text = m_hashed ? "Hash Aggregate" : "Aggregate";
 	printOptInfo(planEntry.lines);
 
 	if (recurse)
@@ -409,7 +728,7 @@ bool AggregatedStream::internalGetRecord(thread_db* tdbb) const
 
 	Request* const request = tdbb->getRequest();
 	record_param* const rpb = &request->req_rpb[m_stream];
-	Impure* const impure = getImpure(request);
+	Impure* const impure = request->getImpure<Impure>(m_impure);
 
 	if (!(impure->irsb_flags & irsb_open))
 	{
@@ -417,7 +736,32 @@ bool AggregatedStream::internalGetRecord(thread_db* tdbb) const
 		return false;
 	}
 
-	if (!evaluateGroup(tdbb))
+	if (m_hashed)
+	{
+		if (impure->state == STATE_GROUPING)
+		{
+			buildHashTable(tdbb, request, impure);
+			impure->state = STATE_FETCHED;
+		}
+
+		if (impure->state == STATE_EOF || !fetchHashGroup(tdbb, request, impure))
+		{
+			impure->state = STATE_EOF;
+			rpb->rpb_number.setValid(false);
+			return false;
+		}
+	}
+	else if (impure->irsb_batched)
+	{
+		if (impure->state == STATE_EOF)
+		{
+			rpb->rpb_number.setValid(false);
+			return false;
+		}
+
+		evaluateBatches(tdbb, request, impure);
+	}
+	else if (!evaluateGroup(tdbb))
 	{
 		rpb->rpb_number.setValid(false);
 		return false;
@@ -426,3 +770,368 @@ bool AggregatedStream::internalGetRecord(thread_db* tdbb) const
 	rpb->rpb_number.setValid(true);
 	return true;
 }
+
+// Check whether the input may be aggregated by batches. It's done for the
+// aggregation without groups, which are computed with a single pass.
+bool AggregatedStream::isBatchable(thread_db* tdbb) const
+{
+	if (m_group || m_hashed)
+		return false;
+
+	// Let the profiler see every record
+	if (tdbb->getAttachment()->getActiveProfilerManagerForNonInternalStatement(tdbb))
+		return false;
+
+	for (const auto& source : m_groupMap->sourceList)
+	{
+		if (const auto aggNode = nodeAs<AggNode>(source))
+		{
+			if (aggNode->indexed)
+				return false;
+		}
+		else if (!nodeIs<LiteralNode>(source))
+			return false;
+	}
+
+	return true;
+}
+
+// Aggregate the whole input by batches. Aggregates that cannot process
+// the batch at once are passed its rows one by one.
+void AggregatedStream::evaluateBatches(thread_db* tdbb, Request* request, Impure* impure) const
+{
+	RecordBatch& batch = *impure->irsb_batch;
+	HalfStaticArray<const AggNode*, 8> rowAggs;
+
+	try
+	{
+		aggInit(tdbb, request, m_groupMap);
+
+		while (m_next->getBatch(tdbb, batch))
+		{
+			rowAggs.clear();
+
+			for (const auto& source : m_groupMap->sourceList)
+			{
+				if (const auto aggNode = nodeAs<AggNode>(source))
+				{
+					if (!aggNode->aggPassBatch(tdbb, request, batch))
+						rowAggs.add(aggNode);
+				}
+			}
+
+			if (rowAggs.hasData())
+			{
+				RecordBatch::RowHolder rows(request->req_rpb.begin(), batch);
+
+				for (ULONG i = 0; i < batch.getCount(); i++)
+				{
+					rows.set(batch.getRow(i));
+
+					for (const auto aggNode : rowAggs)
+						aggNode->aggPass(tdbb, request);
+				}
+			}
+		}
+
+		aggExecute(tdbb, request, m_groupMap->sourceList, m_groupMap->targetList);
+	}
+	catch (const Exception&)
+	{
+		aggFinish(tdbb, request, m_groupMap);
+		throw;
+	}
+
+	impure->state = STATE_EOF;
+}
+
+// Read the whole input, distributing its records between the groups
+void AggregatedStream::buildHashTable(thread_db* tdbb, Request* request, Impure* impure) const
+{
+	MemoryPool& pool = *tdbb->getDefaultPool();
+	const auto memoryLimit = tdbb->getDatabase()->dbb_config->getHashAggregateMemoryLimit();
+
+	HashTable* const table = impure->irsb_hash_table =
+		FB_NEW_POOL(pool) HashTable(pool, m_stateCount, memoryLimit);
+
+	Record* const record = request->req_rpb[m_stream].rpb_record;
+
+	UCharBuffer buffer;
+	UCHAR* const key = buffer.getBuffer(m_keyLength);
+
+	while (m_next->getRecord(tdbb))
+	{
+		const ULONG hash = computeKey(tdbb, request, key);
+
+		auto group = table->find(hash, key, m_keyLength);
+
+		if (group)
+		{
+			swapStates(request, group->states);
+
+			for (const auto& source : m_groupMap->sourceList)
+			{
+				if (const auto aggNode = nodeAs<AggNode>(source))
+					aggNode->aggPass(tdbb, request);
+			}
+
+			swapStates(request, group->states);
+			continue;
+		}
+
+		if (table->isFull())
+			spillGroups(tdbb, request, table);
+
+		group = table->add(hash, key, m_keyLength, record->getLength());
+
+		swapStates(request, group->states);
+		aggInit(tdbb, request, m_groupMap);
+		aggPass(tdbb, request, m_groupMap->sourceList, m_groupMap->targetList);
+		memcpy(group->data, record->getData(), record->getLength());
+		swapStates(request, group->states);
+	}
+
+	if (table->sort)
+	{
+		spillGroups(tdbb, request, table);
+		table->sort->sort(tdbb);
+
+		table->current.getBuffer(m_spillLength);
+		table->pending.getBuffer(m_spillLength);
+	}
+}
+
+// Return the next group
+bool AggregatedStream::fetchHashGroup(thread_db* tdbb, Request* request, Impure* impure) const
+{
+	HashTable* const table = impure->irsb_hash_table;
+	Record* const record = request->req_rpb[m_stream].rpb_record;
+
+	if (!table->sort)
+	{
+		const auto group = table->next();
+
+		if (!group)
+			return false;
+
+		memcpy(record->getData(), group->data, record->getLength());
+
+		swapStates(request, group->states);
+		aggExecute(tdbb, request, m_groupMap->sourceList, m_groupMap->targetList);
+		swapStates(request, group->states);
+
+		return true;
+	}
+
+	// Combine the partial states of the same group, they follow each other in the sort
+
+	const auto readSpilled = [&](UCHAR* buffer)
+	{
+		UCHAR* data = nullptr;
+		table->sort->get(tdbb, reinterpret_cast<ULONG**>(&data));
+
+		if (!data)
+			return false;
+
+		memcpy(buffer, data, m_spillLength);
+		return true;
+	};
+
+	UCHAR* const current = table->current.begin();
+	UCHAR* const pending = table->pending.begin();
+
+	if (table->hasPending)
+	{
+		memcpy(current, pending, m_spillLength);
+		table->hasPending = false;
+	}
+	else if (!readSpilled(current))
+		return false;
+
+	memcpy(record->getData(), current + FB_ALIGN(m_keyLength, FB_DOUBLE_ALIGN), record->getLength());
+
+	aggInit(tdbb, request, m_groupMap);
+	combineSpilled(tdbb, request, current);
+
+	while (readSpilled(pending))
+	{
+		if (memcmp(pending, current, m_keyLength))
+		{
+			table->hasPending = true;
+			break;
+		}
+
+		combineSpilled(tdbb, request, pending);
+	}
+
+	aggExecute(tdbb, request, m_groupMap->sourceList, m_groupMap->targetList);
+
+	return true;
+}
+
+// Make the group key of the current record, return its hash value
+ULONG AggregatedStream::computeKey(thread_db* tdbb, Request* request, UCHAR* keyBuffer) const
+{
+	memset(keyBuffer, 0, m_keyLength);
+
+	UCHAR* keyPtr = keyBuffer;
+
+	for (FB_SIZE_T i = 0; i < m_group->getCount(); i++)
+	{
+		dsc* const desc = EVL_expr(tdbb, request, (*m_group)[i]);
+
+		UCHAR* const valuePtr = keyPtr + 1;
+		const USHORT valueLength = m_keyLengths[i] - 1;
+
+		if (!desc)
+			*keyPtr = 1;
+		else if (desc->isText())
+		{
+			dsc to;
+			to.makeText(valueLength, desc->getTextType(), valuePtr);
+
+			if (IS_INTL_DATA(desc))
+			{
+				// Convert the INTL string into the binary comparable form
+				INTL_string_to_key(tdbb, INTL_INDEX_TYPE(desc), desc, &to, INTL_KEY_UNIQUE);
+			}
+			else
+			{
+				// This call ensures that the padding bytes are appended
+				MOV_move(tdbb, desc, &to, true);
+			}
+		}
+		else
+		{
+			const auto* const data = desc->dsc_address;
+
+			if (desc->isDecFloat())
+			{
+				// Values inside our key buffer are not aligned,
+				// so ensure we satisfy our platform's alignment rules
+				OutAligner<ULONG, MAX_DEC_KEY_LONGS> key(valuePtr, valueLength);
+
+				if (desc->dsc_dtype == dtype_dec64)
+					((Decimal64*) data)->makeKey(key);
+				else if (desc->dsc_dtype == dtype_dec128)
+					((Decimal128*) data)->makeKey(key);
+				else
+					fb_assert(false);
+			}
+			else if ((desc->dsc_dtype == dtype_real && *(float*) data == 0) ||
+				(desc->dsc_dtype == dtype_double && *(double*) data == 0))
+			{
+				// positive and negative zeroes are the same group
+			}
+			else
+			{
+				// Note: for date/time with time zone, we copy only the UTC part
+				fb_assert(valueLength <= desc->dsc_length);
+				memcpy(valuePtr, data, valueLength);
+			}
+		}
+
+		keyPtr += m_keyLengths[i];
+	}
+
+	fb_assert(keyPtr - keyBuffer == m_keyLength);
+
+	return InternalHash::hash(m_keyLength, keyBuffer);
+}
+
+// Exchange the running states of the aggregates with the saved ones
+void AggregatedStream::swapStates(Request* request, impure_value_ex* states) const
+{
+	for (const auto& source : m_groupMap->sourceList)
+	{
+		if (const auto aggNode = nodeAs<AggNode>(source))
+		{
+			aggNode->aggSwapState(request, states);
+			states += aggNode->getStateCount();
+		}
+	}
+}
+
+// Put the partial states of the resident groups into the sort and empty the table
+void AggregatedStream::spillGroups(thread_db* tdbb, Request* request, HashTable* table) const
+{
+	if (!table->sort)
+	{
+		sort_key_def key;
+		key.setSkdLength(SKD_bytes, m_keyLength);
+		key.skd_flags = SKD_ascending;
+		key.setSkdOffset();
+		key.skd_vary_offset = 0;
+
+		table->sort = FB_NEW_POOL(request->req_sorts.getPool())
+			Sort(tdbb->getDatabase(), &request->req_sorts, m_spillLength, 1, 1, &key, nullptr, 0);
+	}
+
+	const ULONG dataOffset = FB_ALIGN(m_keyLength, FB_DOUBLE_ALIGN);
+	const ULONG statesOffset = dataOffset + FB_ALIGN(m_format->fmt_length, FB_DOUBLE_ALIGN);
+
+	for (FB_SIZE_T i = 0; i < table->getCount(); i++)
+	{
+		const auto group = table->getGroup(i);
+
+		UCHAR* data;
+		table->sort->put(tdbb, reinterpret_cast<ULONG**>(&data));
+
+		memset(data, 0, m_spillLength);
+		memcpy(data, group->key, m_keyLength);
+		memcpy(data + dataOffset, group->data, m_format->fmt_length);
+
+		UCHAR* ptr = data + statesOffset;
+
+		for (ULONG j = 0; j < m_stateCount; j++, ptr += m_stateLength)
+		{
+			const impure_value_ex* const state = &group->states[j];
+
+			SpilledState* const spilled = reinterpret_cast<SpilledState*>(ptr);
+			spilled->desc = state->vlu_desc;
+			spilled->desc.dsc_address = nullptr;
+			spilled->count = state->vlux_count;
+
+			// Only the values owned by the state are stored, others are type templates
+
+			const UCHAR* const address = state->vlu_desc.dsc_address;
+
+			if (state->vlu_desc.dsc_dtype &&
+				(address == (UCHAR*) &state->vlu_misc ||
+				 (state->vlu_string && address == state->vlu_string->str_data)))
+			{
+				fb_assert(STATE_HEADER_LENGTH + state->vlu_desc.dsc_length <= m_stateLength);
+				memcpy(ptr + STATE_HEADER_LENGTH, address, state->vlu_desc.dsc_length);
+			}
+		}
+	}
+
+	table->clear();
+}
+
+// Merge the partial states of the spilled group into the running ones
+void AggregatedStream::combineSpilled(thread_db* tdbb, Request* request, const UCHAR* data) const
+{
+	const UCHAR* ptr = data + FB_ALIGN(m_keyLength, FB_DOUBLE_ALIGN) +
+		FB_ALIGN(m_format->fmt_length, FB_DOUBLE_ALIGN);
+
+	for (const auto& source : m_groupMap->sourceList)
+	{
+		if (const auto aggNode = nodeAs<AggNode>(source))
+		{
+			impure_value_ex states[MAX_AGG_STATES];
+			const unsigned count = aggNode->getStateCount();
+
+			for (unsigned i = 0; i < count; i++, ptr += m_stateLength)
+			{
+				const SpilledState* const spilled = reinterpret_cast<const SpilledState*>(ptr);
+
+				states[i].vlu_desc = spilled->desc;
+				states[i].vlu_desc.dsc_address = const_cast<UCHAR*>(ptr + STATE_HEADER_LENGTH);
+				states[i].vlux_count = spilled->count;
+			}
+
+			aggNode->aggCombine(tdbb, request, states);
+		}
+	}
+}
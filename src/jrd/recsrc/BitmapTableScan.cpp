@@ -21,7 +21,9 @@
 #include "../jrd/jrd.h"
 #include "../jrd/btr.h"
 #include "../jrd/req.h"
+#include "../jrd/tra.h"
 #include "../jrd/cmp_proto.h"
+#include "../jrd/dpm_proto.h"
 #include "../jrd/evl_proto.h"
 #include "../jrd/vio_proto.h"
 #include "../jrd/rlck_proto.h"
@@ -37,9 +39,11 @@ using namespace Jrd;
 
 BitmapTableScan::BitmapTableScan(CompilerScratch* csb, const string& alias,
 								 StreamType stream, Rsc::Rel relation,
-								 InversionNode* inversion, double selectivity)
+								 InversionNode* inversion, double selectivity,
+								 BoolExprNode* recheck)
 	: RecordStream(csb, stream),
-	  m_alias(csb->csb_pool, alias), m_relation(relation), m_inversion(inversion)
+	  m_alias(csb->csb_pool, alias), m_relation(relation), m_inversion(inversion),
+	  m_recheck(recheck)
 {
 	fb_assert(m_inversion);
 
@@ -54,6 +58,9 @@ void BitmapTableScan::internalOpen(thread_db* tdbb) const
 
 	impure->irsb_flags = irsb_open;
 	impure->irsb_bitmap = EVL_bitmap(tdbb, m_inversion, NULL);
+	impure->irsb_prefetch_number = 0;
+	impure->irsb_visible_sequence = MAX_ULONG;
+	impure->irsb_visible = false;
 
 	record_param* const rpb = &request->req_rpb[m_stream];
 	RLCK_reserve_relation(tdbb, request->req_transaction, m_relation(), false);
@@ -108,9 +115,28 @@ bool BitmapTableScan::internalGetRecord(thread_db* tdbb) const
 	{
 		do
 		{
-			rpb->rpb_number.setValue(bitmap->current());
+			const FB_UINT64 number = bitmap->current();
+			rpb->rpb_number.setValue(number);
 
-			if (VIO_get(tdbb, rpb, request->req_transaction, request->req_pool))
+			// The index scan has already evaluated the booleans,
+			// so records of the pages visible to everybody exist for sure
+
+			if ((rpb->rpb_stream_flags & RPB_s_index_only) && isVisible(tdbb, number))
+			{
+				rpb->rpb_number.setValid(true);
+				return true;
+			}
+
+			// Read data pages of the following records ahead
+
+			if (number >= impure->irsb_prefetch_number)
+			{
+				impure->irsb_prefetch_number =
+					DPM_prefetch_bitmap(tdbb, rpb->rpb_relation, bitmap, number);
+			}
+
+			if (VIO_get(tdbb, rpb, request->req_transaction, request->req_pool) &&
+				(!m_recheck || m_recheck->execute(tdbb, request).asBool()))
 			{
 				rpb->rpb_number.setValid(true);
 				return true;
@@ -122,6 +148,14 @@ bool BitmapTableScan::internalGetRecord(thread_db* tdbb) const
 	return false;
 }
 
+bool BitmapTableScan::refetchRecord(thread_db* tdbb) const
+{
+	Request* const request = tdbb->getRequest();
+
+	return RecordStream::refetchRecord(tdbb) &&
+		(!m_recheck || m_recheck->execute(tdbb, request).asBool());
+}
+
 void BitmapTableScan::getLegacyPlan(thread_db* tdbb, string& plan, unsigned level) const
 {
 	if (!level)
@@ -141,7 +175,8 @@ void BitmapTableScan::internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, uns
 	planEntry.className = "BitmapTableScan";
 
 	planEntry.lines.add().text = "Table " +
-		printName(tdbb, m_relation()->getName().toQuotedString(), m_alias) + " Access By ID";
+		printName(tdbb, m_relation()->getName().toQuotedString(), m_alias) + " Access By ID" +
+		(m_recheck ? " (Index Only)" : "");
 	printOptInfo(planEntry.lines);
 
 	printInversion(tdbb, m_inversion, planEntry.lines, true, 1, false);
@@ -152,3 +187,35 @@ void BitmapTableScan::internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, uns
 	if (m_alias.hasData() && m_alias != string(m_relation()->getName().object))
 		planEntry.alias = m_alias;
 }
+
+bool BitmapTableScan::isDependent(const StreamList& streams) const
+{
+	return m_recheck && m_recheck->containsAnyStream(streams);
+}
+
+bool BitmapTableScan::isVisible(thread_db* tdbb, FB_UINT64 number) const
+{
+	Request* const request = tdbb->getRequest();
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+	const Database* const dbb = tdbb->getDatabase();
+
+	const ULONG sequence = (ULONG) (number / dbb->dbb_max_records);
+
+	// Own changes made during the scan are not reflected by the cached state,
+	// so use it only until the transaction writes something
+
+	const bool cache = !(request->req_transaction->tra_flags & TRA_write);
+
+	if (cache && sequence == impure->irsb_visible_sequence)
+		return impure->irsb_visible;
+
+	const bool visible = DPM_all_visible(tdbb, request->req_rpb[m_stream].rpb_relation, sequence);
+
+	if (cache)
+	{
+		impure->irsb_visible_sequence = sequence;
+		impure->irsb_visible = visible;
+	}
+
+	return visible;
+}
@@ -120,7 +120,18 @@ void BufferedStream::internalOpen(thread_db* tdbb) const
 	Request* const request = tdbb->getRequest();
 	Impure* const impure = request->getImpure<Impure>(m_impure);
 
+	// Start from the first buffered record if nothing was passed through yet,
+	// the underlying stream is continued afterwards
+
+	if ((impure->irsb_flags & irsb_open) && impure->irsb_replay &&
+		impure->irsb_position <= impure->irsb_buffer->getCount())
+	{
+		impure->irsb_position = 0;
+		return;
+	}
+
 	impure->irsb_flags = irsb_open | irsb_mustread;
+	impure->irsb_replay = false;
 
 	m_next->open(tdbb);
 
@@ -142,6 +153,7 @@ void BufferedStream::close(thread_db* tdbb) const
 	if (impure->irsb_flags & irsb_open)
 	{
 		impure->irsb_flags &= ~irsb_open;
+		impure->irsb_replay = false;
 
 		delete impure->irsb_buffer;
 		impure->irsb_buffer = NULL;
@@ -164,7 +176,20 @@ bool BufferedStream::internalGetRecord(thread_db* tdbb) const
 
 	Record* const buffer_record = impure->irsb_buffer->getTempRecord();
 
-	if (impure->irsb_flags & irsb_mustread)
+	// Read the buffered records first, then pass the rest through
+
+	const bool replayed = impure->irsb_replay &&
+		impure->irsb_position < impure->irsb_buffer->getCount();
+
+	if ((impure->irsb_flags & irsb_mustread) && impure->irsb_replay && !replayed)
+	{
+		if (!m_next->getRecord(tdbb))
+		{
+			impure->irsb_flags &= ~irsb_mustread;
+			return false;
+		}
+	}
+	else if ((impure->irsb_flags & irsb_mustread) && !replayed)
 	{
 		if (!m_next->getRecord(tdbb))
 		{
@@ -304,6 +329,23 @@ bool BufferedStream::internalGetRecord(thread_db* tdbb) const
 	return true;
 }
 
+void BufferedStream::replay(thread_db* tdbb) const
+{
+	// Hand the partially read stream over to another consumer. Its next open
+	// returns the records buffered so far and then continues the underlying
+	// stream without buffering. Until the first record is passed through,
+	// reopening starts from the first buffered record again.
+
+	Request* const request = tdbb->getRequest();
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	fb_assert(impure->irsb_flags & irsb_open);
+	fb_assert(impure->irsb_flags & irsb_mustread);
+	fb_assert(impure->irsb_position == impure->irsb_buffer->getCount());
+
+	impure->irsb_replay = true;
+}
+
 bool BufferedStream::refetchRecord(thread_db* tdbb) const
 {
 	return m_next->refetchRecord(tdbb);
@@ -110,6 +110,58 @@ bool FilteredStream::internalGetRecord(thread_db* tdbb) const
 	return true;
 }
 
+// Filter the batches of the input. The boolean is evaluated for the whole batch
+// if it supports that, otherwise the rows are made current and tested one by one.
+bool FilteredStream::internalGetBatch(thread_db* tdbb, RecordBatch& batch) const
+{
+	JRD_reschedule(tdbb);
+
+	Request* const request = tdbb->getRequest();
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	if (!(impure->irsb_flags & irsb_open))
+		return false;
+
+	if (m_anyBoolean)
+		return RecordSource::internalGetBatch(tdbb, batch);
+
+	BatchColumn result(*tdbb->getDefaultPool());
+	Array<ULONG> positions(*tdbb->getDefaultPool());
+
+	while (m_next->getBatch(tdbb, batch))
+	{
+		positions.clear();
+
+		if (m_boolean->executeBatch(tdbb, request, batch, result))
+		{
+			for (ULONG i = 0; i < result.count; i++)
+			{
+				if (!result.nulls[i] && result.values[i].exact)
+					positions.add(i);
+			}
+		}
+		else
+		{
+			RecordBatch::RowHolder rows(request->req_rpb.begin(), batch);
+
+			for (ULONG i = 0; i < batch.getCount(); i++)
+			{
+				rows.set(batch.getRow(i));
+
+				if (m_boolean->execute(tdbb, request).asBool())
+					positions.add(i);
+			}
+		}
+
+		batch.select(positions);
+
+		if (batch.getCount())
+			return true;
+	}
+
+	return false;
+}
+
 bool FilteredStream::refetchRecord(thread_db* tdbb) const
 {
 	Request* const request = tdbb->getRequest();
@@ -123,6 +175,15 @@ WriteLockResult FilteredStream::lockRecord(thread_db* tdbb) const
 	return m_next->lockRecord(tdbb);
 }
 
+// The source may aggregate the records if it evaluates the whole boolean itself
+bool FilteredStream::pushAggregates(const MapNode* map, const BoolExprNode* boolean)
+{
+	if (boolean || m_invariant || m_anyBoolean)
+		return false;
+
+	return m_next->pushAggregates(map, m_boolean);
+}
+
 void FilteredStream::getLegacyPlan(thread_db* tdbb, string& plan, unsigned level) const
 {
 	m_next->getLegacyPlan(tdbb, plan, level);
@@ -62,6 +62,8 @@ void FullTableScan::internalOpen(thread_db* tdbb) const
 	record_param* const rpb = &request->req_rpb[m_stream];
 	rpb->getWindow(tdbb).win_flags = 0;
 
+	BufferControl* const bcb = dbb->dbb_bcb;
+
 	// Unless this is the only attachment, limit the cache flushing
 	// effect of large sequential scans on the page working sets of
 	// other attachments
@@ -77,8 +79,6 @@ void FullTableScan::internalOpen(thread_db* tdbb) const
 		// because the cumulative effect of scanning all relations
 		// is equal to that of a single large relation.
 
-		BufferControl* const bcb = dbb->dbb_bcb;
-
 		if (attachment->isGbak() || DPM_data_pages(tdbb, m_relation()) > bcb->bcb_count)
 		{
 			rpb->getWindow(tdbb).win_flags = WIN_large_scan;
@@ -86,6 +86,15 @@ void FullTableScan::internalOpen(thread_db* tdbb) const
 		}
 	}
 
+	// With 2Q replacement policy data pages of a relation that doesn't fit
+	// the probation que are not promoted into the main LRU que by this scan
+
+	if (bcb->bcb_probation_limit && attachment &&
+		(attachment->isGbak() || DPM_data_pages(tdbb, m_relation()) > bcb->bcb_probation_limit))
+	{
+		rpb->getWindow(tdbb).win_flags |= WIN_use_once;
+	}
+
 	rpb->rpb_number.setValue(BOF_NUMBER);
 
 	if (m_dbkeyRanges.hasData())
@@ -158,6 +167,37 @@ bool FullTableScan::internalGetRecord(thread_db* tdbb) const
 	return false;
 }
 
+bool FullTableScan::internalGetBatch(thread_db* tdbb, RecordBatch& batch) const
+{
+	JRD_reschedule(tdbb);
+
+	Request* const request = tdbb->getRequest();
+	record_param* const rpb = &request->req_rpb[m_stream];
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	if (!(impure->irsb_flags & irsb_open))
+	{
+		rpb->rpb_number.setValid(false);
+		return false;
+	}
+
+	const RecordNumber* upper = impure->irsb_upper.isValid() ? &impure->irsb_upper : nullptr;
+
+	while (!batch.isFull())
+	{
+		if (!VIO_next_record(tdbb, rpb, request->req_transaction, request->req_pool, DPM_next_all, upper))
+		{
+			rpb->rpb_number.setValid(false);
+			break;
+		}
+
+		rpb->rpb_number.setValid(true);
+		batch.exchange(request->req_rpb.begin());
+	}
+
+	return batch.getCount() != 0;
+}
+
 void FullTableScan::getLegacyPlan(thread_db* tdbb, string& plan, unsigned level) const
 {
 	if (!level)
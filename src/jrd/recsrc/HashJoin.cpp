@@ -21,10 +21,12 @@
  */
 
 #include "firebird.h"
+#include <algorithm>
 #include "../common/classes/Aligner.h"
 #include "../common/classes/Hash.h"
 #include "../jrd/jrd.h"
 #include "../jrd/req.h"
+#include "../jrd/TempSpace.h"
 #include "../jrd/intl.h"
 #include "../jrd/cmp_proto.h"
 #include "../jrd/evl_proto.h"
@@ -43,209 +45,508 @@ using namespace Jrd;
 // Data access: hash join
 // ----------------------
 
-// NS: FIXME - Why use static hash table here??? Hash table shall support dynamic resizing
-static constexpr ULONG HASH_SIZE = 1009;
-static constexpr ULONG BUCKET_PREALLOCATE_SIZE = 32;	// 256 bytes per bucket
+// The hash table is split into partitions by the highest bits of the mixed hash value.
+// If the table does not fit into HashJoinMemoryLimit, the largest partitions are written
+// into the temporary space. Leading records hashed into such partitions are put aside
+// and joined after the leading stream is exhausted, one partition at a time.
 
-unsigned HashJoin::maxCapacity() noexcept
-{
-	// Binary search across 1000 collisions is computationally similar to
-	// linear search across 10 collisions. We use this number as a rough
-	// estimation of whether the lookup performance is likely to be acceptable.
-	return HASH_SIZE * 1000;
-}
+static constexpr ULONG PARTITION_BITS = 6;
+static constexpr ULONG PARTITION_COUNT = 1 << PARTITION_BITS;
+static constexpr ULONG INVALID_PARTITION = MAX_ULONG;
+static constexpr ULONG SPILL_RUN_SIZE = 1024;		// entries per run written to the temporary space
+static constexpr ULONG MIN_DIRECTORY_SIZE = 16;		// must be a power of 2
+static constexpr ULONG EMPTY_SLOT = MAX_ULONG;
+
+static const char* const SCRATCH = "fb_hash_";
 
 
 class HashJoin::HashTable final : public PermanentStorage
 {
-	class CollisionList
+	struct Entry
 	{
-		static constexpr FB_SIZE_T INVALID_ITERATOR = FB_SIZE_T(~0);
-
-		struct Entry
+		bool operator<(const Entry& other) const noexcept
 		{
-			Entry() noexcept
-				: hash(0), position(0)
-			{}
+			return (hash < other.hash) || (hash == other.hash && position < other.position);
+		}
 
-			Entry(ULONG h, ULONG pos) noexcept
-				: hash(h), position(pos)
-			{}
+		ULONG hash;
+		ULONG position;
+	};
 
-			static const ULONG generate(const Entry& item) noexcept
-			{
-				return item.hash;
-			}
+	// Memory used per hashed record: the entry itself plus up to two directory slots
+	static constexpr ULONG ENTRY_COST = sizeof(Entry) + 2 * sizeof(ULONG);
 
-			ULONG hash;
-			ULONG position;
+	// Entries of a single stream inside a single partition. After the build they're sorted,
+	// so that all collisions are adjacent, and the directory (open addressing with linear
+	// probing) maps every distinct hash value to its first entry. Entries of a spilled
+	// partition are stored in the temporary space as a sequence of runs.
+
+	class EntryList
+	{
+		struct Run
+		{
+			offset_t offset;
+			ULONG count;
 		};
 
 	public:
-		CollisionList(MemoryPool& pool)
-			: m_collisions(pool, BUCKET_PREALLOCATE_SIZE),
-			  m_iterator(INVALID_ITERATOR)
+		explicit EntryList(MemoryPool& pool)
+			: m_entries(pool), m_directory(pool), m_runs(pool), m_chunk(pool)
+		{}
+
+		ULONG getCount() const noexcept
 		{
-			m_collisions.setSortMode(FB_ARRAY_SORT_MANUAL);
+			return m_entries.getCount();
 		}
 
-		void sort()
+		void add(ULONG hash, ULONG position)
 		{
-			m_collisions.sort();
+			m_entries.add({hash, position});
 		}
 
-		ULONG getCount() const noexcept
+		void spill(TempSpace* space)
 		{
-			return (ULONG) m_collisions.getCount();
+			const ULONG count = m_entries.getCount();
+
+			if (!count)
+				return;
+
+			const FB_SIZE_T length = count * sizeof(Entry);
+			const offset_t offset = space->allocateSpace(length);
+			space->write(offset, m_entries.begin(), length);
+
+			m_runs.add({offset, count});
+
+			m_entries.free();
+			m_directory.free();
 		}
 
-		void add(ULONG hash, ULONG position)
+		void load(TempSpace* space)
 		{
-			m_collisions.add(Entry(hash, position));
+			FB_SIZE_T count = m_entries.getCount();
+			FB_SIZE_T total = count;
+
+			for (const auto& run : m_runs)
+				total += run.count;
+
+			// Order of entries does not matter, they're sorted afterwards
+
+			Entry* const ptr = m_entries.getBuffer(total);
+
+			for (const auto& run : m_runs)
+			{
+				const FB_SIZE_T length = run.count * sizeof(Entry);
+				space->read(run.offset, ptr + count, length);
+				space->releaseSpace(run.offset, length);
+				count += run.count;
+			}
+
+			m_runs.free();
 		}
 
-		bool locate(ULONG hash)
+		// Return the spilled entries one by one, reading them run by run
+		bool next(TempSpace* space, ULONG& position)
 		{
-			if (m_collisions.find(hash, m_iterator))
-				return true;
+			while (m_cursor == m_chunk.getCount())
+			{
+				m_cursor = 0;
 
-			m_iterator = INVALID_ITERATOR;
-			return false;
+				if (m_nextRun < m_runs.getCount())
+				{
+					const auto& run = m_runs[m_nextRun++];
+					const FB_SIZE_T length = run.count * sizeof(Entry);
+					space->read(run.offset, m_chunk.getBuffer(run.count, false), length);
+					space->releaseSpace(run.offset, length);
+				}
+				else if (m_entries.hasData())
+				{
+					m_chunk.assign(m_entries);
+					m_entries.free();
+				}
+				else
+				{
+					m_chunk.free();
+					return false;
+				}
+			}
+
+			position = m_chunk[m_cursor++].position;
+			return true;
 		}
 
-		bool iterate(ULONG hash, ULONG& position) noexcept
+		void prepare()
 		{
-			if (m_iterator >= m_collisions.getCount())
-				return false;
+			if (m_entries.isEmpty())
+				return;
+
+			std::sort(m_entries.begin(), m_entries.end());
+
+			ULONG distinct = 1;
+			for (ULONG i = 1; i < m_entries.getCount(); i++)
+			{
+				if (m_entries[i].hash != m_entries[i - 1].hash)
+					distinct++;
+			}
+
+			// Keep the directory load factor at or below 50%
+
+			ULONG size = MIN_DIRECTORY_SIZE;
+			while (size < distinct * 2)
+				size <<= 1;
 
-			const Entry& collision = m_collisions[m_iterator++];
+			m_directory.resize(size, EMPTY_SLOT);
+			const ULONG mask = size - 1;
 
-			if (hash != collision.hash)
+			for (ULONG i = 0; i < m_entries.getCount(); i++)
 			{
-				m_iterator = INVALID_ITERATOR;
+				if (i && m_entries[i].hash == m_entries[i - 1].hash)
+					continue;
+
+				ULONG slot = m_entries[i].hash & mask;
+				while (m_directory[slot] != EMPTY_SLOT)
+					slot = (slot + 1) & mask;
+
+				m_directory[slot] = i;
+			}
+		}
+
+		bool locate(ULONG hash, ULONG& index) const noexcept
+		{
+			if (m_directory.isEmpty())
 				return false;
+
+			const ULONG mask = m_directory.getCount() - 1;
+
+			for (ULONG slot = hash & mask; m_directory[slot] != EMPTY_SLOT; slot = (slot + 1) & mask)
+			{
+				if (m_entries[m_directory[slot]].hash == hash)
+				{
+					index = m_directory[slot];
+					return true;
+				}
 			}
 
-			position = collision.position;
+			return false;
+		}
+
+		bool iterate(ULONG& index, ULONG hash, ULONG& position) const noexcept
+		{
+			if (index >= m_entries.getCount() || m_entries[index].hash != hash)
+				return false;
+
+			position = m_entries[index++].position;
 			return true;
 		}
 
+#ifdef PRINT_HASH_TABLE
+		ULONG getDirectorySize() const noexcept
+		{
+			return m_directory.getCount();
+		}
+#endif
+
 	private:
-		SortedArray<Entry, EmptyStorage<Entry>, ULONG, Entry> m_collisions;
-		FB_SIZE_T m_iterator;
+		Array<Entry> m_entries;
+		Array<ULONG> m_directory;
+		Array<Run> m_runs;
+		Array<Entry> m_chunk;
+		FB_SIZE_T m_nextRun = 0;
+		FB_SIZE_T m_cursor = 0;
 	};
 
 public:
-	HashTable(MemoryPool& pool, ULONG streamCount, ULONG tableSize = HASH_SIZE)
+	HashTable(MemoryPool& pool, ULONG streamCount, FB_UINT64 memoryLimit)
 		: PermanentStorage(pool), m_streamCount(streamCount),
-		  m_tableSize(tableSize), m_slot(0)
+		  m_memoryLimit(memoryLimit), m_memoryUsage(0),
+		  m_space(nullptr), m_partition(INVALID_PARTITION), m_spilled(false),
+		  m_probePartition(0)
 	{
-		m_collisions = FB_NEW_POOL(pool) CollisionList*[streamCount * tableSize];
-		memset(m_collisions, 0, streamCount * tableSize * sizeof(CollisionList*));
+		m_lists = FB_NEW_POOL(pool) EntryList*[PARTITION_COUNT * streamCount];
+		memset(m_lists, 0, PARTITION_COUNT * streamCount * sizeof(EntryList*));
+
+		memset(m_deferred, 0, sizeof(m_deferred));
+		memset(m_spilledPartitions, 0, sizeof(m_spilledPartitions));
+
+		m_starts = FB_NEW_POOL(pool) ULONG[streamCount];
+		m_iterators = FB_NEW_POOL(pool) ULONG[streamCount];
 	}
 
 	~HashTable()
 	{
-		for (ULONG i = 0; i < m_streamCount * m_tableSize; i++)
-			delete m_collisions[i];
+		for (ULONG i = 0; i < PARTITION_COUNT * m_streamCount; i++)
+			delete m_lists[i];
 
-		delete[] m_collisions;
+		for (ULONG i = 0; i < PARTITION_COUNT; i++)
+			delete m_deferred[i];
+
+		delete[] m_lists;
+		delete[] m_starts;
+		delete[] m_iterators;
+		delete m_space;
 	}
 
-	void put(ULONG stream, ULONG hash, ULONG position)
+	bool isSpilled() const noexcept
 	{
-		const ULONG slot = hash % m_tableSize;
+		return m_spilled;
+	}
+
+	// Whether the deferred leading records are being joined
+	bool isJoiningDeferred() const noexcept
+	{
+		return m_partition != INVALID_PARTITION;
+	}
 
+	void put(ULONG stream, ULONG hash, ULONG position)
+	{
 		fb_assert(stream < m_streamCount);
-		fb_assert(slot < m_tableSize);
 
-		CollisionList* collisions = m_collisions[stream * m_tableSize + slot];
+		const ULONG partition = getPartition(hash);
+		EntryList*& list = m_lists[partition * m_streamCount + stream];
+
+		if (!list)
+			list = FB_NEW_POOL(getPool()) EntryList(getPool());
+
+		list->add(hash, position);
 
-		if (!collisions)
+		if (m_spilledPartitions[partition])
 		{
-			collisions = FB_NEW_POOL(getPool()) CollisionList(getPool());
-			m_collisions[stream * m_tableSize + slot] = collisions;
+			if (list->getCount() >= SPILL_RUN_SIZE)
+				list->spill(m_space);
+
+			return;
 		}
 
-		collisions->add(hash, position);
+		m_memoryUsage += ENTRY_COST;
+
+		if (m_memoryUsage > m_memoryLimit)
+			spillPartition();
+	}
+
+	void prepare()
+	{
+		for (ULONG partition = 0; partition < PARTITION_COUNT; partition++)
+		{
+			if (m_spilledPartitions[partition])
+				continue;
+
+			for (ULONG i = 0; i < m_streamCount; i++)
+			{
+				if (const auto list = m_lists[partition * m_streamCount + i])
+					list->prepare();
+			}
+		}
+
+#ifdef PRINT_HASH_TABLE
+		FB_UINT64 total = 0, slots = 0;
+		ULONG min = MAX_ULONG, max = 0, count = 0;
+
+		for (ULONG i = 0; i < PARTITION_COUNT * m_streamCount; i++)
+		{
+			EntryList* const list = m_lists[i];
+			if (!list || m_spilledPartitions[i / m_streamCount])
+				continue;
+
+			const auto cnt = list->getCount();
+
+			if (cnt < min)
+				min = cnt;
+			if (cnt > max)
+				max = cnt;
+			total += cnt;
+			slots += list->getDirectorySize();
+			count++;
+		}
+
+		if (count)
+		{
+			printf("Hash table partitions %u, resident count %u, directory slots %u, min %u, max %u, avg %u, spilled %s\n",
+				   count, (ULONG) total, (ULONG) slots, min, max, (ULONG) (total / count),
+				   m_spilled ? "yes" : "no");
+		}
+#endif
+	}
+
+	// Put aside the leading record if its partition is spilled
+	bool defer(ULONG hash, ULONG position)
+	{
+		const ULONG partition = getPartition(hash);
+
+		if (isJoiningDeferred() || !m_spilledPartitions[partition])
+			return false;
+
+		EntryList*& list = m_deferred[partition];
+
+		if (!list)
+			list = FB_NEW_POOL(getPool()) EntryList(getPool());
+
+		list->add(hash, position);
+
+		if (list->getCount() >= SPILL_RUN_SIZE)
+			list->spill(m_space);
+
+		return true;
+	}
+
+	// Load the next spilled partition having deferred leading records
+	bool nextPartition()
+	{
+		if (m_partition == INVALID_PARTITION)
+		{
+			// The leading stream is exhausted, the resident partitions are not needed anymore
+
+			for (ULONG partition = 0; partition < PARTITION_COUNT; partition++)
+			{
+				if (!m_spilledPartitions[partition])
+					releasePartition(partition);
+			}
+
+			m_partition = 0;
+		}
+		else if (m_partition < PARTITION_COUNT)
+			releasePartition(m_partition++);
+
+		for (; m_partition < PARTITION_COUNT; m_partition++)
+		{
+			if (!m_deferred[m_partition])
+			{
+				releasePartition(m_partition);
+				continue;
+			}
+
+			for (ULONG i = 0; i < m_streamCount; i++)
+			{
+				if (const auto list = m_lists[m_partition * m_streamCount + i])
+				{
+					list->load(m_space);
+					list->prepare();
+				}
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+	bool nextDeferred(ULONG& position)
+	{
+		if (m_partition >= PARTITION_COUNT)
+			return false;
+
+		return m_deferred[m_partition]->next(m_space, position);
 	}
 
 	bool setup(ULONG hash)
 	{
-		const ULONG slot = hash % m_tableSize;
+		const ULONG partition = getPartition(hash);
 
 		for (ULONG i = 0; i < m_streamCount; i++)
 		{
-			CollisionList* const collisions = m_collisions[i * m_tableSize + slot];
+			const EntryList* const list = m_lists[partition * m_streamCount + i];
 
-			if (!collisions)
+			if (!list)
 				return false;
 
-			if (!collisions->locate(hash))
+			if (!list->locate(hash, m_starts[i]))
 				return false;
+
+			m_iterators[i] = m_starts[i];
 		}
 
-		m_slot = slot;
+		m_probePartition = partition;
 		return true;
 	}
 
-	void reset(ULONG stream, ULONG hash)
+	void reset(ULONG stream, ULONG /*hash*/) noexcept
 	{
 		fb_assert(stream < m_streamCount);
 
-		CollisionList* const collisions = m_collisions[stream * m_tableSize + m_slot];
-		collisions->locate(hash);
+		m_iterators[stream] = m_starts[stream];
 	}
 
 	bool iterate(ULONG stream, ULONG hash, ULONG& position) noexcept
 	{
 		fb_assert(stream < m_streamCount);
 
-		CollisionList* const collisions = m_collisions[stream * m_tableSize + m_slot];
-		return collisions->iterate(hash, position);
+		const EntryList* const list = m_lists[m_probePartition * m_streamCount + stream];
+		return list->iterate(m_iterators[stream], hash, position);
 	}
 
-	void sort()
+private:
+	static ULONG getPartition(ULONG hash) noexcept
 	{
-		for (ULONG i = 0; i < m_streamCount * m_tableSize; i++)
-		{
-			if (const auto collisions = m_collisions[i])
-				collisions->sort();
-		}
+		// Fibonacci hashing, to not depend on the distribution of the high bits
+		return (ULONG) (hash * 0x9E3779B1U) >> (32 - PARTITION_BITS);
+	}
 
-#ifdef PRINT_HASH_TABLE
-		FB_UINT64 total = 0;
-		ULONG min = MAX_ULONG, max = 0, count = 0;
+	// Write the largest resident partition into the temporary space
+	void spillPartition()
+	{
+		ULONG victim = INVALID_PARTITION;
+		FB_UINT64 victimCount = 0;
 
-		for (ULONG i = 0; i < m_streamCount * m_tableSize; i++)
+		for (ULONG partition = 0; partition < PARTITION_COUNT; partition++)
 		{
-			CollisionList* const collisions = m_collisions[i];
-			if (!collisions)
+			if (m_spilledPartitions[partition])
 				continue;
 
-			const auto cnt = collisions->getCount();
+			FB_UINT64 count = 0;
 
-			if (cnt < min)
-				min = cnt;
-			if (cnt > max)
-				max = cnt;
-			total += cnt;
-			count++;
+			for (ULONG i = 0; i < m_streamCount; i++)
+			{
+				if (const auto list = m_lists[partition * m_streamCount + i])
+					count += list->getCount();
+			}
+
+			if (count > victimCount)
+			{
+				victim = partition;
+				victimCount = count;
+			}
 		}
 
-		if (count)
+		if (victim == INVALID_PARTITION)
+			return;
+
+		if (!m_space)
+			m_space = FB_NEW_POOL(getPool()) TempSpace(getPool(), SCRATCH, false);
+
+		for (ULONG i = 0; i < m_streamCount; i++)
 		{
-			printf("Hash table size %u, count %u, buckets %u, min %u, max %u, avg %u\n",
-				   m_tableSize, (ULONG) total, count, min, max, (ULONG) (total / count));
+			if (const auto list = m_lists[victim * m_streamCount + i])
+				list->spill(m_space);
 		}
-#endif
+
+		m_memoryUsage -= victimCount * ENTRY_COST;
+		m_spilledPartitions[victim] = true;
+		m_spilled = true;
+	}
+
+	void releasePartition(ULONG partition)
+	{
+		for (ULONG i = 0; i < m_streamCount; i++)
+		{
+			EntryList*& list = m_lists[partition * m_streamCount + i];
+			delete list;
+			list = nullptr;
+		}
+
+		delete m_deferred[partition];
+		m_deferred[partition] = nullptr;
 	}
 
-private:
 	const ULONG m_streamCount;
-	const ULONG m_tableSize;
-	CollisionList** m_collisions;
-	ULONG m_slot;
+	const FB_UINT64 m_memoryLimit;
+	FB_UINT64 m_memoryUsage;
+	EntryList** m_lists;
+	EntryList* m_deferred[PARTITION_COUNT];
+	bool m_spilledPartitions[PARTITION_COUNT];
+	TempSpace* m_space;
+	ULONG m_partition;
+	bool m_spilled;
+	ULONG m_probePartition;
+	ULONG* m_starts;
+	ULONG* m_iterators;
 };
 
 
@@ -285,6 +586,9 @@ void HashJoin::init(thread_db* tdbb, CompilerScratch* csb, FB_SIZE_T count,
 	m_cardinality = m_leader.source->getCardinality();
 	m_args.add(m_leader.source);
 
+	// Used only if the hash table gets spilled into the temporary space
+	m_bufferedLeader = FB_NEW_POOL(csb->csb_pool) BufferedStream(csb, m_leader.source);
+
 	for (FB_SIZE_T j = 0; j < leaderKeyCount; j++)
 	{
 		dsc desc;
@@ -374,6 +678,7 @@ void HashJoin::internalOpen(thread_db* tdbb) const
 	delete[] impure->irsb_leader_buffer;
 	impure->irsb_leader_buffer = nullptr;
 
+	m_bufferedLeader->close(tdbb);
 	m_leader.source->open(tdbb);
 }
 
@@ -389,6 +694,7 @@ void HashJoin::close(thread_db* tdbb) const
 		impure->irsb_flags &= ~irsb_open;
 
 		Join::close(tdbb);
+		m_bufferedLeader->close(tdbb);
 
 		delete impure->irsb_hash_table;
 		impure->irsb_hash_table = nullptr;
@@ -414,9 +720,10 @@ bool HashJoin::internalGetRecord(thread_db* tdbb) const
 	{
 		if (impure->irsb_flags & irsb_mustread)
 		{
-			// Fetch the record from the leading stream
+			// Fetch the record from the leading stream.
+			// The hash table is initialized along with the first record.
 
-			if (!m_leader.source->getRecord(tdbb))
+			if (!fetchLeader(tdbb, impure))
 				return false;
 
 			if (m_boolean && m_boolean->execute(tdbb, request) != TriState(true))
@@ -427,47 +734,28 @@ bool HashJoin::internalGetRecord(thread_db* tdbb) const
 				return true;
 			}
 
-			// We have something to join with, so ensure the hash table is initialized
-
-			if (!impure->irsb_hash_table && !impure->irsb_leader_buffer)
-			{
-				auto& pool = *tdbb->getDefaultPool();
-				const auto argCount = m_subs.getCount();
-
-				impure->irsb_hash_table = FB_NEW_POOL(pool) HashTable(pool, argCount);
-				impure->irsb_leader_buffer = FB_NEW_POOL(pool) UCHAR[m_leader.totalKeyLength];
+			HashTable* const hashTable = impure->irsb_hash_table;
 
-				UCharBuffer buffer(pool);
-
-				for (FB_SIZE_T i = 0; i < argCount; i++)
-				{
-					// Read and cache the inner streams. While doing that,
-					// hash the join condition values and populate hash tables.
+			// Compute and hash the comparison keys
 
-					m_subs[i].buffer->open(tdbb);
+			impure->irsb_leader_hash =
+				computeHash(tdbb, request, m_leader, impure->irsb_leader_buffer);
 
-					ULONG counter = 0;
-					const auto keyBuffer = buffer.getBuffer(m_subs[i].totalKeyLength, false);
+			// If the hash table partition for this record is spilled,
+			// put the record aside to be joined after the leading stream is exhausted
 
-					while (m_subs[i].buffer->getRecord(tdbb))
-					{
-						const auto hash = computeHash(tdbb, request, m_subs[i], keyBuffer);
-						impure->irsb_hash_table->put(i, hash, counter++);
-					}
-				}
+			if (hashTable->isSpilled())
+			{
+				const auto position = m_bufferedLeader->getPosition(request) - 1;
 
-				impure->irsb_hash_table->sort();
+				if (hashTable->defer(impure->irsb_leader_hash, (ULONG) position))
+					continue;
 			}
 
-			// Compute and hash the comparison keys
-
-			impure->irsb_leader_hash =
-				computeHash(tdbb, request, m_leader, impure->irsb_leader_buffer);
-
 			// Ensure the every inner stream having matches for this hash slot.
 			// Setup the hash table for the iteration through collisions.
 
-			if (!impure->irsb_hash_table->setup(impure->irsb_leader_hash))
+			if (!hashTable->setup(impure->irsb_leader_hash))
 			{
 				if (m_joinType == JoinType::INNER || m_joinType == JoinType::SEMI)
 					continue;
@@ -558,6 +846,83 @@ void HashJoin::internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsigned l
 	Join::internalGetPlan(tdbb, planEntry, level, recurse);
 }
 
+void HashJoin::buildHashTable(thread_db* tdbb, Impure* impure) const
+{
+	Request* const request = tdbb->getRequest();
+	auto& pool = *tdbb->getDefaultPool();
+	const auto argCount = m_subs.getCount();
+	const auto memoryLimit = tdbb->getDatabase()->dbb_config->getHashJoinMemoryLimit();
+
+	impure->irsb_hash_table = FB_NEW_POOL(pool) HashTable(pool, argCount, memoryLimit);
+	impure->irsb_leader_buffer = FB_NEW_POOL(pool) UCHAR[m_leader.totalKeyLength];
+
+	UCharBuffer buffer(pool);
+
+	for (FB_SIZE_T i = 0; i < argCount; i++)
+	{
+		// Read and cache the inner streams. While doing that,
+		// hash the join condition values and populate hash tables.
+
+		m_subs[i].buffer->open(tdbb);
+
+		ULONG counter = 0;
+		const auto keyBuffer = buffer.getBuffer(m_subs[i].totalKeyLength, false);
+
+		while (m_subs[i].buffer->getRecord(tdbb))
+		{
+			const auto hash = computeHash(tdbb, request, m_subs[i], keyBuffer);
+			impure->irsb_hash_table->put(i, hash, counter++);
+		}
+	}
+
+	impure->irsb_hash_table->prepare();
+}
+
+bool HashJoin::fetchLeader(thread_db* tdbb, Impure* impure) const
+{
+	HashTable* const hashTable = impure->irsb_hash_table;
+
+	if (!hashTable)
+	{
+		// Don't bother with the inner streams if the leading one is empty
+
+		if (!m_leader.source->getRecord(tdbb))
+			return false;
+
+		buildHashTable(tdbb, impure);
+
+		if (!impure->irsb_hash_table->isSpilled())
+			return true;
+
+		// Some partitions of the hash table are spilled, so the leading records
+		// may need to be revisited. Restart the leading stream through the buffer.
+
+		m_bufferedLeader->open(tdbb);
+	}
+	else if (!hashTable->isSpilled())
+		return m_leader.source->getRecord(tdbb);
+
+	if (!impure->irsb_hash_table->isJoiningDeferred() && m_bufferedLeader->getRecord(tdbb))
+		return true;
+
+	// The leading stream is exhausted, join the deferred records partition by partition
+
+	ULONG position;
+
+	while (!impure->irsb_hash_table->nextDeferred(position))
+	{
+		if (!impure->irsb_hash_table->nextPartition())
+			return false;
+	}
+
+	m_bufferedLeader->locate(tdbb, position);
+
+	if (!m_bufferedLeader->getRecord(tdbb))
+		fb_assert(false);
+
+	return true;
+}
+
 ULONG HashJoin::computeHash(thread_db* tdbb,
 							Request* request,
 						    const SubStream& sub,
@@ -22,9 +22,11 @@
 #include "../jrd/exe.h"
 #include "../jrd/btr.h"
 #include "../jrd/req.h"
+#include "../jrd/tra.h"
 #include "../jrd/btr_proto.h"
 #include "../jrd/cch_proto.h"
 #include "../jrd/cmp_proto.h"
+#include "../jrd/dpm_proto.h"
 #include "../jrd/evl_proto.h"
 #include "../jrd/met_proto.h"
 #include "../jrd/vio_proto.h"
@@ -45,7 +47,7 @@ IndexTableScan::IndexTableScan(CompilerScratch* csb, const string& alias,
 							   double selectivity)
 	: RecordStream(csb, stream),
 	  m_alias(csb->csb_pool, alias), m_relation(relation), m_index(index),
-	  m_inversion(NULL), m_condition(NULL), m_length(length), m_offset(0)
+	  m_inversion(NULL), m_condition(NULL), m_length(length), m_offset(0), m_payload(false)
 {
 	fb_assert(m_index);
 
@@ -73,6 +75,9 @@ void IndexTableScan::internalOpen(thread_db* tdbb) const
 
 	rpb->rpb_number.setValue(BOF_NUMBER);
 
+	impure->irsb_visible_sequence = MAX_ULONG;
+	impure->irsb_visible = false;
+
 	fb_assert(!impure->irsb_nav_lower);
 	impure->irsb_nav_current_lower = impure->irsb_nav_lower = FB_NEW_POOL(*tdbb->getDefaultPool()) temporary_key;
 
@@ -330,8 +335,35 @@ bool IndexTableScan::internalGetRecord(thread_db* tdbb) const
 			rpb->rpb_number = number;
 			setPosition(tdbb, impure, rpb, &window, pointer, key);
 
+			// Records of the pages visible to everybody are built of the index payload,
+			// so keep it before the index page is released
+
+			HalfStaticArray<UCHAR, 256> payload;
+
+			if ((rpb->rpb_stream_flags & RPB_s_index_payload) && node.hasPayload())
+				payload.assign(node.payload, node.payloadLength);
+
 			CCH_RELEASE(tdbb, &window);
 
+			if (payload.hasData() && isVisible(tdbb, number.getValue()))
+			{
+				const auto format = rpb->rpb_relation->currentFormat(tdbb);
+				const auto record = VIO_record(tdbb, rpb, format, request->req_pool);
+
+				rpb->rpb_format_number = format->fmt_version;
+				rpb->rpb_runtime_flags &= ~RPB_CLEAR_FLAGS;
+				record->nullify();
+
+				if (BTR_get_payload(tdbb, record, idx, payload.begin(), payload.getCount()))
+				{
+					RBM_SET(tdbb->getDefaultPool(), &impure->irsb_nav_records_visited,
+							rpb->rpb_number.getValue());
+
+					rpb->rpb_number.setValid(true);
+					return true;
+				}
+			}
+
 			if (VIO_get(tdbb, rpb, request->req_transaction, request->req_pool))
 			{
 				if (const auto result = recordKey.compose(rpb->rpb_record))
@@ -396,7 +428,8 @@ void IndexTableScan::internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsi
 	planEntry.className = "IndexTableScan";
 
 	planEntry.lines.add().text = "Table " +
-		printName(tdbb, m_relation()->getName().toQuotedString(), m_alias) + " Access By ID";
+		printName(tdbb, m_relation()->getName().toQuotedString(), m_alias) + " Access By ID" +
+		(m_payload ? " (Index Only)" : "");
 	printOptInfo(planEntry.lines);
 
 	printInversion(tdbb, m_index, planEntry.lines, true, 1, true);
@@ -411,6 +444,33 @@ void IndexTableScan::internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsi
 		printInversion(tdbb, m_inversion, planEntry.lines, true, 2, false);
 }
 
+bool IndexTableScan::isVisible(thread_db* tdbb, FB_UINT64 number) const
+{
+	Request* const request = tdbb->getRequest();
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+	const Database* const dbb = tdbb->getDatabase();
+
+	const ULONG sequence = (ULONG) (number / dbb->dbb_max_records);
+
+	// Own changes made during the scan are not reflected by the cached state,
+	// so use it only until the transaction writes something
+
+	const bool cache = !(request->req_transaction->tra_flags & TRA_write);
+
+	if (cache && sequence == impure->irsb_visible_sequence)
+		return impure->irsb_visible;
+
+	const bool visible = DPM_all_visible(tdbb, request->req_rpb[m_stream].rpb_relation, sequence);
+
+	if (cache)
+	{
+		impure->irsb_visible_sequence = sequence;
+		impure->irsb_visible = visible;
+	}
+
+	return visible;
+}
+
 int IndexTableScan::compareKeys(const index_desc* idx,
 								const UCHAR* key_string1,
 								USHORT length1,
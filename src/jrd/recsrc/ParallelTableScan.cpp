@@ -0,0 +1,812 @@
+/*
+ *  The contents of this file are subject to the Initial
+ *  Developer's Public License Version 1.0 (the "License");
+ *  you may not use this file except in compliance with the
+ *  License. You may obtain a copy of the License at
+ *  http://www.ibphoenix.com/main.nfs?a=ibphoenix&page=ibp_idpl.
+ *
+ *  Software distributed under the License is distributed AS IS,
+ *  WITHOUT WARRANTY OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing rights
+ *  and limitations under the License.
+ *
+ *  The Original Code was created for the Firebird Open Source RDBMS project.
+ *
+ *  Copyright (c) 2026 the Firebird Project and all contributors signed below.
+ *
+ *  All Rights Reserved.
+ *  Contributor(s): ______________________________________.
+ */
+
+#include "firebird.h"
+#include "../common/Task.h"
+#include "../common/StatusArg.h"
+#include "../jrd/jrd.h"
+#include "../jrd/req.h"
+#include "../jrd/tra.h"
+#include "../jrd/met.h"
+#include "../jrd/cch_proto.h"
+#include "../jrd/dpm_proto.h"
+#include "../jrd/tra_proto.h"
+#include "../jrd/vio_proto.h"
+#include "../jrd/rlck_proto.h"
+#include "../jrd/Attachment.h"
+#include "../jrd/WorkerAttachment.h"
+#include "../jrd/RecordBatch.h"
+#include "../dsql/Nodes.h"
+#include "../jrd/optimizer/Optimizer.h"
+
+#include "RecordSource.h"
+
+using namespace Firebird;
+using namespace Jrd;
+
+// ---------------------------------------------
+// Data access: parallel sequential table scan
+// ---------------------------------------------
+
+// The table is split into chunks of CHUNK_PAGES data pages. Chunks are scanned by the
+// parallel workers in rounds, every worker having its own attachment and a read-only
+// transaction started at the snapshot of the request. Records found visible are copied
+// into per-chunk buffers and then returned by the main thread in the chunk order, so
+// the order of records is the same as with the serial scan.
+//
+// Conditions of the stream that need nothing but its own fields and literals are evaluated
+// by the workers for the batches of records read, so only the matching records are copied.
+// The records the batch evaluation can't handle are copied too, the filter above the scan
+// checks the whole condition anyway.
+//
+// When the workers evaluate the whole condition and the scan feeds the aggregation without
+// groups, they also compute the partial states of the aggregates for the matching records
+// of every batch instead of copying them. The main thread merges these states into the
+// request after the round, see pushAggregates(). Batches the aggregates can't handle are
+// copied as usual.
+
+static constexpr USHORT CHUNK_PAGES = 16;
+static constexpr ULONG ROUND_CHUNKS_PER_WORKER = 2;
+
+
+class ParallelTableScan::ScanTask final : public Task
+{
+	// Header of the record stored in the chunk buffer, record data follows it
+	struct RecordHeader
+	{
+		SINT64 number;
+		TraNumber transaction;
+		ULONG length;
+		USHORT format;
+	};
+
+	static constexpr FB_SIZE_T HEADER_LENGTH = FB_ALIGN(sizeof(RecordHeader), FB_DOUBLE_ALIGN);
+
+	// Partial states of the aggregates computed for the chunk
+	struct ChunkStates
+	{
+		explicit ChunkStates(MemoryPool& pool)
+			: states(pool)
+		{}
+
+		Array<impure_value_ex> states;	// states of all the aggregates per batch
+		SINT64 records = 0;				// number of records aggregated
+	};
+
+public:
+	ScanTask(thread_db* tdbb, MemoryPool* pool, Cached::Relation* relation, StreamType stream,
+			 const BoolExprNode* boolean, const Array<const AggNode*>* aggregates,
+			 CommitNumber snapshot, int workers, ULONG chunkCount, USHORT windowFlags)
+		: Task(),
+		  m_pool(pool),
+		  m_dbb(tdbb->getDatabase()),
+		  m_relationId(relation->getId()),
+		  m_stream(stream),
+		  m_boolean(boolean),
+		  m_aggregates(aggregates),
+		  m_snapshot(snapshot),
+		  m_windowFlags(windowFlags),
+		  m_coordinator(pool),
+		  m_items(*pool),
+		  m_chunks(*pool),
+		  m_states(*pool),
+		  m_stop(false),
+		  m_chunkCount(chunkCount),
+		  m_nextChunk(0),
+		  m_roundStart(0),
+		  m_roundEnd(0),
+		  m_readChunk(0),
+		  m_readOffset(0)
+	{
+		for (int i = 0; i < workers; i++)
+			m_items.add(FB_NEW_POOL(*m_pool) Item(this));
+
+		const ULONG roundChunks = workers * ROUND_CHUNKS_PER_WORKER;
+
+		for (ULONG i = 0; i < roundChunks; i++)
+			m_chunks.add(FB_NEW_POOL(*m_pool) UCharBuffer(*m_pool));
+
+		if (m_aggregates)
+		{
+			for (ULONG i = 0; i < roundChunks; i++)
+				m_states.add(FB_NEW_POOL(*m_pool) ChunkStates(*m_pool));
+		}
+	}
+
+	~ScanTask()
+	{
+		for (auto item : m_items)
+			delete item;
+
+		for (auto chunk : m_chunks)
+			delete chunk;
+
+		for (auto states : m_states)
+			delete states;
+	}
+
+	class Item : public Task::WorkItem
+	{
+	public:
+		Item(ScanTask* task) : Task::WorkItem(task),
+			m_inuse(false),
+			m_tra(NULL),
+			m_chunk(0)
+		{}
+
+		virtual ~Item()
+		{
+			if (!m_attStable)
+				return;
+
+			Attachment* att = NULL;
+			{
+				AttSyncLockGuard guard(*m_attStable->getSync(), FB_FUNCTION);
+				att = m_attStable->getHandle();
+				if (!att)
+					return;
+				fb_assert(att->att_use_count > 0);
+			}
+
+			FbLocalStatus status;
+			if (m_tra)
+			{
+				BackgroundContextHolder tdbb(att->att_database, att, &status, FB_FUNCTION);
+				TRA_commit(tdbb, m_tra, false);
+			}
+			WorkerAttachment::releaseAttachment(&status, m_attStable);
+		}
+
+		ScanTask* getScanTask() const
+		{
+			return reinterpret_cast<ScanTask*> (m_task);
+		}
+
+		bool init(thread_db* tdbb)
+		{
+			FbStatusVector* status = tdbb->tdbb_status_vector;
+
+			Attachment* att = NULL;
+
+			if (!m_attStable.hasData())
+				m_attStable = WorkerAttachment::getAttachment(status, getScanTask()->m_dbb);
+
+			if (m_attStable)
+				att = m_attStable->getHandle();
+
+			if (!att)
+			{
+				if (!status->hasData())
+					Arg::Gds(isc_bad_db_handle).copyTo(status);
+
+				return false;
+			}
+
+			tdbb->setDatabase(att->att_database);
+			tdbb->setAttachment(att);
+
+			if (!m_tra)
+			{
+				// Read-only transaction that sees the same snapshot as the request
+
+				const CommitNumber snapshot = getScanTask()->m_snapshot;
+
+				const UCHAR tpb[] =
+				{
+					isc_tpb_version3, isc_tpb_read, isc_tpb_concurrency,
+					isc_tpb_at_snapshot_number, sizeof(snapshot),
+					UCHAR(snapshot), UCHAR(snapshot >> 8), UCHAR(snapshot >> 16), UCHAR(snapshot >> 24),
+					UCHAR(snapshot >> 32), UCHAR(snapshot >> 40), UCHAR(snapshot >> 48), UCHAR(snapshot >> 56)
+				};
+
+				try
+				{
+					WorkerContextHolder holder(tdbb, FB_FUNCTION);
+					m_tra = TRA_start(tdbb, sizeof(tpb), tpb);
+				}
+				catch (const Exception& ex)
+				{
+					ex.stuffException(tdbb->tdbb_status_vector);
+					return false;
+				}
+			}
+
+			tdbb->setTransaction(m_tra);
+
+			return true;
+		}
+
+		bool m_inuse;
+		RefPtr<StableAttachmentPart> m_attStable;
+		jrd_tra* m_tra;
+		ULONG m_chunk;
+	};
+
+	bool handler(WorkItem& _item) override;
+	bool getWorkItem(WorkItem** pItem) override;
+
+	bool getResult(IStatus* status) override
+	{
+		if (status)
+		{
+			status->init();
+			status->setErrors(m_status.getErrors());
+		}
+
+		return m_status.isSuccess();
+	}
+
+	int getMaxWorkers() override
+	{
+		return MIN(m_items.getCount(), m_roundEnd - m_roundStart);
+	}
+
+	bool fetch(thread_db* tdbb, record_param* rpb, MemoryPool* pool);
+
+private:
+	void scanRound(thread_db* tdbb);
+	void copyRecord(UCharBuffer* buffer, const RecordHeader& header, const Record* record);
+	void processBatch(thread_db* tdbb, ULONG chunk, RecordBatch& batch, Array<RecordHeader>& headers);
+	bool aggregateBatch(thread_db* tdbb, ChunkStates* chunkStates, const RecordBatch& batch);
+	void combineStates(thread_db* tdbb);
+
+	void setError(IStatus* status, bool stopTask)
+	{
+		const bool copyStatus = (m_status.isSuccess() && status && status->getState() == IStatus::STATE_ERRORS);
+		if (!copyStatus && (!stopTask || m_stop))
+			return;
+
+		MutexLockGuard guard(m_mutex, FB_FUNCTION);
+		if (m_status.isSuccess() && copyStatus)
+			m_status.save(status);
+		if (stopTask)
+			m_stop = true;
+	}
+
+	MemoryPool* m_pool;
+	Database* m_dbb;
+	const USHORT m_relationId;
+	const StreamType m_stream;
+	const BoolExprNode* const m_boolean;	// condition evaluated by the workers, if any
+	const Array<const AggNode*>* const m_aggregates;	// aggregates computed by the workers, if any
+	const CommitNumber m_snapshot;
+	const USHORT m_windowFlags;
+	Coordinator m_coordinator;
+	Mutex m_mutex;
+	HalfStaticArray<Item*, 8> m_items;
+	HalfStaticArray<UCharBuffer*, 16> m_chunks;	// buffers of the chunks of the current round
+	HalfStaticArray<ChunkStates*, 16> m_states;	// aggregate states of these chunks
+	StatusHolder m_status;
+	volatile bool m_stop;
+
+	const ULONG m_chunkCount;	// number of chunks in the table
+	ULONG m_nextChunk;			// next chunk to assign to the worker
+	ULONG m_roundStart;			// first chunk of the current round
+	ULONG m_roundEnd;			// chunk next to the last one of the current round
+	ULONG m_readChunk;			// chunk of the current round the records are returned from
+	FB_SIZE_T m_readOffset;		// offset of the next record in that chunk's buffer
+};
+
+
+bool ParallelTableScan::ScanTask::handler(WorkItem& _item)
+{
+	Item* item = reinterpret_cast<Item*>(&_item);
+
+	ThreadContextHolder tdbb(NULL);
+
+	if (!item->init(tdbb))
+	{
+		setError(tdbb->tdbb_status_vector, true);
+		return false;
+	}
+
+	WorkerContextHolder wrkHolder(tdbb, FB_FUNCTION);
+
+	MemoryPool* const pool = tdbb->getDefaultPool();
+
+	// Record parameter blocks are indexed by stream for the batch
+	Array<record_param> rpbs(*pool);
+	rpbs.resize(m_stream + 1, record_param());
+	record_param& rpb = rpbs[m_stream];
+
+	jrd_rel* relation = NULL;
+
+	try
+	{
+		Database* dbb = tdbb->getDatabase();
+		jrd_tra* tran = tdbb->getTransaction();
+
+		relation = MetadataCache::getVersioned<Cached::Relation>(tdbb, m_relationId, CacheFlag::AUTOCREATE);
+
+		if (!relation || getPermanent(relation)->isDropped())
+			return !m_stop;
+
+		const ULONG chunk = item->m_chunk - m_roundStart;
+		UCharBuffer* const buffer = m_chunks[chunk];
+		buffer->shrink(0);
+
+		const ULONG chunksPerPP = (dbb->dbb_dp_per_pp + CHUNK_PAGES - 1) / CHUNK_PAGES;
+		const ULONG sequence = item->m_chunk / chunksPerPP;
+		const USHORT firstSlot = (item->m_chunk % chunksPerPP) * CHUNK_PAGES;
+		const USHORT lastSlot = MIN(firstSlot + CHUNK_PAGES, dbb->dbb_dp_per_pp);
+
+		rpb.rpb_relation = relation;
+		rpb.rpb_record = NULL;
+		rpb.getWindow(tdbb).win_flags = m_windowFlags;
+
+		if (m_windowFlags & WIN_large_scan)
+			rpb.rpb_org_scans = getPermanent(relation)->rel_scan_count++;
+
+		rpb.rpb_number.compose(dbb->dbb_max_records, dbb->dbb_dp_per_pp, 0, firstSlot, sequence);
+		rpb.rpb_number.decrement();
+
+		RecordNumber lastRecNo;
+		lastRecNo.compose(dbb->dbb_max_records, dbb->dbb_dp_per_pp, 0, lastSlot, sequence);
+		lastRecNo.decrement();
+
+		AutoPtr<RecordBatch> batch;
+		Array<RecordHeader> headers(*pool);
+
+		if (m_boolean || m_aggregates)
+			batch = FB_NEW_POOL(*pool) RecordBatch(*pool, &m_stream, 1);
+
+		while (!m_stop &&
+			VIO_next_record(tdbb, &rpb, tran, pool, DPM_next_pointer_page, &lastRecNo))
+		{
+			RecordHeader header;
+			header.number = rpb.rpb_number.getValue();
+			header.transaction = rpb.rpb_transaction_nr;
+
+			if (batch)
+			{
+				headers.add(header);
+				batch->exchange(rpbs.begin());
+
+				if (batch->isFull())
+					processBatch(tdbb, chunk, *batch, headers);
+			}
+			else
+				copyRecord(buffer, header, rpb.rpb_record);
+
+			JRD_reschedule(tdbb);
+		}
+
+		if (batch && !m_stop)
+			processBatch(tdbb, chunk, *batch, headers);
+
+		delete rpb.rpb_record;
+
+		if (m_windowFlags & WIN_large_scan)
+			--getPermanent(relation)->rel_scan_count;
+
+		return !m_stop;
+	}
+	catch (const Exception& ex)
+	{
+		ex.stuffException(tdbb->tdbb_status_vector);
+
+		delete rpb.rpb_record;
+
+		if (relation && (m_windowFlags & WIN_large_scan) && getPermanent(relation)->rel_scan_count)
+			--getPermanent(relation)->rel_scan_count;
+	}
+
+	setError(tdbb->tdbb_status_vector, true);
+	return false;
+}
+
+void ParallelTableScan::ScanTask::copyRecord(UCharBuffer* buffer, const RecordHeader& header,
+	const Record* record)
+{
+	const ULONG length = record->getLength();
+
+	const FB_SIZE_T offset = buffer->getCount();
+	UCHAR* const ptr = buffer->getBuffer(offset + HEADER_LENGTH + FB_ALIGN(length, FB_DOUBLE_ALIGN)) + offset;
+
+	RecordHeader* const copy = reinterpret_cast<RecordHeader*>(ptr);
+	copy->number = header.number;
+	copy->transaction = header.transaction;
+	copy->length = length;
+	copy->format = record->getFormat()->fmt_version;
+
+	memcpy(ptr + HEADER_LENGTH, record->getData(), length);
+}
+
+// Aggregate or copy the records of the batch matching the condition and clear the batch.
+// Neither the condition nor the aggregates need the request, see Optimizer::generateRetrieval().
+void ParallelTableScan::ScanTask::processBatch(thread_db* tdbb, ULONG chunk, RecordBatch& batch,
+	Array<RecordHeader>& headers)
+{
+	MemoryPool& pool = *tdbb->getDefaultPool();
+	bool evaluated = true;
+
+	if (m_boolean)
+	{
+		BatchColumn result(pool);
+		evaluated = m_boolean->executeBatch(tdbb, nullptr, batch, result);
+
+		if (evaluated)
+		{
+			Array<ULONG> positions(pool);
+
+			for (ULONG i = 0; i < result.count; i++)
+			{
+				if (!result.nulls[i] && result.values[i].exact)
+					positions.add(i);
+			}
+
+			batch.select(positions);
+		}
+	}
+
+	// Records not matching the whole condition can't be aggregated here
+	if (!evaluated || !m_aggregates || !aggregateBatch(tdbb, m_states[chunk], batch))
+	{
+		UCharBuffer* const buffer = m_chunks[chunk];
+
+		for (ULONG i = 0; i < batch.getCount(); i++)
+		{
+			const ULONG row = batch.getRow(i);
+			copyRecord(buffer, headers[row], batch.getRecord(row, 0));
+		}
+	}
+
+	batch.clear();
+	headers.clear();
+}
+
+// Add the states of all the aggregates for the batch to the chunk ones
+bool ParallelTableScan::ScanTask::aggregateBatch(thread_db* tdbb, ChunkStates* chunkStates,
+	const RecordBatch& batch)
+{
+	const FB_SIZE_T count = m_aggregates->getCount();
+	const FB_SIZE_T offset = chunkStates->states.getCount();
+	impure_value_ex* const states = chunkStates->states.getBuffer(offset + count) + offset;
+
+	for (FB_SIZE_T i = 0; i < count; i++)
+	{
+		if (!(*m_aggregates)[i]->aggPartialBatch(tdbb, nullptr, batch, &states[i]))
+		{
+			chunkStates->states.shrink(offset);
+			return false;
+		}
+	}
+
+	chunkStates->records += batch.getCount();
+	return true;
+}
+
+// Merge the states computed by the workers into the aggregates of the request.
+// The states were moved in memory, so their values are pointed to once again.
+void ParallelTableScan::ScanTask::combineStates(thread_db* tdbb)
+{
+	Request* const request = tdbb->getRequest();
+	const FB_SIZE_T count = m_aggregates->getCount();
+
+	for (const auto chunkStates : m_states)
+	{
+		for (FB_SIZE_T i = 0; i < chunkStates->states.getCount(); i++)
+		{
+			impure_value_ex state = chunkStates->states[i];
+			state.vlu_desc.dsc_address = (UCHAR*) &state.vlu_misc;
+
+			(*m_aggregates)[i % count]->aggCombine(tdbb, request, &state);
+		}
+
+		if (chunkStates->records)
+			tdbb->bumpStats(RecordStatType::SEQ_READS, m_relationId, chunkStates->records);
+	}
+}
+
+bool ParallelTableScan::ScanTask::getWorkItem(WorkItem** pItem)
+{
+	MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+	Item* item = reinterpret_cast<Item*> (*pItem);
+
+	if (item == NULL)
+	{
+		for (Item** p = m_items.begin(); p < m_items.end(); p++)
+		{
+			if (!(*p)->m_inuse)
+			{
+				(*p)->m_inuse = true;
+				*pItem = item = *p;
+				break;
+			}
+		}
+	}
+
+	if (!item)
+		return false;
+
+	item->m_inuse = !m_stop && (m_nextChunk < m_roundEnd);
+
+	if (item->m_inuse)
+		item->m_chunk = m_nextChunk++;
+
+	return item->m_inuse;
+}
+
+void ParallelTableScan::ScanTask::scanRound(thread_db* tdbb)
+{
+	m_roundStart = m_nextChunk;
+	m_roundEnd = MIN(m_chunkCount, m_roundStart + m_chunks.getCount());
+
+	for (auto chunk : m_chunks)
+		chunk->shrink(0);
+
+	for (auto chunkStates : m_states)
+	{
+		chunkStates->states.shrink(0);
+		chunkStates->records = 0;
+	}
+
+	{	// scope
+		EngineCheckout cout(tdbb, FB_FUNCTION);
+		m_coordinator.runSync(this);
+	}
+
+	FbLocalStatus status;
+	if (!getResult(&status))
+		status.raise();
+
+	if (m_aggregates)
+		combineStates(tdbb);
+
+	m_readChunk = 0;
+	m_readOffset = 0;
+}
+
+bool ParallelTableScan::ScanTask::fetch(thread_db* tdbb, record_param* rpb, MemoryPool* pool)
+{
+	while (true)
+	{
+		if (m_readChunk < m_roundEnd - m_roundStart)
+		{
+			const UCharBuffer* const buffer = m_chunks[m_readChunk];
+
+			if (m_readOffset >= buffer->getCount())
+			{
+				m_readChunk++;
+				m_readOffset = 0;
+				continue;
+			}
+
+			const UCHAR* const ptr = buffer->begin() + m_readOffset;
+			const RecordHeader* const header = reinterpret_cast<const RecordHeader*>(ptr);
+
+			m_readOffset += HEADER_LENGTH + FB_ALIGN(header->length, FB_DOUBLE_ALIGN);
+
+			const Format* const format =
+				getPermanent(rpb->rpb_relation)->getFormat(tdbb, header->format);
+
+			Record* const record = VIO_record(tdbb, rpb, format, pool);
+			fb_assert(record->getLength() == header->length);
+			memcpy(record->getData(), ptr + HEADER_LENGTH, header->length);
+
+			rpb->rpb_number.setValue(header->number);
+			rpb->rpb_transaction_nr = header->transaction;
+			rpb->rpb_format_number = header->format;
+			rpb->rpb_runtime_flags &= ~RPB_CLEAR_FLAGS;
+
+			tdbb->bumpStats(RecordStatType::SEQ_READS, rpb->rpb_relation->getId());
+			return true;
+		}
+
+		if (m_nextChunk >= m_chunkCount)
+			return false;
+
+		scanRound(tdbb);
+	}
+}
+
+
+ParallelTableScan::ParallelTableScan(CompilerScratch* csb, const string& alias,
+									 StreamType stream, Rsc::Rel relation, BoolExprNode* boolean)
+	: RecordStream(csb, stream),
+	  m_alias(csb->csb_pool, alias),
+	  m_relation(relation),
+	  m_boolean(boolean),
+	  m_aggregates(csb->csb_pool)
+{
+	m_impure = csb->allocImpure<Impure>();
+	m_cardinality = csb->csb_rpt[stream].csb_cardinality;
+}
+
+// Let the workers compute the aggregates without groups. They must evaluate
+// the whole boolean of the stream and every aggregate argument themselves.
+bool ParallelTableScan::pushAggregates(const MapNode* map, const BoolExprNode* boolean)
+{
+	if (boolean != m_boolean)
+		return false;
+
+	Array<const AggNode*> aggregates;
+
+	for (const auto& source : map->sourceList)
+	{
+		if (const auto aggNode = nodeAs<AggNode>(source))
+		{
+			if (!aggNode->isCombinable() || aggNode->getStateCount() != 1 ||
+				(aggNode->arg && !Optimizer::isWorkerComputable(aggNode->arg, m_stream)))
+			{
+				return false;
+			}
+
+			aggregates.add(aggNode);
+		}
+		else if (!nodeIs<LiteralNode>(source))
+			return false;
+	}
+
+	m_aggregates.assign(aggregates);
+	return m_aggregates.hasData();
+}
+
+void ParallelTableScan::internalOpen(thread_db* tdbb) const
+{
+	Database* const dbb = tdbb->getDatabase();
+	Attachment* const attachment = tdbb->getAttachment();
+	Request* const request = tdbb->getRequest();
+	jrd_tra* const transaction = request->req_transaction;
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	impure->irsb_flags = irsb_open;
+
+	delete impure->irsb_task;
+	impure->irsb_task = nullptr;
+
+	RLCK_reserve_relation(tdbb, transaction, m_relation(), false);
+
+	record_param* const rpb = &request->req_rpb[m_stream];
+	rpb->getWindow(tdbb).win_flags = 0;
+	rpb->rpb_number.setValue(BOF_NUMBER);
+
+	USHORT windowFlags = 0;
+
+	// See FullTableScan::internalOpen() about large scans
+
+	const BufferControl* const bcb = dbb->dbb_bcb;
+	const ULONG dataPages = DPM_data_pages(tdbb, m_relation());
+
+	if (attachment != dbb->dbb_attachments || attachment->att_next)
+	{
+		if (attachment->isGbak() || dataPages > bcb->bcb_count)
+			windowFlags |= WIN_large_scan;
+	}
+
+	if (bcb->bcb_probation_limit && (attachment->isGbak() || dataPages > bcb->bcb_probation_limit))
+		windowFlags |= WIN_use_once;
+
+	// Workers don't see changes of our transaction, so it must not have any.
+	// They share the snapshot of the request, thus it must exist.
+
+	CommitNumber snapshot = 0;
+
+	if (!(transaction->tra_flags & (TRA_write | TRA_degree3 | TRA_system)))
+	{
+		if (!(transaction->tra_flags & TRA_read_committed))
+			snapshot = transaction->tra_snapshot_number;
+		else if ((transaction->tra_flags & TRA_read_consistency) && request->req_snapshot.m_owner)
+			snapshot = request->req_snapshot.m_owner->req_snapshot.m_number;
+	}
+
+	int workers = attachment->att_parallel_workers;
+
+	// Classic in single-user shutdown mode can't create additional worker attachments
+	if (dbb->isShutdown(shut_mode_single) && !(dbb->dbb_flags & DBB_shared))
+		workers = 1;
+
+	const auto relPages = m_relation()->getPages(tdbb);
+	const ULONG chunksPerPP = (dbb->dbb_dp_per_pp + CHUNK_PAGES - 1) / CHUNK_PAGES;
+	const ULONG chunkCount = relPages->rel_pages ? relPages->rel_pages->count() * chunksPerPP : 0;
+
+	if (snapshot && workers > 1 && dataPages > CHUNK_PAGES)
+	{
+		// Let the profiler see every record, just like AggregatedStream does
+		const bool aggregate = m_aggregates.hasData() &&
+			!attachment->getActiveProfilerManagerForNonInternalStatement(tdbb);
+
+		impure->irsb_task = FB_NEW_POOL(*tdbb->getDefaultPool())
+			ScanTask(tdbb, tdbb->getDefaultPool(), m_relation(), m_stream, m_boolean,
+				(aggregate ? &m_aggregates : nullptr), snapshot, workers, chunkCount, windowFlags);
+	}
+	else
+	{
+		// Scan serially, just like FullTableScan does
+
+		rpb->getWindow(tdbb).win_flags = windowFlags;
+
+		if (windowFlags & WIN_large_scan)
+			rpb->rpb_org_scans = m_relation()->rel_scan_count++;
+	}
+}
+
+void ParallelTableScan::close(thread_db* tdbb) const
+{
+	Request* const request = tdbb->getRequest();
+
+	invalidateRecords(request);
+
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	if (impure->irsb_flags & irsb_open)
+	{
+		impure->irsb_flags &= ~irsb_open;
+
+		delete impure->irsb_task;
+		impure->irsb_task = nullptr;
+
+		record_param* const rpb = &request->req_rpb[m_stream];
+		if ((rpb->getWindow(tdbb).win_flags & WIN_large_scan) &&
+			m_relation()->rel_scan_count)
+		{
+			m_relation()->rel_scan_count--;
+		}
+	}
+}
+
+bool ParallelTableScan::internalGetRecord(thread_db* tdbb) const
+{
+	JRD_reschedule(tdbb);
+
+	Request* const request = tdbb->getRequest();
+	record_param* const rpb = &request->req_rpb[m_stream];
+	Impure* const impure = request->getImpure<Impure>(m_impure);
+
+	if (!(impure->irsb_flags & irsb_open))
+	{
+		rpb->rpb_number.setValid(false);
+		return false;
+	}
+
+	const bool found = impure->irsb_task ?
+		impure->irsb_task->fetch(tdbb, rpb, request->req_pool) :
+		VIO_next_record(tdbb, rpb, request->req_transaction, request->req_pool, DPM_next_all);
+
+	rpb->rpb_number.setValid(found);
+	return found;
+}
+
+void ParallelTableScan::getLegacyPlan(thread_db* tdbb, string& plan, unsigned level) const
+{
+	if (!level)
+		plan += "(";
+
+	plan += printName(tdbb, m_alias) + " NATURAL";
+
+	if (!level)
+		plan += ")";
+}
+
+void ParallelTableScan::internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsigned level, bool recurse) const
+{
+	planEntry.className = "ParallelTableScan";
+
+	planEntry.lines.add().text = "Table " +
+		printName(tdbb, m_relation()->getName().toQuotedString(), m_alias) + " Parallel Full Scan";
+	printOptInfo(planEntry.lines);
+
+	planEntry.objectType = m_relation()->getObjectType();
+	planEntry.objectName = m_relation()->getName();
+
+	if (m_alias.hasData() && m_alias != string(m_relation()->getName().object))
+		planEntry.alias = m_alias;
+}
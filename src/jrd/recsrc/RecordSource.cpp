@@ -136,6 +136,26 @@ bool RecordSource::getRecord(thread_db* tdbb) const
 	return internalGetRecord(tdbb);
 }
 
+// Fetch the next rows into the batch, false is returned if there are none.
+// Batches are not used while profiling, so the profiler sees every record.
+bool RecordSource::getBatch(thread_db* tdbb, RecordBatch& batch) const
+{
+	batch.clear();
+
+	return internalGetBatch(tdbb, batch);
+}
+
+// Row mode adapter for the sources that cannot produce batches themselves
+bool RecordSource::internalGetBatch(thread_db* tdbb, RecordBatch& batch) const
+{
+	Request* const request = tdbb->getRequest();
+
+	while (!batch.isFull() && getRecord(tdbb))
+		batch.add(request->req_rpb.begin());
+
+	return batch.getCount() != 0;
+}
+
 string RecordSource::printName(thread_db* tdbb, const string& name, const string& alias)
 {
 	if (alias.isEmpty() || name == alias)
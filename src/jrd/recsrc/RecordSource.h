@@ -23,6 +23,7 @@
 #ifndef JRD_RECORD_SOURCE_H
 #define JRD_RECORD_SOURCE_H
 
+#include <atomic>
 #include <optional>
 #include "../common/classes/array.h"
 #include "../common/classes/objects_array.h"
@@ -30,6 +31,7 @@
 #include "../jrd/RecordSourceNodes.h"
 #include "../jrd/req.h"
 #include "../jrd/RecordBuffer.h"
+#include "../jrd/RecordBatch.h"
 #include "firebird/impl/inf_pub.h"
 #include "../jrd/evl_proto.h"
 #include "../jrd/vio_proto.h"
@@ -154,6 +156,13 @@ namespace Jrd
 			fb_assert(false);
 		}
 
+		// Let the source aggregate the records matching the boolean by itself instead of
+		// returning them. Used for the aggregation without groups, see ParallelTableScan.
+		virtual bool pushAggregates(const MapNode* /*map*/, const BoolExprNode* /*boolean*/ = nullptr)
+		{
+			return false;
+		}
+
 		static bool rejectDuplicate(const UCHAR* /*data1*/, const UCHAR* /*data2*/, void* /*userArg*/)
 		{
 			return true;
@@ -162,6 +171,7 @@ namespace Jrd
 		void open(thread_db* tdbb) const;
 
 		bool getRecord(thread_db* tdbb) const;
+		bool getBatch(thread_db* tdbb, RecordBatch& batch) const;
 
 	protected:
 		// Generic impure block
@@ -194,6 +204,7 @@ namespace Jrd
 
 		virtual void internalOpen(thread_db* tdbb) const = 0;
 		virtual bool internalGetRecord(thread_db* tdbb) const = 0;
+		virtual bool internalGetBatch(thread_db* tdbb, RecordBatch& batch) const;
 
 		ULONG m_impure = 0;
 		bool m_recursive = false;
@@ -250,6 +261,7 @@ namespace Jrd
 		void internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsigned level, bool recurse) const override;
 		void internalOpen(thread_db* tdbb) const override;
 		bool internalGetRecord(thread_db* tdbb) const override;
+		bool internalGetBatch(thread_db* tdbb, RecordBatch& batch) const override;
 
 	private:
 		const Firebird::string m_alias;
@@ -257,31 +269,73 @@ namespace Jrd
 		Firebird::Array<DbKeyRangeNode*> m_dbkeyRanges;
 	};
 
+	class ParallelTableScan final : public RecordStream
+	{
+		class ScanTask;
+
+		struct Impure : public RecordSource::Impure
+		{
+			ScanTask* irsb_task;
+		};
+
+	public:
+		ParallelTableScan(CompilerScratch* csb, const Firebird::string& alias,
+						  StreamType stream, Rsc::Rel relation, BoolExprNode* boolean = nullptr);
+
+		void close(thread_db* tdbb) const override;
+
+		void getLegacyPlan(thread_db* tdbb, Firebird::string& plan, unsigned level) const override;
+
+		bool pushAggregates(const MapNode* map, const BoolExprNode* boolean = nullptr) override;
+
+	protected:
+		void internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsigned level, bool recurse) const override;
+		void internalOpen(thread_db* tdbb) const override;
+		bool internalGetRecord(thread_db* tdbb) const override;
+
+	private:
+		const Firebird::string m_alias;
+		const Rsc::Rel m_relation;
+		NestConst<BoolExprNode> const m_boolean;	// booleans evaluated by the workers
+		Firebird::Array<const AggNode*> m_aggregates;	// aggregates computed by the workers
+	};
+
 	class BitmapTableScan final : public RecordStream
 	{
 		struct Impure : public RecordSource::Impure
 		{
 			RecordBitmap** irsb_bitmap;
+			FB_UINT64 irsb_prefetch_number;		// record number to read data pages ahead at
+			ULONG irsb_visible_sequence;		// data page sequence checked for visibility last
+			bool irsb_visible;					// all records of that page are visible
 		};
 
 	public:
 		BitmapTableScan(CompilerScratch* csb, const Firebird::string& alias,
 						StreamType stream, Rsc::Rel relation,
-						InversionNode* inversion, double selectivity);
+						InversionNode* inversion, double selectivity,
+						BoolExprNode* recheck = nullptr);
 
 		void close(thread_db* tdbb) const override;
 
+		bool refetchRecord(thread_db* tdbb) const override;
+
 		void getLegacyPlan(thread_db* tdbb, Firebird::string& plan, unsigned level) const override;
 
+		bool isDependent(const StreamList& streams) const override;
+
 	protected:
 		void internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsigned level, bool recurse) const override;
 		void internalOpen(thread_db* tdbb) const override;
 		bool internalGetRecord(thread_db* tdbb) const override;
 
 	private:
+		bool isVisible(thread_db* tdbb, FB_UINT64 number) const;
+
 		const Firebird::string m_alias;
 		const Rsc::Rel m_relation;
 		NestConst<InversionNode> const m_inversion;
+		NestConst<BoolExprNode> const m_recheck;	// booleans evaluated by the index scan
 	};
 
 	class IndexTableScan final : public RecordStream
@@ -299,6 +353,8 @@ namespace Jrd
 			temporary_key* irsb_nav_current_lower;		// current lower key
 			temporary_key* irsb_nav_current_upper;		// current upper key
 			IndexScanListIterator* irsb_iterator;		// key list iterator
+			ULONG irsb_visible_sequence;				// data page sequence checked for visibility last
+			bool irsb_visible;							// all records of that page are visible
 			USHORT irsb_nav_offset;						// page offset of current index node
 			USHORT irsb_nav_upper_length;				// length of upper key value
 			USHORT irsb_nav_length;						// length of expanded key
@@ -322,6 +378,16 @@ namespace Jrd
 			m_condition = condition;
 		}
 
+		const InversionNode* getIndex() const
+		{
+			return m_index;
+		}
+
+		void setPayload()
+		{
+			m_payload = true;
+		}
+
 	protected:
 		void internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsigned level, bool recurse) const override;
 		void internalOpen(thread_db* tdbb) const override;
@@ -338,6 +404,7 @@ namespace Jrd
 		void setPosition(thread_db* tdbb, Impure* impure, record_param*,
 						 win* window, const UCHAR*, const temporary_key&) const;
 		bool setupBitmaps(thread_db* tdbb, Impure* impure) const;
+		bool isVisible(thread_db* tdbb, FB_UINT64 number) const;
 
 		const Firebird::string m_alias;
 		const Rsc::Rel m_relation;
@@ -346,6 +413,7 @@ namespace Jrd
 		NestConst<BoolExprNode> m_condition;
 		const FB_SIZE_T m_length;
 		FB_SIZE_T m_offset;
+		bool m_payload;		// records may be built of the index payload
 	};
 
 	class ExternalTableScan final : public RecordStream
@@ -610,12 +678,15 @@ namespace Jrd
 			m_ansiNot = ansiNot;
 		}
 
+		bool pushAggregates(const MapNode* map, const BoolExprNode* boolean = nullptr) override;
+
 	protected:
 		FilteredStream(CompilerScratch* csb, RecordSource* next, BoolExprNode* boolean);
 
 		void internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsigned level, bool recurse) const override;
 		void internalOpen(thread_db* tdbb) const override;
 		bool internalGetRecord(thread_db* tdbb) const override;
+		bool internalGetBatch(thread_db* tdbb, RecordBatch& batch) const override;
 
 		const bool m_invariant;
 
@@ -649,7 +720,6 @@ namespace Jrd
 	public:
 		static const USHORT FLAG_PROJECT	= 0x1;	// sort is really a project
 		static const USHORT FLAG_UNIQUE		= 0x2;	// sorts using unique key - for distinct and group by
-		static const USHORT FLAG_KEY_VARY	= 0x4;	// sort key contains varying length string(s)
 		static const USHORT FLAG_REFETCH	= 0x8;	// refetch data after sorting
 
 		// Special values for SortMap::Item::fieldId.
@@ -725,18 +795,18 @@ namespace Jrd
 			m_next->setAnyBoolean(anyBoolean, ansiAny, ansiNot);
 		}
 
-		ULONG getLength() const
+		// Only the given number of the first sorted records will be fetched
+		void setLimit(ValueExprNode* first, ValueExprNode* skip)
 		{
-			return m_map->length;
+			m_first = first;
+			m_skip = skip;
 		}
 
-		ULONG getKeyLength() const
+		ULONG getLength() const
 		{
-			return m_map->keyLength;
+			return m_map->length;
 		}
 
-		bool compareKeys(const UCHAR* p, const UCHAR* q) const;
-
 		UCHAR* getData(thread_db* tdbb) const;
 		void mapData(thread_db* tdbb, Request* request, UCHAR* data) const;
 
@@ -760,9 +830,12 @@ namespace Jrd
 
 	private:
 		Sort* init(thread_db* tdbb) const;
+		FB_UINT64 getLimit(thread_db* tdbb, Request* request) const;
 
 		NestConst<RecordSource> m_next;
 		const SortMap* const m_map;
+		NestConst<ValueExprNode> m_first;
+		NestConst<ValueExprNode> m_skip;
 	};
 
 	// Make moves in a window without going out of partition boundaries.
@@ -961,16 +1034,53 @@ namespace Jrd
 
 	class AggregatedStream final : public BaseAggWinStream<AggregatedStream, RecordSource>
 	{
+		class HashTable;
+
 	public:
+		struct Impure : public BaseAggWinStream::Impure
+		{
+			HashTable* irsb_hash_table;
+			RecordBatch* irsb_batch;
+			bool irsb_batched;
+		};
+
 		AggregatedStream(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
-			const NestValueArray* group, MapNode* map, RecordSource* next);
+			const NestValueArray* group, MapNode* map, RecordSource* next, bool hashed = false);
+
+		static bool isHashable(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
+			const NestValueArray* group, MapNode* map);
 
 	public:
+		void close(thread_db* tdbb) const override;
+
 		void getLegacyPlan(thread_db* tdbb, Firebird::string& plan, unsigned level) const override;
 
 	protected:
 		void internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsigned level, bool recurse) const override;
+		void internalOpen(thread_db* tdbb) const override;
 		bool internalGetRecord(thread_db* tdbb) const override;
+
+	private:
+		static ULONG getHashLayout(thread_db* tdbb, CompilerScratch* csb, StreamType stream,
+			const NestValueArray* group, MapNode* map,
+			ULONG* keyLengths, ULONG& keyLength, ULONG& stateCount, ULONG& stateLength);
+
+		bool isBatchable(thread_db* tdbb) const;
+		void evaluateBatches(thread_db* tdbb, Request* request, Impure* impure) const;
+
+		void buildHashTable(thread_db* tdbb, Request* request, Impure* impure) const;
+		bool fetchHashGroup(thread_db* tdbb, Request* request, Impure* impure) const;
+		ULONG computeKey(thread_db* tdbb, Request* request, UCHAR* keyBuffer) const;
+		void swapStates(Request* request, impure_value_ex* states) const;
+		void spillGroups(thread_db* tdbb, Request* request, HashTable* table) const;
+		void combineSpilled(thread_db* tdbb, Request* request, const UCHAR* data) const;
+
+		ULONG* m_keyLengths;
+		ULONG m_keyLength;
+		ULONG m_stateCount;
+		ULONG m_stateLength;
+		ULONG m_spillLength;
+		const bool m_hashed;
 	};
 
 	class WindowedStream : public RecordSource
@@ -1145,11 +1255,14 @@ namespace Jrd
 		{
 			RecordBuffer* irsb_buffer;
 			FB_UINT64 irsb_position;
+			bool irsb_replay;
 		};
 
 	public:
 		BufferedStream(CompilerScratch* csb, RecordSource* next);
 
+		void replay(thread_db* tdbb) const;
+
 		void close(thread_db* tdbb) const override;
 
 		bool refetchRecord(thread_db* tdbb) const override;
@@ -1377,8 +1490,6 @@ namespace Jrd
 		void close(thread_db* tdbb) const override;
 		void getLegacyPlan(thread_db* tdbb, Firebird::string& plan, unsigned level) const override;
 
-		static unsigned maxCapacity() noexcept;
-
 	protected:
 		void internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsigned level, bool recurse) const override;
 		void internalOpen(thread_db* tdbb) const override;
@@ -1388,65 +1499,53 @@ namespace Jrd
 		void init(thread_db* tdbb, CompilerScratch* csb, FB_SIZE_T count,
 				  RecordSource* const* args, NestValueArray* const* keys,
 				  double selectivity);
+		void buildHashTable(thread_db* tdbb, Impure* impure) const;
+		bool fetchLeader(thread_db* tdbb, Impure* impure) const;
 		ULONG computeHash(thread_db* tdbb, Request* request,
 						  const SubStream& sub, UCHAR* buffer) const;
 		bool fetchRecord(thread_db* tdbb, Impure* impure, FB_SIZE_T stream) const;
 
 		SubStream m_leader;
+		NestConst<BufferedStream> m_bufferedLeader;
 		Firebird::Array<SubStream> m_subs;
 	};
 
-	class MergeJoin : public Join<SortedStream>
+	// Inner join choosing between nested loops and hashing at runtime.
+	// The first rows of the outer stream are buffered, if there are more
+	// of them than the threshold, the outer stream is restarted and hash-joined.
+
+	class AdaptiveJoin final : public Join<RecordSource>
 	{
-		struct MergeFile
-		{
-			TempSpace* mfb_space;				// merge file uses SORT I/O routines
-			ULONG mfb_equal_records;			// equality group cardinality
-			ULONG mfb_record_size;				// matches sort map length
-			ULONG mfb_current_block;			// current merge block in buffer
-			ULONG mfb_block_size;				// merge block I/O size
-			ULONG mfb_blocking_factor;			// merge equality records per block
-			UCHAR* mfb_block_data;				// merge block I/O buffer
-		};
+		enum class Strategy : UCHAR { NONE, LOOP, HASH };
 
 		struct Impure : public RecordSource::Impure
 		{
-			// CVC: should this value exist for compatibility? It's not used.
-			USHORT irsb_mrg_count;				// next stream in group
-			struct irsb_mrg_repeat
-			{
-				SLONG irsb_mrg_equal;			// queue of equal records
-				SLONG irsb_mrg_equal_end;		// end of the equal queue
-				SLONG irsb_mrg_equal_current;	// last fetched record from equal queue
-				SLONG irsb_mrg_last_fetched;	// first sort merge record of next group
-				SSHORT irsb_mrg_order;			// logical merge order by substream
-				MergeFile irsb_mrg_file;		// merge equivalence file
-			} irsb_mrg_rpt[1];
+			bool irsb_hashed;
 		};
 
-		static const FB_SIZE_T MERGE_BLOCK_SIZE = 65536;
-
 	public:
-		MergeJoin(CompilerScratch* csb, FB_SIZE_T count,
-				  SortedStream* const* args,
-				  const NestValueArray* const* keys);
+		AdaptiveJoin(CompilerScratch* csb, BufferedStream* outer, RecordSource* inner,
+					 RecordSource* hashedInner, RecordSource* hashJoin, ULONG threshold);
 
 		void close(thread_db* tdbb) const override;
 		void getLegacyPlan(thread_db* tdbb, Firebird::string& plan, unsigned level) const override;
 
+		void markRecursive() override;
+		void invalidateRecords(Request* request) const override;
+
 	protected:
 		void internalGetPlan(thread_db* tdbb, PlanEntry& planEntry, unsigned level, bool recurse) const override;
 		void internalOpen(thread_db* tdbb) const override;
 		bool internalGetRecord(thread_db* tdbb) const override;
 
 	private:
-		int compare(thread_db* tdbb, const NestValueArray* node1,
-			const NestValueArray* node2) const;
-		UCHAR* getData(thread_db* tdbb, MergeFile* mfb, SLONG record) const;
-		SLONG getRecordByIndex(thread_db* tdbb, FB_SIZE_T index) const;
-		bool fetchRecord(thread_db* tdbb, FB_SIZE_T index) const;
+		void chooseStrategy(thread_db* tdbb, Impure* impure) const;
 
-		Firebird::Array<const NestValueArray*> m_keys;
+		NestConst<BufferedStream> m_outer;
+		NestConst<RecordSource> m_hashedInner;	// for plan printing only
+		NestConst<RecordSource> m_hashJoin;
+		const ULONG m_threshold;
+		mutable std::atomic<Strategy> m_lastStrategy = Strategy::NONE;
 	};
 
 	class LocalTableStream final : public RecordStream
@@ -46,7 +46,9 @@ using namespace Jrd;
 SortedStream::SortedStream(CompilerScratch* csb, RecordSource* next, SortMap* map)
 	: RecordSource(csb),
 	  m_next(next),
-	  m_map(map)
+	  m_map(map),
+	  m_first(nullptr),
+	  m_skip(nullptr)
 {
 	fb_assert(m_next && m_map);
 
@@ -185,6 +187,34 @@ void SortedStream::nullRecords(thread_db* tdbb) const
 	m_next->nullRecords(tdbb);
 }
 
+// Number of the first sorted records that may be fetched, zero if unlimited.
+// Invalid limits are ignored here, FirstRowsStream and SkipRowsStream
+// report them.
+FB_UINT64 SortedStream::getLimit(thread_db* tdbb, Request* request) const
+{
+	if (!m_first)
+		return 0;
+
+	const dsc* desc = EVL_expr(tdbb, request, m_first);
+	const SINT64 first = desc ? MOV_get_int64(tdbb, desc, 0) : 0;
+
+	if (first <= 0)
+		return 0;
+
+	SINT64 skip = 0;
+
+	if (m_skip)
+	{
+		desc = EVL_expr(tdbb, request, m_skip);
+		skip = desc ? MOV_get_int64(tdbb, desc, 0) : 0;
+
+		if (skip < 0 || skip > MAX_SINT64 - first)
+			return 0;
+	}
+
+	return first + skip;
+}
+
 Sort* SortedStream::init(thread_db* tdbb) const
 {
 	Request* const request = tdbb->getRequest();
@@ -198,7 +228,13 @@ Sort* SortedStream::init(thread_db* tdbb) const
 		Sort(tdbb->getDatabase(), &request->req_sorts,
 			 m_map->length, m_map->keyItems.getCount(), m_map->keyItems.getCount(),
 			 m_map->keyItems.begin(),
-			 ((m_map->flags & FLAG_PROJECT) ? rejectDuplicate : nullptr), 0));
+			 ((m_map->flags & FLAG_PROJECT) ? rejectDuplicate : nullptr), 0,
+			 getLimit(tdbb, request)));
+
+	const auto attachment = tdbb->getAttachment();
+
+	if (attachment->att_parallel_workers > 1)
+		scb->setParallelWorkers(attachment->att_parallel_workers);
 
 	// Pump the input stream dry while pushing records into sort. For
 	// each record, map all fields into the sort record. The reverse
@@ -289,47 +325,6 @@ Sort* SortedStream::init(thread_db* tdbb) const
 	return scb.release();
 }
 
-bool SortedStream::compareKeys(const UCHAR* p, const UCHAR* q) const
-{
-	if (!memcmp(p, q, m_map->keyLength))
-		return true;
-
-	if (!(m_map->flags & FLAG_KEY_VARY))
-		return false;
-
-	// Binary-distinct varying length string keys may in fact be equal.
-	// Re-check the keys at the higher level. See CORE-4909.
-
-	fb_assert(m_map->keyItems.getCount() % 2 == 0);
-	const USHORT count = m_map->keyItems.getCount() / 2;
-	thread_db* tdbb = JRD_get_thread_data();
-
-	for (USHORT i = 0; i < count; i++)
-	{
-		const SortMap::Item* const item = &m_map->items[i];
-
-		const UCHAR flag1 = *(p + item->flagOffset);
-		const UCHAR flag2 = *(q + item->flagOffset);
-
-		if (flag1 != flag2)
-			return false;
-
-		if (!flag1)
-		{
-			dsc desc1 = item->desc;
-			desc1.dsc_address = const_cast<UCHAR*>(p) + (IPTR) desc1.dsc_address;
-
-			dsc desc2 = item->desc;
-			desc2.dsc_address = const_cast<UCHAR*>(q) + (IPTR) desc2.dsc_address;
-
-			if (MOV_compare(tdbb, &desc1, &desc2))
-				return false;
-		}
-	}
-
-	return true;
-}
-
 UCHAR* SortedStream::getData(thread_db* tdbb) const
 {
 	Request* const request = tdbb->getRequest();
@@ -861,3 +861,11 @@ RELATION(nam_constants, rel_constants, ODS_14_0, rel_persistent)
 	FIELD(f_const_package_schema, nam_sch_name, fld_sch_name, 0, ODS_14_0)
 	FIELD(f_const_description, nam_description, fld_description, 1, ODS_14_0)
 END_RELATION
+
+// Relation 60 (RDB$COLUMN_STATISTICS)
+RELATION(nam_column_statistics, rel_column_statistics, ODS_14_0, rel_persistent)
+	FIELD(f_cst_schema, nam_sch_name, fld_sch_name, 0, ODS_14_0)
+	FIELD(f_cst_rname, nam_r_name, fld_r_name, 0, ODS_14_0)
+	FIELD(f_cst_fname, nam_f_name, fld_f_name, 0, ODS_14_0)
+	FIELD(f_cst_histogram, nam_histogram, fld_histogram, 0, ODS_14_0)
+END_RELATION
@@ -297,20 +297,18 @@ void SDW_dump_pages(thread_db* tdbb)
 
 	for (SLONG page_number = HEADER_PAGE + 1; page_number <= max; page_number++)
 	{
-#ifdef SUPERSERVER_V2
-		if (!(page_number % dbb->dbb_prefetch_sequence))
+		if (dbb->dbb_prefetch_pages && !(page_number % dbb->dbb_prefetch_sequence))
 		{
-			SLONG pages[PREFETCH_MAX_PAGES];
+			ULONG pages[PREFETCH_MAX_PAGES];
 
 			SLONG number = page_number;
-			SLONG i = 0;
+			ULONG i = 0;
 			while (i < dbb->dbb_prefetch_pages && number <= max) {
 				pages[i++] = number++;
 			}
 
-			CCH_PREFETCH(tdbb, pages, i);
+			CCH_prefetch(tdbb, DB_PAGE_SPACE, pages, i);
 		}
-#endif
 		for (Shadow* shadow = dbb->dbb_shadow; shadow; shadow = shadow->sdw_next)
 		{
 			if (!(shadow->sdw_flags & (SDW_INVALID | SDW_dumped)))
@@ -41,6 +41,8 @@
 #include "../jrd/val.h"
 #include "../jrd/err_proto.h"
 #include "../yvalve/gds_proto.h"
+#include "../common/Task.h"
+#include "../jrd/WorkerAttachment.h"
 
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
@@ -65,6 +67,9 @@
 constexpr USHORT RUN_GROUP			= 8;
 constexpr USHORT MAX_MERGE_LEVEL	= 2;
 
+// Minimal number of run groups worth merging them in parallel
+constexpr ULONG MIN_PARALLEL_MERGE_GROUPS = 2;
+
 using namespace Jrd;
 using namespace Firebird;
 
@@ -79,6 +84,12 @@ using namespace Firebird;
 constexpr ULONG MAX_SORT_BUFFER_SIZE = 1024 * 128;	// 128KB
 constexpr ULONG MIN_RECORDS_TO_ALLOC = 8;
 
+// Minimal number of records per thread worth sorting the buffer in parallel
+constexpr ULONG MIN_PARALLEL_SORT_RECORDS = 2048;
+
+// Minimal number of records to sort them by the radix sort
+constexpr ULONG MIN_RADIX_SORT_RECORDS = 1024;
+
 // the size of sr_bckptr (everything before sort_record) in bytes
 #define SIZEOF_SR_BCKPTR offsetof(sr, sr_sort_record)
 // the size of sr_bckptr in # of 32 bit longwords
@@ -147,9 +158,351 @@ namespace
 		*a = *b;
 		*b = temp;
 	}
+
+	// Compare two records the same way the quick sort does
+	inline int compareRecords(const SORTP* p, const SORTP* q, ULONG length) noexcept
+	{
+		ULONG tl = length - 1;
+		while (tl && *p == *q)
+		{
+			p++;
+			q++;
+			tl--;
+		}
+
+		if (!tl)
+			return 0;
+
+		return (*p > *q) ? 1 : -1;
+	}
+
+	// Every helper thread of the parallel sort holds a worker attachment while
+	// it runs, thus the sorts share MaxParallelWorkers with the other parallel
+	// tasks. The current thread is the first worker.
+
+	class WorkerReservation
+	{
+	public:
+		explicit WorkerReservation(MemoryPool& p)
+			: m_atts(p)
+		{}
+
+		~WorkerReservation()
+		{
+			FbLocalStatus status;
+			for (auto sAtt : m_atts)
+				WorkerAttachment::releaseAttachment(&status, sAtt);
+		}
+
+		void reserve(Database* dbb, ULONG count)
+		{
+			while (m_atts.getCount() < count)
+			{
+				FbLocalStatus status;
+				StableAttachmentPart* const sAtt = WorkerAttachment::getAttachment(&status, dbb);
+				if (!sAtt)
+					break;
+
+				m_atts.add(sAtt);
+			}
+		}
+
+		ULONG getCount() const
+		{
+			return m_atts.getCount();
+		}
+
+	private:
+		HalfStaticArray<StableAttachmentPart*, 8> m_atts;
+	};
 } // namespace
 
 
+// Sorts the partitions of the sort buffer by the parallel workers.
+// Every partition is placed between the low and high guard keys.
+
+class Sort::PartitionTask : public Task
+{
+public:
+	struct Partition
+	{
+		SORTP** pointers;
+		ULONG count;
+	};
+
+	PartitionTask(MemoryPool& pool, ULONG longs, int workers)
+		: Task(),
+		  m_pool(pool),
+		  m_longs(longs),
+		  m_items(pool),
+		  m_partitions(pool),
+		  m_next(0)
+	{
+		for (int i = 0; i < workers; i++)
+			m_items.add(FB_NEW_POOL(pool) Item(this));
+	}
+
+	~PartitionTask()
+	{
+		for (auto item : m_items)
+			delete item;
+	}
+
+	class Item : public Task::WorkItem
+	{
+	public:
+		Item(PartitionTask* task)
+			: Task::WorkItem(task),
+			  m_inuse(false),
+			  m_partition(0)
+		{}
+
+		bool m_inuse;
+		FB_SIZE_T m_partition;
+	};
+
+	void addPartition(SORTP** pointers, ULONG count)
+	{
+		Partition& partition = m_partitions.add();
+		partition.pointers = pointers;
+		partition.count = count;
+	}
+
+	const Partition& getPartition(FB_SIZE_T n) const
+	{
+		return m_partitions[n];
+	}
+
+	bool handler(WorkItem& _item) override
+	{
+		const Item* const item = reinterpret_cast<Item*>(&_item);
+		const Partition& partition = m_partitions[item->m_partition];
+
+		try
+		{
+			sortPointers(partition.count, partition.pointers, m_longs, m_pool);
+		}
+		catch (const Exception& ex)
+		{
+			FbLocalStatus status;
+			ex.stuffException(&status);
+
+			MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+			if (m_status.isSuccess())
+				m_status.save(&status);
+
+			return false;
+		}
+
+		return true;
+	}
+
+	bool getWorkItem(WorkItem** pItem) override
+	{
+		MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+		Item* item = reinterpret_cast<Item*>(*pItem);
+
+		if (!item)
+		{
+			for (auto p : m_items)
+			{
+				if (!p->m_inuse)
+				{
+					p->m_inuse = true;
+					*pItem = item = p;
+					break;
+				}
+			}
+		}
+
+		if (!item)
+			return false;
+
+		item->m_inuse = (m_next < m_partitions.getCount());
+
+		if (item->m_inuse)
+			item->m_partition = m_next++;
+
+		return item->m_inuse;
+	}
+
+	bool getResult(IStatus* status) override
+	{
+		if (status)
+		{
+			status->init();
+			status->setErrors(m_status.getErrors());
+		}
+
+		return m_status.isSuccess();
+	}
+
+	int getMaxWorkers() override
+	{
+		return MIN(m_items.getCount(), m_partitions.getCount());
+	}
+
+private:
+	MemoryPool& m_pool;
+	const ULONG m_longs;
+	StatusHolder m_status;
+	Mutex m_mutex;
+	HalfStaticArray<Item*, 8> m_items;
+	HalfStaticArray<Partition, 8> m_partitions;
+	FB_SIZE_T m_next;
+};
+
+
+// Merges the groups of runs by the parallel workers, see Sort::mergeParallel().
+// Every worker has its own buffers to read the runs and to write the merged one,
+// the access to the scratch space is serialized.
+
+class Sort::MergeTask : public Task
+{
+public:
+	struct Group
+	{
+		run_control* runs[RUN_GROUP];
+		run_control* output;
+	};
+
+	MergeTask(MemoryPool& pool, Sort* sort, int workers, ULONG bufferSize)
+		: Task(),
+		  m_sort(sort),
+		  m_bufferSize(bufferSize),
+		  m_items(pool),
+		  m_groups(pool),
+		  m_next(0)
+	{
+		for (int i = 0; i < workers; i++)
+			m_items.add(FB_NEW_POOL(pool) Item(this, pool, bufferSize));
+	}
+
+	~MergeTask()
+	{
+		for (auto item : m_items)
+			delete item;
+	}
+
+	class Item : public Task::WorkItem
+	{
+	public:
+		Item(MergeTask* task, MemoryPool& pool, ULONG bufferSize)
+			: Task::WorkItem(task),
+			  m_inuse(false),
+			  m_group(0),
+			  m_buffers(pool)
+		{
+			// Read buffers of the runs are followed by the write buffer
+			m_buffers.getBuffer(bufferSize * (RUN_GROUP + 1));
+		}
+
+		bool m_inuse;
+		FB_SIZE_T m_group;
+		UCharBuffer m_buffers;
+	};
+
+	Group& addGroup()
+	{
+		return m_groups.add();
+	}
+
+	FB_SIZE_T getCount() const
+	{
+		return m_groups.getCount();
+	}
+
+	const Group& getGroup(FB_SIZE_T n) const
+	{
+		return m_groups[n];
+	}
+
+	bool handler(WorkItem& _item) override
+	{
+		Item* const item = reinterpret_cast<Item*>(&_item);
+		const Group& group = m_groups[item->m_group];
+
+		try
+		{
+			m_sort->mergeGroup(group.runs, group.output, item->m_buffers.begin(), m_bufferSize,
+				&m_spaceMutex);
+		}
+		catch (const Exception& ex)
+		{
+			FbLocalStatus status;
+			ex.stuffException(&status);
+
+			MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+			if (m_status.isSuccess())
+				m_status.save(&status);
+
+			return false;
+		}
+
+		return true;
+	}
+
+	bool getWorkItem(WorkItem** pItem) override
+	{
+		MutexLockGuard guard(m_mutex, FB_FUNCTION);
+
+		Item* item = reinterpret_cast<Item*>(*pItem);
+
+		if (!item)
+		{
+			for (auto p : m_items)
+			{
+				if (!p->m_inuse)
+				{
+					p->m_inuse = true;
+					*pItem = item = p;
+					break;
+				}
+			}
+		}
+
+		if (!item)
+			return false;
+
+		item->m_inuse = m_status.isSuccess() && (m_next < m_groups.getCount());
+
+		if (item->m_inuse)
+			item->m_group = m_next++;
+
+		return item->m_inuse;
+	}
+
+	bool getResult(IStatus* status) override
+	{
+		if (status)
+		{
+			status->init();
+			status->setErrors(m_status.getErrors());
+		}
+
+		return m_status.isSuccess();
+	}
+
+	int getMaxWorkers() override
+	{
+		return MIN(m_items.getCount(), m_groups.getCount());
+	}
+
+private:
+	Sort* const m_sort;
+	const ULONG m_bufferSize;
+	StatusHolder m_status;
+	Mutex m_mutex;
+	Mutex m_spaceMutex;		// serializes the scratch space access and the duplicates callback
+	HalfStaticArray<Item*, 8> m_items;
+	HalfStaticArray<Group, 8> m_groups;
+	FB_SIZE_T m_next;
+};
+
+
 Sort::Sort(Database* dbb,
 		   SortOwner* owner,
 		   ULONG record_length,
@@ -160,9 +513,9 @@ Sort::Sort(Database* dbb,
 		   void* user_arg,
 		   FB_UINT64 max_records)
 	: m_dbb(dbb), m_owner(owner),
-	  m_last_record(NULL), m_next_pointer(NULL), m_records(0),
+	  m_last_record(NULL), m_next_pointer(NULL), m_records(0), m_free_record(NULL),
 	  m_runs(NULL), m_merge(NULL), m_free_runs(NULL),
-	  m_flags(0), m_merge_pool(NULL),
+	  m_flags(0), m_merge_pool(NULL), m_workers(1),
 	  m_description(m_owner->getPool(), keys)
 {
 /**************************************
@@ -179,6 +532,10 @@ Sort::Sort(Database* dbb,
  *		  compared. This is used at creation of unique index since sort key
  *		  includes index key (which must be unique) and record numbers.
  *
+ * If max_records is given, only that number of the first records will
+ * be returned. Then the sort keeps a bounded heap of the least records
+ * instead of sorting and storing them all.
+ *
  **************************************/
 	fb_assert(m_owner);
 	fb_assert(unique_keys <= keys);
@@ -222,6 +579,18 @@ Sort::Sort(Database* dbb,
 
 		allocateBuffer(pool);
 
+		// The top-N heap must fit the sort buffer together with its pointers
+		// and the guard keys, otherwise fall back to the complete sort.
+		// Duplicates cannot be eliminated by the heap either.
+
+		if (m_max_records)
+		{
+			const ULONG capacity = m_size_memory / (record_size + sizeof(sort_record*));
+
+			if (m_dup_callback || capacity < 2 || m_max_records > capacity - 2)
+				m_max_records = 0;
+		}
+
 		m_end_memory = m_memory + m_size_memory;
 		m_first_pointer = (sort_record**) m_memory;
 
@@ -229,7 +598,7 @@ Sort::Sort(Database* dbb,
 
 		try
 		{
-			m_space = FB_NEW_POOL(pool) TempSpace(pool, SCRATCH, false);
+			m_space = FB_NEW_POOL(pool) TempSpace(pool, SCRATCH, false, true);
 		}
 		catch (const Exception&)
 		{
@@ -353,34 +722,49 @@ void Sort::put(thread_db* tdbb, ULONG** record_address)
 		if (record != (SR*) m_end_memory)
 		{
 			diddleKey((UCHAR*) (record->sr_sort_record.sort_record_key), true, false);
+
+			if (m_max_records)
+				putTopRecord();
 		}
 
-		// If there isn't room for the record, sort and write the run.
-		// Check that we are not at the beginning of the buffer in addition
-		// to checking for space for the record. This avoids the pointer
-		// record from underflowing in the second condition.
-		if ((UCHAR*) record < m_memory + m_longs ||
-			(UCHAR*) NEXT_RECORD(record) <= (UCHAR*) (m_next_pointer + 1))
+		if (m_free_record)
+		{
+			// Reuse the slot of the record thrown away by the top-N sort
+
+			record = m_free_record;
+			m_free_record = NULL;
+		}
+		else
 		{
-			putRun(tdbb);
-			while (true)
+			// If there isn't room for the record, sort and write the run.
+			// Check that we are not at the beginning of the buffer in addition
+			// to checking for space for the record. This avoids the pointer
+			// record from underflowing in the second condition.
+			if ((UCHAR*) record < m_memory + m_longs ||
+				(UCHAR*) NEXT_RECORD(record) <= (UCHAR*) (m_next_pointer + 1))
 			{
-				run_control* run = m_runs;
-				const USHORT depth = run->run_depth;
-				if (depth == MAX_MERGE_LEVEL)
-					break;
-				USHORT count = 1;
-				while ((run = run->run_next) && run->run_depth == depth)
-					count++;
-				if (count < RUN_GROUP)
-					break;
-				mergeRuns(count);
+				fb_assert(!m_max_records);
+
+				putRun(tdbb);
+				while (true)
+				{
+					run_control* run = m_runs;
+					const USHORT depth = run->run_depth;
+					if (depth == MAX_MERGE_LEVEL)
+						break;
+					USHORT count = 1;
+					while ((run = run->run_next) && run->run_depth == depth)
+						count++;
+					if (count < RUN_GROUP)
+						break;
+					mergeRuns(count);
+				}
+				init();
+				record = m_last_record;
 			}
-			init();
-			record = m_last_record;
-		}
 
-		record = NEXT_RECORD(record);
+			record = NEXT_RECORD(record);
+		}
 
 		// Make sure the first longword of the record points to the pointer
 		m_last_record = record;
@@ -424,6 +808,9 @@ void Sort::sort(thread_db* tdbb)
 		if (m_last_record != (SR*) m_end_memory)
 		{
 			diddleKey((UCHAR*) KEYOF(m_last_record), true, false);
+
+			if (m_max_records)
+				putTopRecord();
 		}
 
 		// If there aren't any runs, things fit nicely in memory. Just sort the mess
@@ -459,6 +846,10 @@ void Sort::sort(thread_db* tdbb)
 			CHECK_FILE(NULL);
 		}
 
+		// Let the parallel workers merge the groups of runs
+		if (m_workers > 1)
+			mergeParallel(tdbb);
+
 		// Build a merge tree for the run_control blocks. Start by laying them all out
 		// in a vector. This is done to allow us to build a merge tree from the
 		// bottom up, ensuring that a balanced tree is built.
@@ -1175,11 +1566,12 @@ void Sort::diddleKey(UCHAR* record, bool direction, bool duplicateHandling)
 #endif
 
 
-sort_record* Sort::getMerge(merge_control* merge)
+sort_record* Sort::getMerge(merge_control* merge, Mutex* mergeMutex)
 {
 /**************************************
  *
  * Get next record from a merge tree and/or run_control.
+ * The mutex is given when a few trees are merged at once.
  *
  **************************************/
 	SORTP *p;				// no more than 1 SORTP* to a line
@@ -1225,7 +1617,11 @@ sort_record* Sort::getMerge(merge_control* merge)
 			l = (ULONG) (run->run_end_buffer - run->run_buffer);
 			n = run->run_records * m_longs * sizeof(ULONG);
 			l = MIN(l, n);
-			run->run_seek = readBlock(m_space, run->run_seek, run->run_buffer, l);
+
+			{	// scope
+				MutexLockGuard guard(mergeMutex, FB_FUNCTION);
+				run->run_seek = readBlock(m_space, run->run_seek, run->run_buffer, l);
+			}
 
 			record = reinterpret_cast<sort_record*>(run->run_buffer);
 			run->run_record =
@@ -1307,9 +1703,16 @@ sort_record* Sort::getMerge(merge_control* merge)
 			diddleKey((UCHAR*) merge->mrg_record_a, false, true);
 			diddleKey((UCHAR*) merge->mrg_record_b, false, true);
 
-			if ((*m_dup_callback) ((const UCHAR*) merge->mrg_record_a,
-										  (const UCHAR*) merge->mrg_record_b,
-										  m_dup_callback_arg))
+			bool reject;
+
+			{	// scope
+				MutexLockGuard guard(mergeMutex, FB_FUNCTION);
+				reject = (*m_dup_callback) ((const UCHAR*) merge->mrg_record_a,
+											(const UCHAR*) merge->mrg_record_b,
+											m_dup_callback_arg);
+			}
+
+			if (reject)
 			{
 				merge->mrg_record_a = NULL;
 				diddleKey((UCHAR*) merge->mrg_record_b, true, true);
@@ -1721,6 +2124,215 @@ void Sort::mergeRuns(USHORT n)
 }
 
 
+void Sort::mergeGroup(run_control* const* runs, run_control* output, UCHAR* buffers, ULONG bufferSize,
+	Mutex* mergeMutex)
+{
+/**************************************
+ *
+ * Merge a group of RUN_GROUP runs into the output run, which has its
+ * scratch space allocated already. Called by a parallel worker, the
+ * buffers are its own: a read buffer per run followed by the write one.
+ *
+ **************************************/
+	merge_control blks[RUN_GROUP];
+	run_merge_hdr* streams[RUN_GROUP];
+	run_merge_hdr** m1 = streams;
+
+	for (USHORT i = 0; i < RUN_GROUP; i++)
+	{
+		run_control* const run = runs[i];
+
+		run->run_buffer = buffers + i * bufferSize;
+		run->run_end_buffer = run->run_buffer + bufferSize;
+		run->run_record = reinterpret_cast<sort_record*>(run->run_end_buffer);
+		run->run_buff_alloc = false;
+		run->run_buff_cache = false;
+
+		*m1++ = (run_merge_hdr*) run;
+	}
+
+	// Build merge tree bottom up, see mergeRuns()
+
+	merge_control* merge;
+	USHORT count;
+	for (count = RUN_GROUP, merge = blks; count > 1;)
+	{
+		run_merge_hdr** m2 = m1 = streams;
+		while (count >= 2)
+		{
+			merge->mrg_header.rmh_type = RMH_TYPE_MRG;
+
+			(*m1)->rmh_parent = merge;
+			merge->mrg_stream_a = *m1++;
+
+			(*m1)->rmh_parent = merge;
+			merge->mrg_stream_b = *m1++;
+
+			merge->mrg_record_a = NULL;
+			merge->mrg_record_b = NULL;
+			*m2++ = (run_merge_hdr*) merge;
+			merge++;
+			count -= 2;
+		}
+		if (count)
+			*m2++ = *m1++;
+		count = m2 - streams;
+	}
+
+	--merge;
+	merge->mrg_header.rmh_parent = NULL;
+
+	// Merge records into the output run
+
+	UCHAR* const outBuffer = buffers + RUN_GROUP * bufferSize;
+	const UCHAR* const outEnd = outBuffer + bufferSize;
+
+	sort_record* q = reinterpret_cast<sort_record*>(outBuffer);
+	FB_UINT64 seek = output->run_seek;
+	output->run_records = 0;
+
+	const sort_record* p;
+	while ( (p = getMerge(merge, mergeMutex)) )
+	{
+		if ((UCHAR*) q >= outEnd)
+		{
+			MutexLockGuard guard(mergeMutex, FB_FUNCTION);
+			seek = writeBlock(m_space, seek, outBuffer, (UCHAR*) q - outBuffer);
+			q = reinterpret_cast<sort_record*>(outBuffer);
+		}
+		ULONG longs_count = m_longs;
+		do {
+			*q++ = *p++;
+		} while (--longs_count);
+		++output->run_records;
+	}
+
+	MutexLockGuard guard(mergeMutex, FB_FUNCTION);
+
+	if ((UCHAR*) q > outBuffer)
+		seek = writeBlock(m_space, seek, outBuffer, (UCHAR*) q - outBuffer);
+
+	// Duplicates may be rejected, free the remainder of the allocated run
+
+	if (seek - output->run_seek < output->run_size)
+	{
+		m_space->releaseSpace(seek, output->run_seek + output->run_size - seek);
+		output->run_size = seek - output->run_seek;
+	}
+}
+
+
+void Sort::mergeParallel(thread_db* tdbb)
+{
+/**************************************
+ *
+ * Merge the groups of RUN_GROUP runs hanging off the sort control block
+ * by the parallel workers, pushing the resulting runs back onto the sort
+ * control block. This shortens the final merge done while the records
+ * are returned. Nothing is done if there are too few groups or no free
+ * worker is available.
+ *
+ **************************************/
+	ULONG runCount = 0;
+	for (const run_control* run = m_runs; run; run = run->run_next)
+		runCount++;
+
+	const ULONG groupCount = runCount / RUN_GROUP;
+	ULONG workers = MIN((ULONG) m_workers, groupCount);
+
+	if (groupCount < MIN_PARALLEL_MERGE_GROUPS || workers < 2)
+		return;
+
+	EngineCheckout cout(tdbb, FB_FUNCTION);
+
+	MemoryPool& pool = m_owner->getPool();
+
+	WorkerReservation helpers(pool);
+	helpers.reserve(m_dbb, workers - 1);
+
+	workers = helpers.getCount() + 1;
+
+	if (workers < 2)
+		return;
+
+	// Runs are stored without the back pointers
+
+	const ULONG rec_size = (m_longs - SIZEOF_SR_BCKPTR_IN_LONGS) << SHIFTLONG;
+	const ULONG bufferSize = (m_max_alloc_size / rec_size) * rec_size;
+
+	MergeTask task(pool, this, workers, bufferSize);
+
+	// Take the groups off the list of runs, allocating the space of the merged runs
+
+	run_control* run = m_runs;
+
+	for (ULONG i = 0; i < groupCount; i++)
+	{
+		MergeTask::Group& group = task.addGroup();
+
+		run_control* const output = FB_NEW_POOL(pool) run_control;
+		memset(output, 0, sizeof(run_control));
+		output->run_header.rmh_type = RMH_TYPE_RUN;
+		group.output = output;
+
+		for (USHORT j = 0; j < RUN_GROUP; j++, run = run->run_next)
+		{
+			group.runs[j] = run;
+			output->run_size += run->run_size;
+			output->run_depth = MAX(output->run_depth, run->run_depth + 1);
+		}
+
+		output->run_seek = m_space->allocateSpace(output->run_size);
+	}
+
+	m_runs = run;
+	m_longs -= SIZEOF_SR_BCKPTR_IN_LONGS;
+
+	Coordinator coord(&pool);
+	coord.runSync(&task);
+
+	FbLocalStatus status;
+	const bool success = task.getResult(&status);
+
+	// Release the merged runs, their buffers belonged to the workers
+
+	for (FB_SIZE_T i = 0; i < task.getCount(); i++)
+	{
+		const MergeTask::Group& group = task.getGroup(i);
+
+		for (auto input : group.runs)
+		{
+			if (success)
+				m_space->releaseSpace(input->run_seek - input->run_size, input->run_size);
+
+			input->run_buffer = NULL;
+			input->run_next = m_free_runs;
+			m_free_runs = input;
+		}
+
+		run_control* const output = group.output;
+
+		if (success)
+		{
+			output->run_next = m_runs;
+			m_runs = output;
+		}
+		else
+		{
+			output->run_next = m_free_runs;
+			m_free_runs = output;
+		}
+	}
+
+	m_longs += SIZEOF_SR_BCKPTR_IN_LONGS;
+
+	if (!success)
+		status.raise();
+
+	CHECK_FILE(NULL);
+}
+
+
 void Sort::quick(SLONG size, SORTP** pointers, ULONG length) noexcept
 {
 /**************************************
@@ -2042,6 +2654,90 @@ void Sort::putRun(thread_db* tdbb)
 }
 
 
+void Sort::putTopRecord()
+{
+/**************************************
+ *
+ * Add the last record put into the buffer to the heap of the top-N
+ * sort. The heap keeps the greatest of the stored records at its top.
+ * When the heap is full, either the new record or the top one gets
+ * thrown away and its slot is reused for the next record.
+ *
+ **************************************/
+	SORTP** const heap = reinterpret_cast<SORTP**>(m_first_pointer + 1);
+	ULONG count = reinterpret_cast<SORTP**>(m_next_pointer) - heap;
+
+	fb_assert(count && count <= m_max_records + 1);
+
+	if (count <= m_max_records)
+	{
+		// Sift the new record up
+
+		for (ULONG i = count - 1; i; )
+		{
+			const ULONG parent = (i - 1) / 2;
+
+			if (compareKeys(heap[i], heap[parent]) <= 0)
+				break;
+
+			swap(heap + i, heap + parent);
+			i = parent;
+		}
+
+		return;
+	}
+
+	SORTP** const last = heap + count - 1;
+
+	// Unless the new record is not less than the greatest one, it replaces
+	// the top of the heap and is sifted down
+
+	if (compareKeys(*last, *heap) < 0)
+	{
+		swap(heap, last);
+		count--;
+
+		for (ULONG i = 0; ; )
+		{
+			ULONG child = 2 * i + 1;
+
+			if (child >= count)
+				break;
+
+			if (child + 1 < count && compareKeys(heap[child + 1], heap[child]) > 0)
+				child++;
+
+			if (compareKeys(heap[child], heap[i]) <= 0)
+				break;
+
+			swap(heap + i, heap + child);
+			i = child;
+		}
+	}
+
+	m_free_record = reinterpret_cast<SR*>(*last - SIZEOF_SR_BCKPTR_IN_LONGS);
+	m_next_pointer--;
+	m_records--;
+}
+
+
+int Sort::compareKeys(const SORTP* p, const SORTP* q) const noexcept
+{
+/**************************************
+ *
+ * Compare the (already diddled) keys of two records.
+ *
+ **************************************/
+	for (ULONG l = m_key_length; l; l--, p++, q++)
+	{
+		if (*p != *q)
+			return (*p > *q) ? 1 : -1;
+	}
+
+	return 0;
+}
+
+
 void Sort::sortBuffer(thread_db* tdbb)
 {
 /**************************************
@@ -2064,30 +2760,8 @@ void Sort::sortBuffer(thread_db* tdbb)
 	SORTP** j = (SORTP**) (m_first_pointer) + 1;
 	const ULONG n = (SORTP**) (m_next_pointer) - j;	// calculate # of records
 
-	quick(n, j, m_longs);
-
-	// Scream through and correct any out of order pairs
-	// hvlad: don't compare user keys against high_key
-	while (j < (SORTP**) m_next_pointer - 1)
-	{
-		SORTP** i = j;
-		j++;
-		if (**i >= **j)
-		{
-			const SORTP* p = *i;
-			const SORTP* q = *j;
-			ULONG tl = m_longs - 1;
-			while (tl && *p == *q)
-			{
-				p++;
-				q++;
-				tl--;
-			}
-			if (tl && *p > *q) {
-				swap(i, j);
-			}
-		}
-	}
+	if (!sortParallel(n, j))
+		sortPointers(n, j, m_longs, m_owner->getPool());
 
 	// If duplicate handling hasn't been requested, we're done
 
@@ -2135,6 +2809,265 @@ void Sort::sortBuffer(thread_db* tdbb)
 }
 
 
+void Sort::sortPointers(SLONG size, SORTP** pointers, ULONG length, MemoryPool& pool)
+{
+/**************************************
+ *
+ * Sort an array of record pointers by the kernel suitable for its size.
+ * The same assumptions as for quick() apply.
+ *
+ **************************************/
+	if ((ULONG) size >= MIN_RADIX_SORT_RECORDS)
+		radix(size, pointers, length, pool);
+	else
+	{
+		quick(size, pointers, length);
+		orderPairs(size, pointers, length);
+	}
+}
+
+
+void Sort::radix(SLONG size, SORTP** pointers, ULONG length, MemoryPool& pool)
+{
+/**************************************
+ *
+ * Sort an array of record pointers by two longwords of the keys, copied
+ * together with the pointers into a separate array. The longwords equal
+ * in all the records (e.g. null flags) are skipped. The array is sorted
+ * by the LSD radix sort, a byte per pass, without touching the records
+ * themselves. Then the records with equal prefixes, if any, are ordered
+ * by quick(). Runs of equal prefixes are surrounded by records with
+ * lesser and greater keys (or the guard ones), so the assumptions of
+ * quick() still hold.
+ *
+ **************************************/
+	struct Item
+	{
+		FB_UINT64 prefix;
+		SORTP* record;
+	};
+
+	const unsigned PASSES = sizeof(FB_UINT64);
+	const ULONG recordLongs = length - SIZEOF_SR_BCKPTR_IN_LONGS;
+
+	// Find the longwords common for all the records
+
+	ULONG common = recordLongs;
+
+	for (SLONG n = 1; n < size && common; n++)
+	{
+		const SORTP* p = pointers[0];
+		const SORTP* q = pointers[n];
+		ULONG l = 0;
+
+		while (l < common && p[l] == q[l])
+			l++;
+
+		common = l;
+	}
+
+	if (common == recordLongs)
+		return;		// all the records are equal
+
+	Array<Item> buffer(pool);
+	Item* items = buffer.getBuffer(2 * size);
+	Item* temp = items + size;
+
+	ULONG counts[PASSES][256];
+	memset(counts, 0, sizeof(counts));
+
+	for (SLONG n = 0; n < size; n++)
+	{
+		SORTP* const record = pointers[n];
+
+		FB_UINT64 prefix = ((FB_UINT64) record[common]) << 32;
+		if (common + 1 < recordLongs)
+			prefix |= record[common + 1];
+
+		items[n].prefix = prefix;
+		items[n].record = record;
+
+		for (unsigned pass = 0; pass < PASSES; pass++)
+			counts[pass][(prefix >> (pass * 8)) & 0xFF]++;
+	}
+
+	for (unsigned pass = 0; pass < PASSES; pass++)
+	{
+		ULONG* const count = counts[pass];
+		const unsigned shift = pass * 8;
+
+		// Skip the byte that is the same in all the keys
+
+		if (count[(items[0].prefix >> shift) & 0xFF] == (ULONG) size)
+			continue;
+
+		ULONG offset = 0;
+		for (unsigned digit = 0; digit < 256; digit++)
+		{
+			const ULONG n = count[digit];
+			count[digit] = offset;
+			offset += n;
+		}
+
+		for (SLONG n = 0; n < size; n++)
+			temp[count[(items[n].prefix >> shift) & 0xFF]++] = items[n];
+
+		Item* const swapped = items;
+		items = temp;
+		temp = swapped;
+	}
+
+	for (SLONG n = 0; n < size; n++)
+	{
+		pointers[n] = items[n].record;
+		((SORTP***) (pointers[n]))[BACK_OFFSET] = pointers + n;
+	}
+
+	// Order the records with equal prefixes
+
+	for (SLONG start = 0; start < size; )
+	{
+		SLONG end = start + 1;
+
+		while (end < size && items[end].prefix == items[start].prefix)
+			end++;
+
+		if (end - start > 1)
+		{
+			quick(end - start, pointers + start, length);
+			orderPairs(end - start, pointers + start, length);
+		}
+
+		start = end;
+	}
+}
+
+
+void Sort::orderPairs(SLONG size, SORTP** pointers, ULONG length) noexcept
+{
+/**************************************
+ *
+ * Scream through the array sorted by quick() and correct
+ * any out of order pairs.
+ *
+ **************************************/
+	SORTP** j = pointers;
+
+	// hvlad: don't compare user keys against high_key
+	while (j < pointers + size - 1)
+	{
+		SORTP** i = j;
+		j++;
+		if (**i >= **j)
+		{
+			const SORTP* p = *i;
+			const SORTP* q = *j;
+			ULONG tl = length - 1;
+			while (tl && *p == *q)
+			{
+				p++;
+				q++;
+				tl--;
+			}
+			if (tl && *p > *q) {
+				swap(i, j);
+			}
+		}
+	}
+}
+
+
+bool Sort::sortParallel(SLONG size, SORTP** pointers)
+{
+/**************************************
+ *
+ * Split the array of record pointers into partitions, sort them by
+ * the parallel workers and merge the results back into the array.
+ * Return false if the array is too small to be worth it or no free
+ * worker is available.
+ *
+ **************************************/
+	ULONG partCount = MIN((ULONG) m_workers, (ULONG) size / MIN_PARALLEL_SORT_RECORDS);
+
+	if (partCount < 2)
+		return false;
+
+	MemoryPool& pool = m_owner->getPool();
+
+	WorkerReservation helpers(pool);
+	helpers.reserve(m_dbb, partCount - 1);
+
+	partCount = helpers.getCount() + 1;
+
+	if (partCount < 2)
+		return false;
+
+	// Copy the partitions to the separate array, each one between the guard keys
+
+	Array<SORTP*> temp(pool);
+	SORTP** const base = temp.getBuffer(size + 2 * partCount);
+
+	PartitionTask task(pool, m_longs, partCount);
+
+	SORTP** from = pointers;
+	SORTP** to = base;
+
+	for (ULONG part = 0; part < partCount; part++)
+	{
+		const ULONG count = size / partCount + (part < size % partCount ? 1 : 0);
+
+		*to++ = reinterpret_cast<SORTP*>(low_key);
+		task.addPartition(to, count);
+		memcpy(to, from, count * sizeof(SORTP*));
+		from += count;
+		to += count;
+		*to++ = reinterpret_cast<SORTP*>(high_key);
+	}
+
+	// sortBuffer() keeps the attachment checked out while we wait for the workers
+
+	Coordinator coord(&pool);
+	coord.runSync(&task);
+
+	FbLocalStatus status;
+	if (!task.getResult(&status))
+		status.raise();
+
+	// Merge the sorted partitions back, fixing the back pointers
+
+	HalfStaticArray<SORTP**, 8> heads(pool, partCount);
+	HalfStaticArray<SORTP**, 8> ends(pool, partCount);
+
+	for (ULONG part = 0; part < partCount; part++)
+	{
+		const auto& partition = task.getPartition(part);
+		heads.add(partition.pointers);
+		ends.add(partition.pointers + partition.count);
+	}
+
+	for (SORTP** ptr = pointers; ptr < pointers + size; ptr++)
+	{
+		ULONG least = partCount;
+
+		for (ULONG part = 0; part < partCount; part++)
+		{
+			if (heads[part] < ends[part] &&
+				(least == partCount || compareRecords(*heads[part], *heads[least], m_longs) < 0))
+			{
+				least = part;
+			}
+		}
+
+		fb_assert(least < partCount);
+
+		*ptr = *heads[least]++;
+		((SORTP***) (*ptr))[BACK_OFFSET] = ptr;
+	}
+
+	return true;
+}
+
+
 void Sort::sortRunsBySeek(int n)
 {
 /**************************************
@@ -291,6 +291,19 @@ public:
 		return m_flags & scb_sorted;
 	}
 
+	// Allow the memory buffer to be sorted and the runs to be merged by a few threads
+	void setParallelWorkers(int workers) noexcept
+	{
+		m_workers = workers;
+	}
+
+	// In-memory kernels sorting an array of record pointers. They are
+	// public to be compared by the unit tests.
+	static void sortPointers(SLONG, SORTP**, ULONG, MemoryPool&);
+	static void quick(SLONG, SORTP**, ULONG) noexcept;
+	static void orderPairs(SLONG, SORTP**, ULONG) noexcept;
+	static void radix(SLONG, SORTP**, ULONG, MemoryPool&);
+
 	static FB_UINT64 readBlock(TempSpace* space, FB_UINT64 seek, UCHAR* address, ULONG length)
 	{
 		const size_t bytes = space->read(seek, address, length);
@@ -306,26 +319,33 @@ public:
 	}
 
 private:
+	class PartitionTask;
+	class MergeTask;
+
 	void allocateBuffer(MemoryPool&);
 	void releaseBuffer();
 
 	void diddleKey(UCHAR*, bool, bool);
-	sort_record* getMerge(merge_control*);
+	sort_record* getMerge(merge_control*, Firebird::Mutex* = nullptr);
 	sort_record* getRecord();
 	ULONG allocate(ULONG, ULONG, bool);
 	void init();
 	void mergeRuns(USHORT);
+	void mergeGroup(run_control* const*, run_control*, UCHAR*, ULONG, Firebird::Mutex*);
+	void mergeParallel(Jrd::thread_db*);
 	ULONG order();
 	void orderAndSave(Jrd::thread_db*);
 	void putRun(Jrd::thread_db*);
+	void putTopRecord();
+	int compareKeys(const SORTP*, const SORTP*) const noexcept;
 	void sortBuffer(Jrd::thread_db*);
+	bool sortParallel(SLONG, SORTP**);
 	void sortRunsBySeek(int);
 
 #ifdef DEV_BUILD
 	void checkFile(const run_control*);
 #endif
 
-	static void quick(SLONG, SORTP**, ULONG) noexcept;
 
 	Database* m_dbb;							// Database
 	SortOwner* m_owner;							// Sort owner
@@ -339,7 +359,8 @@ private:
 	ULONG m_key_length;							// Key length
 	ULONG m_unique_length;						// Unique key length, used when duplicates eliminated
 	FB_UINT64 m_records;						// Number of records
-	FB_UINT64 m_max_records;					// Maximum number of records to store, assigned but unused.
+	FB_UINT64 m_max_records;					// Maximum number of records to store, zero if unlimited
+	SR* m_free_record;							// Record slot released by the top-N sort
 	TempSpace* m_space;							// temporary space for scratch file
 	run_control* m_runs;						// ALLOC: Run on scratch file, if any
 	merge_control* m_merge;						// Top level merge block
@@ -349,6 +370,8 @@ private:
 	void* m_dup_callback_arg;					// Duplicate handling callback arg
 	merge_control* m_merge_pool;				// ALLOC: pool of merge_control blocks
 
+	int m_workers;								// Number of threads allowed to sort or merge
+
 	ULONG m_min_alloc_size;						// MIN and MAX values
 	ULONG m_max_alloc_size;						// for the run buffer size
 
@@ -3050,6 +3050,7 @@ bool Service::process_switches(ClumpletReader& spb, string& switches)
 				bigint = true;
 				[[fallthrough]];
 			case isc_spb_prp_page_buffers:
+			case isc_spb_prp_page_cache:
 			case isc_spb_prp_sweep_interval:
 			case isc_spb_prp_shutdown_db:
 			case isc_spb_prp_deny_new_attachments:
@@ -0,0 +1,193 @@
+#include "firebird.h"
+#include "boost/test/unit_test.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../jrd/BCBHashTable.h"
+
+using namespace Firebird;
+using namespace Jrd;
+
+
+namespace
+{
+	// Attaches the current thread to libcds for the lifetime of the object
+
+	class CdsThread
+	{
+	public:
+		CdsThread()
+		{
+#ifdef HASH_USE_CDS_LIST
+			if (!cds::threading::Manager::isThreadAttached())
+				cds::threading::Manager::attachThread();
+#endif
+		}
+
+		~CdsThread()
+		{
+#ifdef HASH_USE_CDS_LIST
+			if (cds::threading::Manager::isThreadAttached())
+				cds::threading::Manager::detachThread();
+#endif
+		}
+	};
+
+	// Hash table filled with buffers for pages 1..count of the main page space
+
+	class TestTable
+	{
+	public:
+		explicit TestTable(ULONG count)
+			: table(*getDefaultMemoryPool(), count)
+		{
+			for (ULONG i = 0; i < count; i++)
+			{
+				BufferDesc* const bdb = FB_NEW_POOL(*getDefaultMemoryPool()) BufferDesc(nullptr, nullptr);
+				bdbs.push_back(bdb);
+
+				const PageNumber page(DB_PAGE_SPACE, i + 1);
+
+				BOOST_REQUIRE(!table.emplace(bdb, page, false));
+				bdb->bdb_page = page;
+			}
+		}
+
+		~TestTable()
+		{
+			for (auto bdb : bdbs)
+			{
+				table.remove(bdb);
+				delete bdb;
+			}
+		}
+
+		BCBHashTable table;
+		std::vector<BufferDesc*> bdbs;
+	};
+}
+
+
+BOOST_AUTO_TEST_SUITE(EngineSuite)
+BOOST_AUTO_TEST_SUITE(BCBHashTableSuite)
+BOOST_AUTO_TEST_SUITE(BCBHashTableTests)
+
+
+BOOST_AUTO_TEST_CASE(FindEmplaceRemoveTest)
+{
+	CdsThread cdsThread;
+
+	constexpr ULONG PAGES = 1000;
+	TestTable test(PAGES);
+	BCBHashTable& table = test.table;
+
+	for (ULONG i = 0; i < PAGES; i++)
+		BOOST_TEST(table.find(PageNumber(DB_PAGE_SPACE, i + 1)) == test.bdbs[i]);
+
+	BOOST_TEST(!table.find(PageNumber(DB_PAGE_SPACE, PAGES + 1)));
+
+	// The same page number in another page space is a different page
+	BOOST_TEST(!table.find(PageNumber(TEMP_PAGE_SPACE, 1)));
+
+	// Page is already in the table - the present buffer is returned
+	BufferDesc other(nullptr, nullptr);
+	BOOST_TEST(table.emplace(&other, PageNumber(DB_PAGE_SPACE, 1), false) == test.bdbs[0]);
+
+	// Reassign buffer to another page, as get_buffer() does
+	BufferDesc* const bdb = test.bdbs[0];
+	const PageNumber newPage(TEMP_PAGE_SPACE, 1);
+
+	BOOST_TEST(!table.emplace(bdb, newPage, true));
+	bdb->bdb_page = newPage;
+
+	BOOST_TEST(!table.find(PageNumber(DB_PAGE_SPACE, 1)));
+	BOOST_TEST(table.find(newPage) == bdb);
+
+	table.remove(test.bdbs[1]);
+	BOOST_TEST(!table.find(PageNumber(DB_PAGE_SPACE, 2)));
+
+	BOOST_TEST(!table.emplace(test.bdbs[1], PageNumber(DB_PAGE_SPACE, 2), false));
+	BOOST_TEST(table.find(PageNumber(DB_PAGE_SPACE, 2)) == test.bdbs[1]);
+}
+
+
+BOOST_AUTO_TEST_CASE(ResizeTest)
+{
+	CdsThread cdsThread;
+
+	constexpr ULONG PAGES = 500;
+	TestTable test(PAGES);
+
+	test.table.resize(PAGES * 4);
+
+	for (ULONG i = 0; i < PAGES; i++)
+		BOOST_TEST(test.table.find(PageNumber(DB_PAGE_SPACE, i + 1)) == test.bdbs[i]);
+}
+
+
+// Microbenchmark: every thread looks up the same small set of hot pages,
+// like concurrent CCH_fetch of index root and upper b-tree level pages does.
+
+BOOST_AUTO_TEST_CASE(HotPagesBenchmark)
+{
+	CdsThread cdsThread;
+
+	constexpr ULONG PAGES = 16384;
+	constexpr ULONG HOT_PAGES = 64;
+	constexpr ULONG LOOKUPS = 200000;
+
+	TestTable test(PAGES);
+	const BCBHashTable& table = test.table;
+
+	const unsigned maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (unsigned threadCount = 1; ; threadCount = std::min(threadCount * 2, maxThreads))
+	{
+		std::atomic<ULONG> missed{0};
+		std::vector<std::thread> threads;
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (unsigned n = 0; n < threadCount; n++)
+		{
+			threads.emplace_back([&, n]() {
+				CdsThread cdsThread;
+				ULONG localMissed = 0;
+
+				for (ULONG i = 0; i < LOOKUPS; i++)
+				{
+					// hot pages are spread over the whole table
+					const ULONG pageNum = ((i + n) % HOT_PAGES) * (PAGES / HOT_PAGES) + 1;
+					const BufferDesc* const bdb = table.find(PageNumber(DB_PAGE_SPACE, pageNum));
+
+					if (!bdb || bdb->bdb_page.getPageNum() != pageNum)
+						localMissed++;
+				}
+
+				missed += localMissed;
+			});
+		}
+
+		for (auto& thread : threads)
+			thread.join();
+
+		const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start).count();
+
+		BOOST_CHECK_EQUAL(missed.load(), 0u);
+
+		BOOST_TEST_MESSAGE("BCBHashTable::find: " << threadCount << " thread(s), " <<
+			(FB_UINT64) LOOKUPS * threadCount * 1000000 / std::max<FB_UINT64>(elapsed, 1) <<
+			" lookups/sec");
+
+		if (threadCount == maxThreads)
+			break;
+	}
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()	// BCBHashTableTests
+BOOST_AUTO_TEST_SUITE_END()	// BCBHashTableSuite
+BOOST_AUTO_TEST_SUITE_END()	// EngineSuite
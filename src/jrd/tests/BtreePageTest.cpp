@@ -0,0 +1,583 @@
+#include "firebird.h"
+#include "boost/test/unit_test.hpp"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../jrd/jrd.h"
+#include "../jrd/btr.h"
+#include "../jrd/btn.h"
+#include "../jrd/btr_proto.h"
+#include "../jrd/EngineInterface.h"
+#include "../common/classes/ClumpletWriter.h"
+#include "../common/classes/TempFile.h"
+#include "../auth/SecureRemotePassword/Message.h"
+
+using namespace Firebird;
+using namespace Jrd;
+using namespace Ods;
+
+
+namespace
+{
+	typedef std::vector<UCHAR> Key;
+
+	const USHORT PAGE_SIZE = 8192;
+
+	// Integer keys ordered the same way as their values, with the
+	// trailing zero bytes removed like in the numeric index keys
+
+	Key makeIntegerKey(SINT64 value)
+	{
+		const FB_UINT64 ordered = (FB_UINT64) value ^ ((FB_UINT64) 1 << 63);
+
+		Key key;
+		for (int shift = 56; shift >= 0; shift -= 8)
+			key.push_back((UCHAR) (ordered >> shift));
+
+		while (key.size() > 1 && !key.back())
+			key.pop_back();
+
+		return key;
+	}
+
+	// Long string keys sharing the most of their bytes
+
+	Key makeStringKey(ULONG value)
+	{
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), "CUSTOMER/EUROPE/GERMANY/BERLIN/%010u", value);
+
+		return Key(buffer, buffer + strlen(buffer));
+	}
+
+	// Leaf page image filled with the given ascending keys, the nodes are
+	// prefix compressed and the jump nodes are placed every jumpInterval bytes
+
+	class TestPage
+	{
+	public:
+		TestPage(const std::vector<Key>& allKeys, USHORT jumpInterval)
+			: buffer(PAGE_SIZE)
+		{
+			std::vector<UCHAR> nodes(PAGE_SIZE);
+			std::vector<USHORT> offsets;
+			UCHAR* pointer = nodes.data();
+			const UCHAR* const limit = nodes.data() + PAGE_SIZE - 1024;
+
+			const Key* previous = nullptr;
+
+			for (const auto& key : allKeys)
+			{
+				if (pointer >= limit)
+					break;
+
+				const USHORT prefix = previous ?
+					IndexNode::computePrefix(previous->data(), previous->size(), key.data(), key.size()) : 0;
+
+				IndexNode node;
+				node.setNode(prefix, key.size() - prefix, RecordNumber(keys.size()));
+				node.data = const_cast<UCHAR*>(key.data()) + prefix;
+
+				offsets.push_back(pointer - nodes.data());
+				pointer = node.writeNode(pointer, true);
+
+				keys.push_back(key);
+				previous = &key;
+			}
+
+			IndexNode endNode;
+			endNode.setEndLevel();
+			endLevelOffset = pointer - nodes.data();
+			pointer = endNode.writeNode(pointer, true);
+
+			const USHORT nodesLength = pointer - nodes.data();
+
+			// Jump nodes refer to the first node after every jumpInterval bytes
+
+			std::vector<IndexJumpNode> jumpNodes;
+			Key jumpKey;
+			USHORT jumpSize = 0;
+			USHORT nextArea = jumpInterval;
+
+			for (size_t i = 1; i < offsets.size() && jumpNodes.size() < MAX_UCHAR; i++)
+			{
+				if (offsets[i] <= nextArea)
+					continue;
+
+				IndexNode node;
+				node.readNode(nodes.data() + offsets[i], true);
+
+				IndexJumpNode jumpNode;
+				jumpNode.offset = offsets[i];
+				jumpNode.prefix = IndexNode::computePrefix(jumpKey.data(), jumpKey.size(),
+					keys[i].data(), node.prefix);
+				jumpNode.length = node.prefix - jumpNode.prefix;
+				jumpNode.data = keys[i].data() + jumpNode.prefix;
+
+				jumpKey.assign(keys[i].begin(), keys[i].begin() + node.prefix);
+				jumpSize += jumpNode.getJumpNodeSize();
+				jumpNodes.push_back(jumpNode);
+
+				nextArea += jumpInterval;
+			}
+
+			nodesOffset = BTR_SIZE + jumpSize;
+
+			const auto page = getPage();
+			page->btr_header.pag_type = pag_index;
+			page->btr_level = 0;
+			page->btr_jump_interval = jumpInterval;
+			page->btr_jump_size = jumpSize;
+			page->btr_jump_count = (UCHAR) jumpNodes.size();
+			page->btr_length = nodesOffset + nodesLength;
+
+			pointer = page->btr_nodes;
+			for (auto& jumpNode : jumpNodes)
+			{
+				jumpNode.offset += nodesOffset;
+				pointer = jumpNode.writeJumpNode(pointer);
+			}
+
+			memcpy(page->btr_nodes + jumpSize, nodes.data(), nodesLength);
+
+			for (const auto offset : offsets)
+				nodePointers.push_back(buffer.data() + nodesOffset + offset);
+
+			nodePointers.push_back(buffer.data() + nodesOffset + endLevelOffset);
+		}
+
+		btree_page* getPage()
+		{
+			return reinterpret_cast<btree_page*>(buffer.data());
+		}
+
+		// The first node not less than the key, or the end of level marker
+		const UCHAR* expectedPosition(const Key& key) const
+		{
+			const auto pos = std::lower_bound(keys.begin(), keys.end(), key);
+			return nodePointers[pos - keys.begin()];
+		}
+
+		const UCHAR* find(const Key& key)
+		{
+			temporary_key search;
+			makeSearchKey(key, search);
+
+			USHORT prefix = 0;
+			return BTR_find_leaf(getPage(), &search, nullptr, &prefix, false, 0);
+		}
+
+		static void makeSearchKey(const Key& key, temporary_key& search)
+		{
+			search.key_length = key.size();
+			search.key_flags = 0;
+			search.key_nulls = 0;
+			memcpy(search.key_data, key.data(), key.size());
+		}
+
+		std::vector<Key> keys;
+
+	private:
+		std::vector<UCHAR> buffer;
+		std::vector<const UCHAR*> nodePointers;
+		USHORT nodesOffset = 0;
+		USHORT endLevelOffset = 0;
+	};
+
+	// Keys to look for: every stored key and keys next to them
+
+	std::vector<Key> makeProbes(const std::vector<Key>& keys)
+	{
+		std::vector<Key> probes;
+
+		for (const auto& key : keys)
+		{
+			probes.push_back(key);
+
+			Key shorter(key.begin(), key.end() - 1);
+			probes.push_back(shorter);
+
+			Key longer(key);
+			longer.push_back(1);
+			probes.push_back(longer);
+		}
+
+		probes.push_back(Key(1, 0));
+		probes.push_back(Key(64, MAX_UCHAR));
+
+		return probes;
+	}
+
+	// Database created by the embedded engine and dropped at the end of the test
+
+	class TestDatabase
+	{
+	public:
+		TestDatabase()
+			: provider(JProvider::getInstance())
+		{
+			const PathName fileName = TempFile::create("fb_btree_");
+
+			ClumpletWriter dpb(ClumpletReader::dpbList, MAX_DPB_SIZE);
+			dpb.insertString(isc_dpb_trusted_auth, DBA_USER_NAME);
+			dpb.insertInt(isc_dpb_page_size, 4096);
+			dpb.insertInt(isc_dpb_sql_dialect, SQL_DIALECT_V6);
+			dpb.insertInt(isc_dpb_force_write, 0);
+			dpb.insertInt(isc_dpb_overwrite, 1);
+
+			FbLocalStatus status;
+			attachment.assignRefNoIncr(provider->createDatabase(&status, fileName.c_str(),
+				dpb.getBufferLength(), dpb.getBuffer()));
+			status.check();
+		}
+
+		~TestDatabase()
+		{
+			FbLocalStatus status;
+			attachment->dropDatabase(&status);
+		}
+
+		void execute(const string& sql)
+		{
+			FbLocalStatus status;
+			RefPtr<JTransaction> transaction(REF_NO_INCR, attachment->startTransaction(&status, 0, nullptr));
+			status.check();
+
+			attachment->execute(&status, transaction, 0, sql.c_str(), SQL_DIALECT_V6,
+				nullptr, nullptr, nullptr, nullptr);
+			status.check();
+
+			transaction->commit(&status);
+			status.check();
+		}
+
+		SINT64 count(const string& sql)
+		{
+			Message result;
+			Field<ISC_INT64> value(result);
+
+			FbLocalStatus status;
+			RefPtr<JTransaction> transaction(REF_NO_INCR, attachment->startTransaction(&status, 0, nullptr));
+			status.check();
+
+			attachment->execute(&status, transaction, 0, sql.c_str(), SQL_DIALECT_V6,
+				nullptr, nullptr, result.getMetadata(), result.getBuffer());
+			status.check();
+
+			transaction->commit(&status);
+			status.check();
+
+			return value;
+		}
+
+		// Rows first, first + step, ... are inserted one by one
+		void insert(const char* table, SINT64 first, SINT64 step, ULONG rows)
+		{
+			string sql;
+			sql.printf(
+				"execute block as\n"
+				"	declare id bigint = %" SQUADFORMAT ";\n"
+				"	declare n integer = %" ULONGFORMAT ";\n"
+				"begin\n"
+				"	while (n > 0) do\n"
+				"	begin\n"
+				"		insert into %s (id) values (:id);\n"
+				"		id = id + %" SQUADFORMAT ";\n"
+				"		n = n - 1;\n"
+				"	end\n"
+				"end", first, rows, table, step);
+
+			execute(sql);
+		}
+
+		// Number of the page fetches from the page cache of the database
+		SINT64 getFetches()
+		{
+			const UCHAR items[] = {isc_info_fetches, isc_info_end};
+			UCHAR buffer[BUFFER_TINY];
+
+			FbLocalStatus status;
+			attachment->getInfo(&status, sizeof(items), items, sizeof(buffer), buffer);
+			status.check();
+
+			for (ClumpletReader p(ClumpletReader::InfoResponse, buffer, sizeof(buffer)); !p.isEof(); p.moveNext())
+			{
+				if (p.getClumpTag() == isc_info_fetches)
+					return p.getBigInt();
+			}
+
+			return 0;
+		}
+
+	private:
+		AutoPlugin<JProvider> provider;
+		RefPtr<JAttachment> attachment;
+	};
+}
+
+
+BOOST_AUTO_TEST_SUITE(EngineSuite)
+BOOST_AUTO_TEST_SUITE(BtreeSuite)
+BOOST_AUTO_TEST_SUITE(BtreePageTests)
+
+
+BOOST_AUTO_TEST_CASE(MatchPrefixTest)
+{
+	std::mt19937 generator(1);
+
+	for (USHORT length = 0; length <= 70; length++)
+	{
+		for (USHORT diff = 0; diff <= length; diff++)
+		{
+			Key p(length + 1), q(length + 1);
+			for (USHORT i = 0; i < length; i++)
+				p[i] = q[i] = (UCHAR) generator();
+
+			if (diff < length)
+				q[diff] = p[diff] + 1;
+
+			BOOST_TEST(IndexNode::matchPrefix(p.data(), q.data(), length) == diff);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(FindLeafTest)
+{
+	std::vector<Key> integerKeys, stringKeys;
+
+	for (SINT64 i = -500; i < 1500; i++)
+		integerKeys.push_back(makeIntegerKey(i * 3));
+
+	for (ULONG i = 0; i < 1000; i++)
+		stringKeys.push_back(makeStringKey(i * 7));
+
+	for (const auto keys : {&integerKeys, &stringKeys})
+	{
+		for (const USHORT jumpInterval : {128, 286, 544})
+		{
+			TestPage page(*keys, jumpInterval);
+			BOOST_TEST(page.getPage()->btr_jump_count > 0);
+
+			for (const auto& probe : makeProbes(page.keys))
+				BOOST_TEST((page.find(probe) == page.expectedPosition(probe)));
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(PayloadNodeTest)
+{
+	std::vector<UCHAR> buffer(2 * MAX_SSHORT);
+
+	for (const USHORT payloadLength : {0, 1, 127, 128, 300, 16383})
+	{
+		for (const USHORT keyLength : {0, 1, 30})
+		{
+			Key key(keyLength, 'K');
+			Key payload(payloadLength);
+			for (USHORT i = 0; i < payloadLength; i++)
+				payload[i] = (UCHAR) (i * 7 + 1);
+
+			IndexNode node;
+			node.setNode(5, keyLength, RecordNumber(123456));
+			node.data = key.data();
+			node.setPayload(payload.data(), payloadLength);
+
+			const UCHAR* const end = node.writeNode(buffer.data(), true);
+			BOOST_TEST(end - buffer.data() == node.getNodeSize(true));
+
+			IndexNode read;
+			BOOST_TEST(read.readNode(buffer.data(), true) == end);
+
+			BOOST_TEST(read.prefix == 5);
+			BOOST_TEST(read.length == keyLength);
+			BOOST_TEST(read.recordNumber.getValue() == 123456);
+			BOOST_TEST(!memcmp(read.data, key.data(), keyLength));
+			BOOST_TEST(read.hasPayload() == (payloadLength != 0));
+			BOOST_TEST(read.payloadLength == payloadLength);
+			BOOST_TEST(!memcmp(read.payload, payload.data(), payloadLength));
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(LastLeafTest)
+{
+	const USHORT RELATION_ID = 200;
+	const MetaId INDEX_ID = 3;
+
+	std::vector<Key> keys;
+	for (SINT64 i = 0; i < 500; i++)
+		keys.push_back(makeIntegerKey(i * 3));
+
+	TestPage page(keys, 286);
+	const auto bucket = page.getPage();
+	bucket->btr_relation = RELATION_ID;
+	bucket->btr_id = INDEX_ID;
+
+	const auto acceptsFor = [&](const Key& key, MetaId indexId)
+	{
+		temporary_key search;
+		TestPage::makeSearchKey(key, search);
+		return BTR_last_leaf_accepts(bucket, RELATION_ID, indexId, &search);
+	};
+
+	const auto accepts = [&](const Key& key)
+	{
+		return acceptsFor(key, INDEX_ID);
+	};
+
+	// Keys greater than the first one belong to the rightmost leaf page
+
+	const Key& first = page.keys.front();
+	Key longer(first);
+	longer.push_back(1);
+
+	BOOST_TEST(accepts(longer));
+	BOOST_TEST(accepts(page.keys[1]));
+	BOOST_TEST(accepts(page.keys.back()));
+	BOOST_TEST(accepts(makeIntegerKey(1000000)));
+
+	BOOST_TEST(!accepts(first));
+	BOOST_TEST(!accepts(Key(first.begin(), first.end() - 1)));
+	BOOST_TEST(!accepts(makeIntegerKey(-1)));
+
+	// Only the live rightmost leaf page of the same index is used
+
+	BOOST_TEST(!acceptsFor(page.keys.back(), INDEX_ID + 1));
+	BOOST_TEST(!acceptsFor(page.keys.back(), INDEX_ID + 256));
+
+	bucket->btr_sibling = 12345;
+	BOOST_TEST(!accepts(page.keys.back()));
+	bucket->btr_sibling = 0;
+
+	bucket->btr_level = 1;
+	BOOST_TEST(!accepts(page.keys.back()));
+	bucket->btr_level = 0;
+
+	bucket->btr_header.pag_flags |= btr_released;
+	BOOST_TEST(!accepts(page.keys.back()));
+	bucket->btr_header.pag_flags &= ~btr_released;
+
+	bucket->btr_relation = RELATION_ID + 1;
+	BOOST_TEST(!accepts(page.keys.back()));
+	bucket->btr_relation = RELATION_ID;
+
+	BOOST_TEST(accepts(page.keys.back()));
+}
+
+// Not a check but a measurement, see the test log for the timings
+BOOST_AUTO_TEST_CASE(FindLeafBenchmarkTest)
+{
+	const unsigned ROUNDS = 200;
+
+	std::vector<Key> integerKeys, stringKeys;
+
+	for (SINT64 i = 0; i < 5000; i++)
+		integerKeys.push_back(makeIntegerKey(i * 1000003));
+
+	for (ULONG i = 0; i < 5000; i++)
+		stringKeys.push_back(makeStringKey(i));
+
+	for (const auto keys : {&integerKeys, &stringKeys})
+	{
+		for (const USHORT jumpInterval : {286, 544})
+		{
+			TestPage page(*keys, jumpInterval);
+
+			std::vector<Key> probes(page.keys);
+			std::shuffle(probes.begin(), probes.end(), std::mt19937(42));
+
+			const auto start = std::chrono::steady_clock::now();
+
+			for (unsigned round = 0; round < ROUNDS; round++)
+			{
+				for (const auto& probe : probes)
+				{
+					if (!page.find(probe))
+						BOOST_FAIL("Key not found");
+				}
+			}
+
+			const auto elapsed = std::chrono::steady_clock::now() - start;
+			const auto lookups = (double) ROUNDS * probes.size();
+
+			BOOST_TEST_MESSAGE("Leaf page with " << page.keys.size() << (keys == &integerKeys ? " integer" : " string")
+				<< " keys, " << (int) page.getPage()->btr_jump_count << " jump nodes: "
+				<< std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / lookups << " ns per lookup");
+		}
+	}
+}
+
+
+// Ascending keys are inserted into the rightmost leaf page remembered by the
+// previous insert, see insert_last_leaf. The timings are in the test log.
+BOOST_AUTO_TEST_CASE(LastLeafInsertTest)
+{
+	const ULONG ROWS = 100000;
+
+	TestDatabase database;
+	database.execute("create table ascending_keys (id bigint not null)");
+	database.execute("create index ascending_keys_id on ascending_keys (id)");
+	database.execute("create table descending_keys (id bigint not null)");
+	database.execute("create index descending_keys_id on descending_keys (id)");
+
+	const auto measure = [&](const char* table, SINT64 first, SINT64 step, SINT64& fetches)
+	{
+		fetches = database.getFetches();
+		const auto start = std::chrono::steady_clock::now();
+
+		database.insert(table, first, step, ROWS);
+
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		fetches = database.getFetches() - fetches;
+
+		return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+	};
+
+	const auto indexCount = [&](const char* table, SINT64 low, SINT64 high)
+	{
+		string sql;
+		sql.printf("select count(*) from %s where id between %" SQUADFORMAT " and %" SQUADFORMAT
+			" plan (%s index (%s_id))", table, low, high, table, table);
+
+		return database.count(sql);
+	};
+
+	// The descending keys never belong to the rightmost leaf page, so every
+	// insert descends from the top of the index, while the ascending ones
+	// skip the upper levels
+
+	SINT64 ascendingFetches, descendingFetches;
+	const auto ascendingTime = measure("ascending_keys", 0, 1, ascendingFetches);
+	const auto descendingTime = measure("descending_keys", -1, -1, descendingFetches);
+
+	BOOST_TEST_MESSAGE("Insert of " << ROWS << " index keys: ascending " << ascendingTime << " ms, "
+		<< (double) ascendingFetches / ROWS << " page fetches per row, descending " << descendingTime
+		<< " ms, " << (double) descendingFetches / ROWS << " page fetches per row");
+
+	BOOST_TEST(ascendingFetches + SINT64(ROWS / 2) < descendingFetches);
+
+	// The rightmost leaf page was split many times on the way, the inserts
+	// that didn't fit fell back to the usual descent
+
+	BOOST_TEST(indexCount("ascending_keys", 0, ROWS - 1) == SINT64(ROWS));
+	BOOST_TEST(indexCount("ascending_keys", 0, 9) == 10);
+	BOOST_TEST(indexCount("ascending_keys", ROWS - 10, ROWS - 1) == 10);
+	BOOST_TEST(indexCount("descending_keys", -SINT64(ROWS), -1) == SINT64(ROWS));
+
+	// The remembered page is released with the index and may be reused by
+	// the next index of the table, the keys mustn't go to the released page
+
+	database.execute("drop index ascending_keys_id");
+	database.execute("create index ascending_keys_id on ascending_keys (id)");
+	database.insert("ascending_keys", ROWS, 1, ROWS);
+
+	BOOST_TEST(indexCount("ascending_keys", 0, 2 * ROWS - 1) == SINT64(2 * ROWS));
+	BOOST_TEST(indexCount("ascending_keys", ROWS, 2 * ROWS - 1) == SINT64(ROWS));
+	BOOST_TEST(database.count("select count(*) from ascending_keys") == SINT64(2 * ROWS));
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()	// BtreePageTests
+BOOST_AUTO_TEST_SUITE_END()	// BtreeSuite
+BOOST_AUTO_TEST_SUITE_END()	// EngineSuite
@@ -0,0 +1,256 @@
+#include "firebird.h"
+#include "boost/test/unit_test.hpp"
+#include <initializer_list>
+#include "../jrd/jrd.h"
+#include "../jrd/req.h"
+#include "../jrd/Relation.h"
+#include "../jrd/dpm_proto.h"
+
+using namespace Firebird;
+using namespace Jrd;
+using namespace Ods;
+
+
+namespace
+{
+	const USHORT SLOT = 3;
+	const USHORT PAGE_SIZE = 1024;
+
+	// Data page image with a primary record version per given transaction
+
+	class TestDataPage
+	{
+	public:
+		TestDataPage(std::initializer_list<TraNumber> transactions)
+		{
+			memset(buffer, 0, sizeof(buffer));
+
+			USHORT offset = PAGE_SIZE;
+
+			for (const auto traNum : transactions)
+			{
+				offset -= FB_ALIGN(RHD_SIZE, ODS_ALIGNMENT);
+
+				auto& index = get()->dpg_rpt[get()->dpg_count++];
+				index.dpg_offset = offset;
+				index.dpg_length = RHD_SIZE;
+
+				getHeader(get()->dpg_count - 1)->rhd_transaction = (ULONG) traNum;
+			}
+		}
+
+		data_page* get()
+		{
+			return reinterpret_cast<data_page*>(buffer);
+		}
+
+		rhd* getHeader(USHORT line)
+		{
+			return reinterpret_cast<rhd*>(buffer + get()->dpg_rpt[line].dpg_offset);
+		}
+
+		// DPM_update or DPM_store changes a record, the pointer page is updated by mark_full
+		void change(UCHAR* bits)
+		{
+			get()->dpg_header.pag_flags &= ~(dpg_swept | dpg_visible);
+			PPG_DP_BITS_BYTE(bits, SLOT) = DPM_page_bits(bits, SLOT, get()->dpg_header.pag_flags, false);
+		}
+
+		// Sweep or garbage collector, see check_swept
+		void sweep(UCHAR* bits, const RelationPages& pages, TraNumber oldest, TraNumber oldestActive)
+		{
+			const UCHAR flags = DPM_swept_flags(get(), oldest, oldestActive);
+
+			if (!flags)
+				return;
+
+			get()->dpg_header.pag_flags |= flags;
+			PPG_DP_BITS_BYTE(bits, SLOT) = DPM_page_bits(bits, SLOT, get()->dpg_header.pag_flags, false);
+
+			if (flags & dpg_visible)
+				PPG_DP_BITS_BYTE(bits, SLOT) = DPM_clear_purged_bits(bits, SLOT, &pages, oldestActive);
+		}
+
+	private:
+		alignas(ODS_ALIGNMENT) UCHAR buffer[PAGE_SIZE];
+	};
+
+	// Versions are removed before their index keys while the next
+	// transaction number is given, see PurgeGuard and DPM_mark_purged
+	void startPurge(UCHAR* bits, RelationPages& pages, TraNumber nextTraNum)
+	{
+		pages.startPurge(nextTraNum);
+		PPG_DP_BIT_SET(bits, SLOT, ppg_dp_purged);
+	}
+}
+
+
+BOOST_AUTO_TEST_SUITE(EngineSuite)
+BOOST_AUTO_TEST_SUITE(PointerPageSuite)
+
+
+BOOST_AUTO_TEST_SUITE(SweptFlagsTests)
+
+BOOST_AUTO_TEST_CASE(VisibleTest)
+{
+	TestDataPage page({5, 6, 7});
+
+	BOOST_TEST(DPM_swept_flags(page.get(), 10, 10) == (dpg_swept | dpg_visible));
+
+	// The last version may still be invisible to an active snapshot
+	BOOST_TEST(DPM_swept_flags(page.get(), 10, 7) == dpg_swept);
+	BOOST_TEST(DPM_swept_flags(page.get(), 7, 10) == dpg_swept);
+
+	// Nothing is swept if a version is not older than the oldest interesting transaction
+	BOOST_TEST(DPM_swept_flags(page.get(), 6, 10) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(NotSweptTest)
+{
+	TestDataPage backVersion({5, 6, 7});
+	backVersion.getHeader(1)->rhd_b_page = 100;
+
+	BOOST_TEST(DPM_swept_flags(backVersion.get(), 10, 10) == 0);
+
+	TestDataPage deleted({5, 6, 7});
+	deleted.getHeader(2)->rhd_flags = rpb_deleted;
+
+	BOOST_TEST(DPM_swept_flags(deleted.get(), 10, 10) == 0);
+
+	// Removed lines are skipped
+	deleted.get()->dpg_rpt[2].dpg_offset = 0;
+
+	BOOST_TEST(DPM_swept_flags(deleted.get(), 10, 10) == (dpg_swept | dpg_visible));
+}
+
+BOOST_AUTO_TEST_SUITE_END()	// SweptFlagsTests
+
+
+BOOST_AUTO_TEST_SUITE(PageBitsTests)
+
+BOOST_AUTO_TEST_CASE(CopyFlagsTest)
+{
+	UCHAR bits[SLOT + 2] = {};
+	PPG_DP_BIT_SET(bits, SLOT, ppg_dp_reserved | ppg_dp_purged);
+	PPG_DP_BIT_SET(bits, SLOT + 1, ppg_dp_full);
+
+	PPG_DP_BITS_BYTE(bits, SLOT) = DPM_page_bits(bits, SLOT, dpg_full | dpg_swept | dpg_visible, false);
+
+	BOOST_TEST(PPG_DP_BIT_TEST(bits, SLOT, ppg_dp_full | ppg_dp_swept | ppg_dp_visible) ==
+		(ppg_dp_full | ppg_dp_swept | ppg_dp_visible));
+
+	// Bits of the pointer page itself are kept, other slots are not touched
+	BOOST_TEST(PPG_DP_BIT_TEST(bits, SLOT, ppg_dp_reserved | ppg_dp_purged) ==
+		(ppg_dp_reserved | ppg_dp_purged));
+	BOOST_TEST(PPG_DP_BITS_BYTE(bits, SLOT + 1) == ppg_dp_full);
+
+	// The removed versions may still have index keys
+	BOOST_TEST(!PPG_DP_ALL_VISIBLE(bits, SLOT));
+
+	PPG_DP_BITS_BYTE(bits, SLOT) = DPM_page_bits(bits, SLOT, 0, true);
+
+	BOOST_TEST(PPG_DP_BIT_TEST(bits, SLOT, PPG_DP_ALL_BITS) ==
+		(ppg_dp_empty | ppg_dp_reserved | ppg_dp_purged));
+}
+
+BOOST_AUTO_TEST_SUITE_END()	// PageBitsTests
+
+
+BOOST_AUTO_TEST_SUITE(PurgedBitTests)
+
+BOOST_AUTO_TEST_CASE(VisibleAgainAfterSweepTest)
+{
+	RelationPages pages(*getDefaultMemoryPool());
+	TestDataPage page({5, 6, 7});
+	UCHAR bits[SLOT + 1] = {};
+
+	page.sweep(bits, pages, 10, 10);
+	BOOST_TEST(PPG_DP_ALL_VISIBLE(bits, SLOT));
+
+	// Update, then garbage collection of the old version
+
+	page.change(bits);
+	BOOST_TEST(!PPG_DP_ALL_VISIBLE(bits, SLOT));
+
+	startPurge(bits, pages, 20);
+	pages.finishPurge(true);
+
+	page.sweep(bits, pages, 30, 30);
+	BOOST_TEST(PPG_DP_ALL_VISIBLE(bits, SLOT));
+	BOOST_TEST(!PPG_DP_BIT_TEST(bits, SLOT, ppg_dp_purged));
+}
+
+BOOST_AUTO_TEST_CASE(ActiveScanTest)
+{
+	RelationPages pages(*getDefaultMemoryPool());
+	TestDataPage page({5, 6, 7});
+	UCHAR bits[SLOT + 1] = {};
+
+	// Transaction 15 built its bitmap from the keys of the versions
+	// being removed while transaction 20 is the latest one
+
+	page.change(bits);
+	startPurge(bits, pages, 20);
+	pages.finishPurge(true);
+
+	// The page is visible to transaction 15, but the bitmap may have
+	// the numbers of the removed records
+
+	page.sweep(bits, pages, 15, 15);
+	BOOST_TEST(PPG_DP_BIT_TEST(bits, SLOT, ppg_dp_visible));
+	BOOST_TEST(!PPG_DP_ALL_VISIBLE(bits, SLOT));
+
+	page.sweep(bits, pages, 20, 20);
+	BOOST_TEST(!PPG_DP_ALL_VISIBLE(bits, SLOT));
+
+	// Every transaction started before the removal has finished
+
+	page.sweep(bits, pages, 21, 21);
+	BOOST_TEST(PPG_DP_ALL_VISIBLE(bits, SLOT));
+}
+
+BOOST_AUTO_TEST_CASE(PurgeInProgressTest)
+{
+	RelationPages pages(*getDefaultMemoryPool());
+	TestDataPage page({5, 6, 7});
+	UCHAR bits[SLOT + 1] = {};
+
+	page.change(bits);
+
+	// Index keys of the removed versions are not garbage collected yet
+
+	startPurge(bits, pages, 20);
+
+	page.sweep(bits, pages, 30, 30);
+	BOOST_TEST(PPG_DP_BIT_TEST(bits, SLOT, ppg_dp_visible));
+	BOOST_TEST(!PPG_DP_ALL_VISIBLE(bits, SLOT));
+
+	pages.finishPurge(true);
+
+	page.sweep(bits, pages, 30, 30);
+	BOOST_TEST(PPG_DP_ALL_VISIBLE(bits, SLOT));
+}
+
+BOOST_AUTO_TEST_CASE(PurgeFailedTest)
+{
+	RelationPages pages(*getDefaultMemoryPool());
+	TestDataPage page({5, 6, 7});
+	UCHAR bits[SLOT + 1] = {};
+
+	page.change(bits);
+
+	startPurge(bits, pages, 20);
+	pages.finishPurge(false);
+
+	// The keys may stay in indices forever
+
+	page.sweep(bits, pages, 30, 30);
+	BOOST_TEST(!PPG_DP_ALL_VISIBLE(bits, SLOT));
+	BOOST_TEST(!pages.purgesDone(30));
+}
+
+BOOST_AUTO_TEST_SUITE_END()	// PurgedBitTests
+
+
+BOOST_AUTO_TEST_SUITE_END()	// PointerPageSuite
+BOOST_AUTO_TEST_SUITE_END()	// EngineSuite
@@ -0,0 +1,280 @@
+#include "firebird.h"
+#include "boost/test/unit_test.hpp"
+#include <chrono>
+#include "../jrd/jrd.h"
+#include "../jrd/req.h"
+#include "../jrd/RecordBatch.h"
+
+using namespace Firebird;
+using namespace Jrd;
+
+
+namespace
+{
+	const StreamType STREAM = 1;
+	const USHORT FIELD_A = 0;
+	const USHORT FIELD_B = 1;
+
+	// Table scan simulation: the records of two BIGINT fields, A and B, are read
+	// into the stream record the same way VIO_next_record() does it
+
+	class TestScan
+	{
+	public:
+		TestScan()
+			: format(Format::newFormat(*getDefaultMemoryPool(), 2))
+		{
+			// Null flags are followed by the fields
+			for (USHORT id = 0; id < format->fmt_count; id++)
+				format->fmt_desc[id].makeInt64(0, (SINT64*) (IPTR) ((id + 1) * sizeof(SINT64)));
+
+			format->fmt_length = (format->fmt_count + 1) * sizeof(SINT64);
+		}
+
+		~TestScan()
+		{
+			for (auto& rpb : rpbs)
+				delete rpb.rpb_record;
+
+			delete format;
+		}
+
+		void fetch(SINT64 number)
+		{
+			record_param* const rpb = &rpbs[STREAM];
+
+			if (!rpb->rpb_record)
+				rpb->rpb_record = FB_NEW_POOL(*getDefaultMemoryPool()) Record(*getDefaultMemoryPool(), format);
+
+			UCHAR* const data = rpb->rpb_record->getData();
+			memset(data, 0, sizeof(SINT64));
+			setField(data, FIELD_A, number % 100);
+			setField(data, FIELD_B, number);
+
+			rpb->rpb_number.setValue(number);
+			rpb->rpb_number.setValid(true);
+		}
+
+		// Value of the field in the current record of the stream
+		SINT64 getField(USHORT id) const
+		{
+			const auto data = rpbs[STREAM].rpb_record->getData();
+			return *(const SINT64*) (data + (IPTR) format->fmt_desc[id].dsc_address);
+		}
+
+		Format* const format;
+		record_param rpbs[STREAM + 1];
+
+	private:
+		void setField(UCHAR* data, USHORT id, SINT64 value)
+		{
+			*(SINT64*) (data + (IPTR) format->fmt_desc[id].dsc_address) = value;
+		}
+	};
+
+	// Filter and aggregate of SELECT SUM(B) FROM T WHERE A < 30,
+	// evaluated against the current record of the stream
+
+	SINT64 filterAggregate(const TestScan& scan)
+	{
+		return (scan.getField(FIELD_A) < 30) ? scan.getField(FIELD_B) : 0;
+	}
+
+	SINT64 expectedSum(ULONG count)
+	{
+		SINT64 sum = 0;
+
+		for (ULONG i = 0; i < count; i++)
+		{
+			if (i % 100 < 30)
+				sum += i;
+		}
+
+		return sum;
+	}
+}
+
+
+BOOST_AUTO_TEST_SUITE(EngineSuite)
+BOOST_AUTO_TEST_SUITE(RecordBatchSuite)
+
+
+BOOST_AUTO_TEST_SUITE(RecordBatchTests)
+
+BOOST_AUTO_TEST_CASE(ExchangeTest)
+{
+	TestScan scan;
+	RecordBatch batch(*getDefaultMemoryPool(), &STREAM, 1);
+
+	for (ULONG round = 0; round < 2; round++)
+	{
+		batch.clear();
+
+		for (SINT64 i = 0; i < 10; i++)
+		{
+			scan.fetch(round * 10 + i);
+			const Record* const record = scan.rpbs[STREAM].rpb_record;
+
+			batch.exchange(scan.rpbs);
+
+			// The batch took the record over, the stream got a former one
+			BOOST_TEST(batch.getRecord(i, 0) == record);
+			BOOST_TEST(scan.rpbs[STREAM].rpb_record != record);
+		}
+
+		BOOST_TEST(batch.getCount() == 10u);
+
+		RecordBatch::RowHolder rows(scan.rpbs, batch);
+
+		for (ULONG i = 0; i < batch.getCount(); i++)
+		{
+			rows.set(batch.getRow(i));
+			BOOST_TEST(scan.getField(FIELD_B) == SINT64(round * 10 + i));
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(RowHolderTest)
+{
+	TestScan scan;
+	RecordBatch batch(*getDefaultMemoryPool(), &STREAM, 1);
+
+	for (SINT64 i = 0; i < 5; i++)
+	{
+		scan.fetch(i);
+		batch.add(scan.rpbs);
+	}
+
+	// The filter leaves the first rows selected, while the scan is positioned
+	// at the last one
+
+	Array<ULONG> positions;
+	positions.add(0);
+	positions.add(1);
+	batch.select(positions);
+
+	const record_param* const rpb = &scan.rpbs[STREAM];
+	const Record* const record = rpb->rpb_record;
+
+	{	// scope
+		RecordBatch::RowHolder rows(scan.rpbs, batch);
+
+		rows.set(batch.getRow(1));
+
+		BOOST_TEST(rpb->rpb_record == batch.getRecord(1, 0));
+		BOOST_TEST(rpb->rpb_number.getValue() == 1);
+		BOOST_TEST(scan.getField(FIELD_B) == 1);
+	}
+
+	// The scan continues from its own position
+	BOOST_TEST(rpb->rpb_record == record);
+	BOOST_TEST(rpb->rpb_number.getValue() == 4);
+	BOOST_TEST(scan.getField(FIELD_B) == 4);
+}
+
+// Not a check but a measurement, see the test log for the timings.
+// The row mode evaluation of the batch rows is compared with the copying
+// of the rows to and from the batch the record source used to do.
+BOOST_AUTO_TEST_CASE(FilterAggregateBenchmarkTest)
+{
+	const ULONG COUNT = 1000000;
+	const unsigned ROUNDS = 5;
+
+	const SINT64 expected = expectedSum(COUNT);
+
+	const auto measure = [&](SINT64 (*scanner)(TestScan&, RecordBatch&))
+	{
+		std::chrono::steady_clock::duration total{};
+
+		for (unsigned round = 0; round < ROUNDS; round++)
+		{
+			TestScan scan;
+			RecordBatch batch(*getDefaultMemoryPool(), &STREAM, 1);
+
+			const auto start = std::chrono::steady_clock::now();
+			const SINT64 sum = scanner(scan, batch);
+			total += std::chrono::steady_clock::now() - start;
+
+			BOOST_TEST(sum == expected);
+		}
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(total).count() / ROUNDS;
+	};
+
+	// Record at a time
+	const auto rowTime = measure([](TestScan& scan, RecordBatch&)
+	{
+		SINT64 sum = 0;
+
+		for (ULONG i = 0; i < COUNT; i++)
+		{
+			scan.fetch(i);
+			sum += filterAggregate(scan);
+		}
+
+		return sum;
+	});
+
+	// Batches of copied records, copied back to be evaluated
+	const auto copyTime = measure([](TestScan& scan, RecordBatch& batch)
+	{
+		SINT64 sum = 0;
+
+		for (ULONG i = 0; i < COUNT;)
+		{
+			batch.clear();
+
+			for (; i < COUNT && !batch.isFull(); i++)
+			{
+				scan.fetch(i);
+				batch.add(scan.rpbs);
+			}
+
+			Record* const record = scan.rpbs[STREAM].rpb_record;
+
+			for (ULONG pos = 0; pos < batch.getCount(); pos++)
+			{
+				record->copyFrom(batch.getRecord(batch.getRow(pos), 0));
+				sum += filterAggregate(scan);
+			}
+		}
+
+		return sum;
+	});
+
+	// Batches of exchanged records, evaluated in place
+	const auto exchangeTime = measure([](TestScan& scan, RecordBatch& batch)
+	{
+		SINT64 sum = 0;
+
+		for (ULONG i = 0; i < COUNT;)
+		{
+			batch.clear();
+
+			for (; i < COUNT && !batch.isFull(); i++)
+			{
+				scan.fetch(i);
+				batch.exchange(scan.rpbs);
+			}
+
+			RecordBatch::RowHolder rows(scan.rpbs, batch);
+
+			for (ULONG pos = 0; pos < batch.getCount(); pos++)
+			{
+				rows.set(batch.getRow(pos));
+				sum += filterAggregate(scan);
+			}
+		}
+
+		return sum;
+	});
+
+	BOOST_TEST_MESSAGE("Filter and aggregate of " << COUNT << " records: row " << rowTime
+		<< " us, batch with copies " << copyTime << " us, batch with exchange " << exchangeTime << " us");
+}
+
+BOOST_AUTO_TEST_SUITE_END()	// RecordBatchTests
+
+
+BOOST_AUTO_TEST_SUITE_END()	// RecordBatchSuite
+BOOST_AUTO_TEST_SUITE_END()	// EngineSuite
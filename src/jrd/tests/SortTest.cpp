@@ -0,0 +1,242 @@
+#include "firebird.h"
+#include "boost/test/unit_test.hpp"
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../jrd/jrd.h"
+#include "../jrd/sort.h"
+
+using namespace Firebird;
+using namespace Jrd;
+
+
+namespace
+{
+	const ULONG BACK_LONGS = offsetof(sr, sr_sort_record) / sizeof(SORTP);
+
+	// Records laid out as in the sort buffer: the back pointer followed by the key.
+	// The first common longwords of the keys are equal, like the null flags or
+	// string prefixes. The array of pointers to the keys is surrounded by the
+	// guard keys.
+
+	class TestRecords
+	{
+	public:
+		TestRecords(ULONG count, ULONG keyLongs, ULONG range, unsigned seed, ULONG common = 0)
+			: count(count),
+			  keyLongs(keyLongs),
+			  longs(FB_ALIGN(BACK_LONGS + keyLongs, 2)),
+			  data((count + 1) * longs),	// quick() may read a longword past the last record
+			  lowKey(longs, 0),
+			  highKey(longs, MAX_ULONG),
+			  pointers(count + 2)
+		{
+			std::mt19937 generator(seed);
+			std::uniform_int_distribution<ULONG> distribution(0, range - 1);
+
+			for (ULONG i = 0; i < count; i++)
+			{
+				SORTP* const key = data.data() + i * longs + BACK_LONGS;
+
+				for (ULONG j = 0; j < keyLongs; j++)
+					key[j] = (j < common) ? j : distribution(generator);
+			}
+
+			reset();
+		}
+
+		void reset()
+		{
+			pointers[0] = lowKey.data();
+			pointers[count + 1] = highKey.data();
+
+			for (ULONG i = 0; i < count; i++)
+			{
+				pointers[i + 1] = data.data() + i * longs + BACK_LONGS;
+				backPointer(i) = &pointers[i + 1];
+			}
+		}
+
+		SORTP** begin()
+		{
+			return &pointers[1];
+		}
+
+		SORTP**& backPointer(ULONG n)
+		{
+			return *reinterpret_cast<SORTP***>(data.data() + n * longs);
+		}
+
+		bool isOrdered() const
+		{
+			for (ULONG i = 1; i < count; i++)
+			{
+				if (compare(pointers[i], pointers[i + 1]) > 0)
+					return false;
+			}
+
+			return true;
+		}
+
+		bool hasValidBackPointers() const
+		{
+			for (ULONG i = 1; i <= count; i++)
+			{
+				const auto back = reinterpret_cast<SORTP* const* const*>(pointers[i] - BACK_LONGS);
+
+				if (*back != &pointers[i])
+					return false;
+			}
+
+			return true;
+		}
+
+		std::vector<SORTP> getKeys() const
+		{
+			std::vector<SORTP> keys;
+
+			for (ULONG i = 1; i <= count; i++)
+				keys.insert(keys.end(), pointers[i], pointers[i] + keyLongs);
+
+			return keys;
+		}
+
+		int compare(const SORTP* p, const SORTP* q) const
+		{
+			for (ULONG j = 0; j < keyLongs; j++)
+			{
+				if (p[j] != q[j])
+					return (p[j] > q[j]) ? 1 : -1;
+			}
+
+			return 0;
+		}
+
+		const ULONG count;
+		const ULONG keyLongs;
+		const ULONG longs;
+
+	private:
+		std::vector<SORTP> data;
+		std::vector<SORTP> lowKey;
+		std::vector<SORTP> highKey;
+		std::vector<SORTP*> pointers;
+	};
+
+	void quickSort(TestRecords& records)
+	{
+		Sort::quick(records.count, records.begin(), records.longs);
+		Sort::orderPairs(records.count, records.begin(), records.longs);
+	}
+
+	void radixSort(TestRecords& records)
+	{
+		Sort::radix(records.count, records.begin(), records.longs, *getDefaultMemoryPool());
+	}
+}
+
+
+BOOST_AUTO_TEST_SUITE(EngineSuite)
+BOOST_AUTO_TEST_SUITE(SortSuite)
+BOOST_AUTO_TEST_SUITE(SortKernelTests)
+
+
+BOOST_AUTO_TEST_CASE(RadixMatchesQuickTest)
+{
+	struct Case
+	{
+		ULONG count;
+		ULONG keyLongs;
+		ULONG range;
+		ULONG common;
+	};
+
+	const Case cases[] =
+	{
+		{1, 1, 10, 0},
+		{2, 2, 10, 0},
+		{1000, 1, 3, 0},			// mostly equal keys
+		{1000, 2, 10, 2},			// all keys are equal
+		{5000, 2, MAX_ULONG, 0},	// distinct prefixes
+		{5000, 4, 2, 0},			// ties broken beyond the prefix
+		{5000, 6, 100, 3},			// common longwords are skipped
+		{20000, 3, 1000, 1}
+	};
+
+	unsigned seed = 1;
+
+	for (const auto& test : cases)
+	{
+		TestRecords byQuick(test.count, test.keyLongs, test.range, seed, test.common);
+		TestRecords byRadix(test.count, test.keyLongs, test.range, seed, test.common);
+		seed++;
+
+		quickSort(byQuick);
+		radixSort(byRadix);
+
+		BOOST_TEST(byQuick.isOrdered());
+		BOOST_TEST(byRadix.isOrdered());
+		BOOST_TEST(byRadix.hasValidBackPointers());
+		BOOST_TEST((byQuick.getKeys() == byRadix.getKeys()));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(SortPointersTest)
+{
+	TestRecords records(3000, 2, 100, 7);
+
+	Sort::sortPointers(records.count, records.begin(), records.longs, *getDefaultMemoryPool());
+
+	BOOST_TEST(records.isOrdered());
+	BOOST_TEST(records.hasValidBackPointers());
+}
+
+// Not a check but a measurement, see the test log for the timings
+BOOST_AUTO_TEST_CASE(KernelBenchmarkTest)
+{
+	const ULONG COUNT = 200000;
+	const unsigned ROUNDS = 5;
+
+	struct Case
+	{
+		ULONG keyLongs;
+		ULONG common;
+	};
+
+	// Short keys, and wide ones with the common leading part
+	const Case cases[] = {{2, 0}, {8, 4}};
+
+	for (const auto& test : cases)
+	{
+		TestRecords records(COUNT, test.keyLongs, MAX_ULONG, 42, test.common);
+
+		const auto measure = [&](void (*kernel)(TestRecords&))
+		{
+			std::chrono::steady_clock::duration total{};
+
+			for (unsigned round = 0; round < ROUNDS; round++)
+			{
+				records.reset();
+
+				const auto start = std::chrono::steady_clock::now();
+				kernel(records);
+				total += std::chrono::steady_clock::now() - start;
+
+				BOOST_TEST(records.isOrdered());
+			}
+
+			return std::chrono::duration_cast<std::chrono::microseconds>(total).count() / ROUNDS;
+		};
+
+		const auto quickTime = measure(quickSort);
+		const auto radixTime = measure(radixSort);
+
+		BOOST_TEST_MESSAGE("Sorting " << COUNT << " records with " << test.keyLongs << " key longwords ("
+			<< test.common << " common): quick " << quickTime << " us, radix " << radixTime << " us");
+	}
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()	// SortKernelTests
+BOOST_AUTO_TEST_SUITE_END()	// SortSuite
+BOOST_AUTO_TEST_SUITE_END()	// EngineSuite
@@ -114,7 +114,8 @@ bool TipCache::MemBlockInitializer::initialize(SharedMemoryBase* sm, bool initFl
 }
 
 TipCache::TipCache(Database* dbb)
-	: m_tpcHeader(NULL), m_snapshots(NULL), m_transactionsPerBlock(0), m_lock(nullptr),
+	: m_tpcHeader(NULL), m_snapshots(NULL), m_transactionsPerBlock(0),
+	  m_hugePages(dbb->dbb_config->getHugePageSize() != 0), m_lock(nullptr),
 	  globalTpcInitializer(this), snapshotsInitializer(this), memBlockInitializer(this),
 	  m_blocks_memory(*dbb->dbb_permanent)
 {
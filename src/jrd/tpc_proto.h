@@ -280,6 +280,7 @@ private:
 		explicit MemoryInitializer(TipCache *cache) noexcept : m_cache(cache) {}
 		void mutexBug(int osErrorCode, const char* text) override;
 		USHORT getVersion() const override { return TPC_VERSION; }
+		bool useHugePages() const override { return m_cache->m_hugePages; }
 	protected:
 		TipCache* m_cache;
 	};
@@ -322,6 +323,7 @@ private:
 	Firebird::SharedMemory<GlobalTpcHeader>* m_tpcHeader; // final
 	Firebird::SharedMemory<SnapshotList>* m_snapshots; // final
 	ULONG m_transactionsPerBlock; // final. When set, we assume TPC has been initialized.
+	const bool m_hugePages; // final. Back shared memory by huge pages, see HugePageSize.
 
 	Firebird::AutoPtr<Lock> m_lock;
 
@@ -658,6 +658,20 @@ static void explain_pp_bits(const UCHAR bits, Firebird::string& names)
 			names.append(", ");
 		names.append("reserved");
 	}
+
+	if (bits & ppg_dp_visible)
+	{
+		if (!names.empty())
+			names.append(", ");
+		names.append("visible");
+	}
+
+	if (bits & ppg_dp_purged)
+	{
+		if (!names.empty())
+			names.append(", ");
+		names.append("purged");
+	}
 }
 
 
@@ -1211,7 +1225,7 @@ Validation::FETCH_CODE Validation::fetch_page(bool mark, ULONG page_number,
 	}
 
 	window->win_page = page_number;
-	window->win_flags = 0;
+	window->win_flags = WIN_use_once;
 	pag** page_pointer = reinterpret_cast<pag**>(aPage_pointer);
 
 	FB_SIZE_T pos;
@@ -1766,6 +1780,9 @@ Validation::RTN Validation::walk_data_page(jrd_rel* relation, ULONG page_number,
 	if (dp_flags & dpg_secondary)
 		pp_bits |= ppg_dp_secondary;
 
+	if (dp_flags & dpg_visible)
+		pp_bits |= ppg_dp_visible;
+
 	if (page->dpg_count == 0)
 		pp_bits |= ppg_dp_empty;
 
@@ -2648,6 +2665,10 @@ Validation::RTN Validation::walk_pointer_page(jrd_rel* relation, ULONG sequence)
 			if (*pages)
 			{
 				UCHAR &pp_bits = PPG_DP_BITS_BYTE(bits, slot);
+
+				// Purged bit has no counterpart at the data page
+				new_pp_bits |= (pp_bits & ppg_dp_purged);
+
 				if (pp_bits != new_pp_bits)
 				{
 					Firebird::string s_pp, s_dp;
@@ -2921,6 +2942,12 @@ void restoreFlags(UCHAR* byte, UCHAR flags, bool empty)
 	else
 		*byte &= ~bit;
 
+	bit = PPG_DP_BIT_MASK(slot, ppg_dp_visible);
+	if (flags & dpg_visible)
+		*byte |= bit;
+	else
+		*byte &= ~bit;
+
 	bit = PPG_DP_BIT_MASK(slot, ppg_dp_empty);
 	if (empty)
 		*byte |= bit;
@@ -456,7 +456,7 @@ bool SweepTask::handler(WorkItem& _item)
 			rpb.rpb_org_scans = getPermanent(relation)->rel_scan_count++;
 			rpb.rpb_record = NULL;
 			rpb.rpb_stream_flags = RPB_s_no_data | RPB_s_sweeper;
-			rpb.getWindow(tdbb).win_flags = WIN_large_scan;
+			rpb.getWindow(tdbb).win_flags = WIN_large_scan | WIN_use_once;
 
 			rpb.rpb_number.compose(dbb->dbb_max_records, dbb->dbb_dp_per_pp, 0, 0, item->m_firstPP);
 			rpb.rpb_number.decrement();
@@ -601,6 +601,48 @@ namespace
 
 		return Compressor::unpack(rpb->rpb_length, rpb->rpb_address, outLength, output);
 	}
+
+	// Marks the data page as purged and counts the removal of record versions
+	// until the end of the scope, when their index keys are garbage collected.
+	// Removal interrupted by an error may leave the keys in indices. Keys read
+	// into bitmaps before their removal may be used by transactions started
+	// up to now, so the latest transaction number is remembered as well.
+
+	class PurgeGuard
+	{
+	public:
+		PurgeGuard(thread_db* tdbb, record_param* rpb)
+			: m_pages(rpb->rpb_relation->isTemporary() ? NULL : rpb->rpb_relation->getPages(tdbb)),
+			  m_exceptions(std::uncaught_exceptions())
+		{
+			if (m_pages)
+				m_pages->startPurge(tdbb->getDatabase()->dbb_next_transaction);
+
+			try
+			{
+				DPM_mark_purged(tdbb, rpb);
+			}
+			catch (const Exception&)
+			{
+				if (m_pages)
+					m_pages->finishPurge(true);
+				throw;
+			}
+		}
+
+		~PurgeGuard()
+		{
+			if (m_pages)
+				m_pages->finishPurge(std::uncaught_exceptions() == m_exceptions);
+		}
+
+		PurgeGuard(const PurgeGuard&) = delete;
+		PurgeGuard& operator=(const PurgeGuard&) = delete;
+
+	private:
+		RelationPages* const m_pages;
+		const int m_exceptions;
+	};
 };
 
 
@@ -971,6 +1013,10 @@ void VIO_backout(thread_db* tdbb, record_param* rpb, const jrd_tra* transaction)
 		}
 	}
 
+	// Versions are removed below before or after their index keys
+
+	PurgeGuard purgeGuard(tdbb, rpb);
+
 	// Re-fetch the record.
 
 	if (!DPM_get(tdbb, rpb, LCK_write))
@@ -2368,6 +2414,10 @@ bool VIO_erase(thread_db* tdbb, record_param* rpb, jrd_tra* transaction)
 			DFW_post_work(transaction, dfw_delete_package_constant, &desc, &schemaDesc, 0, object_name.package);
 			break;
 
+		case rel_column_statistics:
+			protect_system_table_delupd(tdbb, relation, "DELETE");
+			break;
+
 		default:    // Shut up compiler warnings
 			break;
 		}
@@ -2763,6 +2813,8 @@ void VIO_intermediate_gc(thread_db* tdbb, record_param* rpb, jrd_tra* transactio
 		precedence_stack.push(PageNumber(relPages->rel_pg_space_id, staying_chain_rpb.rpb_page));
 	}
 
+	PurgeGuard purgeGuard(tdbb, rpb);
+
 	// Read head version with write lock and check if it is still the same version
 	record_param temp_rpb = *rpb;
 
@@ -3778,6 +3830,10 @@ bool VIO_modify(thread_db* tdbb, record_param* org_rpb, record_param* new_rpb, j
 			DFW_post_work(transaction, dfw_modify_package_constant, &desc1, &schemaDesc, 0, object_name.package);
 			break;
 
+		case rel_column_statistics:
+			protect_system_table_delupd(tdbb, relation, "UPDATE");
+			break;
+
 		default:
 			break;
 		}
@@ -4726,6 +4782,10 @@ void VIO_store(thread_db* tdbb, record_param* rpb, jrd_tra* transaction)
 			DFW_post_work(transaction, dfw_create_package_constant, &desc, &schemaDesc, 0, object_name.package);
 			break;
 
+		case rel_column_statistics:
+			protect_system_table_insert(tdbb, request, relation);
+			break;
+
 		default:    // Shut up compiler warnings
 			break;
 		}
@@ -4838,7 +4898,7 @@ bool VIO_sweep(thread_db* tdbb, jrd_tra* transaction, TraceSweepEvent* traceSwee
 	record_param rpb;
 	rpb.rpb_record = NULL;
 	rpb.rpb_stream_flags = RPB_s_no_data | RPB_s_sweeper;
-	rpb.getWindow(tdbb).win_flags = WIN_large_scan;
+	rpb.getWindow(tdbb).win_flags = WIN_large_scan | WIN_use_once;
 
 	GarbageCollector* gc = dbb->dbb_garbage_collector;
 	bool ret = true;
@@ -5527,6 +5587,8 @@ static void expunge(thread_db* tdbb, record_param* rpb, const jrd_tra* transacti
 	if (attachment->att_flags & ATT_no_cleanup)
 		return;
 
+	PurgeGuard purgeGuard(tdbb, rpb);
+
 	// Re-fetch the record
 
 	if (!DPM_get(tdbb, rpb, LCK_write))
@@ -7023,6 +7085,8 @@ static void purge(thread_db* tdbb, record_param* rpb)
 	temp.rpb_prior = rpb->rpb_prior;
 	rpb->rpb_record = temp.rpb_record;
 
+	PurgeGuard purgeGuard(tdbb, rpb);
+
 	if (!DPM_get(tdbb, rpb, LCK_write))
 	{
 		// purge
@@ -7397,6 +7461,10 @@ void VIO_update_in_place(thread_db* tdbb,
 	// unavoidable assigned to some value
 	fb_assert(stack);
 
+	// Keys of the version being overwritten stay in indices for a while
+
+	PurgeGuard purgeGuard(tdbb, org_rpb);
+
 	Record* const old_data = org_rpb->rpb_record;
 
 	// If the old version has been stored as a delta, things get complicated.  Clearly,
@@ -4052,6 +4052,11 @@ bool LockManager::checkHeader(const MemoryHeader* header, bool raiseError)
 	return IpcObject::checkHeader(header, raiseError);
 };
 
+bool LockManager::useHugePages() const
+{
+	return m_config->getHugePageSize() != 0;
+}
+
 #ifdef USE_SHMEM_EXT
 void LockManager::Extent::assign(const SharedMemoryBase& p)
 {
@@ -484,6 +484,7 @@ private:
 	USHORT getType() const override { return Firebird::SharedMemoryBase::SRAM_LOCK_MANAGER; }
 	USHORT getVersion() const override { return LHB_VERSION; }
 	const char* getName() const override { return "LockManager"; }
+	bool useHugePages() const override;
 
 	bool m_bugcheck;
 	prc* m_process;
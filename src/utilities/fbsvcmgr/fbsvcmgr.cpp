@@ -468,6 +468,7 @@ constexpr SvcSwitches propertiesOptions[] =
 {
 	{"dbname", putStringArgument, 0, isc_spb_dbname, 0},
 	{"prp_page_buffers", putIntArgument, 0, isc_spb_prp_page_buffers, 0},
+	{"prp_page_cache", putIntArgument, 0, isc_spb_prp_page_cache, 0},
 	{"prp_sweep_interval", putIntArgument, 0, isc_spb_prp_sweep_interval, 0},
 	{"prp_shutdown_db", putIntArgument, 0, isc_spb_prp_shutdown_db, 0},
 	{"prp_deny_new_transactions", putIntArgument, 0, isc_spb_prp_deny_new_transactions, 0},